@@ -10,6 +10,66 @@
 #define PIN_BOTON_MANUAL    17 
 #define PIN_SDA             21
 #define PIN_SCL             22
+#define PIN_RTC_SQW         27   // SQW del DS3231 (1 Hz); si no llega pulso se resincroniza por minuto
+#define PIN_PRESION         35   // Transductores de la línea: ADC1 (el ADC2 lo ocupa la WiFi)
+#define PIN_CAUDAL          39
+#define PIN_CORRIENTE       36   // Transformador de corriente de la bomba (zona 1)
+
+// ==========================================
+// ZONAS DE RIEGO (una salida por válvula/bomba)
+// ==========================================
+#define MAX_ZONAS           16   // Límite del BombaManager (máscaras de 16 bits)
+#define NUM_ZONAS           8    // Zonas instaladas en este controlador
+
+// La zona 1 es la bomba original
+#define PIN_ZONA_1          PIN_BOMBA
+#define PIN_ZONA_2          4
+#define PIN_ZONA_3          5
+#define PIN_ZONA_4          18
+#define PIN_ZONA_5          19
+#define PIN_ZONA_6          23
+#define PIN_ZONA_7          25
+#define PIN_ZONA_8          26
+
+// Un pin por zona instalada (NUM_ZONAS elementos)
+#define PINES_ZONAS { PIN_ZONA_1, PIN_ZONA_2, PIN_ZONA_3, PIN_ZONA_4, \
+                      PIN_ZONA_5, PIN_ZONA_6, PIN_ZONA_7, PIN_ZONA_8 }
+// Las mismas, una Bomba por pin: cada una se construye en su sitio con
+// llaves (sus campos son atómicos y no se copian)
+#define BOMBAS_ZONAS { {PIN_ZONA_1}, {PIN_ZONA_2}, {PIN_ZONA_3}, {PIN_ZONA_4}, \
+                       {PIN_ZONA_5}, {PIN_ZONA_6}, {PIN_ZONA_7}, {PIN_ZONA_8} }
+
+// ==========================================
+// SENSORES DE LÍNEA (presión y caudal)
+// ==========================================
+// Muestreados a SENSORES_HZ y decimados a SENSORES_HZ / 16. Con alguna
+// zona regando, y pasado el arranque, un valor fuera de [MIN, MAX] corta
+// todas las zonas: poca presión o poco caudal = bomba en seco; mucho
+// caudal = tubería rota; mucha presión = línea cerrada.
+// SENSORES_HZ es múltiplo de 50 y de 60: un ciclo de red son muestras
+// exactas para el RMS de la corriente.
+#define SENSORES_HZ         6000
+#define PRESION_FONDO       10000 // mbar a fondo de escala (1023 cuentas)
+#define PRESION_MIN         500
+#define PRESION_MAX         6000
+#define CAUDAL_FONDO        600   // Décimas de L/min a fondo de escala
+#define CAUDAL_MIN          20
+#define CAUDAL_MAX          450
+#define SENSORES_MS         2    // Periodo de su tarea regando (el anillo aguanta 85 ms)
+#define REPOSO_SENSORES_MS  50   // Sin zonas regando solo se drena el ADC
+
+// ==========================================
+// CORRIENTE DE LA BOMBA (zona 1)
+// ==========================================
+// RMS verdadero de cada ciclo de red. Tras el arranque: por debajo de MIN
+// no está girando (solo se avisa); por encima de MAX dos ciclos seguidos,
+// o en el nivel de rotor bloqueado uno solo, se corta.
+#define RED_HZ              60
+#define CORRIENTE_MA_CUENTA 97    // SCT-013-030 (30 A/1 V) con 3,3 V en 10 bits
+#define CORRIENTE_MIN_MA    1000
+#define CORRIENTE_MAX_MA    12000 // 1,5 x nominal (8 A)
+#define CORRIENTE_BLOQUEO_MA 24000
+#define ARRANQUE_BOMBA_MS   500   // Pico de arranque permitido
 
 // ==========================================
 // CONFIGURACIÓN DE PANTALLA
@@ -19,14 +79,17 @@
 #define OLED_HEIGHT   64
 
 // ==========================================
-// MAPA DE MEMORIA EEPROM
+// MAPA DE MEMORIA EEPROM (ANTIGUO)
 // ==========================================
-// Dejamos los primeros 200 bytes libres para tu ConfigManager
-#define EEPROM_SIZE         512
+// La config vive ahora en el almacén de registros (partición "cfglog").
+// Este mapa solo se lee una vez, para migrar lo que hubiera guardado.
+#define EEPROM_SIZE         1024
 #define EEPROM_ADDR_MQTT    200  // Inicio bloque MQTT
 #define EEPROM_ADDR_PORT    280  
 #define EEPROM_ADDR_USER    290  
 #define EEPROM_ADDR_PASS    330  
+// La zona 1 sigue en la dirección 0 (compatibilidad); las demás van aquí
+#define EEPROM_ADDR_ZONAS   512
 
 // ==========================================
 // VALORES POR DEFECTO (HiveMQ)
@@ -35,5 +98,20 @@
 #define DEFAULT_MQTT_PORT   "8883"
 #define DEFAULT_MQTT_USER   "esp32"
 #define DEFAULT_MQTT_PASS   "L8U8Zg7AA4PhRyV"
+// Codificación de lo publicado al arrancar; la nube la cambia con
+// {"codificacion": "msgpack"} y se anuncia en .../capacidades
+#define DEFAULT_CODIFICACION CODIFICACION_JSON
+
+// Ritmo máximo de publicación (lo que aguanta el enlace TLS sin atascarse)
+#define MQTT_MENSAJES_POR_SEGUNDO  10
+#define MQTT_RAFAGA                8
+
+// ==========================================
+// BAJO CONSUMO (instalaciones solares)
+// ==========================================
+// Con la pantalla apagada el control duerme (light sleep) hasta el próximo
+// cambio del horario, un botón o un comando de la red. 0 = siempre despierto.
+#define BAJO_CONSUMO        1
+#define REPOSO_RED_MS       100  // Sondeo MQTT en reposo (del orden del beacon DTIM)
 
 #endif
\ No newline at end of file
@@ -9,9 +9,17 @@
 // Configuración Global
 #include "Config.h"
 
+// HAL (implementación ESP32)
+#include "hal/Hal.h"
+#include "hal/esp32/RtcHalDs3231.h"
+#include "hal/esp32/PantallaSsd1306.h"
+#include "hal/esp32/MqttPubSub.h"
+
 // TUS CLASES
 #include "objects/Bomba.h"
 #include "objects/BombaConfig.h"
+#include "objects/AlmacenRegistros.h"
+#include "objects/DiarioRiego.h"
 #include "objects/Boton.h"
 #include "objects/OLED.h"
 #include "objects/Potenciometro.h"
@@ -22,6 +30,10 @@
 #include "manager/NetworkManager.h"
 #include "manager/ConfigManager.h"
 #include "manager/BombaManager.h"
+#include "manager/Planificador.h"
+#include "manager/Perfilador.h"
+#include "manager/SensorManager.h"
+#include "manager/MonitorCorriente.h"
 
 // ==========================================
 // DECLARACIÓN EXTERNA (El Catálogo)
@@ -31,16 +43,28 @@
 extern Adafruit_SSD1306 oledRef;
 extern RtcDS3231<TwoWire> Rtc;
 
-extern Bomba bomba;
-extern BombaConfig configBomba; 
+extern RtcHalDs3231 rtcHal;
+extern PantallaSsd1306 pantalla;
+extern MqttPubSub mqtt;
+
+extern Bomba bombas[NUM_ZONAS];
+extern BombaConfig configsZonas[NUM_ZONAS]; 
+extern AlmacenRegistros almacen;
+extern DiarioRiego diario;
 extern ConfigManager configManager;
 extern BombaManager bombaManager; 
+extern Planificador planificador;
+extern Perfilador perfilador;
 extern Boton botonBomba;
 extern Boton botonManual;
 extern Potenciometro pot;
 extern OLED oled; 
 extern Reloj reloj;
+extern SensorManager sensores;
+extern MonitorCorriente monitorBomba;
 
+extern ColaComandos colaComandos;
+extern ColaEventos colaEventos;
 extern NetworkManager network;
 
 extern MenuBomba menuBomba;
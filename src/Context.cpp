@@ -7,18 +7,47 @@
 Adafruit_SSD1306 oledRef(OLED_WIDTH, OLED_HEIGHT, &Wire, -1);
 RtcDS3231<TwoWire> Rtc(Wire);
 
-Bomba bomba(PIN_BOMBA);
-BombaConfig configBomba; 
-Boton botonManual(PIN_BOTON_MANUAL);
-ConfigManager configManager(configBomba);
-BombaManager bombaManager(bomba, configBomba, Rtc, botonManual); 
+RtcHalDs3231 rtcHal(Rtc);
+PantallaSsd1306 pantalla(oledRef, OLED_ADDR);
+MqttPubSub mqtt;
+
+Bomba bombas[NUM_ZONAS] = BOMBAS_ZONAS;
+BombaConfig configsZonas[NUM_ZONAS]; 
+Boton botonManual(PIN_BOTON_MANUAL, 400); // Con doble click
+AlmacenRegistros almacen;                 // Partición "cfglog" (partitions.csv)
+DiarioRiego diario;                       // Partición "diario"
+ConfigManager configManager(configsZonas, NUM_ZONAS, almacen);
+BombaManager bombaManager(bombas, NUM_ZONAS, configManager, rtcHal, botonManual, diario);
+Planificador planificador;
+Perfilador perfilador;
 Boton botonBomba(PIN_BOTON_BOMBA);
 Potenciometro pot(PIN_POT);
-OLED oled(oledRef, 7000); 
-Reloj reloj(Rtc, oled);
+OLED oled(pantalla, 7000); 
+Reloj reloj(rtcHal, oled, PIN_RTC_SQW);
+
+// Transductores de la línea principal: protegen todas las zonas
+const CanalSensor canalesSensores[] = {
+//   nombre     pin          fondo          mínimo        máximo        zonas
+    {"presion", PIN_PRESION, PRESION_FONDO, PRESION_MIN,  PRESION_MAX,  0xFFFF},
+    {"caudal",  PIN_CAUDAL,  CAUDAL_FONDO,  CAUDAL_MIN,   CAUDAL_MAX,   0xFFFF},
+};
+SensorManager sensores(canalesSensores, 2, bombaManager, SENSORES_HZ);
+// La tarea drena cada SENSORES_MS regando y cada REPOSO_SENSORES_MS en reposo
+static_assert(SENSORES_MS <= hal::ADC_TRAMA_MS, "una trama del ADC debe cubrir un drenado");
+static_assert(REPOSO_SENSORES_MS <= hal::ADC_ESPERA_MAX_MS, "el pool del ADC no aguanta el reposo");
+
+// Transformador de corriente de la bomba (zona 1)
+const LimitesCorriente limitesBomba = {
+    CORRIENTE_MA_CUENTA, CORRIENTE_MIN_MA, CORRIENTE_MAX_MA, CORRIENTE_BLOQUEO_MA, ARRANQUE_BOMBA_MS
+};
+MonitorCorriente monitorBomba(bombas[0], 0, bombaManager, PIN_CORRIENTE, limitesBomba, SENSORES_HZ, RED_HZ);
+
+// Colas entre el núcleo de red (0) y el de control (1)
+ColaComandos colaComandos;
+ColaEventos colaEventos;
 
 // Pasamos 'oled' al NetworkManager
-NetworkManager network(oled, configManager);
+NetworkManager network(oled, configManager, mqtt, colaComandos, colaEventos, diario, perfilador);
 
 MenuBomba menuBomba(oled, botonBomba, pot, configManager);
 MenuReloj menuReloj(oled, botonBomba, pot, reloj); 
@@ -31,25 +60,25 @@ void initSystem() {
     Serial.begin(115200);
 
     // 1. Hardware Básico
-    bomba.iniciar();
+    for (int z = 0; z < NUM_ZONAS; z++) bombas[z].iniciar();
     Wire.begin(PIN_SDA, PIN_SCL); 
     
-    if(!oledRef.begin(SSD1306_SWITCHCAPVCC, OLED_ADDR)) { 
+    if(!pantalla.iniciar()) { 
         Serial.println(F("Fallo OLED"));
     }
     
+    analogReadResolution(10); // Antes del muestreo en segundo plano del pot
     pot.iniciar();
+    sensores.iniciar();       // Mismo ADC continuo, a SENSORES_HZ (en pausa sin riego)
+    monitorBomba.iniciar();
     botonBomba.iniciar();
     botonManual.iniciar();
-    Rtc.Begin();
+    rtcHal.iniciar();
+    reloj.iniciar();          // Fase del segundo + SQW; desde aquí nadie lee el DS3231
+    hal::eepromIniciar(EEPROM_SIZE);  // Solo para migrar la config antigua
     configManager.iniciar();
-    analogReadResolution(10); 
+    if (!diario.iniciar()) Serial.println(F("Sin particion 'diario': no se guarda historial"));
 
     // 2. Iniciar Red (WiFiManager + MQTT)
     network.iniciar();
-
-    // 3. Configurar RTC
-    RtcDateTime compiled = RtcDateTime(__DATE__, __TIME__);
-    if (!Rtc.IsDateTimeValid()) Rtc.SetDateTime(compiled);
-    if (!Rtc.GetIsRunning()) Rtc.SetIsRunning(true);
 }
\ No newline at end of file
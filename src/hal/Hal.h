@@ -0,0 +1,135 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Funciones que corren en una ISR: en ESP32 deben vivir en IRAM para
+// seguir funcionando mientras la caché de flash está apagada.
+#if defined(ESP_PLATFORM)
+#include <esp_attr.h>
+#define HAL_ISR IRAM_ATTR
+#else
+#define HAL_ISR
+#endif
+
+// ==========================================
+// CAPA DE ABSTRACCIÓN DE HARDWARE (HAL)
+// ==========================================
+// Todo el código de control (objects/, manager/, menu/) habla con el
+// hardware SOLO a través de estas funciones. Hay dos implementaciones:
+//   - hal/esp32/  : Arduino-ESP32 (placa real)
+//   - hal/native/ : simulación en Linux ([env:native] de PlatformIO)
+
+namespace hal {
+
+    // --- Niveles y modos de pin (independientes de Arduino) ---
+    enum Nivel : uint8_t {
+        BAJO = 0,
+        ALTO = 1
+    };
+
+    enum ModoPin : uint8_t {
+        ENTRADA,
+        ENTRADA_PULLUP,
+        SALIDA
+    };
+
+    // --- GPIO ---
+    void pinModo(int pin, ModoPin modo);
+    void escribir(int pin, Nivel nivel);
+    Nivel leer(int pin);
+
+    // Interrupción por cambio de nivel. 'alCambiar' corre en la ISR con el
+    // nivel nuevo y el micros() del flanco: corta, sin bloqueos y HAL_ISR.
+    typedef void (*CallbackFlanco)(void* ctx, Nivel nivel, uint32_t us);
+    bool interrupcionPin(int pin, CallbackFlanco alCambiar, void* ctx);
+
+    // --- ADC ---
+    int leerAnalogico(int pin);         // 0-1023 (resolución de 10 bits)
+
+    // ADC continuo: el hardware convierte en segundo plano (DMA en ESP32) y
+    // deja las muestras (0-1023) de cada pin en su propio anillo. Cada pin
+    // pedido con adcContinuoIniciar() es un canal más (todos en el arranque,
+    // antes de leer; repetir un pin solo cambia su ritmo): el ADC va al
+    // ritmo del más rápido y los lentos se quedan con una de cada k tramas.
+    // adcContinuoLeer() drena hasta 'max' muestras de ese pin y nunca
+    // bloquea; cada pin tiene un único lector, y cada lector un anillo de
+    // ADC_ANILLO muestras de margen antes de perder las más nuevas.
+    // El hardware entrega tramas de ADC_TRAMA_MS (lo que un lector activo
+    // deja entre drenados) y guarda ADC_ESPERA_MAX_MS sin que nadie lea.
+    static const uint8_t ADC_CANALES = 4;
+    static const uint16_t ADC_ANILLO = 512;
+    static const uint16_t ADC_TRAMA_MS = 2;
+    static const uint16_t ADC_ESPERA_MAX_MS = 50;
+    bool adcContinuoIniciar(int pin, uint16_t muestrasPorSegundo);
+    size_t adcContinuoLeer(int pin, uint16_t* destino, size_t max);
+    uint32_t adcContinuoPerdidas(int pin);  // Muestras tiradas por el hardware o sin sitio en el anillo
+    // Un canal en pausa no se convierte: el ADC sigue al ritmo del más
+    // rápido de los demás y, sin ninguno, se para del todo (ni temporizador
+    // ni DMA: el chip puede entrar en light sleep). Lo lleva su lector: al
+    // pausar se tira lo que quedaba en el anillo y al reanudar llegan
+    // muestras desde ese momento. Repetir el mismo estado no cuesta nada.
+    bool adcContinuoPausar(int pin, bool pausado);
+
+    // --- Reloj del sistema ---
+    unsigned long millis();
+    unsigned long micros();
+    void esperar(unsigned long ms);     // Equivalente a delay()
+
+    // Disparo único a 'us' microsegundos vista (esp_timer en ESP32). Hay
+    // uno solo: programarlo de nuevo sustituye al pendiente. 'alVencer'
+    // corre en la tarea del temporizador, no en la ISR: puede escribir GPIO
+    // y llamar a despertar(), pero debe ser corto y no bloquear.
+    typedef void (*CallbackDisparo)(void* ctx);
+    bool disparoProgramar(uint64_t us, CallbackDisparo alVencer, void* ctx);
+    void disparoCancelar();
+
+    // --- Bajo consumo ---
+    // dormir() bloquea la tarea hasta 'ms' o hasta que la despierte un pin
+    // registrado con despertarConPin() o una llamada a despertar() desde
+    // otra tarea; devuelve true si la despertaron antes de tiempo. En la
+    // placa, con bajoConsumoIniciar() el chip entra solo en light sleep
+    // mientras todas las tareas están bloqueadas (la WiFi sigue asociada).
+    bool bajoConsumoIniciar();          // false: sin light sleep (dormir() solo bloquea)
+    bool despertarConPin(int pin);      // El pin ya debe tener interrupcionPin()
+    bool dormir(unsigned long ms);
+    void despertar();
+
+    // --- Consola ---
+    void log(const char* msg);          // Línea completa (añade salto)
+
+    // --- EEPROM ---
+    void eepromIniciar(size_t tamanio);
+    void eepromLeer(int direccion, void* destino, size_t len);
+    void eepromEscribir(int direccion, const void* origen, size_t len);
+    bool eepromConfirmar();             // commit() en ESP32
+
+    // --- Particiones de flash propias ---
+    // Vistas como NOR: se borran por sectores enteros (quedan a 0xFF) y
+    // escribir solo puede pasar bits de 1 a 0. Direcciones relativas al
+    // inicio de cada partición (ver partitions.csv).
+    enum ParticionFlash : uint8_t {
+        FLASH_CONFIG,   // "cfglog": almacén de registros de configuración
+        FLASH_DIARIO    // "diario": historial de riego pendiente de subir
+    };
+    static const size_t FLASH_SECTOR = 4096;
+    size_t flashSectores(ParticionFlash particion);    // 0 si no existe
+    bool flashLeer(ParticionFlash particion, uint32_t direccion, void* destino, size_t len);
+    bool flashEscribir(ParticionFlash particion, uint32_t direccion, const void* origen, size_t len);
+    bool flashBorrarSector(ParticionFlash particion, size_t sector);
+
+    // --- Red ---
+    bool wifiConectado();
+
+    // Datos pequeños del núcleo de red (NVS en la placa, con su propio
+    // reparto de desgaste): p.ej. la sesión TLS. Se pueden usar desde
+    // cualquier tarea; escribir solo cuando cambian.
+    size_t nvsLeer(const char* clave, void* destino, size_t max);   // 0 si no hay
+    bool nvsEscribir(const char* clave, const void* datos, size_t len);
+
+    // Helpers tipados para no pelear con sizeof en cada llamada
+    template <typename T>
+    inline void eepromGet(int direccion, T& valor) { eepromLeer(direccion, &valor, sizeof(T)); }
+
+    template <typename T>
+    inline void eepromPut(int direccion, const T& valor) { eepromEscribir(direccion, &valor, sizeof(T)); }
+}
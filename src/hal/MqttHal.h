@@ -0,0 +1,56 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <functional>
+
+// Cómo va una conexión pedida con empezarConexion()
+enum ProgresoConexion : uint8_t {
+    CONEXION_EN_CURSO,
+    CONEXION_LISTA,
+    CONEXION_FALLIDA
+};
+
+// Handshakes TLS desde el arranque (solo transportes con TLS)
+struct EstadisticasTls {
+    uint32_t completos = 0;     // Intercambio de claves entero
+    uint32_t reanudados = 0;    // Con la sesión guardada (ticket o ID)
+    uint32_t msCompleto = 0;    // Lo que tardó el último de cada tipo
+    uint32_t msReanudado = 0;
+};
+
+// ==========================================
+// TRANSPORTE MQTT (PubSubClient o loopback)
+// ==========================================
+class MqttHal {
+    private:
+        bool ultimaConexion = false;
+
+    public:
+        typedef std::function<void(char* topic, uint8_t* payload, unsigned int length)> Callback;
+
+        virtual ~MqttHal() {}
+
+        virtual void configurar(const char* servidor, uint16_t puerto) = 0;
+        virtual void setCallback(Callback cb) = 0;
+        virtual bool conectar(const char* clientId, const char* usuario, const char* clave) = 0;
+        virtual bool conectado() = 0;
+        virtual int estado() = 0;     // Código de error del cliente (rc)
+        virtual bool suscribir(const char* topic) = 0;
+        // Payload binario (JSON o MessagePack): siempre con longitud
+        virtual bool publicar(const char* topic, const uint8_t* payload, size_t len, bool retenido) = 0;
+        virtual void procesar() = 0;  // Equivalente a client.loop()
+
+        // Conexión sin bloquear a quien la pide. Mientras progresoConexion()
+        // sea EN_CURSO no se puede tocar el cliente (ni conectado()) y los
+        // textos tienen que seguir vivos. Por defecto es síncrona.
+        virtual bool empezarConexion(const char* clientId, const char* usuario, const char* clave) {
+            ultimaConexion = conectar(clientId, usuario, clave);
+            return true;
+        }
+        virtual ProgresoConexion progresoConexion() {
+            return ultimaConexion ? CONEXION_LISTA : CONEXION_FALLIDA;
+        }
+
+        // nullptr si el transporte no usa TLS
+        virtual const EstadisticasTls* tls() const { return nullptr; }
+};
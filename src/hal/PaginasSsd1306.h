@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// ==========================================
+// DIFERENCIAS ENTRE CUADROS DEL SSD1306
+// ==========================================
+// La RAM del SSD1306 se organiza en páginas de 8 filas de píxeles; cada
+// byte es una columna de esa página. Para no mandar los 1024 bytes en
+// cada volcado se compara con el último cuadro enviado y, por página,
+// se envía solo la ventana [col0, col1] que cambió.
+namespace ssd1306 {
+
+    static const uint8_t ANCHO = 128;
+    static const uint8_t PAGINAS = 8;                // 64 px de alto
+    static const uint16_t BYTES_CUADRO = ANCHO * PAGINAS;
+
+    // Coste de abrir una ventana: control + PAGEADDR(3) + COLUMNADDR(3)
+    // en una transacción, más el byte de control de los datos.
+    static const uint8_t BYTES_VENTANA = 8;
+
+    struct Ventana {
+        uint8_t pagina;
+        uint8_t col0;
+        uint8_t col1;       // Inclusive
+    };
+
+    // Devuelve cuántas ventanas sucias hay (como mucho PAGINAS)
+    inline uint8_t ventanasSucias(const uint8_t* actual, const uint8_t* previo, Ventana* ventanas) {
+        uint8_t n = 0;
+        for (uint8_t p = 0; p < PAGINAS; p++) {
+            const uint8_t* a = actual + p * ANCHO;
+            const uint8_t* b = previo + p * ANCHO;
+            int c0 = 0;
+            while (c0 < ANCHO && a[c0] == b[c0]) c0++;
+            if (c0 == ANCHO) continue;
+            int c1 = ANCHO - 1;
+            while (a[c1] == b[c1]) c1--;
+            ventanas[n].pagina = p;
+            ventanas[n].col0 = (uint8_t)c0;
+            ventanas[n].col1 = (uint8_t)c1;
+            n++;
+        }
+        return n;
+    }
+}
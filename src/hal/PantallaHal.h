@@ -0,0 +1,21 @@
+#pragma once
+#include <stdint.h>
+
+// ==========================================
+// PANTALLA DE TEXTO (SSD1306 o consola)
+// ==========================================
+// Coordenadas en píxeles, igual que Adafruit_GFX.
+class PantallaHal {
+    public:
+        virtual ~PantallaHal() {}
+
+        virtual bool iniciar() = 0;
+        virtual void limpiar() = 0;
+        virtual void escribir(int16_t x, int16_t y, const char* msg) = 0;
+        virtual void volcar() = 0;    // Enviar al panel lo que cambió
+        virtual void encender() = 0;
+        virtual void apagar() = 0;
+
+        // Bytes mandados al panel desde el arranque (datos + comandos)
+        virtual uint32_t bytesEnviados() const { return 0; }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#ifdef HAL_NATIVE
+#include "native/RtcDateTime.h"   // Reimplementación mínima para el host
+#else
+#include <Wire.h>
+#include <RtcDS3231.h>            // makuna/RTC (trae RtcDateTime)
+#endif
+
+// ==========================================
+// RELOJ DE TIEMPO REAL (DS3231 o simulado)
+// ==========================================
+class RtcHal {
+    public:
+        virtual ~RtcHal() {}
+
+        virtual void iniciar() = 0;
+        virtual RtcDateTime leer() = 0;
+        virtual void escribir(const RtcDateTime& fechaHora) = 0;
+        virtual bool esValida() = 0;
+
+        // Saca 1 Hz por el pin SQW (bajada = cambio de segundo). false si no hay.
+        virtual bool activarPulsoSegundo() { return false; }
+};
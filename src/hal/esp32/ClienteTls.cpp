@@ -0,0 +1,362 @@
+#include "ClienteTls.h"
+#include <Arduino.h>
+#include <atomic>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <mbedtls/version.h>
+#include <lwip/dns.h>
+#include <lwip/tcpip.h>
+#include <lwip/sockets.h>
+#include "../Hal.h"
+
+// mbedTLS 3 (Arduino-ESP32 3.x) esconde los campos de las estructuras
+#ifndef MBEDTLS_PRIVATE
+#define MBEDTLS_PRIVATE(campo) campo
+#endif
+
+static const char* CLAVE_NVS = "sesionTls";
+static const unsigned long ESPERA_ESCRITURA_MS = 5000;
+static const uint32_t MAX_POLL_MS = 100;       // Tope de cada espera del handshake
+
+ClienteTls::ClienteTls() {
+    mbedtls_net_init(&red);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_session_init(&sesion);
+}
+
+ClienteTls::~ClienteTls() {
+    stop();
+    mbedtls_ssl_session_free(&sesion);
+    if (aleatorioListo) {
+        mbedtls_ctr_drbg_free(&aleatorio);
+        mbedtls_entropy_free(&entropia);
+    }
+}
+
+bool ClienteTls::prepararAleatorio() {
+    if (aleatorioListo) return true;
+    mbedtls_entropy_init(&entropia);
+    mbedtls_ctr_drbg_init(&aleatorio);
+    static const char semilla[] = "riego-tls";
+    if (mbedtls_ctr_drbg_seed(&aleatorio, mbedtls_entropy_func, &entropia,
+                              (const unsigned char*)semilla, sizeof(semilla)) != 0) {
+        mbedtls_ctr_drbg_free(&aleatorio);
+        mbedtls_entropy_free(&entropia);
+        return false;
+    }
+    aleatorioListo = true;
+    return true;
+}
+
+// ======================================================
+// SESIÓN (RAM + NVS)
+// ======================================================
+// Se carga una vez, en la primera conexión tras arrancar
+void ClienteTls::cargarSesion() {
+    if (sesionCargada) return;
+    sesionCargada = true;
+
+    static uint8_t buffer[MAX_SESION];
+    size_t len = hal::nvsLeer(CLAVE_NVS, buffer, sizeof(buffer));
+    if (len > 0 && mbedtls_ssl_session_load(&sesion, buffer, len) == 0) haySesion = true;
+}
+
+// Se guarda en la NVS solo tras un handshake completo (sesión nueva); tras
+// una reanudación basta con refrescar la de RAM (puede traer ticket nuevo)
+void ClienteTls::guardarSesion(mbedtls_ssl_session& nueva, bool persistir) {
+    mbedtls_ssl_session_free(&sesion);
+    sesion = nueva;     // Se queda con lo que reservó 'nueva'
+    mbedtls_ssl_session_init(&nueva);
+    haySesion = true;
+
+    if (!persistir) return;
+    static uint8_t buffer[MAX_SESION];
+    size_t len = 0;
+    if (mbedtls_ssl_session_save(&sesion, buffer, sizeof(buffer), &len) == 0) {
+        hal::nvsEscribir(CLAVE_NVS, buffer, len);
+    }
+}
+
+void ClienteTls::olvidarSesion() {
+    mbedtls_ssl_session_free(&sesion);
+    mbedtls_ssl_session_init(&sesion);
+    haySesion = false;
+    uint8_t nada = 0;
+    hal::nvsEscribir(CLAVE_NVS, &nada, sizeof(nada));   // No carga: cuenta como vacía
+}
+
+// El broker no quiere la sesión: manda una alerta fatal o, si la acepta
+// pero no casa con lo que guardamos, falla el Finished. Un RST, un fallo
+// de recv() o el plazo agotado no dicen nada de ella y se vuelve a ofrecer.
+static bool sesionRechazada(int r) {
+    return r == MBEDTLS_ERR_SSL_FATAL_ALERT_MESSAGE ||
+           r == MBEDTLS_ERR_SSL_INVALID_MAC;
+}
+
+// ======================================================
+// DNS Y TCP CON PLAZO
+// ======================================================
+// mbedtls_net_connect() resuelve con getaddrinfo() y conecta bloqueando,
+// sin más límite que los reintentos de lwIP (~14 s el DNS, más de un
+// minuto los SYN). Aquí el nombre se pide con la API asíncrona de lwIP y
+// el socket se abre no bloqueante: todo cabe en el plazo de connect().
+//
+// La respuesta del DNS puede llegar después del plazo: la consulta vive
+// aquí (no en la pila) y lleva número, y la tarea de lwIP descarta lo que
+// no sea de la última.
+struct ConsultaDns {
+    char host[80];
+    ip_addr_t ip;
+    bool ok;
+    std::atomic<uint32_t> numero{0};       // La que espera connect()
+    std::atomic<uint32_t> resuelta{0};     // La última con respuesta (ok / ip)
+};
+static ConsultaDns consultaDns;
+
+// En la tarea de lwIP (las dos)
+static void alResolverDns(const char*, const ip_addr_t* ip, void* arg) {
+    uint32_t n = (uint32_t)(uintptr_t)arg;
+    if (n != consultaDns.numero.load(std::memory_order_acquire)) return;   // Llegó tarde
+    consultaDns.ok = ip != nullptr && IP_IS_V4(ip);
+    if (consultaDns.ok) consultaDns.ip = *ip;
+    consultaDns.resuelta.store(n, std::memory_order_release);
+}
+
+static void pedirDns(void* arg) {
+    uint32_t n = (uint32_t)(uintptr_t)arg;
+    if (n != consultaDns.numero.load(std::memory_order_acquire)) return;
+    ip_addr_t ip;
+    err_t r = dns_gethostbyname(consultaDns.host, &ip, alResolverDns, arg);
+    if (r == ERR_OK) alResolverDns(nullptr, &ip, arg);              // IP literal o en caché
+    else if (r != ERR_INPROGRESS) alResolverDns(nullptr, nullptr, arg);
+}
+
+static long msHasta(unsigned long limite) {
+    return (long)(limite - ::millis());
+}
+
+static bool resolver(const char* host, unsigned long limite, uint32_t& ipv4) {
+    uint32_t n = consultaDns.numero.load(std::memory_order_relaxed) + 1;
+    if (n == 0) n = 1;
+    strncpy(consultaDns.host, host, sizeof(consultaDns.host) - 1);
+    consultaDns.host[sizeof(consultaDns.host) - 1] = '\0';
+    consultaDns.numero.store(n, std::memory_order_release);
+
+    if (tcpip_callback(pedirDns, (void*)(uintptr_t)n) != ERR_OK) return false;
+    while (consultaDns.resuelta.load(std::memory_order_acquire) != n) {
+        if (msHasta(limite) <= 0) return false;
+        ::delay(5);
+    }
+    if (!consultaDns.ok) return false;
+    ipv4 = ip4_addr_get_u32(ip_2_ip4(&consultaDns.ip));
+    return true;
+}
+
+// Socket TCP ya conectado (y no bloqueante) o -1
+static int conectarTcp(uint32_t ipv4, uint16_t puerto, unsigned long limite) {
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    sockaddr_in destino = {};
+    destino.sin_family = AF_INET;
+    destino.sin_port = htons(puerto);
+    destino.sin_addr.s_addr = ipv4;
+    if (::connect(fd, (sockaddr*)&destino, sizeof(destino)) != 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+
+    // Conectado = se puede escribir; el resultado real queda en SO_ERROR
+    long queda = msHasta(limite);
+    if (queda <= 0) queda = 0;
+    fd_set escritura;
+    FD_ZERO(&escritura);
+    FD_SET(fd, &escritura);
+    timeval espera = { queda / 1000, (queda % 1000) * 1000 };
+    int error = 0;
+    socklen_t largo = sizeof(error);
+    if (select(fd + 1, NULL, &escritura, NULL, &espera) <= 0 ||
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &largo) != 0 || error != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// ======================================================
+// CONEXIÓN
+// ======================================================
+int ClienteTls::connect(IPAddress ip, uint16_t port) {
+    return connect(ip.toString().c_str(), port);
+}
+
+int ClienteTls::connect(const char* host, uint16_t port) {
+    stop();
+    if (!prepararAleatorio()) return 0;
+    cargarSesion();
+
+    // Un solo plazo para DNS, TCP y handshake
+    unsigned long inicio = ::millis();
+    unsigned long limite = inicio + plazoConexionMs;
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) != 0) {
+        return 0;
+    }
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &aleatorio);
+#if MBEDTLS_VERSION_MAJOR >= 3
+    mbedtls_ssl_conf_max_tls_version(&conf, MBEDTLS_SSL_VERSION_TLS1_2);
+#else
+    mbedtls_ssl_conf_max_version(&conf, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
+#endif
+#if defined(MBEDTLS_SSL_SESSION_TICKETS)
+    mbedtls_ssl_conf_session_tickets(&conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#endif
+
+    uint32_t ipv4;
+    if (mbedtls_ssl_setup(&ssl, &conf) != 0 ||
+        mbedtls_ssl_set_hostname(&ssl, host) != 0 ||
+        !resolver(host, limite, ipv4) ||
+        (red.fd = conectarTcp(ipv4, port, limite)) < 0) {
+        cerrar();
+        return 0;
+    }
+    mbedtls_ssl_set_bio(&ssl, &red, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    // Se ofrece la sesión guardada; si el broker no la quiere hace uno completo
+    bool ofrecida = haySesion && mbedtls_ssl_set_session(&ssl, &sesion) == 0;
+
+    int r;
+    while ((r = mbedtls_ssl_handshake(&ssl)) != 0) {
+        bool esperar = r == MBEDTLS_ERR_SSL_WANT_READ || r == MBEDTLS_ERR_SSL_WANT_WRITE;
+        long queda = msHasta(limite);
+        if (!esperar || queda <= 0) {
+            // Solo la sesión que el broker rechaza deja de ofrecerse
+            if (ofrecida && sesionRechazada(r)) olvidarSesion();
+            cerrar();
+            return 0;
+        }
+        // Hasta que el socket esté listo (o se acabe el plazo), sin girar en vacío
+        mbedtls_net_poll(&red, r == MBEDTLS_ERR_SSL_WANT_READ ? MBEDTLS_NET_POLL_READ : MBEDTLS_NET_POLL_WRITE,
+                         (uint32_t)queda < MAX_POLL_MS ? (uint32_t)queda : MAX_POLL_MS);
+    }
+
+    // Reanudada = mismo master secret que la sesión ofrecida (mbedTLS 3
+    // solo deja pedir la sesión una vez por conexión)
+    mbedtls_ssl_session nueva;
+    mbedtls_ssl_session_init(&nueva);
+    bool obtenida = mbedtls_ssl_get_session(&ssl, &nueva) == 0;
+    bool reanudada = ofrecida && obtenida &&
+                     memcmp(nueva.MBEDTLS_PRIVATE(master), sesion.MBEDTLS_PRIVATE(master),
+                            sizeof(nueva.MBEDTLS_PRIVATE(master))) == 0;
+
+    unsigned long ms = ::millis() - inicio;
+    if (reanudada) {
+        estadisticas.reanudados++;
+        estadisticas.msReanudado = ms;
+    } else {
+        estadisticas.completos++;
+        estadisticas.msCompleto = ms;
+    }
+    if (obtenida) guardarSesion(nueva, !reanudada);
+    mbedtls_ssl_session_free(&nueva);
+
+    abierto = true;
+    return 1;
+}
+
+void ClienteTls::cerrar() {
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_net_free(&red);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_net_init(&red);
+    abierto = false;
+    asomado = -1;
+}
+
+void ClienteTls::stop() {
+    if (abierto) mbedtls_ssl_close_notify(&ssl);
+    cerrar();
+}
+
+// ======================================================
+// DATOS
+// ======================================================
+size_t ClienteTls::write(uint8_t b) {
+    return write(&b, 1);
+}
+
+size_t ClienteTls::write(const uint8_t* buf, size_t size) {
+    if (!abierto) return 0;
+    size_t enviados = 0;
+    unsigned long inicio = ::millis();
+    while (enviados < size) {
+        int r = mbedtls_ssl_write(&ssl, buf + enviados, size - enviados);
+        if (r > 0) {
+            enviados += r;
+        } else if (r == MBEDTLS_ERR_SSL_WANT_WRITE || r == MBEDTLS_ERR_SSL_WANT_READ) {
+            if (::millis() - inicio > ESPERA_ESCRITURA_MS) break;
+            ::delay(1);
+        } else {
+            cerrar();
+            break;
+        }
+    }
+    return enviados;
+}
+
+int ClienteTls::available() {
+    if (!abierto) return 0;
+    int pendientes = asomado >= 0 ? 1 : 0;
+
+    // Lee el siguiente registro si lo hay, sin bloquear
+    int r = mbedtls_ssl_read(&ssl, NULL, 0);
+    if (r < 0 && r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        cerrar();
+        return pendientes;
+    }
+    return pendientes + mbedtls_ssl_get_bytes_avail(&ssl);
+}
+
+int ClienteTls::read() {
+    uint8_t b;
+    return read(&b, 1) == 1 ? b : -1;
+}
+
+int ClienteTls::read(uint8_t* buf, size_t size) {
+    if (size == 0) return 0;
+    size_t leidos = 0;
+    if (asomado >= 0) {
+        buf[leidos++] = (uint8_t)asomado;
+        asomado = -1;
+    }
+    if (!abierto || leidos == size) return leidos ? (int)leidos : -1;
+
+    int r = mbedtls_ssl_read(&ssl, buf + leidos, size - leidos);
+    if (r > 0) {
+        leidos += r;
+    } else if (r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+        cerrar();   // 0 = close_notify del broker
+    }
+    return leidos ? (int)leidos : -1;
+}
+
+int ClienteTls::peek() {
+    if (asomado < 0) {
+        uint8_t b;
+        if (abierto && mbedtls_ssl_read(&ssl, &b, 1) == 1) asomado = b;
+    }
+    return asomado;
+}
+
+void ClienteTls::flush() {}
+
+uint8_t ClienteTls::connected() {
+    if (abierto) available();   // Detecta el cierre del otro lado
+    return abierto || asomado >= 0;
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <Client.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include "../MqttHal.h"
+
+// ==========================================
+// CLIENTE TLS CON REANUDACIÓN DE SESIÓN
+// ==========================================
+// Sustituye a WiFiClientSecure bajo PubSubClient. Guarda la sesión TLS
+// (ticket o ID, lo que dé el broker) en RAM y en la NVS, y la ofrece en
+// cada reconexión: si el broker la acepta se ahorra el intercambio de
+// claves (ECDHE + certificado), que en el ESP32 son cientos de ms de CPU
+// y varios viajes de ida y vuelta.
+//
+// DNS, TCP y handshake comparten un plazo (setHandshakeTimeout): nada de
+// connect() bloquea más allá.
+// Como setInsecure(): no se verifica el certificado del broker.
+// Solo TLS 1.2: la reanudación se detecta porque el master secret es el
+// de la sesión guardada.
+class ClienteTls : public Client {
+    private:
+        static const size_t MAX_SESION = 2048;  // Sesión serializada (con certificado)
+
+        mbedtls_net_context red;
+        mbedtls_ssl_context ssl;
+        mbedtls_ssl_config conf;
+        mbedtls_entropy_context entropia;
+        mbedtls_ctr_drbg_context aleatorio;
+        bool aleatorioListo = false;
+        bool abierto = false;
+        int asomado = -1;               // Byte de peek() pendiente
+
+        mbedtls_ssl_session sesion;     // La última buena (si haySesion)
+        bool haySesion = false;
+        bool sesionCargada = false;
+
+        unsigned long plazoConexionMs = 15000;  // DNS + TCP + handshake
+        EstadisticasTls estadisticas;
+
+        bool prepararAleatorio();
+        void cargarSesion();
+        void guardarSesion(mbedtls_ssl_session& nueva, bool persistir);
+        void cerrar();
+
+    public:
+        ClienteTls();
+        ~ClienteTls();
+
+        // Plazo de todo connect(), no solo del handshake (como en WiFiClientSecure)
+        void setHandshakeTimeout(unsigned long segundos) { plazoConexionMs = segundos * 1000; }
+        void olvidarSesion();
+        const EstadisticasTls& tls() const { return estadisticas; }
+
+        // --- Client ---
+        int connect(IPAddress ip, uint16_t port) override;
+        int connect(const char* host, uint16_t port) override;
+        size_t write(uint8_t b) override;
+        size_t write(const uint8_t* buf, size_t size) override;
+        int available() override;
+        int read() override;
+        int read(uint8_t* buf, size_t size) override;
+        int peek() override;
+        void flush() override;
+        void stop() override;
+        uint8_t connected() override;
+        operator bool() override { return connected(); }
+};
@@ -0,0 +1,595 @@
+#include "../Hal.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <Preferences.h>
+#include <WiFi.h>
+#include <esp_partition.h>
+#include <esp_pm.h>
+#include <esp_sleep.h>
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+#include <esp_timer.h>
+#include <esp_task.h>
+#include <string.h>
+#include <atomic>
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+#include <esp_adc/adc_continuous.h>
+#endif
+#include "../../objects/ColaSpsc.h"
+
+// Implementación de la HAL sobre Arduino-ESP32.
+// OJO: dentro de 'namespace hal' hay que llamar a las funciones de Arduino
+// con '::' para no llamarnos a nosotros mismos.
+
+// ==========================================
+// INTERRUPCIONES DE GPIO
+// ==========================================
+struct RegistroFlanco {
+    int pin;
+    hal::CallbackFlanco alCambiar;
+    void* ctx;
+    bool despierta;             // Saca al chip de light sleep (despertarConPin)
+};
+static const uint8_t MAX_FLANCOS = 8;
+static RegistroFlanco registrosFlanco[MAX_FLANCOS];
+static uint8_t numRegistrosFlanco = 0;
+
+// ==========================================
+// BAJO CONSUMO
+// ==========================================
+// La tarea que duerme espera una notificación de FreeRTOS; con la gestión
+// de energía activa, el idle mete el chip en light sleep. El ESP32 solo
+// sale de light sleep por GPIO con interrupción por NIVEL: mientras se
+// duerme, cada pin de despertar espera el nivel contrario al que tenía
+// (su próximo flanco) y al volver recupera el CHANGE de siempre.
+static TaskHandle_t tareaDormida = nullptr;
+static volatile bool despertadoresArmados = false;
+
+static void IRAM_ATTR isrFlanco(void* arg) {
+    RegistroFlanco* r = static_cast<RegistroFlanco*>(arg);
+    hal::Nivel nivel = ::digitalRead(r->pin) == HIGH ? hal::ALTO : hal::BAJO;
+    r->alCambiar(r->ctx, nivel, (uint32_t)::micros());
+
+    if (r->despierta && despertadoresArmados) {
+        gpio_ll_intr_disable(&GPIO, r->pin);   // Por nivel se repetiría mientras siga pulsado
+        BaseType_t cambio = pdFALSE;
+        if (tareaDormida) vTaskNotifyGiveFromISR(tareaDormida, &cambio);
+        if (cambio) portYIELD_FROM_ISR();
+    }
+}
+
+// ==========================================
+// DISPARO ÚNICO
+// ==========================================
+// Un esp_timer de un solo disparo. Su callback corre en la tarea
+// "esp_timer" (prioridad máxima, núcleo 0), que sale de light sleep sola:
+// el flanco llega con la latencia de despertar (~1 ms), sin sondear.
+static esp_timer_handle_t temporizadorDisparo = nullptr;
+static hal::CallbackDisparo disparoCallback = nullptr;
+static void* disparoCtx = nullptr;
+
+static void alVencerDisparo(void*) {
+    disparoCallback(disparoCtx);
+}
+
+// ==========================================
+// ADC CONTINUO
+// ==========================================
+// Core 3.x: el ADC_DIGI del IDF recorre todos los canales por DMA y deja
+// las conversiones en su pool. Cada trama cubre un drenado del lector
+// (ADC_TRAMA_MS) y el pool aguanta ADC_ESPERA_MAX_MS sin leer; si aun así
+// se llena, el driver tira la trama y se cuenta como perdida. Por debajo
+// del mínimo del ADC_DIGI se convierte más rápido y cada muestra es la
+// media de 'conversionesAdc' conversiones seguidas de su canal.
+// Core 2.x no expone el modo continuo: un temporizador hardware despierta
+// a una tarea propia que hace analogRead() (no la de esp_timer, que es la
+// que conmuta los relés a su hora; ni el bucle de control).
+// En ambos casos las muestras pasan a cada lector por su ColaSpsc.
+// Los canales en pausa salen del reparto; sin ninguno en marcha el driver
+// (o el temporizador) se para y suelta el cerrojo de energía: sin riego y
+// en reposo, el ADC no impide el light sleep.
+struct CanalAdc {
+    int pin;
+    uint16_t muestrasPorSegundo;
+    bool pausado;
+    bool enReparto;             // Convertido con la configuración en marcha
+    uint16_t paso;              // Se queda una de cada 'paso' muestras
+    uint16_t cuenta;
+    uint32_t suma;              // Conversiones de la muestra en curso
+    uint16_t sumadas;
+    uint32_t perdidasAntes;     // Del driver, en arranques anteriores
+    ColaSpsc<uint16_t, hal::ADC_ANILLO> anillo;
+};
+static CanalAdc canalesAdc[hal::ADC_CANALES];
+static uint8_t numCanalesAdc = 0;
+static bool adcEnMarcha = false;
+static uint16_t conversionesAdc = 1;            // Por muestra y canal
+static uint32_t conversionesPorTramaAdc = 1;    // De cada canal
+static std::atomic<uint32_t> tramasPerdidasAdc{0};
+
+// Quien reparte tramas lo coge sin esperar (si está ocupado, ya reparte
+// otro); rearrancar (pausar un canal desde otra tarea) espera a tenerlo.
+// Mutex y no atomic_flag: el que rearranca puede tener más prioridad.
+static SemaphoreHandle_t cerrojoAdc = nullptr;
+
+static CanalAdc* buscarCanalAdc(int pin) {
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        if (canalesAdc[c].pin == pin) return &canalesAdc[c];
+    }
+    return nullptr;
+}
+
+// Reparte una muestra: cada canal se queda con la suya si le toca
+static inline void repartirMuestraAdc(uint8_t canal, uint16_t muestra) {
+    CanalAdc& c = canalesAdc[canal];
+    if (++c.cuenta < c.paso) return;
+    c.cuenta = 0;
+    c.anillo.meter(muestra);
+}
+
+static inline void acumularConversionAdc(uint8_t canal, uint16_t valor) {
+    CanalAdc& c = canalesAdc[canal];
+    c.suma += valor;
+    if (++c.sumadas < conversionesAdc) return;
+    repartirMuestraAdc(canal, (uint16_t)(c.suma / c.sumadas));
+    c.suma = 0;
+    c.sumadas = 0;
+}
+
+// Muestras de 'c' en las tramas que no llegaron a los anillos
+static uint32_t perdidasDriverAdc(const CanalAdc& c) {
+    if (!c.enReparto) return c.perdidasAntes;  // Las tramas de ahora no son suyas
+    uint64_t conversiones = (uint64_t)tramasPerdidasAdc.load(std::memory_order_relaxed) * conversionesPorTramaAdc;
+    return c.perdidasAntes + (uint32_t)(conversiones / ((uint32_t)conversionesAdc * c.paso));
+}
+
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+static const uint32_t ADC_DMA_HZ = SOC_ADC_SAMPLE_FREQ_THRES_LOW; // Mínimo del ADC_DIGI
+static const uint8_t SIN_CANAL = 0xFF;
+
+#if CONFIG_IDF_TARGET_ESP32 || CONFIG_IDF_TARGET_ESP32S2
+#define ADC_FORMATO ADC_DIGI_OUTPUT_FORMAT_TYPE1
+#define ADC_CANAL(p) ((p)->type1.channel)
+#define ADC_DATO(p) ((p)->type1.data)
+#else
+#define ADC_FORMATO ADC_DIGI_OUTPUT_FORMAT_TYPE2
+#define ADC_CANAL(p) ((p)->type2.channel)
+#define ADC_DATO(p) ((p)->type2.data)
+#endif
+
+static adc_continuous_handle_t manejadorAdc = nullptr;
+static uint8_t canalAdcDe[SOC_ADC_MAX_CHANNEL_NUM];    // Canal del ADC1 -> canalesAdc
+
+// Pool lleno: el driver tira esta trama
+static bool IRAM_ATTR alDesbordarPoolAdc(adc_continuous_handle_t, const adc_continuous_evt_data_t*, void*) {
+    tramasPerdidasAdc.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+// Dos lectores (p.ej. el potenciómetro y los sensores) pueden pedir tramas
+// a la vez desde tareas distintas: el que llega segundo no espera, ya las
+// está repartiendo el otro. Así cada anillo sigue teniendo un solo productor.
+static void recogerTramaAdc() {
+    if (xSemaphoreTake(cerrojoAdc, 0) != pdTRUE) return;
+    if (!adcEnMarcha) {
+        xSemaphoreGive(cerrojoAdc);
+        return;
+    }
+    static uint8_t datos[256] __attribute__((aligned(4)));
+    uint32_t leidos = 0;
+    while (adc_continuous_read(manejadorAdc, datos, sizeof(datos), &leidos, 0) == ESP_OK) {
+        for (uint32_t i = 0; i + SOC_ADC_DIGI_RESULT_BYTES <= leidos; i += SOC_ADC_DIGI_RESULT_BYTES) {
+            adc_digi_output_data_t* p = (adc_digi_output_data_t*)&datos[i];
+            uint32_t canal = ADC_CANAL(p);
+            if (canal >= SOC_ADC_MAX_CHANNEL_NUM || canalAdcDe[canal] == SIN_CANAL) continue;
+            acumularConversionAdc(canalAdcDe[canal], (uint16_t)(ADC_DATO(p) >> 2)); // 12 -> 10 bits
+        }
+    }
+    xSemaphoreGive(cerrojoAdc);
+}
+
+static void pararAdc() {
+    if (!manejadorAdc) return;
+    if (adcEnMarcha) adc_continuous_stop(manejadorAdc);
+    adc_continuous_deinit(manejadorAdc);
+    manejadorAdc = nullptr;
+    adcEnMarcha = false;
+}
+#else
+static const uint8_t TEMPORIZADOR_ADC = 1;      // Temporizador hardware propio
+static hw_timer_t* temporizadorAdc = nullptr;
+static TaskHandle_t tareaAdc = nullptr;
+
+static void IRAM_ATTR alVencerTemporizadorAdc() {
+    BaseType_t despertar = pdFALSE;
+    vTaskNotifyGiveFromISR(tareaAdc, &despertar);
+    if (despertar) portYIELD_FROM_ISR();
+}
+
+// Por debajo de esp_timer: si se retrasa, lo que se pierde es una muestra
+// (cada vencimiento acumulado cuenta como trama perdida), no un relé
+static void bucleAdc(void*) {
+    for (;;) {
+        uint32_t vencidos = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (xSemaphoreTake(cerrojoAdc, 0) != pdTRUE) {
+            tramasPerdidasAdc.fetch_add(vencidos, std::memory_order_relaxed);   // Rearrancando
+            continue;
+        }
+        if (vencidos > 1) tramasPerdidasAdc.fetch_add(vencidos - 1, std::memory_order_relaxed);
+        for (uint8_t c = 0; adcEnMarcha && c < numCanalesAdc; c++) {
+            CanalAdc& canal = canalesAdc[c];
+            if (canal.pausado) continue;
+            if (canal.cuenta + 1 < canal.paso) {
+                canal.cuenta++;                      // Sin leer: no le toca
+                continue;
+            }
+            repartirMuestraAdc(c, (uint16_t)::analogRead(canal.pin));
+        }
+        xSemaphoreGive(cerrojoAdc);
+    }
+}
+#endif
+
+// (Re)arranca la conversión con los canales pedidos hasta ahora que no
+// estén en pausa, al ritmo del más rápido; sin ninguno, la deja parada.
+// Siempre con cerrojoAdc cogido.
+static bool arrancarAdc() {
+    uint16_t hzMax = 0;
+    uint8_t activos = 0;
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        if (canalesAdc[c].pausado) continue;
+        activos++;
+        if (canalesAdc[c].muestrasPorSegundo > hzMax) hzMax = canalesAdc[c].muestrasPorSegundo;
+    }
+    // Lo ya perdido se guarda con el reparto viejo; las cuentas siguen subiendo.
+    // El que sigue en marcha pierde lo que quedaba a medias: cuenta como hueco
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        CanalAdc& canal = canalesAdc[c];
+        if (!canal.paso) continue;
+        canal.perdidasAntes = perdidasDriverAdc(canal) + (canal.enReparto && !canal.pausado ? 1 : 0);
+    }
+    tramasPerdidasAdc.store(0, std::memory_order_relaxed);
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        canalesAdc[c].enReparto = !canalesAdc[c].pausado;
+        if (canalesAdc[c].pausado) continue;
+        uint16_t paso = hzMax / canalesAdc[c].muestrasPorSegundo;
+        canalesAdc[c].paso = paso ? paso : 1;
+        canalesAdc[c].cuenta = 0;
+        canalesAdc[c].suma = 0;
+        canalesAdc[c].sumadas = 0;
+    }
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+    pararAdc();                                 // Suelta el cerrojo de energía del driver
+    if (!activos) return true;
+
+    // Conversiones por canal y muestra para no bajar del mínimo del ADC_DIGI
+    uint32_t porMuestra = (uint32_t)hzMax * activos;
+    conversionesAdc = (ADC_DMA_HZ + porMuestra - 1) / porMuestra;
+    uint32_t hz = porMuestra * conversionesAdc;
+
+    // Una trama por drenado del lector (redondeada a vueltas enteras de
+    // los canales) y un pool que aguanta la espera más larga entre drenados
+    uint32_t unidad = SOC_ADC_DIGI_DATA_BYTES_PER_CONV * SOC_ADC_DIGI_RESULT_BYTES * activos;
+    uint32_t bytesTrama = hz * hal::ADC_TRAMA_MS / 1000 * SOC_ADC_DIGI_RESULT_BYTES;
+    bytesTrama = (bytesTrama + unidad - 1) / unidad * unidad;
+    uint32_t tramasPool = (hal::ADC_ESPERA_MAX_MS + hal::ADC_TRAMA_MS - 1) / hal::ADC_TRAMA_MS + 1;
+    conversionesPorTramaAdc = bytesTrama / SOC_ADC_DIGI_RESULT_BYTES / activos;
+
+    adc_continuous_handle_cfg_t memoria = {};
+    memoria.max_store_buf_size = bytesTrama * tramasPool;
+    memoria.conv_frame_size = bytesTrama;
+    if (adc_continuous_new_handle(&memoria, &manejadorAdc) != ESP_OK) {
+        manejadorAdc = nullptr;
+        return false;
+    }
+
+    adc_digi_pattern_config_t patron[hal::ADC_CANALES] = {};
+    memset(canalAdcDe, SIN_CANAL, sizeof(canalAdcDe));
+    uint8_t p = 0;
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        if (canalesAdc[c].pausado) continue;
+        adc_unit_t unidadAdc;
+        adc_channel_t canal;
+        // Solo el ADC1 convierte por DMA en el ESP32
+        if (adc_continuous_io_to_channel(canalesAdc[c].pin, &unidadAdc, &canal) != ESP_OK || unidadAdc != ADC_UNIT_1) {
+            pararAdc();
+            return false;
+        }
+        patron[p].atten = ADC_ATTEN_DB_12;
+        patron[p].channel = canal;
+        patron[p].unit = ADC_UNIT_1;
+        patron[p].bit_width = SOC_ADC_DIGI_MAX_BITWIDTH;
+        p++;
+        canalAdcDe[canal] = c;
+    }
+    adc_continuous_config_t config = {};
+    config.pattern_num = activos;
+    config.adc_pattern = patron;
+    config.sample_freq_hz = hz;
+    config.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    config.format = ADC_FORMATO;
+
+    adc_continuous_evt_cbs_t avisos = {};
+    avisos.on_pool_ovf = &alDesbordarPoolAdc;
+    if (adc_continuous_config(manejadorAdc, &config) != ESP_OK ||
+        adc_continuous_register_event_callbacks(manejadorAdc, &avisos, nullptr) != ESP_OK ||
+        adc_continuous_start(manejadorAdc) != ESP_OK) {
+        pararAdc();
+        return false;
+    }
+    adcEnMarcha = true;
+    return true;
+#else
+    conversionesAdc = 1;
+    conversionesPorTramaAdc = 1;                // Un vencimiento, una conversión por canal
+    if (!tareaAdc && xTaskCreatePinnedToCore(bucleAdc, "adc", 2048, nullptr, ESP_TASK_TIMER_PRIO - 1,
+                                             &tareaAdc, 0) != pdPASS) {
+        tareaAdc = nullptr;
+        return false;
+    }
+    if (!temporizadorAdc) {
+        temporizadorAdc = ::timerBegin(TEMPORIZADOR_ADC, 80, true);   // 1 MHz
+        if (!temporizadorAdc) return false;
+        ::timerAttachInterrupt(temporizadorAdc, &alVencerTemporizadorAdc, true);
+    }
+    ::timerAlarmDisable(temporizadorAdc);
+    ::timerStop(temporizadorAdc);
+    adcEnMarcha = activos > 0;
+    if (!activos) return true;                  // Ni interrupción ni tarea despierta
+    ::timerWrite(temporizadorAdc, 0);
+    ::timerAlarmWrite(temporizadorAdc, 1000000UL / hzMax, true);
+    ::timerAlarmEnable(temporizadorAdc);
+    ::timerStart(temporizadorAdc);
+    return true;
+#endif
+}
+
+namespace hal {
+
+    void pinModo(int pin, ModoPin modo) {
+        switch (modo) {
+            case ENTRADA:        ::pinMode(pin, INPUT); break;
+            case ENTRADA_PULLUP: ::pinMode(pin, INPUT_PULLUP); break;
+            case SALIDA:         ::pinMode(pin, OUTPUT); break;
+        }
+    }
+
+    void escribir(int pin, Nivel nivel) {
+        ::digitalWrite(pin, nivel == ALTO ? HIGH : LOW);
+    }
+
+    Nivel leer(int pin) {
+        return ::digitalRead(pin) == HIGH ? ALTO : BAJO;
+    }
+
+    bool interrupcionPin(int pin, CallbackFlanco alCambiar, void* ctx) {
+        if (numRegistrosFlanco >= MAX_FLANCOS || digitalPinToInterrupt(pin) < 0) return false;
+        RegistroFlanco* r = &registrosFlanco[numRegistrosFlanco++];
+        r->pin = pin;
+        r->alCambiar = alCambiar;
+        r->ctx = ctx;
+        r->despierta = false;
+        ::attachInterruptArg(digitalPinToInterrupt(pin), isrFlanco, r, CHANGE);
+        return true;
+    }
+
+    int leerAnalogico(int pin) {
+        return ::analogRead(pin);
+    }
+
+    bool adcContinuoIniciar(int pin, uint16_t muestrasPorSegundo) {
+        if (muestrasPorSegundo == 0) return false;
+        if (!cerrojoAdc && !(cerrojoAdc = xSemaphoreCreateMutex())) return false;
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal) {
+            if (numCanalesAdc >= ADC_CANALES) return false;
+            canal = &canalesAdc[numCanalesAdc++];
+            canal->pin = pin;
+            canal->pausado = false;
+            canal->enReparto = false;
+        }
+        xSemaphoreTake(cerrojoAdc, portMAX_DELAY);
+        canal->muestrasPorSegundo = muestrasPorSegundo;
+        bool ok = arrancarAdc();
+        xSemaphoreGive(cerrojoAdc);
+        return ok;
+    }
+
+    size_t adcContinuoLeer(int pin, uint16_t* destino, size_t max) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal) return 0;
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        recogerTramaAdc();
+#endif
+        size_t n = 0;
+        while (n < max && canal->anillo.sacar(destino[n])) n++;
+        return n;
+    }
+
+    uint32_t adcContinuoPerdidas(int pin) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        return canal ? canal->anillo.totalRechazados() + perdidasDriverAdc(*canal) : 0;
+    }
+
+    bool adcContinuoPausar(int pin, bool pausado) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal) return false;
+        if (canal->pausado == pausado) return true;
+        xSemaphoreTake(cerrojoAdc, portMAX_DELAY);
+        canal->pausado = pausado;
+        bool ok = arrancarAdc();
+        xSemaphoreGive(cerrojoAdc);
+        // Desde aquí nadie mete en su anillo: lo que queda es de antes del parón
+        uint16_t viejas;
+        while (pausado && canal->anillo.sacar(viejas)) {}
+        return ok;
+    }
+
+    unsigned long millis() {
+        return ::millis();
+    }
+
+    unsigned long micros() {
+        return ::micros();
+    }
+
+    void esperar(unsigned long ms) {
+        ::delay(ms);
+    }
+
+    bool disparoProgramar(uint64_t us, CallbackDisparo alVencer, void* ctx) {
+        if (!temporizadorDisparo) {
+            esp_timer_create_args_t args = {};
+            args.callback = &alVencerDisparo;
+            args.name = "disparo";
+            if (esp_timer_create(&args, &temporizadorDisparo) != ESP_OK) return false;
+        }
+        esp_timer_stop(temporizadorDisparo);   // Falla si no estaba en marcha: da igual
+        disparoCallback = alVencer;
+        disparoCtx = ctx;
+        return esp_timer_start_once(temporizadorDisparo, us) == ESP_OK;
+    }
+
+    void disparoCancelar() {
+        if (temporizadorDisparo) esp_timer_stop(temporizadorDisparo);
+    }
+
+    bool bajoConsumoIniciar() {
+#if CONFIG_PM_ENABLE
+#if ESP_ARDUINO_VERSION_MAJOR >= 3
+        esp_pm_config_t cfg = {};
+#else
+        esp_pm_config_esp32_t cfg = {};
+#endif
+        cfg.max_freq_mhz = ::getCpuFrequencyMhz();
+        cfg.min_freq_mhz = 40;          // XTAL mientras nadie pida más
+        cfg.light_sleep_enable = true;
+        esp_sleep_enable_gpio_wakeup();
+        if (esp_pm_configure(&cfg) == ESP_OK) {
+            WiFi.setSleep(true);        // Modem sleep: la radio despierta en cada beacon DTIM
+            return true;
+        }
+        // Sin tickless idle en el sdkconfig: al menos bajar la frecuencia
+        cfg.light_sleep_enable = false;
+        esp_pm_configure(&cfg);
+#endif
+        return false;
+    }
+
+    bool despertarConPin(int pin) {
+        for (uint8_t i = 0; i < numRegistrosFlanco; i++) {
+            if (registrosFlanco[i].pin != pin) continue;
+            registrosFlanco[i].despierta = true;
+            return true;
+        }
+        return false;
+    }
+
+    bool dormir(unsigned long ms) {
+        tareaDormida = xTaskGetCurrentTaskHandle();
+
+        // Armar antes de pasar a nivel: si el flanco llega entre medias, la
+        // ISR ya lo trata como despertar
+        despertadoresArmados = true;
+        for (uint8_t i = 0; i < numRegistrosFlanco; i++) {
+            RegistroFlanco& r = registrosFlanco[i];
+            if (!r.despierta) continue;
+            gpio_wakeup_enable((gpio_num_t)r.pin,
+                               ::digitalRead(r.pin) == HIGH ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+        }
+
+        bool avisada = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0;
+
+        despertadoresArmados = false;
+        for (uint8_t i = 0; i < numRegistrosFlanco; i++) {
+            RegistroFlanco& r = registrosFlanco[i];
+            if (!r.despierta) continue;
+            gpio_num_t pin = (gpio_num_t)r.pin;
+            gpio_intr_disable(pin);
+            gpio_wakeup_disable(pin);
+            gpio_set_intr_type(pin, GPIO_INTR_ANYEDGE);
+            // Con la interrupción parada somos el único productor: se
+            // entrega el nivel actual por si cambió mientras estaba desarmada
+            r.alCambiar(r.ctx, ::digitalRead(r.pin) == HIGH ? ALTO : BAJO, (uint32_t)::micros());
+            gpio_intr_enable(pin);
+        }
+        return avisada;
+    }
+
+    void despertar() {
+        TaskHandle_t tarea = tareaDormida;
+        if (tarea) xTaskNotifyGive(tarea);
+    }
+
+    void log(const char* msg) {
+        Serial.println(msg);
+    }
+
+    void eepromIniciar(size_t tamanio) {
+        EEPROM.begin(tamanio);
+    }
+
+    void eepromLeer(int direccion, void* destino, size_t len) {
+        EEPROM.readBytes(direccion, destino, len);
+    }
+
+    void eepromEscribir(int direccion, const void* origen, size_t len) {
+        EEPROM.writeBytes(direccion, origen, len);
+    }
+
+    bool eepromConfirmar() {
+        return EEPROM.commit();
+    }
+
+    // Particiones de partitions.csv (subtipos libres 0x40 y 0x41)
+    static const esp_partition_t* particionFlash(ParticionFlash particion) {
+        static const esp_partition_t* config = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x40, "cfglog");
+        static const esp_partition_t* diario = esp_partition_find_first(
+            ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)0x41, "diario");
+        return particion == FLASH_DIARIO ? diario : config;
+    }
+
+    size_t flashSectores(ParticionFlash particion) {
+        const esp_partition_t* p = particionFlash(particion);
+        return p ? p->size / FLASH_SECTOR : 0;
+    }
+
+    bool flashLeer(ParticionFlash particion, uint32_t direccion, void* destino, size_t len) {
+        const esp_partition_t* p = particionFlash(particion);
+        return p && esp_partition_read(p, direccion, destino, len) == ESP_OK;
+    }
+
+    bool flashEscribir(ParticionFlash particion, uint32_t direccion, const void* origen, size_t len) {
+        const esp_partition_t* p = particionFlash(particion);
+        return p && esp_partition_write(p, direccion, origen, len) == ESP_OK;
+    }
+
+    bool flashBorrarSector(ParticionFlash particion, size_t sector) {
+        const esp_partition_t* p = particionFlash(particion);
+        return p && esp_partition_erase_range(p, sector * FLASH_SECTOR, FLASH_SECTOR) == ESP_OK;
+    }
+
+    bool wifiConectado() {
+        return WiFi.status() == WL_CONNECTED;
+    }
+
+    // Espacio de nombres "red" de la NVS (Preferences abre y cierra cada vez)
+    size_t nvsLeer(const char* clave, void* destino, size_t max) {
+        Preferences nvs;
+        if (!nvs.begin("red", true)) return 0;
+        size_t len = nvs.getBytesLength(clave);
+        if (len > max) len = 0;
+        if (len > 0) len = nvs.getBytes(clave, destino, len);
+        nvs.end();
+        return len;
+    }
+
+    bool nvsEscribir(const char* clave, const void* datos, size_t len) {
+        Preferences nvs;
+        if (!nvs.begin("red", false)) return false;
+        bool ok = nvs.putBytes(clave, datos, len) == len;
+        nvs.end();
+        return ok;
+    }
+}
@@ -0,0 +1,71 @@
+#include "MqttPubSub.h"
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static const uint32_t PILA_CONEXION = 8192;  // mbedTLS necesita pila para el handshake
+
+MqttPubSub::MqttPubSub() : client(espClient) {}
+
+void MqttPubSub::configurar(const char* servidor, uint16_t puerto) {
+    espClient.setHandshakeTimeout(15);  // s: ni en segundo plano se queda colgada
+    client.setSocketTimeout(10);
+    client.setServer(servidor, puerto);
+    client.setBufferSize(1024); // Los 256 B por defecto no dan para info (con tramos) ni diagnostico en JSON
+}
+
+void MqttPubSub::setCallback(Callback cb) {
+    client.setCallback(cb);
+}
+
+bool MqttPubSub::conectar(const char* clientId, const char* usuario, const char* clave) {
+    return client.connect(clientId, usuario, clave);
+}
+
+bool MqttPubSub::conectado() {
+    return client.connected();
+}
+
+int MqttPubSub::estado() {
+    return client.state();
+}
+
+bool MqttPubSub::suscribir(const char* topic) {
+    return client.subscribe(topic);
+}
+
+bool MqttPubSub::publicar(const char* topic, const uint8_t* payload, size_t len, bool retenido) {
+    return client.publish(topic, payload, len, retenido);
+}
+
+void MqttPubSub::procesar() {
+    client.loop();
+}
+
+// ======================================================
+// CONEXIÓN EN SEGUNDO PLANO
+// ======================================================
+void MqttPubSub::tareaConexion(void* parametro) {
+    MqttPubSub* self = static_cast<MqttPubSub*>(parametro);
+    bool ok = self->client.connect(self->peticionId, self->peticionUsuario, self->peticionClave);
+    self->progreso.store(ok ? CONEXION_LISTA : CONEXION_FALLIDA, std::memory_order_release);
+    vTaskDelete(NULL);
+}
+
+bool MqttPubSub::empezarConexion(const char* clientId, const char* usuario, const char* clave) {
+    if (progreso.load(std::memory_order_acquire) == CONEXION_EN_CURSO) return false;
+    peticionId = clientId;
+    peticionUsuario = usuario;
+    peticionClave = clave;
+    progreso.store(CONEXION_EN_CURSO, std::memory_order_release);
+
+    // En el núcleo de la red: el de control no se entera
+    if (xTaskCreatePinnedToCore(tareaConexion, "mqttConexion", PILA_CONEXION, this, 1, NULL, 0) != pdPASS) {
+        progreso.store(CONEXION_FALLIDA, std::memory_order_release);
+        return false;
+    }
+    return true;
+}
+
+ProgresoConexion MqttPubSub::progresoConexion() {
+    return (ProgresoConexion)progreso.load(std::memory_order_acquire);
+}
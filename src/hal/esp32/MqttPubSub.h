@@ -0,0 +1,37 @@
+#pragma once
+#include "../MqttHal.h"
+#include <atomic>
+#include <PubSubClient.h>
+#include "ClienteTls.h"
+
+// Adaptador de PubSubClient sobre TLS a MqttHal. El handshake TLS puede
+// tardar segundos: empezarConexion() lo hace en una tarea aparte y solo
+// deja el resultado en un atómico.
+class MqttPubSub : public MqttHal {
+    private:
+        ClienteTls espClient;       // TLS con reanudación de sesión
+        PubSubClient client;
+
+        // Lo que usa la tarea de conexión (vive hasta que termina)
+        const char* peticionId = nullptr;
+        const char* peticionUsuario = nullptr;
+        const char* peticionClave = nullptr;
+        std::atomic<uint8_t> progreso{CONEXION_FALLIDA};
+
+        static void tareaConexion(void* parametro);
+
+    public:
+        MqttPubSub();
+
+        void configurar(const char* servidor, uint16_t puerto) override;
+        void setCallback(Callback cb) override;
+        bool conectar(const char* clientId, const char* usuario, const char* clave) override;
+        bool conectado() override;
+        int estado() override;
+        bool suscribir(const char* topic) override;
+        bool publicar(const char* topic, const uint8_t* payload, size_t len, bool retenido) override;
+        void procesar() override;
+        bool empezarConexion(const char* clientId, const char* usuario, const char* clave) override;
+        ProgresoConexion progresoConexion() override;
+        const EstadisticasTls* tls() const override { return &espClient.tls(); }
+};
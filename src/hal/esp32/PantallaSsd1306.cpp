@@ -0,0 +1,91 @@
+#include "PantallaSsd1306.h"
+#include <string.h>
+
+// Los buffers de Wire son de 32 bytes en muchos cores (128 en ESP32):
+// 1 de control + 31 de datos entra en cualquiera.
+static const uint8_t DATOS_POR_TRANSACCION = 31;
+
+PantallaSsd1306::PantallaSsd1306(Adafruit_SSD1306& displayRef, uint8_t direccionI2C, TwoWire& wireRef)
+    : display(displayRef), wire(wireRef), direccion(direccionI2C),
+      previoValido(false), enviados(0) {}
+
+bool PantallaSsd1306::iniciar() {
+    if (!display.begin(SSD1306_SWITCHCAPVCC, direccion)) {
+        return false;
+    }
+    display.clearDisplay();
+    display.setTextSize(1);      // Tamaño normal
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(0, 0);
+    previoValido = false;        // begin() no limpia la RAM del panel
+    return true;
+}
+
+void PantallaSsd1306::limpiar() {
+    display.clearDisplay();
+}
+
+void PantallaSsd1306::escribir(int16_t x, int16_t y, const char* msg) {
+    display.setTextColor(SSD1306_WHITE);
+    display.setCursor(x, y);
+    display.print(msg);
+}
+
+void PantallaSsd1306::volcar() {
+    const uint8_t* cuadro = display.getBuffer();
+
+    // Primer volcado: no sabemos qué hay en el panel -> cuadro completo
+    if (!previoValido) {
+        display.display();
+        memcpy(previo, cuadro, sizeof(previo));
+        previoValido = true;
+        enviados += ssd1306::BYTES_CUADRO + ssd1306::BYTES_VENTANA;
+        return;
+    }
+
+    ssd1306::Ventana ventanas[ssd1306::PAGINAS];
+    uint8_t n = ssd1306::ventanasSucias(cuadro, previo, ventanas);
+    if (n == 0) return;
+
+    wire.setClock(400000);   // Igual que Adafruit durante display()
+    for (uint8_t i = 0; i < n; i++) enviarVentana(ventanas[i], cuadro);
+    wire.setClock(100000);
+}
+
+void PantallaSsd1306::enviarVentana(const ssd1306::Ventana& v, const uint8_t* cuadro) {
+    // Modo de direccionamiento horizontal (el que deja begin()): fijar la
+    // ventana y los datos entran columna a columna dentro de ella.
+    wire.beginTransmission(direccion);
+    wire.write((uint8_t)0x00);                 // Co=0, D/C=0: comandos
+    wire.write((uint8_t)SSD1306_PAGEADDR);
+    wire.write(v.pagina);
+    wire.write(v.pagina);
+    wire.write((uint8_t)SSD1306_COLUMNADDR);
+    wire.write(v.col0);
+    wire.write(v.col1);
+    wire.endTransmission();
+
+    uint16_t desde = v.pagina * ssd1306::ANCHO + v.col0;
+    uint16_t restantes = v.col1 - v.col0 + 1;
+    while (restantes > 0) {
+        uint8_t trozo = restantes > DATOS_POR_TRANSACCION ? DATOS_POR_TRANSACCION : restantes;
+        wire.beginTransmission(direccion);
+        wire.write((uint8_t)0x40);             // Co=0, D/C=1: datos
+        wire.write(cuadro + desde, trozo);
+        wire.endTransmission();
+        desde += trozo;
+        restantes -= trozo;
+    }
+
+    uint16_t inicio = v.pagina * ssd1306::ANCHO + v.col0;
+    memcpy(previo + inicio, cuadro + inicio, v.col1 - v.col0 + 1);
+    enviados += ssd1306::BYTES_VENTANA + (v.col1 - v.col0 + 1);
+}
+
+void PantallaSsd1306::encender() {
+    display.ssd1306_command(SSD1306_DISPLAYON);
+}
+
+void PantallaSsd1306::apagar() {
+    display.ssd1306_command(SSD1306_DISPLAYOFF);
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "../PantallaHal.h"
+#include "../PaginasSsd1306.h"
+#include <Wire.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_SSD1306.h>
+
+// Adaptador del SSD1306 (Adafruit) a PantallaHal.
+// volcar() guarda una copia del último cuadro enviado y manda por I2C
+// solo las ventanas de columnas que cambiaron en cada página.
+class PantallaSsd1306 : public PantallaHal {
+    private:
+        Adafruit_SSD1306& display;
+        TwoWire& wire;
+        uint8_t direccion;
+
+        uint8_t previo[ssd1306::BYTES_CUADRO]; // Lo que tiene la RAM del panel
+        bool previoValido;
+        uint32_t enviados;
+
+        void enviarVentana(const ssd1306::Ventana& v, const uint8_t* cuadro);
+
+    public:
+        PantallaSsd1306(Adafruit_SSD1306& displayRef, uint8_t direccionI2C, TwoWire& wireRef = Wire);
+
+        bool iniciar() override;
+        void limpiar() override;
+        void escribir(int16_t x, int16_t y, const char* msg) override;
+        void volcar() override;
+        void encender() override;
+        void apagar() override;
+        uint32_t bytesEnviados() const override { return enviados; }
+};
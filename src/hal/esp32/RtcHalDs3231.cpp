@@ -0,0 +1,30 @@
+#include "RtcHalDs3231.h"
+
+RtcHalDs3231::RtcHalDs3231(RtcDS3231<TwoWire>& rtc) : Rtc(rtc) {}
+
+void RtcHalDs3231::iniciar() {
+    Rtc.Begin();
+
+    RtcDateTime compilado = RtcDateTime(__DATE__, __TIME__);
+    if (!Rtc.IsDateTimeValid()) Rtc.SetDateTime(compilado);
+    if (!Rtc.GetIsRunning()) Rtc.SetIsRunning(true);
+}
+
+RtcDateTime RtcHalDs3231::leer() {
+    return Rtc.GetDateTime();
+}
+
+void RtcHalDs3231::escribir(const RtcDateTime& fechaHora) {
+    Rtc.SetDateTime(fechaHora);
+}
+
+bool RtcHalDs3231::esValida() {
+    return Rtc.IsDateTimeValid();
+}
+
+bool RtcHalDs3231::activarPulsoSegundo() {
+    Rtc.Enable32kHzPin(false);
+    Rtc.SetSquareWavePinClockFrequency(DS3231SquareWaveClock_1Hz);
+    Rtc.SetSquareWavePin(DS3231SquareWavePin_ModeClock);
+    return Rtc.LastError() == 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include "../RtcHal.h"
+#include <Wire.h>
+#include <RtcDS3231.h>
+
+// Adaptador del DS3231 (makuna/RTC) a RtcHal
+class RtcHalDs3231 : public RtcHal {
+    private:
+        RtcDS3231<TwoWire>& Rtc;
+
+    public:
+        RtcHalDs3231(RtcDS3231<TwoWire>& rtc);
+
+        void iniciar() override;
+        RtcDateTime leer() override;
+        void escribir(const RtcDateTime& fechaHora) override;
+        bool esValida() override;
+        bool activarPulsoSegundo() override;
+};
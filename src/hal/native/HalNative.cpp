@@ -0,0 +1,401 @@
+#include "HalNative.h"
+#include <stdio.h>
+#include <string.h>
+
+// Implementación de la HAL para el host: todo vive en RAM y el tiempo
+// solo avanza cuando alguien llama a esperar() o sim::avanzar().
+
+static const int NUM_PINES = 40;       // GPIO0..GPIO39 como en el ESP32
+static const size_t EEPROM_MAX = 4096;
+
+static hal::Nivel pines[NUM_PINES];
+static int analogicos[NUM_PINES];
+static hal::CallbackFlanco flancos[NUM_PINES];
+static void* flancosCtx[NUM_PINES];
+static unsigned long tiempoMs = 0;
+static bool logSilenciado = false;
+static bool wifiOk = true;
+
+// Bajo consumo: dormir() salta el reloj de golpe salvo que haya un aviso
+// pendiente (despertar() o un flanco en un pin de despertar)
+static bool despiertaPin[NUM_PINES];
+static bool avisoDespertar = false;
+static unsigned long msDormidos = 0;
+static unsigned long siestas = 0;
+
+// Disparo único: vence cuando el reloj simulado cruza 'disparoUs'
+static bool disparoArmado = false;
+static uint64_t disparoUs = 0;
+static hal::CallbackDisparo disparoCallback = nullptr;
+static void* disparoCtx = nullptr;
+
+// Adelanta el reloj 'ms' o solo hasta el disparo si vence antes (y lo
+// lanza). Devuelve true si disparó.
+static bool avanzarHastaDisparo(unsigned long ms) {
+    uint64_t finUs = (uint64_t)(tiempoMs + ms) * 1000;
+    if (!disparoArmado || disparoUs > finUs) {
+        tiempoMs += ms;
+        return false;
+    }
+    unsigned long enMs = (unsigned long)((disparoUs + 999) / 1000);
+    if (enMs > tiempoMs) tiempoMs = enMs;
+    disparoArmado = false;
+    disparoCallback(disparoCtx);
+    return true;
+}
+
+static void avanzarReloj(unsigned long ms) {
+    unsigned long fin = tiempoMs + ms;
+    while (avanzarHastaDisparo(fin - tiempoMs)) {}
+}
+
+// ADC continuo simulado: cada canal genera las muestras que "habrían
+// llegado" desde su última lectura según el reloj simulado.
+struct CanalAdc {
+    int pin;
+    unsigned long periodoUs;
+    unsigned long ultimaMuestraUs;
+    uint32_t perdidas;
+    bool pausado;
+};
+static CanalAdc canalesAdc[hal::ADC_CANALES];
+static uint8_t numCanalesAdc = 0;
+
+// Formas de onda grabadas (sim::reproducirAnalogico): el ADC continuo de
+// ese pin las recorre en bucle, una muestra por periodo
+struct Grabacion {
+    const uint16_t* muestras;
+    size_t largo;
+    size_t pos;
+};
+static Grabacion grabaciones[NUM_PINES];
+
+static uint16_t muestraAdc(int pin) {
+    Grabacion& g = grabaciones[pin];
+    if (!g.largo) return (uint16_t)analogicos[pin];
+    uint16_t m = g.muestras[g.pos];
+    if (++g.pos >= g.largo) g.pos = 0;
+    return m;
+}
+
+static CanalAdc* buscarCanalAdc(int pin) {
+    for (uint8_t c = 0; c < numCanalesAdc; c++) {
+        if (canalesAdc[c].pin == pin) return &canalesAdc[c];
+    }
+    return nullptr;
+}
+
+static uint8_t eeprom[EEPROM_MAX];
+static size_t eepromTamanio = 0;
+
+// NVS: unas pocas claves en RAM
+struct EntradaNvs {
+    char clave[16];
+    uint8_t datos[2048];
+    size_t len;
+};
+static const uint8_t NVS_CLAVES = 4;
+static EntradaNvs nvs[NVS_CLAVES];
+
+// Particiones de flash: 4 sectores NOR en RAM cada una. Cuenta borrados
+// por sector y puede "cortar la luz" tras N bytes escritos (lo demás no
+// llega a la flash).
+static const size_t FLASH_PARTICIONES = 2;
+static const size_t FLASH_SECTORES = 4;
+static uint8_t flash[FLASH_PARTICIONES][FLASH_SECTORES * hal::FLASH_SECTOR];
+static bool flashIniciada = false;
+static unsigned long borradosFlash[FLASH_PARTICIONES][FLASH_SECTORES];
+static long bytesHastaCorte = -1;      // -1: sin corte programado
+
+static void iniciarFlash() {
+    if (flashIniciada) return;
+    memset(flash, 0xFF, sizeof(flash));
+    flashIniciada = true;
+}
+
+namespace hal {
+
+    void pinModo(int pin, ModoPin modo) {
+        if (pin < 0 || pin >= NUM_PINES) return;
+        if (modo == ENTRADA_PULLUP) pines[pin] = ALTO;
+    }
+
+    void escribir(int pin, Nivel nivel) {
+        if (pin < 0 || pin >= NUM_PINES) return;
+        pines[pin] = nivel;
+    }
+
+    Nivel leer(int pin) {
+        if (pin < 0 || pin >= NUM_PINES) return BAJO;
+        return pines[pin];
+    }
+
+    bool interrupcionPin(int pin, CallbackFlanco alCambiar, void* ctx) {
+        if (pin < 0 || pin >= NUM_PINES) return false;
+        flancos[pin] = alCambiar;
+        flancosCtx[pin] = ctx;
+        return true;
+    }
+
+    int leerAnalogico(int pin) {
+        if (pin < 0 || pin >= NUM_PINES) return 0;
+        return analogicos[pin];
+    }
+
+    bool adcContinuoIniciar(int pin, uint16_t muestrasPorSegundo) {
+        if (pin < 0 || pin >= NUM_PINES || muestrasPorSegundo == 0) return false;
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal) {
+            if (numCanalesAdc >= ADC_CANALES) return false;
+            canal = &canalesAdc[numCanalesAdc++];
+            canal->pin = pin;
+            canal->perdidas = 0;
+            canal->pausado = false;
+        }
+        canal->periodoUs = 1000000UL / muestrasPorSegundo;
+        canal->ultimaMuestraUs = micros();
+        return true;
+    }
+
+    size_t adcContinuoLeer(int pin, uint16_t* destino, size_t max) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal || canal->pausado) return 0;
+        unsigned long pendientes = (micros() - canal->ultimaMuestraUs) / canal->periodoUs;
+        if (pendientes > ADC_ANILLO) {              // El anillo real desborda igual
+            canal->ultimaMuestraUs += (pendientes - ADC_ANILLO) * canal->periodoUs;
+            canal->perdidas += pendientes - ADC_ANILLO;
+            Grabacion& g = grabaciones[pin];
+            if (g.largo) g.pos = (g.pos + pendientes - ADC_ANILLO) % g.largo;
+            pendientes = ADC_ANILLO;
+        }
+        size_t n = 0;
+        while (n < max && n < pendientes) destino[n++] = muestraAdc(pin);
+        canal->ultimaMuestraUs += n * canal->periodoUs;
+        return n;
+    }
+
+    uint32_t adcContinuoPerdidas(int pin) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        return canal ? canal->perdidas : 0;
+    }
+
+    bool adcContinuoPausar(int pin, bool pausado) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        if (!canal) return false;
+        if (!pausado && canal->pausado) canal->ultimaMuestraUs = micros();   // Sin lo del parón
+        canal->pausado = pausado;
+        return true;
+    }
+
+    unsigned long millis() {
+        return tiempoMs;
+    }
+
+    unsigned long micros() {
+        return tiempoMs * 1000UL;
+    }
+
+    void esperar(unsigned long ms) {
+        avanzarReloj(ms);
+    }
+
+    bool disparoProgramar(uint64_t us, CallbackDisparo alVencer, void* ctx) {
+        disparoCallback = alVencer;
+        disparoCtx = ctx;
+        disparoUs = (uint64_t)tiempoMs * 1000 + us;
+        disparoArmado = true;
+        return true;
+    }
+
+    void disparoCancelar() {
+        disparoArmado = false;
+    }
+
+    bool bajoConsumoIniciar() {
+        return true;
+    }
+
+    bool despertarConPin(int pin) {
+        if (pin < 0 || pin >= NUM_PINES || !flancos[pin]) return false;
+        despiertaPin[pin] = true;
+        return true;
+    }
+
+    bool dormir(unsigned long ms) {
+        if (avisoDespertar) {
+            avisoDespertar = false;
+            return true;
+        }
+        // Un disparo que vence durante la siesta puede despertarla
+        unsigned long inicio = tiempoMs;
+        unsigned long fin = tiempoMs + ms;
+        siestas++;
+        while (tiempoMs != fin) {
+            if (avanzarHastaDisparo(fin - tiempoMs) && avisoDespertar) {
+                avisoDespertar = false;
+                msDormidos += tiempoMs - inicio;
+                return true;
+            }
+        }
+        msDormidos += ms;
+        return false;
+    }
+
+    void despertar() {
+        avisoDespertar = true;
+    }
+
+    void log(const char* msg) {
+        if (!logSilenciado) puts(msg);
+    }
+
+    void eepromIniciar(size_t tamanio) {
+        if (tamanio > EEPROM_MAX) tamanio = EEPROM_MAX;
+        if (eepromTamanio == 0) memset(eeprom, 0xFF, sizeof(eeprom)); // Flash borrada
+        eepromTamanio = tamanio;
+    }
+
+    void eepromLeer(int direccion, void* destino, size_t len) {
+        if (direccion < 0 || direccion + len > EEPROM_MAX) return;
+        memcpy(destino, eeprom + direccion, len);
+    }
+
+    void eepromEscribir(int direccion, const void* origen, size_t len) {
+        if (direccion < 0 || direccion + len > EEPROM_MAX) return;
+        memcpy(eeprom + direccion, origen, len);
+    }
+
+    bool eepromConfirmar() {
+        return eepromTamanio > 0;
+    }
+
+    size_t flashSectores(ParticionFlash particion) {
+        return particion < FLASH_PARTICIONES ? FLASH_SECTORES : 0;
+    }
+
+    bool flashLeer(ParticionFlash particion, uint32_t direccion, void* destino, size_t len) {
+        iniciarFlash();
+        if (particion >= FLASH_PARTICIONES || direccion + len > sizeof(flash[0])) return false;
+        memcpy(destino, flash[particion] + direccion, len);
+        return true;
+    }
+
+    bool flashEscribir(ParticionFlash particion, uint32_t direccion, const void* origen, size_t len) {
+        iniciarFlash();
+        if (particion >= FLASH_PARTICIONES || direccion + len > sizeof(flash[0])) return false;
+        const uint8_t* bytes = static_cast<const uint8_t*>(origen);
+        for (size_t i = 0; i < len; i++) {
+            if (bytesHastaCorte == 0) return false;   // Sin luz
+            if (bytesHastaCorte > 0) bytesHastaCorte--;
+            flash[particion][direccion + i] &= bytes[i];  // NOR: solo 1 -> 0
+        }
+        return true;
+    }
+
+    bool flashBorrarSector(ParticionFlash particion, size_t sector) {
+        iniciarFlash();
+        if (particion >= FLASH_PARTICIONES || sector >= FLASH_SECTORES || bytesHastaCorte == 0) return false;
+        memset(flash[particion] + sector * FLASH_SECTOR, 0xFF, FLASH_SECTOR);
+        borradosFlash[particion][sector]++;
+        return true;
+    }
+
+    bool wifiConectado() {
+        return wifiOk;
+    }
+
+    static EntradaNvs* buscarNvs(const char* clave, bool crear) {
+        for (uint8_t i = 0; i < NVS_CLAVES; i++) {
+            if (nvs[i].len && strncmp(nvs[i].clave, clave, sizeof(nvs[i].clave)) == 0) return &nvs[i];
+        }
+        if (!crear) return nullptr;
+        for (uint8_t i = 0; i < NVS_CLAVES; i++) {
+            if (nvs[i].len == 0) return &nvs[i];
+        }
+        return nullptr;
+    }
+
+    size_t nvsLeer(const char* clave, void* destino, size_t max) {
+        EntradaNvs* e = buscarNvs(clave, false);
+        if (!e || e->len > max) return 0;
+        memcpy(destino, e->datos, e->len);
+        return e->len;
+    }
+
+    bool nvsEscribir(const char* clave, const void* datos, size_t len) {
+        EntradaNvs* e = buscarNvs(clave, true);
+        if (!e || len == 0 || len > sizeof(e->datos) || strlen(clave) >= sizeof(e->clave)) return false;
+        strcpy(e->clave, clave);
+        memcpy(e->datos, datos, len);
+        e->len = len;
+        return true;
+    }
+}
+
+namespace sim {
+
+    void avanzar(unsigned long ms) {
+        avanzarReloj(ms);
+    }
+
+    void fijarPin(int pin, hal::Nivel nivel) {
+        if (pin < 0 || pin >= NUM_PINES) return;
+        bool cambia = pines[pin] != nivel;
+        hal::escribir(pin, nivel);
+        if (cambia && flancos[pin]) flancos[pin](flancosCtx[pin], nivel, (uint32_t)hal::micros());
+        if (cambia && despiertaPin[pin]) avisoDespertar = true;
+    }
+
+    hal::Nivel nivelPin(int pin) {
+        return hal::leer(pin);
+    }
+
+    void fijarAnalogico(int pin, int valor) {
+        if (pin < 0 || pin >= NUM_PINES) return;
+        analogicos[pin] = valor;
+    }
+
+    void reproducirAnalogico(int pin, const uint16_t* muestras, size_t largo) {
+        if (pin < 0 || pin >= NUM_PINES) return;
+        grabaciones[pin].muestras = muestras;
+        grabaciones[pin].largo = muestras ? largo : 0;
+        grabaciones[pin].pos = 0;
+    }
+
+    bool adcConvirtiendo(int pin) {
+        CanalAdc* canal = buscarCanalAdc(pin);
+        return canal && !canal->pausado;
+    }
+
+    void silenciarLog(bool silencio) {
+        logSilenciado = silencio;
+    }
+
+    void fijarWifi(bool conectado) {
+        wifiOk = conectado;
+    }
+
+    unsigned long totalMsDormidos() {
+        return msDormidos;
+    }
+
+    unsigned long totalSiestas() {
+        return siestas;
+    }
+
+    void cortarFlashTras(long bytes) {
+        bytesHastaCorte = bytes;
+    }
+
+    unsigned long borradosSector(hal::ParticionFlash particion, size_t sector) {
+        if (particion >= FLASH_PARTICIONES || sector >= FLASH_SECTORES) return 0;
+        return borradosFlash[particion][sector];
+    }
+
+    void borrarFlash() {
+        memset(flash, 0xFF, sizeof(flash));
+        memset(borradosFlash, 0, sizeof(borradosFlash));
+        flashIniciada = true;
+        bytesHastaCorte = -1;
+    }
+}
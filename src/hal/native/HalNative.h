@@ -0,0 +1,27 @@
+#pragma once
+#include "../Hal.h"
+
+// ==========================================
+// CONTROLES DE LA SIMULACIÓN (solo host)
+// ==========================================
+// El código de control no conoce estas funciones; las usan el main nativo
+// y los bancos de prueba para "mover" el mundo exterior.
+namespace sim {
+    void avanzar(unsigned long ms);          // Adelanta el reloj del sistema
+    void fijarPin(int pin, hal::Nivel nivel); // Nivel visto en una entrada
+    hal::Nivel nivelPin(int pin);             // Último nivel escrito/fijado
+    void fijarAnalogico(int pin, int valor);
+    // El ADC continuo de 'pin' recorre en bucle estas muestras (0-1023)
+    // en vez del valor fijo; largo 0 o nullptr lo devuelve a fijarAnalogico()
+    void reproducirAnalogico(int pin, const uint16_t* muestras, size_t largo);
+    bool adcConvirtiendo(int pin);            // Pedido al ADC continuo y sin pausa
+    void silenciarLog(bool silencio);
+    void fijarWifi(bool conectado);
+    unsigned long totalMsDormidos();          // Tiempo pasado en hal::dormir()
+    unsigned long totalSiestas();
+
+    // Particiones de flash
+    void cortarFlashTras(long bytes);         // Corte de luz tras N bytes (-1: nunca)
+    unsigned long borradosSector(hal::ParticionFlash particion, size_t sector);
+    void borrarFlash();                       // Flash virgen (todo a 0xFF)
+}
@@ -0,0 +1,80 @@
+#include "MqttLoopback.h"
+#include <stdio.h>
+#include <string.h>
+
+MqttLoopback::MqttLoopback(bool eco)
+    : enLinea(false), aceptarConexion(true), publicados(0), bytes(0), eco(eco) {}
+
+void MqttLoopback::configurar(const char* servidor, uint16_t puerto) {
+    (void)servidor;
+    (void)puerto;
+}
+
+void MqttLoopback::setCallback(Callback cb) {
+    callback = cb;
+}
+
+bool MqttLoopback::conectar(const char* clientId, const char* usuario, const char* clave) {
+    (void)clientId;
+    (void)usuario;
+    (void)clave;
+    enLinea = aceptarConexion;
+    return enLinea;
+}
+
+bool MqttLoopback::conectado() {
+    return enLinea;
+}
+
+int MqttLoopback::estado() {
+    return enLinea ? 0 : -2; // MQTT_CONNECTED / MQTT_CONNECT_FAILED
+}
+
+bool MqttLoopback::suscribir(const char* topic) {
+    (void)topic;
+    return enLinea;
+}
+
+bool MqttLoopback::publicar(const char* topic, const uint8_t* payload, size_t len, bool retenido) {
+    if (!enLinea) return false;
+    publicados++;
+    bytes += len;
+    if (!eco) return true;
+
+    // Texto tal cual; lo binario (MessagePack) en hexadecimal
+    bool esTexto = len > 0 && payload[0] == '{';
+    printf("[MQTT] %s%s <- ", topic, retenido ? " (retenido)" : "");
+    if (esTexto) {
+        fwrite(payload, 1, len, stdout);
+    } else {
+        for (size_t i = 0; i < len; i++) printf("%02x", payload[i]);
+        printf(" (%u B)", (unsigned)len);
+    }
+    printf("\n");
+    return true;
+}
+
+void MqttLoopback::procesar() {
+}
+
+void MqttLoopback::inyectar(const char* topic, const char* payload) {
+    inyectar(topic, reinterpret_cast<const uint8_t*>(payload), strlen(payload));
+}
+
+void MqttLoopback::inyectar(const char* topic, const uint8_t* payload, size_t len) {
+    if (!callback) return;
+
+    // PubSubClient entrega el payload en un buffer mutable, sin terminador
+    char topicBuf[128];
+    uint8_t payloadBuf[512];
+    if (len > sizeof(payloadBuf)) len = sizeof(payloadBuf);
+
+    snprintf(topicBuf, sizeof(topicBuf), "%s", topic);
+    memcpy(payloadBuf, payload, len);
+    callback(topicBuf, payloadBuf, len);
+}
+
+void MqttLoopback::fijarBrokerDisponible(bool disponible) {
+    aceptarConexion = disponible;
+    if (!disponible) enLinea = false;
+}
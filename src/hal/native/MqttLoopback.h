@@ -0,0 +1,33 @@
+#pragma once
+#include "../MqttHal.h"
+
+// Transporte MQTT del host: no abre sockets. Guarda lo publicado y permite
+// inyectar mensajes entrantes como si llegaran del broker.
+class MqttLoopback : public MqttHal {
+    private:
+        Callback callback;
+        bool enLinea;
+        bool aceptarConexion;
+        unsigned long publicados;
+        unsigned long bytes;
+        bool eco;
+
+    public:
+        MqttLoopback(bool eco = true);
+
+        void configurar(const char* servidor, uint16_t puerto) override;
+        void setCallback(Callback cb) override;
+        bool conectar(const char* clientId, const char* usuario, const char* clave) override;
+        bool conectado() override;
+        int estado() override;
+        bool suscribir(const char* topic) override;
+        bool publicar(const char* topic, const uint8_t* payload, size_t len, bool retenido) override;
+        void procesar() override;
+
+        // --- Controles de simulación ---
+        void inyectar(const char* topic, const char* payload);
+        void inyectar(const char* topic, const uint8_t* payload, size_t len);
+        void fijarBrokerDisponible(bool disponible);
+        unsigned long totalPublicados() const { return publicados; }
+        unsigned long totalBytes() const { return bytes; }
+};
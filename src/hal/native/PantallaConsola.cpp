@@ -0,0 +1,89 @@
+#include "PantallaConsola.h"
+#include "../PaginasSsd1306.h"
+#include <stdio.h>
+#include <string.h>
+
+PantallaConsola::PantallaConsola(bool eco)
+    : encendida(true), eco(eco), volcados(0), primerVolcado(true), enviados(0) {
+    memset(lineas, ' ', sizeof(lineas));
+    for (int f = 0; f < FILAS; f++) lineas[f][COLUMNAS] = '\0';
+    memcpy(ultimas, lineas, sizeof(lineas));
+}
+
+bool PantallaConsola::iniciar() {
+    limpiar();
+    return true;
+}
+
+void PantallaConsola::limpiar() {
+    for (int f = 0; f < FILAS; f++) {
+        memset(lineas[f], ' ', COLUMNAS);
+    }
+}
+
+void PantallaConsola::escribir(int16_t x, int16_t y, const char* msg) {
+    int fila = y / 10;
+    int col = x / 6;
+    if (fila < 0 || fila >= FILAS) return;
+
+    for (; *msg && col < COLUMNAS; msg++, col++) {
+        if (col >= 0) lineas[fila][col] = *msg;
+    }
+}
+
+// Cada carácter ocupa 6x8 px; una fila de texto (y = fila*10) cae en una
+// o dos páginas. Se acumula la ventana de columnas cambiadas por página.
+void PantallaConsola::contarVentanas() {
+    int col0[ssd1306::PAGINAS], col1[ssd1306::PAGINAS];
+    for (int p = 0; p < ssd1306::PAGINAS; p++) { col0[p] = ssd1306::ANCHO; col1[p] = -1; }
+
+    for (int f = 0; f < FILAS; f++) {
+        int c0 = 0;
+        while (c0 < COLUMNAS && lineas[f][c0] == ultimas[f][c0]) c0++;
+        if (c0 == COLUMNAS) continue;
+        int c1 = COLUMNAS - 1;
+        while (lineas[f][c1] == ultimas[f][c1]) c1--;
+
+        int pInicio = (f * 10) / 8;
+        int pFin = (f * 10 + 7) / 8;
+        for (int p = pInicio; p <= pFin && p < ssd1306::PAGINAS; p++) {
+            if (c0 * 6 < col0[p]) col0[p] = c0 * 6;
+            if (c1 * 6 + 5 > col1[p]) col1[p] = c1 * 6 + 5;
+        }
+    }
+
+    for (int p = 0; p < ssd1306::PAGINAS; p++) {
+        if (col1[p] >= ssd1306::ANCHO) col1[p] = ssd1306::ANCHO - 1;
+        if (col1[p] >= 0) enviados += ssd1306::BYTES_VENTANA + (col1[p] - col0[p] + 1);
+    }
+}
+
+void PantallaConsola::volcar() {
+    volcados++;
+    if (primerVolcado) {
+        primerVolcado = false;
+        enviados += ssd1306::BYTES_CUADRO + ssd1306::BYTES_VENTANA;
+    } else {
+        contarVentanas();
+    }
+    if (memcmp(lineas, ultimas, sizeof(lineas)) == 0) return;
+    memcpy(ultimas, lineas, sizeof(lineas));
+
+    if (!eco || !encendida) return;
+    printf("+----------------------+\n");
+    for (int f = 0; f < FILAS; f++) printf("|%s|\n", lineas[f]);
+    printf("+----------------------+\n");
+}
+
+void PantallaConsola::encender() {
+    encendida = true;
+}
+
+void PantallaConsola::apagar() {
+    encendida = false;
+}
+
+const char* PantallaConsola::linea(int fila) const {
+    if (fila < 0 || fila >= FILAS) return "";
+    return ultimas[fila];
+}
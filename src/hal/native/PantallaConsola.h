@@ -0,0 +1,37 @@
+#pragma once
+#include "../PantallaHal.h"
+
+// Pantalla del host: guarda las líneas de texto (10 px por fila, como OLED)
+// y las vuelca a stdout solo cuando cambian. Además estima los bytes que
+// el SSD1306 habría recibido con el volcado por ventanas (ver
+// PaginasSsd1306.h), para poder medir el tráfico I2C sin placa.
+class PantallaConsola : public PantallaHal {
+    public:
+        static const int FILAS = 7;
+        static const int COLUMNAS = 22;   // 128 px / 6 px por carácter
+
+    private:
+        char lineas[FILAS][COLUMNAS + 1];
+        char ultimas[FILAS][COLUMNAS + 1];
+        bool encendida;
+        bool eco;
+        unsigned long volcados;
+        bool primerVolcado;
+        uint32_t enviados;
+
+        void contarVentanas();
+
+    public:
+        PantallaConsola(bool eco = true);
+
+        bool iniciar() override;
+        void limpiar() override;
+        void escribir(int16_t x, int16_t y, const char* msg) override;
+        void volcar() override;
+        void encender() override;
+        void apagar() override;
+
+        const char* linea(int fila) const;
+        unsigned long totalVolcados() const { return volcados; }
+        uint32_t bytesEnviados() const override { return enviados; }
+};
@@ -0,0 +1,67 @@
+#include "RtcDateTime.h"
+
+static const uint8_t DIAS_MES[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+uint8_t RtcDateTime::diasDelMes(uint16_t anio, uint8_t mes) {
+    if (mes == 2 && (anio % 4) == 0) return 29; // Válido para 2000-2099
+    return DIAS_MES[mes - 1];
+}
+
+uint16_t RtcDateTime::diasDesde2000(uint16_t anio, uint8_t mes, uint8_t dia) {
+    uint16_t dias = dia - 1;
+    for (uint8_t m = 1; m < mes; m++) {
+        dias += diasDelMes(anio, m);
+    }
+    uint16_t anios = anio - 2000;
+    return dias + 365 * anios + (anios + 3) / 4;
+}
+
+RtcDateTime::RtcDateTime(uint32_t secondsFrom2000) {
+    second = secondsFrom2000 % 60;
+    uint32_t resto = secondsFrom2000 / 60;
+    minute = resto % 60;
+    resto /= 60;
+    hour = resto % 24;
+    uint16_t dias = resto / 24;
+
+    yearFrom2000 = 0;
+    for (;;) {
+        uint16_t diasAnio = ((yearFrom2000 % 4) == 0) ? 366 : 365;
+        if (dias < diasAnio) break;
+        dias -= diasAnio;
+        yearFrom2000++;
+    }
+
+    month = 1;
+    for (;;) {
+        uint8_t diasMes = diasDelMes(2000 + yearFrom2000, month);
+        if (dias < diasMes) break;
+        dias -= diasMes;
+        month++;
+    }
+    dayOfMonth = dias + 1;
+}
+
+RtcDateTime::RtcDateTime(uint16_t year, uint8_t month, uint8_t dayOfMonth,
+                         uint8_t hour, uint8_t minute, uint8_t second)
+    : yearFrom2000(year >= 2000 ? year - 2000 : year),
+      month(month), dayOfMonth(dayOfMonth),
+      hour(hour), minute(minute), second(second) {}
+
+bool RtcDateTime::IsValid() const {
+    return (month >= 1 && month <= 12 &&
+            dayOfMonth >= 1 && dayOfMonth <= diasDelMes(Year(), month) &&
+            hour < 24 && minute < 60 && second < 60);
+}
+
+uint8_t RtcDateTime::DayOfWeek() const {
+    return (TotalDays() + 6) % 7; // 01/01/2000 fue Sábado
+}
+
+uint16_t RtcDateTime::TotalDays() const {
+    return diasDesde2000(Year(), month, dayOfMonth);
+}
+
+uint32_t RtcDateTime::TotalSeconds() const {
+    return ((uint32_t)TotalDays() * 24 + hour) * 3600UL + minute * 60UL + second;
+}
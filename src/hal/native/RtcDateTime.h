@@ -0,0 +1,38 @@
+#pragma once
+#include <stdint.h>
+
+// ==========================================
+// RtcDateTime PARA EL HOST
+// ==========================================
+// Subconjunto de la clase de makuna/RTC con la misma semántica:
+// época 2000-01-01 00:00:00, DayOfWeek() 0 = Domingo.
+class RtcDateTime {
+    private:
+        uint8_t yearFrom2000;
+        uint8_t month;
+        uint8_t dayOfMonth;
+        uint8_t hour;
+        uint8_t minute;
+        uint8_t second;
+
+        static uint8_t diasDelMes(uint16_t anio, uint8_t mes);
+        static uint16_t diasDesde2000(uint16_t anio, uint8_t mes, uint8_t dia);
+
+    public:
+        RtcDateTime(uint32_t secondsFrom2000 = 0);
+        RtcDateTime(uint16_t year, uint8_t month, uint8_t dayOfMonth,
+                    uint8_t hour, uint8_t minute, uint8_t second);
+
+        bool IsValid() const;
+
+        uint16_t Year() const { return 2000 + yearFrom2000; }
+        uint8_t Month() const { return month; }
+        uint8_t Day() const { return dayOfMonth; }
+        uint8_t Hour() const { return hour; }
+        uint8_t Minute() const { return minute; }
+        uint8_t Second() const { return second; }
+
+        uint8_t DayOfWeek() const;
+        uint16_t TotalDays() const;
+        uint32_t TotalSeconds() const;
+};
@@ -0,0 +1,34 @@
+#include "RtcSimulado.h"
+#include "../Hal.h"
+
+RtcSimulado::RtcSimulado(const RtcDateTime& inicial)
+    : segundosBase(inicial.TotalSeconds()), millisBase(0), valida(inicial.IsValid()),
+      derivaPpm(0), lecturas(0) {}
+
+void RtcSimulado::iniciar() {
+    millisBase = hal::millis();
+}
+
+RtcDateTime RtcSimulado::leer() {
+    lecturas++;
+    int64_t transcurrido = hal::millis() - millisBase;
+    transcurrido += transcurrido * derivaPpm / 1000000;
+    return RtcDateTime(segundosBase + (uint32_t)(transcurrido / 1000));
+}
+
+void RtcSimulado::fijarDerivaPpm(int32_t ppm) {
+    // Se rebasa para que el cambio no mueva la hora actual
+    segundosBase = leer().TotalSeconds();
+    millisBase = hal::millis();
+    derivaPpm = ppm;
+}
+
+void RtcSimulado::escribir(const RtcDateTime& fechaHora) {
+    segundosBase = fechaHora.TotalSeconds();
+    millisBase = hal::millis();
+    valida = fechaHora.IsValid();
+}
+
+bool RtcSimulado::esValida() {
+    return valida;
+}
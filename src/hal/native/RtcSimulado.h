@@ -0,0 +1,24 @@
+#pragma once
+#include "../RtcHal.h"
+
+// RTC del host: una fecha de referencia más el millis() simulado
+class RtcSimulado : public RtcHal {
+    private:
+        uint32_t segundosBase;     // Segundos desde 2000 al fijar la hora
+        unsigned long millisBase;  // hal::millis() en ese momento
+        bool valida;
+        int32_t derivaPpm;         // Lo que adelanta el RTC frente a millis()
+        uint32_t lecturas;
+
+    public:
+        RtcSimulado(const RtcDateTime& inicial = RtcDateTime(2025, 1, 1, 0, 0, 0));
+
+        void iniciar() override;
+        RtcDateTime leer() override;
+        void escribir(const RtcDateTime& fechaHora) override;
+        bool esValida() override;
+
+        // Solo simulación
+        void fijarDerivaPpm(int32_t ppm);
+        uint32_t totalLecturas() const { return lecturas; }
+};
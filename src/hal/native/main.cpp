@@ -0,0 +1,240 @@
+// Los tests de PlatformIO (test/, pio test -e native) compilan también
+// src/; este main solo existe fuera de ellos.
+#ifndef PIO_UNIT_TESTING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "Config.h"
+#include "HalNative.h"
+#include "RtcSimulado.h"
+#include "PantallaConsola.h"
+#include "../PaginasSsd1306.h"
+#include "MqttLoopback.h"
+#include "objects/Bomba.h"
+#include "objects/BombaConfig.h"
+#include "objects/Boton.h"
+#include "objects/OLED.h"
+#include "objects/Potenciometro.h"
+#include "objects/Reloj.h"
+#include "objects/AlmacenRegistros.h"
+#include "objects/DiarioRiego.h"
+#include "manager/ConfigManager.h"
+#include "manager/BombaManager.h"
+#include "manager/Planificador.h"
+#include "manager/Perfilador.h"
+#include "manager/Serializador.h"
+#include "menu/MenuBomba.h"
+#include "menu/MenuReloj.h"
+#include "menu/MenuPrincipal.h"
+
+// ==========================================
+// SIMULADOR EN EL HOST ([env:native])
+// ==========================================
+// Mismo cableado que Context.cpp pero sobre la HAL nativa. Ejecuta el lazo
+// de control durante N horas simuladas con el mismo planificador que loop()
+// para poder perfilarlo sin placa:
+//
+//   pio run -e native && .pio/build/native/program [horas] [deriva_rtc_ppm] [reposo]
+//
+// Con reposo=1 la pantalla se da por apagada y el planificador duerme
+// entre eventos, como con BAJO_CONSUMO en la placa.
+
+RtcSimulado rtcHal(RtcDateTime(2025, 1, 6, 7, 0, 0)); // Lunes 07:00
+PantallaConsola pantalla(false);
+MqttLoopback mqtt(false);
+
+Bomba bombas[NUM_ZONAS] = BOMBAS_ZONAS;
+BombaConfig configsZonas[NUM_ZONAS];
+Boton botonManual(PIN_BOTON_MANUAL, 400); // Con doble click
+AlmacenRegistros almacen;
+DiarioRiego diario;
+ConfigManager configManager(configsZonas, NUM_ZONAS, almacen);
+BombaManager bombaManager(bombas, NUM_ZONAS, configManager, rtcHal, botonManual, diario);
+Planificador planificador;
+Perfilador perfilador;     // En el host micros() sale del reloj simulado: cuenta veces, no tiempos
+static int etapaInterfaz = -1;
+static int etapaRiego = -1;
+Boton botonBomba(PIN_BOTON_BOMBA);
+Potenciometro pot(PIN_POT);
+OLED oled(pantalla, 7000);
+Reloj reloj(rtcHal, oled);
+
+MenuBomba menuBomba(oled, botonBomba, pot, configManager);
+MenuReloj menuReloj(oled, botonBomba, pot, reloj);
+MenuPrincipal menuPrincipal(oled, botonBomba, menuBomba, menuReloj);
+
+static unsigned long cambios = 0;
+static uint16_t estadoAnterior = 0;
+static unsigned long lotesDiario = 0;
+static unsigned long subidasDiario = 0;
+
+void tareaInterfaz() {
+    MedidaEtapa medida(perfilador, etapaInterfaz);
+    botonBomba.leerEvento();
+    pot.leer();
+}
+
+// La nube reajusta el horario de una zona cada 5 min, a veces en ráfaga
+// (mismo valor repetido y correcciones seguidas): ejercita el almacén.
+// Lleva su propio ritmo: es el mundo exterior y un despertar no lo adelanta.
+void tareaNube() {
+    static uint8_t vuelta = 0;
+    static unsigned long siguiente = 0;
+    long falta = (long)(siguiente - hal::millis());
+    if (falta > 0) {
+        planificador.proximaEn(falta);
+        return;
+    }
+    siguiente += 300000;
+    uint8_t z = vuelta % NUM_ZONAS;
+    uint8_t inicio = z * 15 + (vuelta / NUM_ZONAS) % 2;
+    for (uint8_t r = 0; r < 3; r++) {
+        configManager.configurarPorDias(z, 0b0111110, 8 + inicio / 60, inicio % 60,
+                                        8 + (inicio + 10) / 60, (inicio + 10) % 60);
+    }
+    vuelta++;
+    planificador.atenderYa();   // Como la red al encolar un comando
+}
+
+// Sube el diario como NetworkManager::vaciarDiario(). El broker no está
+// disponible la primera mitad de la simulación: todo espera en flash.
+void tareaSubida() {
+    if (!mqtt.conectado() && !mqtt.conectar("sim", "", "")) return;
+
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    for (uint8_t i = 0; i < 4; i++) {
+        uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+        if (n == 0) return;
+        char payload[serializar::TAM_DIARIO];
+        size_t len = serializar::diario(payload, CODIFICACION_MSGPACK, lote, n, diario.totalPerdidas());
+        if (!len || !mqtt.publicar("casa/jardin/bomba/diario", (const uint8_t*)payload, len, false)) {
+            diario.rebobinar();
+            return;
+        }
+        diario.confirmar(lote[n - 1].secuencia);
+        lotesDiario++;
+        subidasDiario += n;
+    }
+}
+
+// Pantalla de estado como la del equipo: fecha/hora + zonas, 1 vez/s
+void tareaPantalla() {
+    char estadoTxt[17];
+    snprintf(estadoTxt, sizeof(estadoTxt), "Zonas ON: %d/%d",
+             __builtin_popcount(bombaManager.zonasEncendidas()), NUM_ZONAS);
+    oled.iniciarCuadro();
+    oled.limpiar();
+    reloj.mostrarHora();
+    oled.mostrar(estadoTxt, 0, 2);
+    oled.confirmarCuadro();
+}
+
+void tareaRiego() {
+    reloj.actualizar();
+    {
+        MedidaEtapa medida(perfilador, etapaRiego);
+        bombaManager.Evaluar(reloj.ahora());
+        bombaManager.armarFlanco(reloj.msHasta(bombaManager.proximoCambioHorario()));
+    }
+    configManager.actualizar();
+    diario.actualizar();
+
+    unsigned long ms = bombaManager.msHastaProximoEvento(reloj.ahora());
+    unsigned long guardar = configManager.msHastaGuardar();
+    planificador.proximaEn(guardar < ms ? guardar : ms);
+
+    uint16_t estado = bombaManager.zonasEncendidas();
+    if (estado == estadoAnterior) return;
+
+    RtcDateTime ahora = reloj.ahora();
+    for (uint8_t z = 0; z < NUM_ZONAS; z++) {
+        if (!((estado ^ estadoAnterior) & (1 << z))) continue;
+        printf("%04u-%02u-%02u %02u:%02u:%02u  Zona %u -> %s\n",
+               ahora.Year(), ahora.Month(), ahora.Day(),
+               ahora.Hour(), ahora.Minute(), ahora.Second(),
+               z + 1, (estado & (1 << z)) ? "ON" : "OFF");
+        cambios++;
+    }
+    estadoAnterior = estado;
+}
+
+int main(int argc, char** argv) {
+    unsigned long horas = (argc > 1) ? strtoul(argv[1], NULL, 10) : 24;
+    long derivaRtc = (argc > 2) ? strtol(argv[2], NULL, 10) : 0;   // ppm
+    bool reposo = (argc > 3) && atoi(argv[3]) != 0;
+
+    for (int z = 0; z < NUM_ZONAS; z++) bombas[z].iniciar();
+    pantalla.iniciar();
+    pot.iniciar();
+    botonBomba.iniciar();
+    botonManual.iniciar();
+    rtcHal.iniciar();
+    rtcHal.fijarDerivaPpm(derivaRtc);
+    reloj.iniciar();
+    hal::eepromIniciar(EEPROM_SIZE);
+    configManager.iniciar();
+    diario.iniciar();
+    mqtt.fijarBrokerDisponible(false);
+
+    // Riego escalonado: zona z de lunes a viernes, 08:00 + 15 min * z, 10 min
+    for (uint8_t z = 0; z < NUM_ZONAS; z++) {
+        uint8_t inicio = z * 15;
+        configManager.configurarPorDias(z, 0b0111110, 8 + inicio / 60, inicio % 60,
+                                        8 + (inicio + 10) / 60, (inicio + 10) % 60);
+    }
+
+    planificador.agregar("riego",    tareaRiego,    50, 20, 60000);
+    planificador.agregar("interfaz", tareaInterfaz, 50, 50);
+    planificador.agregar("pantalla", tareaPantalla, 1000, 100);
+    planificador.agregar("nube",     tareaNube,     300000, 1000, 300000);
+    planificador.agregar("subida",   tareaSubida,   10000, 1000, 10000);
+    hal::despertarConPin(PIN_BOTON_MANUAL);
+    hal::despertarConPin(PIN_BOTON_BOMBA);
+    planificador.fijarReposo(reposo);
+    pot.pausar(reposo);                  // Como en la placa: en reposo no se muestrea
+    etapaInterfaz = perfilador.agregar("interfaz");
+    etapaRiego    = perfilador.agregar("riego");
+
+    unsigned long fin = hal::millis() + horas * 3600000UL;
+    unsigned long mitad = hal::millis() + horas * 1800000UL;
+    unsigned long iteraciones = 0;
+    clock_t inicioCpu = clock();
+
+    while (hal::millis() < fin) {
+        if (hal::millis() >= mitad) mqtt.fijarBrokerDisponible(true);
+        planificador.ejecutar();
+        iteraciones++;
+    }
+
+    double cpuMs = 1000.0 * (clock() - inicioCpu) / CLOCKS_PER_SEC;
+    printf("Horas simuladas: %lu, iteraciones: %lu, cambios: %lu\n", horas, iteraciones, cambios);
+    printf("CPU host: %.1f ms (%.3f us/iteracion)\n", cpuMs, 1000.0 * cpuMs / iteraciones);
+    printf("Reloj: %lu lecturas del DS3231, deriva medida %ld ppm (simulada %ld), desfase final %ld s\n",
+           (unsigned long)rtcHal.totalLecturas(), (long)reloj.deriva(), derivaRtc,
+           (long)reloj.ahora().TotalSeconds() - (long)rtcHal.leer().TotalSeconds());
+    unsigned long volcados = pantalla.totalVolcados();
+    printf("OLED: %lu volcados, %lu bytes I2C (%lu con cuadro completo)\n",
+           volcados, (unsigned long)pantalla.bytesEnviados(),
+           volcados * (ssd1306::BYTES_CUADRO + ssd1306::BYTES_VENTANA));
+    printf("Flash: %lu registros escritos, %lu omitidos (iguales), %lu compactaciones; borrados por sector:",
+           (unsigned long)almacen.totalEscrituras(), (unsigned long)almacen.totalOmitidas(),
+           (unsigned long)almacen.totalCompactaciones());
+    for (size_t s = 0; s < hal::flashSectores(hal::FLASH_CONFIG); s++) printf(" %lu", sim::borradosSector(hal::FLASH_CONFIG, s));
+    printf("\n");
+    printf("Diario: %lu subidas en %lu mensajes (%lu bytes MQTT), %lu pendientes, %lu perdidas\n",
+           subidasDiario, lotesDiario, mqtt.totalBytes(), (unsigned long)diario.pendientes(),
+           (unsigned long)diario.totalPerdidas());
+    for (uint8_t i = 0; i < planificador.totalTareas(); i++) {
+        const Tarea& t = planificador.tarea(i);
+        printf("  %-10s %lu ejecuciones, %lu fuera de plazo, peor retraso %lu ms\n",
+               t.nombre, t.ejecuciones, t.excesos, t.peorRetraso);
+    }
+    perfilador.reportar();
+    bombaManager.flancos().reportar();
+    printf("Reposo: %lu ms dormidos (%.1f %%) en %lu siestas\n", sim::totalMsDormidos(),
+           100.0 * sim::totalMsDormidos() / (horas * 3600000UL), sim::totalSiestas());
+    return 0;
+}
+
+#endif // PIO_UNIT_TESTING
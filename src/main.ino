@@ -5,103 +5,269 @@
 // VARIABLES LOCALES DE INTERFAZ
 // ==========================================
 // Solo dejamos aquí lo estrictamente necesario para la UI del Loop
-unsigned long lastMsgMQTT = 0;
 const int UMBRAL_POT = 5;
 int lastPotVal = -1;
 
 // Variables para gestión de pantalla OLED
 unsigned long ultimaInteraccion = 0;
-unsigned long ultimaActualizacionReloj = 0;
 const unsigned long TIEMPO_ENCENDIDO_PANTALLA = 10000; // 10 segundos
 
-// ==========================================
-// SETUP
-// ==========================================
-void setup() {
-    initSystem(); 
-}
+// Etapas del perfilador (se registran en setup(), antes de la tarea de red)
+int etapaRed = -1;
+int etapaBoton = -1;
+int etapaPot = -1;
+int etapaPantalla = -1;
+int etapaRiego = -1;
+int etapaReporte = -1;
+int etapaSensores = -1;
+
+bool bajoConsumo = false;               // Los dos botones pueden despertar al chip
 
 // ==========================================
-// LOOP
+// TAREAS (cada una con su periodo y su plazo)
 // ==========================================
-void loop() {
-    unsigned long ahora = millis();
 
-    // 1. MANTENIMIENTO DE RED (WiFi & MQTT)
-    // Se encarga de reconectar y procesar mensajes entrantes ("ON", "OFF")
+// 1. MANTENIMIENTO DE RED (WiFi & MQTT)
+// Se encarga de reconectar y procesar mensajes entrantes ("ON", "OFF").
+// Corre en el núcleo 0: un TLS colgado no frena el riego (núcleo 1).
+// Solo habla con el control a través de colaComandos / colaEventos.
+void tareaRed() {
+    MedidaEtapa medida(perfilador, etapaRed);
     network.update();
+}
 
-    // 2. LECTURA DE INTERFAZ HUMANA (Menú y Potenciómetro)
-    // Nota: El botón de la BOMBA (manual) se lee dentro de bombaManager.Evaluar()
-    int btnMenu = botonBomba.leerEvento(); // Botón del Menú (Pin 16)
-    
-    int rawPot = pot.leer();       
+#if !CONFIG_FREERTOS_UNICORE
+void bucleRed(void* parametro) {
+    for (;;) {
+        tareaRed();
+        // En reposo se sondea más despacio para dejar dormir al chip
+        vTaskDelay(pdMS_TO_TICKS(planificador.enReposo() ? REPOSO_RED_MS : 10));
+    }
+}
+#endif
+
+// 2. LECTURA DE INTERFAZ HUMANA (Menú y Potenciómetro)
+// Nota: El botón de la BOMBA (manual) se lee dentro de bombaManager.Evaluar()
+// El menú no bloquea: con él abierto cada vuelta es un paso suyo (lee él
+// el botón y el pot) y el riego y el botón manual siguen a su ritmo.
+void tareaInterfaz() {
+    if (menuPrincipal.abierto()) {
+        ultimaInteraccion = millis();    // Pantalla encendida mientras dure (tiene su timeout)
+        // Al cerrarse, lo que se giró el pot dentro no cuenta como actividad
+        if (!menuPrincipal.actualizar()) lastPotVal = pot.leer() / 128;
+        return;
+    }
+
+    int btnMenu;
+    {
+        MedidaEtapa medida(perfilador, etapaBoton);
+        btnMenu = botonBomba.leerEvento(); // Botón del Menú (Pin 16)
+    }
+
+    int rawPot;
+    {
+        MedidaEtapa medida(perfilador, etapaPot);
+        rawPot = pot.leer();
+    }
     int potVal = rawPot / 128; // Escala 0-8 para menús
 
-    // 3. DETECTAR ACTIVIDAD (Para encender pantalla)
+    // DETECTAR ACTIVIDAD (Para encender pantalla)
     if ((btnMenu != 0) || abs(potVal - lastPotVal) > UMBRAL_POT) {
         oled.encender();
-        ultimaInteraccion = ahora; 
+        ultimaInteraccion = millis(); 
         
         // Si pulsó el botón de Menú (Click Largo = 2)
-        if (btnMenu == 2) { 
-            menuPrincipal.mostrarMenu();
-            oled.limpiar();
-            ultimaInteraccion = ahora; // Renovar tiempo de pantalla
-        }
+        if (btnMenu == 2) menuPrincipal.abrir();
     }
     lastPotVal = potVal;
+}
 
-    // 4. GESTIÓN VISUAL (Qué mostrar en la OLED)
-    if (ahora - ultimaInteraccion < TIEMPO_ENCENDIDO_PANTALLA) {
-        // Refrescar cada 1 segundo para no parpadear demasiado
-        if (ahora - ultimaActualizacionReloj >= 1000) { 
-            ultimaActualizacionReloj = ahora;
-            
-            // Si no estás dentro del menú (asumimos que menuPrincipal bloquea si está activo, 
-            // o si es simple, mostramos estado base):
-            
-            oled.limpiar();
-            
-            // Mitad del tiempo mostramos Estado, mitad Reloj (o ambos si caben)
-            if ((ahora - ultimaInteraccion) < TIEMPO_ENCENDIDO_PANTALLA / 2) {
-                // FASE 1: ESTADO BOMBA
-                bool hardwareOn = bomba.estaEncendida(); 
-                String estadoTxt = hardwareOn ? "Bomba: ON" : "Bomba: OFF";
-                oled.mostrar(estadoTxt.c_str(), 0, 0);
-                // Mostrar estado Cloud
-                if(network.isConnected()) oled.mostrar("Cloud: OK", 0, 1);
-                else oled.mostrar("Cloud: ...", 0, 1);
-            } else {
-                // FASE 2: HORA
-                reloj.mostrarHora();
-            }
-        }
-    } else {
+// 3. GESTIÓN VISUAL (Qué mostrar en la OLED), cada 1 segundo
+void tareaPantalla() {
+    unsigned long ahora = millis();
+
+    if (ahora - ultimaInteraccion >= TIEMPO_ENCENDIDO_PANTALLA) {
         oled.apagar(); // Ahorro de energía
+        return;
     }
+    if (menuPrincipal.abierto()) return;    // La pantalla es del menú
 
-    // 5. CEREBRO DE RIEGO (Lógica + Botón Manual)
-    // Evalúa horarios Y lee el botón físico de la bomba (Pin 17)
-    bombaManager.Evaluar(Rtc.GetDateTime());
+    MedidaEtapa medida(perfilador, etapaPantalla);
 
-    // 6. REPORTE DE ESTADO MQTT (Solo si cambia)
-    static bool ultimoEstadoReportado = false; 
-    bool estadoRealBomba = bomba.estaEncendida(); // O bomba.estaEncendida()
+    // Fuera del menú, el estado base. Todo en un cuadro: un solo volcado y
+    // el panel solo recibe lo que cambió desde el anterior.
+    oled.iniciarCuadro();
+    oled.limpiar();
+    
+    // Mitad del tiempo mostramos Estado, mitad Reloj (o ambos si caben)
+    if ((ahora - ultimaInteraccion) < TIEMPO_ENCENDIDO_PANTALLA / 2) {
+        // FASE 1: ESTADO BOMBA (zonas regando / instaladas)
+        int zonasOn = __builtin_popcount(bombaManager.zonasEncendidas()); 
+        char estadoTxt[17];
+        snprintf(estadoTxt, sizeof(estadoTxt), "Zonas ON: %d/%d", zonasOn, NUM_ZONAS);
+        oled.mostrar(estadoTxt, 0, 0);
+        // Mostrar estado Cloud
+        if(network.isConnected()) oled.mostrar("Cloud: OK", 0, 1);
+        else oled.mostrar("Cloud: ...", 0, 1);
+    } else {
+        // FASE 2: HORA
+        reloj.mostrarHora();
+    }
+    oled.confirmarCuadro();
+}
 
-    if (estadoRealBomba != ultimoEstadoReportado) {
-        // Hubo cambio (ON->OFF o OFF->ON)
-        network.publishStatus(estadoRealBomba);
-        ultimoEstadoReportado = estadoRealBomba;
-        
-        Serial.print("Cambio estado -> MQTT: ");
-        Serial.println(estadoRealBomba ? "ON" : "OFF");
+// 4. CEREBRO DE RIEGO (Lógica + Botón Manual)
+// Aplica lo que pidió la nube, evalúa horarios Y lee el botón físico (Pin 17)
+void tareaRiego() {
+    ComandoControl cmd;
+    while (colaComandos.sacar(cmd)) bombaManager.aplicarComando(cmd);
+
+    reloj.actualizar();                  // Casi siempre sin tocar el I2C
+    {
+        MedidaEtapa medida(perfilador, etapaRiego);
+        bombaManager.Evaluar(reloj.ahora());
+        bombaManager.armarFlanco(reloj.msHasta(bombaManager.proximoCambioHorario()));
+    }
+
+    // Confirmamos a la red la config que quedó guardada, venga de la nube,
+    // del menú o del botón (cola llena: el resto en la próxima vuelta)
+    static uint16_t porConfirmar = 0;
+    porConfirmar |= configManager.tomarCambiadas();
+    for (uint16_t m = porConfirmar; m; m &= m - 1) {
+        uint8_t z = __builtin_ctz(m);
+        if (!colaEventos.meterConfig(z, configManager.config(z))) break;
+        porConfirmar &= ~(1 << z);
+    }
+    configManager.actualizar();          // Guarda en flash las ráfagas ya asentadas
+    diario.actualizar();                 // Marca como subido lo que confirmó la red
+
+    // En reposo no hace falta volver antes del próximo cambio del horario,
+    // del fin de un manual o del guardado pendiente
+    unsigned long ms = bombaManager.msHastaProximoEvento(reloj.ahora());
+    unsigned long guardar = configManager.msHastaGuardar();
+    planificador.proximaEn(guardar < ms ? guardar : ms);
+}
+
+// 5. REPORTE DE ESTADO MQTT (Solo las zonas que cambian)
+// El control no publica: deja un evento por zona en la cola para la red.
+// Cuenta como cambio tanto la salida como el override (auto/manual).
+void tareaReporte() {
+    MedidaEtapa medida(perfilador, etapaReporte);
+    static uint16_t ultimoEstadoReportado = 0; 
+    static EstadoOverride ultimoOverride[NUM_ZONAS] = {};
+    uint16_t estadoZonas = bombaManager.zonasEncendidas();
+
+    uint16_t cambios = estadoZonas ^ ultimoEstadoReportado;
+    for (uint8_t z = 0; z < NUM_ZONAS; z++) {
+        if (bombaManager.obtenerOverride(z) != ultimoOverride[z]) cambios |= (1 << z);
+    }
+
+    if (cambios) {
+        for (uint8_t z = 0; z < NUM_ZONAS; z++) {
+            if (!(cambios & (1 << z))) continue;
+            bool encendida = estadoZonas & (1 << z);
+
+            EventoControl ev;
+            ev.tipo = EventoControl::ESTADO_ZONA;
+            ev.zona = z;
+            ev.encendida = encendida;
+            ev.estadoOverride = bombaManager.obtenerOverride(z);
+            if (!colaEventos.meter(ev)) return; // Cola llena: reintentamos en la próxima vuelta
+
+            if (encendida) ultimoEstadoReportado |= (1 << z);
+            else ultimoEstadoReportado &= ~(1 << z);
+            ultimoOverride[z] = ev.estadoOverride;
+            Serial.printf("Cambio zona %d -> MQTT: %s (%s)\n", z + 1, encendida ? "ON" : "OFF",
+                          serializar::nombreOverride(ev.estadoOverride));
+        }
         
         // Forzamos encender pantalla para que el usuario vea que pasó algo
         oled.encender();
-        ultimaInteraccion = ahora;
+        ultimaInteraccion = millis();
+    }
+}
+
+// 6. DIAGNÓSTICO: avisa por Serial de las tareas que se pasan de plazo y
+// vuelca los histogramas de cada etapa (la red los publica en .../diagnostico)
+void tareaDiagnostico() {
+    planificador.reportar();
+    perfilador.reportar();
+    bombaManager.flancos().reportar();
+    sensores.reportar();
+    monitorBomba.reportar();
+}
+
+// 7. SENSORES DE LÍNEA (presión, caudal y corriente de la bomba)
+// Filtra el ADC y, ante una anomalía, abre los relés desde aquí mismo: el
+// corte no espera a tareaRiego, que en reposo puede tardar un minuto.
+// Va en el núcleo 1 por encima de loop(), así que interrumpe una pasada.
+void tareaSensores() {
+    MedidaEtapa medida(perfilador, etapaSensores);
+    sensores.actualizar();
+    monitorBomba.actualizar();
+}
+
+#if !CONFIG_FREERTOS_UNICORE
+void bucleSensores(void* parametro) {
+    for (;;) {
+        tareaSensores();
+        vTaskDelay(pdMS_TO_TICKS(bombaManager.zonasActivas() ? SENSORES_MS : REPOSO_SENSORES_MS));
     }
+}
+#endif
+
+// ==========================================
+// SETUP
+// ==========================================
+void setup() {
+    etapaRed      = perfilador.agregar("red");
+    etapaBoton    = perfilador.agregar("boton");
+    etapaPot      = perfilador.agregar("pot");
+    etapaPantalla = perfilador.agregar("pantalla");
+    etapaRiego    = perfilador.agregar("riego");
+    etapaReporte  = perfilador.agregar("reporte");
+    etapaSensores = perfilador.agregar("sensores");
+    initSystem();                        // network.iniciar() añade "publicar"
+
+    // En reposo (pantalla apagada) solo riego, diag y la red marcan el
+    // ritmo; las demás corren al despertar
+    //                   nombre        función           periodo  plazo  reposo (ms)
+    planificador.agregar("riego",      tareaRiego,       50,      20,    60000);
+    planificador.agregar("interfaz",   tareaInterfaz,    50,      50);
+    planificador.agregar("reporte",    tareaReporte,     100,     200);
+    planificador.agregar("pantalla",   tareaPantalla,    1000,    100);
+    planificador.agregar("diag",       tareaDiagnostico, 60000,   1000,  60000);
+
+    // La red va aparte, en el núcleo 0 (loop() ya corre en el 1), y los
+    // sensores en el 1 con más prioridad que loop()
+#if CONFIG_FREERTOS_UNICORE
+    planificador.agregar("red",        tareaRed,         20,      100,   REPOSO_RED_MS);
+    planificador.agregar("sensores",   tareaSensores,    SENSORES_MS, 5, REPOSO_SENSORES_MS);
+#else
+    xTaskCreatePinnedToCore(bucleRed, "red", 8192, NULL, 1, NULL, 0);
+    xTaskCreatePinnedToCore(bucleSensores, "sensores", 3072, NULL, 2, NULL, 1);
+#endif
+
+#if BAJO_CONSUMO
+    // Sin interrupción en los botones una pulsación no despertaría: no se duerme
+    bajoConsumo = hal::despertarConPin(PIN_BOTON_BOMBA) && hal::despertarConPin(PIN_BOTON_MANUAL);
+    if (bajoConsumo && !hal::bajoConsumoIniciar()) {
+        Serial.println(F("Sin light sleep automatico: el reposo solo deja la CPU parada"));
+    }
+#endif
+}
+
+// ==========================================
+// LOOP
+// ==========================================
+void loop() {
+    // Con la pantalla apagada y ningún botón a medias no mira nadie: reposo.
+    // El pot tampoco se mira: sin riego (sensores en pausa) el ADC se para
+    bool reposo = bajoConsumo && !oled.estaEncendido() &&
+                  !botonBomba.ocupado() && !botonManual.ocupado();
+    planificador.fijarReposo(reposo);
+    pot.pausar(reposo);
 
-    // Pequeño respiro para estabilidad
-    delay(10); 
+    // Corre la tarea más urgente o duerme justo hasta que venza la siguiente
+    planificador.ejecutar();
 }
\ No newline at end of file
@@ -1,144 +1,390 @@
 #include "BombaManager.h"
+#include "../hal/Hal.h"
+
+static const uint32_t SEGUNDOS_DIA = 86400UL;
+
+// Disparos de cron solapados que se encadenan buscando el final de la
+// racha; si sigue más allá (p.ej. "* * * * *") se vuelve a mirar luego
+static const uint8_t MAX_ENCADENADOS = 64;
 
 // Constructor
-BombaManager::BombaManager(Bomba& bomba, BombaConfig& configBomba, RtcDS3231<TwoWire>& rtc, Boton& btnManual)
-    : bomba(bomba), configBomba(configBomba), Rtc(rtc), btnManual(btnManual) {}
+BombaManager::BombaManager(Bomba* bombas, uint8_t numZonas, ConfigManager& configManager, RtcHal& rtc, Boton& btnManual,
+                           DiarioRiego& diario)
+    : bombas(bombas), numZonas(numZonas > NUM_ZONAS ? NUM_ZONAS : numZonas),
+      configManager(configManager), Rtc(rtc), btnManual(btnManual), diario(diario),
+      conmutador(bombas, this->numZonas) {
+    for (uint8_t z = 0; z < MAX_ZONAS; z++) {
+        proximoCambio[z] = 0;
+        inicioManual[z] = 0;
+        encendidaDesde[z] = 0;
+        causaOverride[z] = CAUSA_HORARIO;
+    }
+}
 
 // ======================================================
 // EVALUAR (CEREBRO CENTRAL)
 // ======================================================
 void BombaManager::Evaluar(const RtcDateTime& now) {
 
-    // 1. ¿QUÉ DICE EL HORARIO? (Cálculo puro)
-    bool deberiaEstarEncendido = calcularSiDebeEstarEncendido(now);
+    // 1. ¿QUÉ DICE EL HORARIO? (Compilado: solo se recalcula en el flanco)
+    uint32_t ahora = now.TotalSeconds();
+
+    // Si el disparo ya conmutó el flanco, ese segundo ha empezado aunque
+    // la hora leída vaya unos ms por detrás: si no, se desharía el cambio
+    uint32_t conmutado = conmutador.segundoConmutado();
+    if (conmutado > ahora && conmutado - ahora <= 1) ahora = conmutado;
+    if (revisionCompilada != configManager.obtenerRevision() || ahora < compiladoEn) {
+        // Config nueva o reloj atrasado -> recompilar todas las zonas
+        revisionCompilada = configManager.obtenerRevision();
+        mascaraDesactivada = 0;
+        for (uint8_t z = 0; z < numZonas; z++) {
+            proximoCambio[z] = 0;
+            if (configManager.config(z).desactivarHoy) mascaraDesactivada |= (1 << z);
+        }
+        // El mapa semanal solo depende de la config, no de la hora
+        if (revisionCompilada != revisionSemanas) {
+            revisionSemanas = revisionCompilada;
+            mascaraSemanal = 0;
+            for (uint8_t z = 0; z < numZonas; z++) {
+                if (semanas[z].compilar(configManager.config(z))) mascaraSemanal |= (1 << z);
+            }
+        }
+        proximoGlobal = 0;
+    }
 
-    // 2. ¿QUÉ DICE EL BOTÓN FÍSICO?
+    if (ahora >= proximoGlobal) {
+        proximoGlobal = SIN_CAMBIO;
+        for (uint8_t z = 0; z < numZonas; z++) {
+            if (ahora >= proximoCambio[z]) compilarZona(z, ahora);
+            if (proximoCambio[z] < proximoGlobal) proximoGlobal = proximoCambio[z];
+        }
+        compiladoEn = ahora;
+    }
+
+    // 2. ¿QUÉ DICE EL BOTÓN FÍSICO? (Zona 1)
     int click = btnManual.leerEvento(); 
 
     if (click == 1) { // CLICK CORTO -> TOGGLE (Natural)
-        Serial.println("Boton Manual: Click detectado");
+        hal::log("Boton Manual: Click detectado");
         
-        if (bomba.estaEncendida()) {
+        if (mascaraEncendidas & 1) {
             // Si está encendida (por horario o manual) -> APAGAR
-            estadoOverride = MANUAL_OFF;
-            Serial.println("-> Accion: Forzar APAGADO");
+            forzarManual(0, false, CAUSA_BOTON);
+            hal::log("-> Accion: Forzar APAGADO");
         } else {
             // Si está apagada -> ENCENDER
-            estadoOverride = MANUAL_ON;
-            inicioManual = millis();
-            Serial.println("-> Accion: Forzar ENCENDIDO");
+            forzarManual(0, true, CAUSA_BOTON);
+            hal::log("-> Accion: Forzar ENCENDIDO");
         }
     } 
-    else if (click == 2) { // CLICK LARGO -> RESET TOTAL
-        Serial.println("Boton Manual: Click Largo -> RESET A AUTO");
-        estadoOverride = AUTO;
-        configBomba.desactivarHoy = false; // Reactivamos si estaba bloqueado
+    else if (click == 2) { // CLICK LARGO -> RESET TOTAL (todas las zonas)
+        hal::log("Boton Manual: Click Largo -> RESET A AUTO");
+        for (uint8_t z = 0; z < numZonas; z++) {
+            resetAutomator(z, CAUSA_BOTON);
+            configManager.reactivarHoy(z);     // Reactivamos si estaba bloqueado
+        }
+        mascaraDesactivada = 0;
+    }
+    else if (click == 3) { // DOBLE CLICK -> APAGAR TODAS LAS ZONAS
+        hal::log("Boton Manual: Doble Click -> TODO APAGADO");
+        for (uint8_t z = 0; z < numZonas; z++) forzarManual(z, false, CAUSA_BOTON);
     }
 
-    // 3. SEGURIDAD (Timeout)
-    if (estadoOverride == MANUAL_ON) {
-        if (millis() - inicioManual > TIEMPO_MAXIMO_MANUAL) {
-            Serial.println("Tiempo manual excedido -> Vuelta a Auto");
-            estadoOverride = AUTO; 
+    // 3. SEGURIDAD (Timeout y cortes de los sensores)
+    // El sensor ya abrió el relé; aquí queda como override para que nadie
+    // lo vuelva a cerrar, y se reescribe por si un flanco se cruzó con él
+    uint32_t cortes = cortesSensor.exchange(0, std::memory_order_acq_rel);
+    uint16_t porCorriente = (cortes >> 16) & ((1u << numZonas) - 1);
+    uint16_t cortadas = (cortes | porCorriente) & ((1u << numZonas) - 1);
+    for (uint16_t m = cortadas; m; m &= m - 1) {
+        uint8_t z = __builtin_ctz(m);
+        hal::log("Sensor fuera de rango -> Zona cortada");
+        forzarManual(z, false, (porCorriente & (1 << z)) ? CAUSA_CORRIENTE : CAUSA_SENSOR);
+    }
+
+    if (mascaraManualOn) {
+        unsigned long ms = hal::millis();
+        for (uint8_t z = 0; z < numZonas; z++) {
+            if ((mascaraManualOn & (1 << z)) && ms - inicioManual[z] > TIEMPO_MAXIMO_MANUAL) {
+                hal::log("Tiempo manual excedido -> Vuelta a Auto");
+                resetAutomator(z, CAUSA_TIMEOUT);
+            }
         }
     }
     
     // 4. RESET INTELIGENTE DE 'MANUAL OFF'
     // Si forzaste apagado, pero el horario ya terminó, volvemos a AUTO
     // para que mañana funcione normal sin que tengas que tocar nada.
-    if (estadoOverride == MANUAL_OFF && !deberiaEstarEncendido) {
-        estadoOverride = AUTO;
-    }
+    mascaraManualOff &= mascaraHorario;
 
     // 5. EJECUCIÓN FINAL (Solo aquí tocamos el hardware)
-    switch (estadoOverride) {
-        case MANUAL_ON:
-            bomba.ActivarBomba();
-            break;
-            
-        case MANUAL_OFF:
-            bomba.ApagarBomba();
-            break;
-            
-        case AUTO:
-            // En auto, respetamos el "desactivarHoy" (emergencia)
-            if (configBomba.desactivarHoy) {
-                bomba.ApagarBomba();
-            } else if (deberiaEstarEncendido) {
-                bomba.ActivarBomba();
-            } else {
-                bomba.ApagarBomba();
-            }
-            break;
+    // En auto respetamos el "desactivarHoy" (emergencia); los overrides mandan.
+    uint16_t deseado = (mascaraHorario & ~mascaraDesactivada & ~mascaraManualOff) | mascaraManualOn;
+
+    // Lo que el disparo ya escribió en el flanco no se vuelve a escribir
+    uint16_t conmutadasEncendidas;
+    uint16_t conmutadas = conmutador.recoger(conmutadasEncendidas);
+    uint16_t enSalidas = (mascaraEncendidas & ~conmutadas) | (conmutadasEncendidas & conmutadas) | cortadas;
+
+    // Solo escribimos los GPIO de las zonas que cambian
+    uint16_t escribir = deseado ^ enSalidas;
+    while (escribir) {
+        uint8_t z = __builtin_ctz(escribir);
+        escribir &= escribir - 1;
+        if (deseado & (1 << z)) bombas[z].ActivarBomba();
+        else bombas[z].ApagarBomba();
+    }
+
+    // Y cada cambio, al diario (lo haya escrito quien lo haya escrito)
+    uint16_t cambios = deseado ^ mascaraEncendidas;
+    while (cambios) {
+        uint8_t z = __builtin_ctz(cambios);
+        cambios &= cambios - 1;
+        bool encender = deseado & (1 << z);
+
+        CausaCambio causa = (mascaraTocada & (1 << z)) ? causaOverride[z] : CAUSA_HORARIO;
+        uint32_t duracion = 0;
+        if (encender) encendidaDesde[z] = ahora;
+        else if (ahora > encendidaDesde[z]) duracion = ahora - encendidaDesde[z];
+        diario.anotar(z, encender, causa, ahora, duracion);
+    }
+    mascaraEncendidas = deseado;
+    mascaraTocada = 0;
+    salidasActivas.store(deseado, std::memory_order_release);
+}
+
+// ======================================================
+// FLANCO PROGRAMADO
+// ======================================================
+// Lo que quedará tras el próximo cambio del horario con los overrides de
+// ahora; si entre tanto cambian, la siguiente llamada lo rearma.
+void BombaManager::armarFlanco(unsigned long msHasta) {
+    if (proximoGlobal == SIN_CAMBIO || msHasta == 0) {
+        conmutador.cancelar();          // Ya toca: lo hace la pasada normal
+        return;
+    }
+
+    uint16_t horarioSiguiente = mascaraHorario;
+    for (uint8_t z = 0; z < numZonas; z++) {
+        if (proximoCambio[z] == proximoGlobal) horarioSiguiente ^= 1 << z;
     }
+    horarioSiguiente ^= (horarioSiguiente ^ mascaraHorario) & mascaraRevisar;
+    uint16_t siguiente = (horarioSiguiente & ~mascaraDesactivada & ~mascaraManualOff) | mascaraManualOn;
+    conmutador.programar(proximoGlobal, msHasta, siguiente ^ mascaraEncendidas, siguiente);
 }
 
 // ======================================================
 // CONTROLES EXTERNOS (Para MQTT)
 // ======================================================
-void BombaManager::forzarManual(bool encender) {
+void BombaManager::forzarManual(uint8_t zona, bool encender, CausaCambio causa) {
+    if (zona >= numZonas) return;
+    uint16_t bit = 1 << zona;
+    mascaraTocada |= bit;
+    causaOverride[zona] = causa;
+
     if (encender) {
-        estadoOverride = MANUAL_ON;
-        inicioManual = millis();
+        mascaraManualOn |= bit;
+        mascaraManualOff &= ~bit;
+        inicioManual[zona] = hal::millis();
     } else {
-        estadoOverride = MANUAL_OFF;
+        mascaraManualOff |= bit;
+        mascaraManualOn &= ~bit;
     }
 }
 
-void BombaManager::resetAutomator() {
-    estadoOverride = AUTO;
+// Corre en la tarea de sensores: solo GPIO y atómicos, como el disparo del
+// conmutador. Ese disparo podría volver a cerrar el relé antes de la
+// pasada; la pasada, despierta aquí mismo, lo abre otra vez.
+void BombaManager::cortarPorSensor(uint16_t zonas, CausaCambio causa) {
+    for (uint16_t m = zonas; m; m &= m - 1) {
+        uint8_t z = __builtin_ctz(m);
+        if (z >= numZonas) break;
+        bombas[z].ApagarBomba();
+    }
+    cortesSensor.fetch_or(causa == CAUSA_CORRIENTE ? (uint32_t)zonas << 16 : zonas, std::memory_order_acq_rel);
+    hal::despertar();
 }
 
-void BombaManager::ActualizarConfigBomba(const BombaConfig& nuevaConfig) {
-    configBomba = nuevaConfig;
+void BombaManager::resetAutomator(uint8_t zona, CausaCambio causa) {
+    if (zona >= numZonas) return;
+    mascaraTocada |= 1 << zona;
+    causaOverride[zona] = causa;
+    mascaraManualOn &= ~(1 << zona);
+    mascaraManualOff &= ~(1 << zona);
 }
 
-// ======================================================
-// LÓGICA DE CÁLCULO DE HORARIOS (Devuelven bool)
-// ======================================================
-bool BombaManager::calcularSiDebeEstarEncendido(const RtcDateTime& now) {
-    if (!configBomba.habilitada) return false;
+void BombaManager::ActualizarConfigBomba(uint8_t zona, const BombaConfig& nuevaConfig) {
+    configManager.aplicarConfig(zona, nuevaConfig); // Sube la revisión -> se recompila
+}
+
+bool BombaManager::aplicarComando(const ComandoControl& cmd) {
+    if (cmd.zona >= numZonas) return false;
 
-    switch (configBomba.modo) {
-        case POR_DIAS:      return checkPorDias(now);
-        case POR_INTERVALO: return checkPorIntervalo(now);
-        case POR_FECHA:     return checkPorFecha(now);
-        default:            return false;
+    switch (cmd.tipo) {
+        case ComandoControl::MANUAL_ON:
+            forzarManual(cmd.zona, true);
+            return false;
+
+        case ComandoControl::MANUAL_OFF:
+            forzarManual(cmd.zona, false);
+            return false;
+
+        case ComandoControl::MANUAL_AUTO:
+            resetAutomator(cmd.zona);
+            return false;
+
+        case ComandoControl::CONFIGURAR: {
+            const BombaConfig& c = cmd.config;
+            switch (c.modo) {
+                case POR_DIAS:
+                    configManager.configurarPorDias(cmd.zona, c.diasSemana, c.horaInicio, c.minutoInicio, c.horaFin, c.minutoFin);
+                    return true;
+                case POR_INTERVALO:
+                    configManager.configurarPorIntervalo(cmd.zona, c.intervaloDias, c.fechaInicio, c.horaInicio, c.minutoInicio, c.horaFin, c.minutoFin);
+                    return true;
+                case POR_FECHA:
+                    configManager.configurarPorFecha(cmd.zona, c.proximaFecha, c.horaInicio, c.minutoInicio, c.horaFin, c.minutoFin);
+                    return true;
+                case SEMANAL:
+                    return configManager.configurarSemanal(cmd.zona, c.tramos, c.numTramos);
+                case CRON:
+                    return configManager.configurarCron(cmd.zona, c.cron);
+                default:
+                    return false;
+            }
+        }
+
+        case ComandoControl::CODIFICACION:
+            return false;   // Lo resuelve la red, no debería llegar aquí
+    }
+    return false;
+}
+
+unsigned long BombaManager::msHastaProximoEvento(const RtcDateTime& now) const {
+    uint32_t ahora = now.TotalSeconds();
+    unsigned long ms = SIN_CAMBIO;
+    if (proximoGlobal != SIN_CAMBIO) ms = proximoGlobal > ahora ? (proximoGlobal - ahora) * 1000UL : 0;
+
+    if (mascaraManualOn) {
+        unsigned long ahoraMs = hal::millis();
+        for (uint8_t z = 0; z < numZonas; z++) {
+            if (!(mascaraManualOn & (1 << z))) continue;
+            unsigned long pasado = ahoraMs - inicioManual[z];
+            unsigned long falta = pasado > TIEMPO_MAXIMO_MANUAL ? 0 : TIEMPO_MAXIMO_MANUAL - pasado + 1;
+            if (falta < ms) ms = falta;
+        }
     }
+    return ms;
 }
 
-bool BombaManager::checkPorDias(const RtcDateTime& now) {
-    bool activoHoy = configBomba.diasSemana & (1 << now.DayOfWeek());
-    if (!activoHoy) return false;
-    return estaEnHorario(now);
+EstadoOverride BombaManager::obtenerOverride(uint8_t zona) const {
+    if (zona >= numZonas) return AUTO;
+    if (mascaraManualOn & (1 << zona)) return MANUAL_ON;
+    if (mascaraManualOff & (1 << zona)) return MANUAL_OFF;
+    return AUTO;
 }
 
-bool BombaManager::checkPorIntervalo(const RtcDateTime& now) {
-    RtcDateTime inicio(configBomba.fechaInicio.anio, configBomba.fechaInicio.mes, configBomba.fechaInicio.dia, configBomba.horaInicio, configBomba.minutoInicio, 0);
-    int64_t inicioSecs = (int64_t)inicio.TotalSeconds();
-    int64_t nowSecs = (int64_t)now.TotalSeconds();
-    int64_t diasPasados = (nowSecs - inicioSecs) / 86400LL;
+// ======================================================
+// COMPILACIÓN DEL HORARIO (Solo calcula, no actúa)
+// ======================================================
+// Deja en 'mascaraHorario' lo que pide el horario de la zona ahora mismo y
+// en 'proximoCambio[zona]' el segundo exacto en que eso cambia. Mientras no
+// se llegue a ese instante ni cambie la config, Evaluar() no recalcula nada.
+void BombaManager::compilarZona(uint8_t zona, uint32_t ahora) {
+    const BombaConfig& cfg = configManager.config(zona);
+    uint16_t bit = 1 << zona;
 
-    if (diasPasados < 0) return false;
-    
-    if ((diasPasados % configBomba.intervaloDias) == 0) {
-        return estaEnHorario(now);
+    mascaraHorario &= ~bit;
+    mascaraRevisar &= ~bit;
+    proximoCambio[zona] = SIN_CAMBIO;
+
+    if (!cfg.habilitada) return;
+
+    if (cfg.modo == CRON) {
+        compilarCron(zona, cfg.cron, ahora);
+        return;
+    }
+
+    // Modos semanales: el estado es un bit del mapa y el cambio, el final
+    // de esa racha (siempre en un minuto en punto)
+    if (mascaraSemanal & bit) {
+        uint16_t minuto = HorarioSemanal::minutoDeSemana(ahora);
+        if (semanas[zona].encendido(minuto)) mascaraHorario |= bit;
+        uint16_t falta = semanas[zona].minutosHastaCambio(minuto);
+        if (falta) proximoCambio[zona] = (ahora / 60 + falta) * 60;
+        return;
+    }
+
+    uint32_t inicioSeg = (cfg.horaInicio * 60UL + cfg.minutoInicio) * 60UL;
+    uint32_t finSeg    = (cfg.horaFin * 60UL + cfg.minutoFin) * 60UL;
+    if (inicioSeg >= finSeg) return; // Ventana vacía: nunca enciende
+
+    uint32_t hoy = ahora / SEGUNDOS_DIA;
+    uint32_t segHoy = ahora % SEGUNDOS_DIA;
+
+    // ¿Estamos dentro de la ventana de hoy? -> se apaga al final de la ventana
+    if (segHoy >= inicioSeg && segHoy < finSeg && diaActivo(cfg, hoy)) {
+        mascaraHorario |= bit;
+        proximoCambio[zona] = hoy * SEGUNDOS_DIA + finSeg;
+        return;
+    }
+
+    // Si no, se enciende al inicio de la ventana del próximo día activo
+    uint32_t dia = proximoDiaActivo(cfg, segHoy < inicioSeg ? hoy : hoy + 1);
+    if (dia != SIN_CAMBIO) {
+        proximoCambio[zona] = dia * SEGUNDOS_DIA + inicioSeg;
     }
-    return false;
 }
 
-bool BombaManager::checkPorFecha(const RtcDateTime& now) {
-    if (now.Year() == configBomba.proximaFecha.anio &&
-        now.Month() == configBomba.proximaFecha.mes &&
-        now.Day() == configBomba.proximaFecha.dia) {
-        return estaEnHorario(now);
+// Encendida si algún disparo de los últimos 'duracion' minutos sigue
+// regando; el cambio es el fin de la racha (disparos que se solapan o se
+// tocan la alargan) o, apagada, el próximo disparo
+void BombaManager::compilarCron(uint8_t zona, const HorarioCron& cron, uint32_t ahora) {
+    uint16_t bit = 1 << zona;
+    uint32_t duracion = cron.duracion * 60UL;
+
+    uint32_t inicio = cron::siguiente(cron, ahora >= duracion ? ahora - duracion + 1 : 0);
+    if (inicio == cron::SIN_DISPARO) return;
+    if (inicio > ahora) {
+        proximoCambio[zona] = inicio;
+        return;
     }
-    return false;
+
+    mascaraHorario |= bit;
+    for (uint8_t i = 0; i < MAX_ENCADENADOS; i++) {
+        uint32_t otro = cron::siguiente(cron, inicio + 60);
+        if (otro == cron::SIN_DISPARO || otro > inicio + duracion) {
+            proximoCambio[zona] = inicio + duracion;
+            return;
+        }
+        inicio = otro;
+    }
+    mascaraRevisar |= bit;
+    proximoCambio[zona] = inicio > ahora ? inicio : ahora - ahora % 60 + 60;
 }
 
-bool BombaManager::estaEnHorario(const RtcDateTime& now) {
-    int actualMin = now.Hour() * 60 + now.Minute();
-    int inicioMin = configBomba.horaInicio * 60 + configBomba.minutoInicio;
-    int finMin    = configBomba.horaFin * 60 + configBomba.minutoFin;
-    return (actualMin >= inicioMin && actualMin < finMin);
+bool BombaManager::diaActivo(const BombaConfig& cfg, uint32_t dia) {
+    return proximoDiaActivo(cfg, dia) == dia;
+}
+
+// Primer día (días desde 2000-01-01) >= 'desde' en el que toca regar
+uint32_t BombaManager::proximoDiaActivo(const BombaConfig& cfg, uint32_t desde) {
+    // POR_DIAS y SEMANAL van por el mapa semanal
+    switch (cfg.modo) {
+        case POR_INTERVALO: {
+            if (cfg.intervaloDias == 0) return SIN_CAMBIO;
+            RtcDateTime inicio(cfg.fechaInicio.anio, cfg.fechaInicio.mes, cfg.fechaInicio.dia, 0, 0, 0);
+            uint32_t ancla = inicio.TotalSeconds() / SEGUNDOS_DIA;
+            if (desde <= ancla) return ancla;
+            uint32_t resto = (desde - ancla) % cfg.intervaloDias;
+            return (resto == 0) ? desde : desde + (cfg.intervaloDias - resto);
+        }
+        case POR_FECHA: {
+            RtcDateTime fecha(cfg.proximaFecha.anio, cfg.proximaFecha.mes, cfg.proximaFecha.dia, 0, 0, 0);
+            uint32_t dia = fecha.TotalSeconds() / SEGUNDOS_DIA;
+            return (dia >= desde) ? dia : SIN_CAMBIO;
+        }
+        default:
+            return SIN_CAMBIO;
+    }
 }
\ No newline at end of file
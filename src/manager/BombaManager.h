@@ -2,44 +2,109 @@
 #include "../objects/Bomba.h"
 #include "../objects/BombaConfig.h"
 #include "../objects/Boton.h" // Usamos Botón, no Switch
-#include <Wire.h>
-#include <RtcDS3231.h>
+#include "../objects/ConmutadorProgramado.h"
+#include "../objects/Cron.h"
+#include "../objects/DiarioRiego.h"
+#include "../objects/HorarioSemanal.h"
+#include "../manager/ConfigManager.h"
+#include "../manager/Comandos.h"
+#include "../hal/RtcHal.h"
+#include "Config.h"
 
 // Estados de prioridad
-enum EstadoOverride {
-    AUTO,       // Manda el horario
-    MANUAL_ON,  // Forzado ON (Ignora horario)
-    MANUAL_OFF  // Forzado OFF (Ignora horario)
-};
-
+// ==========================================
+// GESTOR DE ZONAS
+// ==========================================
+// Cada zona (bomba o válvula) tiene su horario y su override, guardados en
+// arrays paralelos y máscaras de bits (bit z = zona z). Una sola pasada
+// evalúa todas las zonas: en reposo cuesta lo mismo que una.
 class BombaManager {
+public:
+    static const uint32_t SIN_CAMBIO = 0xFFFFFFFF; // El horario no vuelve a cambiar
+
 private:
-    Bomba& bomba;
-    BombaConfig& configBomba;
-    RtcDS3231<TwoWire>& Rtc;
-    Boton& btnManual; // Referencia al botón físico (Pin 17)
-
-    // Variables de Control Manual
-    EstadoOverride estadoOverride = AUTO;
-    unsigned long inicioManual = 0;
+    Bomba* bombas;    // Array de salidas, una por zona
+    uint8_t numZonas;
+    ConfigManager& configManager;
+    RtcHal& Rtc;
+    Boton& btnManual; // Referencia al botón físico (Pin 17) -> actúa sobre la zona 1
+    DiarioRiego& diario;
+    ConmutadorProgramado conmutador;  // Escribe los GPIO justo en el flanco del horario
+
+    // --- Compartido con la tarea de sensores ---
+    std::atomic<uint16_t> salidasActivas{0};  // Copia de mascaraEncendidas
+    std::atomic<uint32_t> cortesSensor{0};    // Cortadas sin recoger (0-15: CAUSA_SENSOR, 16-31: CAUSA_CORRIENTE)
+
     const unsigned long TIEMPO_MAXIMO_MANUAL = 3600000; // 1 Hora seguridad
 
-    // Métodos auxiliares que solo CALCULAN (retornan bool), no actúan
-    bool calcularSiDebeEstarEncendido(const RtcDateTime& now);
-    bool checkPorDias(const RtcDateTime& now);
-    bool checkPorIntervalo(const RtcDateTime& now);
-    bool checkPorFecha(const RtcDateTime& now);
-    bool estaEnHorario(const RtcDateTime& now);
+    // --- Máscaras de estado (bit z = zona z) ---
+    uint16_t mascaraHorario = 0;      // Lo que pide el horario compilado
+    uint16_t mascaraManualOn = 0;     // Override MANUAL_ON
+    uint16_t mascaraManualOff = 0;    // Override MANUAL_OFF
+    uint16_t mascaraDesactivada = 0;  // Copia de 'desactivarHoy' de cada config
+    uint16_t mascaraEncendidas = 0;   // Lo que se escribió en los GPIO
+    uint16_t mascaraTocada = 0;       // Overrides cambiados desde la última pasada
+    uint16_t mascaraSemanal = 0;      // Zonas que se miran en su mapa semanal
+    uint16_t mascaraRevisar = 0;      // Su proximoCambio no es un flanco: solo se vuelve a mirar
+
+    // --- Arrays paralelos por zona ---
+    // Horario compilado: "en proximoCambio[z] la zona z pasa a !horario"
+    // (salvo en mascaraRevisar, donde solo toca recompilar).
+    // Tiempos en segundos desde 2000-01-01 (RtcDateTime::TotalSeconds).
+    uint32_t proximoCambio[MAX_ZONAS];
+    unsigned long inicioManual[MAX_ZONAS];
+    uint32_t encendidaDesde[MAX_ZONAS];   // Para la duración en el diario
+    CausaCambio causaOverride[MAX_ZONAS]; // Quién tocó el override (si mascaraTocada)
+    HorarioSemanal semanas[NUM_ZONAS];    // POR_DIAS y SEMANAL compilados (1,3 KB cada uno: solo las zonas cableadas)
+
+    uint32_t proximoGlobal = 0;       // min(proximoCambio): 0 = compilar ya
+    uint32_t compiladoEn = 0;         // Para detectar que el reloj fue atrasado
+    uint16_t revisionCompilada = 0;
+    uint16_t revisionSemanas = 0xFFFF; // De la config que hay en 'semanas'
+
+    // Métodos auxiliares que solo CALCULAN, no actúan
+    void compilarZona(uint8_t zona, uint32_t ahora);
+    void compilarCron(uint8_t zona, const HorarioCron& cron, uint32_t ahora);
+    bool diaActivo(const BombaConfig& cfg, uint32_t dia);
+    uint32_t proximoDiaActivo(const BombaConfig& cfg, uint32_t desde);
 
 public:
-    // Constructor recibe Boton
-    BombaManager(Bomba& bomba, BombaConfig& configBomba, RtcDS3231<TwoWire>& rtc, Boton& btnManual);
+    BombaManager(Bomba* bombas, uint8_t numZonas, ConfigManager& configManager, RtcHal& rtc, Boton& btnManual,
+                 DiarioRiego& diario);
     
     void Evaluar(const RtcDateTime& now);
 
-    // Métodos para MQTT
-    void forzarManual(bool encender);
-    void resetAutomator(); 
+    // Arma el próximo flanco del horario para que los relés conmuten en
+    // su segundo exacto aunque nadie llame a Evaluar(). 'msHasta': ms
+    // hasta proximoCambioHorario() (Reloj::msHasta). Llamar tras Evaluar().
+    void armarFlanco(unsigned long msHasta);
+    const ConmutadorProgramado& flancos() const { return conmutador; }
+
+    // Corte de seguridad desde la tarea de sensores (cualquier tarea): los
+    // relés de 'zonas' se abren ya, sin esperar a la próxima pasada, y esa
+    // pasada lo hace suyo como un MANUAL_OFF con 'causa' (CAUSA_SENSOR o
+    // CAUSA_CORRIENTE). Como todo MANUAL_OFF, se levanta solo al acabar la
+    // ventana del horario.
+    void cortarPorSensor(uint16_t zonas, CausaCambio causa = CAUSA_SENSOR);
+    // Zonas encendidas según la última pasada; se puede leer desde cualquier tarea
+    uint16_t zonasActivas() const { return salidasActivas.load(std::memory_order_acquire); }
+
+    // Métodos para MQTT (zona: 0..numZonas-1)
+    void forzarManual(uint8_t zona, bool encender, CausaCambio causa = CAUSA_MQTT);
+    void resetAutomator(uint8_t zona, CausaCambio causa = CAUSA_MQTT);
+
+    void ActualizarConfigBomba(uint8_t zona, const BombaConfig& nuevaConfig);
+
+    // Aplica un comando llegado de la red. Devuelve true si cambió la config.
+    bool aplicarComando(const ComandoControl& cmd);
+
+    // Consultas
+    uint8_t zonas() const { return numZonas; }
+    uint16_t zonasEncendidas() const { return mascaraEncendidas; }
+    EstadoOverride obtenerOverride(uint8_t zona) const;
+    uint32_t proximoCambioHorario() const { return proximoGlobal; } // SIN_CAMBIO si no hay
 
-    void ActualizarConfigBomba(const BombaConfig& nuevaConfig);
+    // ms hasta que Evaluar() tenga algo que hacer sin que nadie avise: el
+    // próximo cambio del horario o el fin del manual más antiguo. SIN_CAMBIO si nada.
+    unsigned long msHastaProximoEvento(const RtcDateTime& now) const;
 };
\ No newline at end of file
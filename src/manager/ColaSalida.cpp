@@ -0,0 +1,57 @@
+#include "ColaSalida.h"
+
+ColaSalida::ColaSalida(uint8_t mensajesPorSegundo, uint8_t rafaga)
+    : periodo(1000 / (mensajesPorSegundo ? mensajesPorSegundo : 1)),
+      rafaga(rafaga ? rafaga : 1), fichas(rafaga ? rafaga : 1) {}
+
+// ======================================================
+// PENDIENTES
+// ======================================================
+void ColaSalida::marcar(TopicoSalida topico, uint8_t zona) {
+    if (topico >= NUM_TOPICOS_SALIDA || zona >= MAX_ZONAS) return;
+    uint16_t bit = 1 << zona;
+    if (pendientes[topico] & bit) fusionados.fetch_add(1, std::memory_order_relaxed);
+    pendientes[topico] |= bit;
+}
+
+void ColaSalida::marcarZonas(TopicoSalida topico, uint8_t numZonas) {
+    for (uint8_t z = 0; z < numZonas; z++) marcar(topico, z);
+}
+
+bool ColaSalida::siguiente(TopicoSalida& topico, uint8_t& zona) const {
+    for (uint8_t t = 0; t < NUM_TOPICOS_SALIDA; t++) {
+        if (!pendientes[t]) continue;
+        topico = (TopicoSalida)t;
+        zona = __builtin_ctz(pendientes[t]);
+        return true;
+    }
+    return false;
+}
+
+void ColaSalida::enviado(TopicoSalida topico, uint8_t zona) {
+    if (topico >= NUM_TOPICOS_SALIDA || zona >= MAX_ZONAS) return;
+    pendientes[topico] &= ~(1 << zona);
+    enviados.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint8_t ColaSalida::totalPendientes() const {
+    uint8_t n = 0;
+    for (uint8_t t = 0; t < NUM_TOPICOS_SALIDA; t++) n += __builtin_popcount(pendientes[t]);
+    return n;
+}
+
+// ======================================================
+// RITMO
+// ======================================================
+bool ColaSalida::tomarFicha(unsigned long ahora) {
+    while (fichas < rafaga && ahora - ultimaFicha >= periodo) {
+        fichas++;
+        ultimaFicha += periodo;
+    }
+    // Con el cubo lleno el tiempo no acumula: se cuenta desde ahora
+    if (fichas >= rafaga) ultimaFicha = ahora;
+
+    if (fichas == 0) return false;
+    fichas--;
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "Config.h"
+
+// Lo que la red tiene que publicar, por orden de prioridad
+enum TopicoSalida : uint8_t {
+    SALIDA_CAPACIDADES,     // .../capacidades (sin zona: se usa la 0)
+    SALIDA_ESTADO,          // .../estado
+    SALIDA_CONFIGURACION,   // .../configuracion
+    SALIDA_INFO,            // .../info
+    SALIDA_DIAGNOSTICO,     // .../diagnostico (sin zona)
+    NUM_TOPICOS_SALIDA
+};
+
+// ==========================================
+// COLA DE SALIDA MQTT (acotada y con fusión)
+// ==========================================
+// Todo lo que se publica es estado: basta con saber QUÉ falta por enviar
+// (un bit por topic y zona) y serializar lo último al enviarlo. Así la
+// memoria es fija (NUM_TOPICOS_SALIDA máscaras de 16 bits), un cambio que
+// llega antes de publicar el anterior lo sustituye (se cuenta como
+// fusionado) y nada se pierde mientras no hay conexión: sigue marcado
+// hasta que publicar() lo acepte.
+//
+// El envío se limita con un cubo de fichas para no saturar el enlace TLS
+// (y el buffer de PubSubClient) en las ráfagas tras reconectar.
+//
+// Solo la usa el núcleo de red; los contadores se pueden leer desde otro.
+class ColaSalida {
+    private:
+        uint16_t pendientes[NUM_TOPICOS_SALIDA] = {};  // bit z = zona z
+
+        // Cubo de fichas: una cada 'periodo' ms, hasta 'rafaga'
+        unsigned long periodo;
+        uint8_t rafaga;
+        uint8_t fichas;
+        unsigned long ultimaFicha = 0;
+
+        std::atomic<uint32_t> enviados{0};
+        std::atomic<uint32_t> fusionados{0};  // Sustituidos antes de salir
+        std::atomic<uint32_t> fallidos{0};    // publicar() rechazado: se reintenta
+
+    public:
+        ColaSalida(uint8_t mensajesPorSegundo, uint8_t rafaga);
+
+        // Pide publicar (de nuevo) ese topic; el contenido se toma al enviar
+        void marcar(TopicoSalida topico, uint8_t zona = 0);
+        void marcarZonas(TopicoSalida topico, uint8_t numZonas);
+
+        // El pendiente más prioritario (sin sacarlo)
+        bool siguiente(TopicoSalida& topico, uint8_t& zona) const;
+        void enviado(TopicoSalida topico, uint8_t zona);
+        void fallido() { fallidos.fetch_add(1, std::memory_order_relaxed); }
+
+        // Consume una ficha si la hay (false: esperar a la próxima vuelta)
+        bool tomarFicha(unsigned long ahora);
+
+        uint8_t totalPendientes() const;
+        uint32_t totalEnviados() const { return enviados.load(std::memory_order_relaxed); }
+        uint32_t totalFusionados() const { return fusionados.load(std::memory_order_relaxed); }
+        uint32_t totalFallidos() const { return fallidos.load(std::memory_order_relaxed); }
+};
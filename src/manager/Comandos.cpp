@@ -0,0 +1,97 @@
+#include "Comandos.h"
+#include <string.h>
+
+// ======================================================
+// HUECO DE CONFIG
+// ======================================================
+HuecoConfig::HuecoConfig() {
+    uint32_t copia[PALABRAS] = {};
+    BombaConfig porDefecto;
+    memcpy(copia, &porDefecto, sizeof(porDefecto));
+    for (uint8_t i = 0; i < PALABRAS; i++) palabras[i].store(copia[i], std::memory_order_relaxed);
+}
+
+uint16_t HuecoConfig::dejar(const BombaConfig& nueva) {
+    uint32_t copia[PALABRAS] = {};
+    memcpy(copia, &nueva, sizeof(nueva));
+    uint32_t s = secuencia.load(std::memory_order_relaxed);
+    secuencia.store(s + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for (uint8_t i = 0; i < PALABRAS; i++) palabras[i].store(copia[i], std::memory_order_relaxed);
+    secuencia.store(s + 2, std::memory_order_release);
+    return (uint16_t)((s + 2) / 2);
+}
+
+bool HuecoConfig::leer(BombaConfig& destino, uint16_t& revision) const {
+    uint32_t antes = secuencia.load(std::memory_order_acquire);
+    if (antes & 1) return false;
+    uint32_t copia[PALABRAS];
+    for (uint8_t i = 0; i < PALABRAS; i++) copia[i] = palabras[i].load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (secuencia.load(std::memory_order_relaxed) != antes) return false;
+    memcpy(&destino, copia, sizeof(destino));
+    revision = (uint16_t)(antes / 2);
+    return true;
+}
+
+// ======================================================
+// RED -> CONTROL
+// ======================================================
+bool ColaComandos::meter(const ComandoControl& cmd) {
+    Entrada e = {cmd.tipo, cmd.zona, cmd.codificacion, 0};
+    if (cmd.tipo == ComandoControl::CONFIGURAR) {
+        if (cmd.zona >= NUM_ZONAS) return false;
+        // Con la cola llena el hueco no se toca: el CONFIGURAR de esta zona
+        // que ya esté dentro conserva su revisión y se aplica
+        if (cola.llena()) return cola.meter(e);     // Falla y cuenta el rechazo
+        e.revision = configs[cmd.zona].dejar(cmd.config);
+    }
+    return cola.meter(e);
+}
+
+bool ColaComandos::sacar(ComandoControl& cmd) {
+    Entrada e;
+    while (cola.sacar(e)) {
+        cmd.tipo = e.tipo;
+        cmd.zona = e.zona;
+        cmd.codificacion = e.codificacion;
+        if (e.tipo != ComandoControl::CONFIGURAR) return true;
+        // Otra revisión, o la red escribiéndola ahora mismo: el hueco solo se
+        // escribe con sitio en la cola, así que ese CONFIGURAR viene detrás
+        uint16_t revision;
+        if (configs[e.zona].leer(cmd.config, revision) && revision == e.revision) return true;
+    }
+    return false;
+}
+
+// ======================================================
+// CONTROL -> RED
+// ======================================================
+uint16_t ColaEventos::dejarConfig(uint8_t zona, const BombaConfig& config) {
+    return zona < NUM_ZONAS ? configs[zona].dejar(config) : 0;
+}
+
+bool ColaEventos::meterConfig(uint8_t zona, const BombaConfig& config) {
+    if (zona >= NUM_ZONAS) return false;
+    EventoControl ev;
+    ev.tipo = EventoControl::CONFIG_APLICADA;
+    ev.zona = zona;
+    ev.encendida = false;
+    ev.estadoOverride = AUTO;
+    ev.revision = 0;
+    if (cola.llena()) return cola.meter(ev);        // Igual que los comandos: el hueco, intacto
+    ev.revision = configs[zona].dejar(config);
+    return cola.meter(ev);
+}
+
+bool ColaEventos::config(uint8_t zona, BombaConfig& destino, uint16_t* revision) const {
+    static const uint8_t INTENTOS = 4;     // Una escritura son unas pocas decenas de palabras
+    if (zona >= NUM_ZONAS) return false;
+    uint16_t leida;
+    for (uint8_t i = 0; i < INTENTOS; i++) {
+        if (!configs[zona].leer(destino, leida)) continue;
+        if (revision) *revision = leida;
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include "Config.h"
+#include "../objects/BombaConfig.h"
+#include "../objects/ColaSpsc.h"
+
+// ==========================================
+// MENSAJES ENTRE RED (núcleo 0) Y CONTROL (núcleo 1)
+// ==========================================
+
+// Quién manda en una zona
+enum EstadoOverride : uint8_t {
+    AUTO,       // Manda el horario
+    MANUAL_ON,  // Forzado ON (Ignora horario)
+    MANUAL_OFF  // Forzado OFF (Ignora horario)
+};
+
+// Cómo viajan los payloads por MQTT
+enum Codificacion : uint8_t {
+    CODIFICACION_JSON,
+    CODIFICACION_MSGPACK    // Mismo esquema que el JSON, en MessagePack
+};
+
+// Red -> Control: lo que pide la nube
+struct ComandoControl {
+    enum Tipo : uint8_t {
+        MANUAL_ON,
+        MANUAL_OFF,
+        MANUAL_AUTO,
+        CONFIGURAR,     // 'config' lleva el modo y sus parámetros
+        CODIFICACION    // Solo de la red (no pasa al control): 'codificacion' de salida
+    };
+
+    Tipo tipo;
+    uint8_t zona;       // Índice interno 0..N-1
+    BombaConfig config;
+    Codificacion codificacion;
+};
+
+// Control -> Red: lo que hay que publicar
+struct EventoControl {
+    enum Tipo : uint8_t {
+        ESTADO_ZONA,    // La salida de 'zona' (o su override) cambió
+        CONFIG_APLICADA // La config ya guardada de 'zona' está en su hueco
+    };
+
+    Tipo tipo;
+    uint8_t zona;
+    bool encendida;
+    EstadoOverride estadoOverride;
+    uint16_t revision;  // CONFIG_APLICADA: la config está en el hueco de 'zona'
+};
+
+// ==========================================
+// HUECO DE CONFIG POR ZONA
+// ==========================================
+// Las colas no copian BombaConfig en cada entrada: la config viaja por un
+// hueco por zona que guarda solo la última, y la entrada lleva la revisión.
+// Un escritor y un lector en núcleos distintos, sin cerrojos (seqlock): el
+// escritor nunca espera; el lector que pilla una escritura a medias lo sabe
+// (leer() da false) y decide él si reintenta.
+class HuecoConfig {
+    private:
+        static const uint8_t PALABRAS = (sizeof(BombaConfig) + 3) / 4;
+        std::atomic<uint32_t> secuencia{0};    // Impar: escribiendo. Revisión = secuencia / 2
+        std::atomic<uint32_t> palabras[PALABRAS];
+
+    public:
+        HuecoConfig();                                      // Con la config por defecto
+        uint16_t dejar(const BombaConfig& nueva);           // Devuelve la revisión nueva
+        bool leer(BombaConfig& destino, uint16_t& revision) const;
+};
+
+// Red -> Control. Un CONFIGURAR deja su config en el hueco de la zona; si
+// antes de sacarlo llega otro para la misma zona, sacar() se salta el viejo.
+// Un CONFIGURAR rechazado (cola llena) no toca el hueco.
+class ColaComandos {
+    private:
+        struct Entrada {
+            ComandoControl::Tipo tipo;
+            uint8_t zona;
+            Codificacion codificacion;
+            uint16_t revision;
+        };
+        ColaSpsc<Entrada, 16> cola;
+        HuecoConfig configs[NUM_ZONAS];
+
+    public:
+        bool meter(const ComandoControl& cmd);
+        bool sacar(ComandoControl& cmd);
+};
+
+// Control -> Red. CONFIG_APLICADA deja la config guardada en el hueco de la
+// zona, que es además la copia que publica la red (no guarda otra).
+class ColaEventos {
+    private:
+        ColaSpsc<EventoControl, 32> cola;
+        HuecoConfig configs[NUM_ZONAS];
+
+    public:
+        bool meter(const EventoControl& ev) { return cola.meter(ev); }
+        bool sacar(EventoControl& ev) { return cola.sacar(ev); }
+
+        // Deja la config de 'zona' sin avisar (p.ej. al arrancar, antes de las tareas)
+        uint16_t dejarConfig(uint8_t zona, const BombaConfig& config);
+        // Deja la config y mete el CONFIG_APLICADA que la anuncia
+        bool meterConfig(uint8_t zona, const BombaConfig& config);
+        // La última config que dejó el control para 'zona' (lado red). false
+        // si el control la estaba reescribiendo: se reintenta más tarde
+        bool config(uint8_t zona, BombaConfig& destino, uint16_t* revision = nullptr) const;
+};
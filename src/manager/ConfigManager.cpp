@@ -1,76 +1,195 @@
 #include "ConfigManager.h"
-#include <EEPROM.h>
+#include "../hal/Hal.h"
+#include "../objects/HorarioSemanal.h"
+#include "../objects/Cron.h"
+#include "Config.h"
+#include <string.h>
+#include <stddef.h>
 
-ConfigManager::ConfigManager(BombaConfig& config)
-    : bombaConfig(config) {}
+static_assert(NUM_ZONAS <= MAX_ZONAS, "NUM_ZONAS supera MAX_ZONAS");
+static_assert(sizeof(BombaConfig) <= AlmacenRegistros::MAX_DATOS, "BombaConfig no cabe en un registro");
+static_assert(sizeof(CredencialesMqtt) <= AlmacenRegistros::MAX_DATOS, "Las credenciales no caben en un registro");
+
+ConfigManager::ConfigManager(BombaConfig* configs, uint8_t numZonas, AlmacenRegistros& almacen)
+    : configs(configs), numZonas(numZonas), almacen(almacen) {
+    static_assert(CLAVE_ZONA + MAX_ZONAS <= CLAVE_MQTT, "Las claves de zona pisan la de MQTT");
+    static_assert(offsetof(BombaConfig, numTramos) == LARGO_ZONA_V1, "BombaConfig v1 ya no es un prefijo");
+    static_assert(offsetof(BombaConfig, cron) == LARGO_ZONA_V2, "BombaConfig v2 ya no es un prefijo");
+}
 
 void ConfigManager::iniciar() {
-    bombaConfig = cargarConfig();
+    if (!almacen.iniciar()) {
+        hal::log("Sin almacen de config: se usan valores por defecto");
+    } else if (almacen.estabaVacio()) {
+        migrarDesdeEeprom();
+    }
+
+    for (uint8_t z = 0; z < numZonas; z++) {
+        configs[z] = cargarConfig(z);
 
-    if (!bombaConfig.habilitada) {
-        bombaConfig = BombaConfig();
-        guardarConfig(bombaConfig);
+        if (!configs[z].habilitada) {
+            configs[z] = BombaConfig();
+            marcarPendiente(z);
+        }
     }
+    guardarPendientes();
+    revision++;
 }
 
 // =================== PRIVADOS ===================
-BombaConfig ConfigManager::cargarConfig() {
-    BombaConfig config;
-    EEPROM.get(EEPROM_ADDR, config);
-
-    bool invalida = false;
-
+bool ConfigManager::esValida(const BombaConfig& config) {
     // Validar fecha próxima
     if (config.proximaFecha.anio < 2024 || config.proximaFecha.anio > 2100 ||
         config.proximaFecha.mes < 1 || config.proximaFecha.mes > 12 ||
         config.proximaFecha.dia < 1 || config.proximaFecha.dia > 31) {
-        invalida = true;
+        return false;
     }
 
     // Validar fecha inicio
     if (config.fechaInicio.anio < 2024 || config.fechaInicio.anio > 2100 ||
         config.fechaInicio.mes < 1 || config.fechaInicio.mes > 12 ||
         config.fechaInicio.dia < 1 || config.fechaInicio.dia > 31) {
-        invalida = true;
+        return false;
     }
 
     // Validar horas y minutos
     if (config.horaInicio > 23 || config.horaFin > 23 ||
         config.minutoInicio > 59 || config.minutoFin > 59) {
-        invalida = true;
+        return false;
     }
 
     // Validar intervalo
     if (config.intervaloDias == 0 || config.intervaloDias > 30) {
-        invalida = true;
+        return false;
     }
 
-    if (invalida) {
-        return BombaConfig(); // <- devuelve un struct limpio
+    // Validar tramos (minutos de la semana)
+    if (config.numTramos > MAX_TRAMOS) return false;
+    for (uint8_t i = 0; i < config.numTramos; i++) {
+        const Tramo& t = config.tramos[i];
+        if (t.inicio >= MINUTOS_SEMANA || t.minutos == 0 || t.minutos > MINUTOS_SEMANA) return false;
     }
 
+    // La expresión cron solo hace falta en su modo (fuera de él va a cero)
+    if (config.modo == CRON && !cron::valida(config.cron)) return false;
+
+    return true;
+}
+
+BombaConfig ConfigManager::cargarConfig(uint8_t zona) {
+    uint8_t datos[AlmacenRegistros::MAX_DATOS];
+    uint8_t version = 0;
+    uint8_t largo = almacen.leer(CLAVE_ZONA + zona, datos, sizeof(datos), &version);
+
+    BombaConfig config;
+    if (largo == 0 || !migrarZona(version, datos, largo, config) || !esValida(config)) {
+        return BombaConfig(); // <- devuelve un struct limpio
+    }
     return config;
 }
 
+// Un registro de zona de cualquier versión conocida -> BombaConfig actual.
+// Al cambiar BombaConfig: subir VERSION_ZONA y añadir aquí el caso anterior.
+bool ConfigManager::migrarZona(uint8_t version, const uint8_t* datos, uint8_t largo, BombaConfig& config) {
+    switch (version) {
+        case 1:
+        case 2: {
+            // Sin tramos (v1) ni cron (v2): el resto queda con sus valores por defecto
+            uint8_t largoVersion = version == 1 ? LARGO_ZONA_V1 : LARGO_ZONA_V2;
+            if (largo != largoVersion) return false;
+            config = BombaConfig();
+            memcpy(static_cast<void*>(&config), datos, largoVersion);
+            return true;
+        }
+        case 3:
+            if (largo != sizeof(BombaConfig)) return false;
+            memcpy(&config, datos, sizeof(BombaConfig));
+            return true;
+        default:
+            return false;   // Versión desconocida (firmware más nuevo): por defecto
+    }
+}
 
-void ConfigManager::guardarConfig(const BombaConfig& config) {
-    BombaConfig actual;
-    EEPROM.get(EEPROM_ADDR, actual);
+// Primer arranque con el almacén: se trae lo que hubiera en la EEPROM
+// antigua (zona 1 en 0, resto desde EEPROM_ADDR_ZONAS, MQTT en su bloque).
+// Allí las zonas tenían la disposición de la v1.
+void ConfigManager::migrarDesdeEeprom() {
+    for (uint8_t z = 0; z < numZonas; z++) {
+        int direccion = z == 0 ? 0 : EEPROM_ADDR_ZONAS + (z - 1) * LARGO_ZONA_V1;
+        if (direccion + LARGO_ZONA_V1 > EEPROM_SIZE) break;
+        BombaConfig config;
+        hal::eepromLeer(direccion, &config, LARGO_ZONA_V1);
+        if (esValida(config)) {
+            almacen.escribir(CLAVE_ZONA + z, VERSION_ZONA, &config, sizeof(config));
+        }
+    }
 
-    if (memcmp(&actual, &config, sizeof(BombaConfig)) != 0) {
-        EEPROM.put(EEPROM_ADDR, config);
+    uint8_t marca;
+    hal::eepromGet(EEPROM_ADDR_MQTT, marca);
+    if (marca != 0xFF && marca != 0x00) {
+        CredencialesMqtt credenciales;
+        cargarCredenciales(credenciales);   // Valores por defecto
+        hal::eepromLeer(EEPROM_ADDR_MQTT, credenciales.servidor, sizeof(credenciales.servidor));
+        hal::eepromLeer(EEPROM_ADDR_USER, credenciales.usuario, sizeof(credenciales.usuario));
+        credenciales.servidor[sizeof(credenciales.servidor) - 1] = '\0';
+        credenciales.usuario[sizeof(credenciales.usuario) - 1] = '\0';
+        guardarCredenciales(credenciales);
     }
+    hal::log("Config migrada de la EEPROM al almacen");
+}
+
+
+// Solo marca la zona: la escritura real la hace actualizar() agrupando
+// ráfagas (varios cambios seguidos = un solo registro por zona)
+void ConfigManager::marcarPendiente(uint8_t zona) {
+    unsigned long ahora = hal::millis();
+    if (!pendientes) primerCambio = ahora;
+    ultimoCambio = ahora;
+    pendientes |= (1 << zona);
 }
 
+void ConfigManager::actualizar() {
+    if (!pendientes) return;
+    unsigned long ahora = hal::millis();
+    if (ahora - ultimoCambio >= ESPERA_GUARDADO_MS || ahora - primerCambio >= MAX_ESPERA_GUARDADO_MS) {
+        guardarPendientes();
+    }
+}
 
-void ConfigManager::aplicarCambios() {
-    guardarConfig(bombaConfig);
+unsigned long ConfigManager::msHastaGuardar() const {
+    if (!pendientes) return ~0UL;
+    unsigned long ahora = hal::millis();
+    unsigned long quieto = ahora - ultimoCambio;
+    unsigned long total = ahora - primerCambio;
+    if (quieto >= ESPERA_GUARDADO_MS || total >= MAX_ESPERA_GUARDADO_MS) return 0;
+    unsigned long porQuieto = ESPERA_GUARDADO_MS - quieto;
+    unsigned long porTope = MAX_ESPERA_GUARDADO_MS - total;
+    return porQuieto < porTope ? porQuieto : porTope;
+}
+
+void ConfigManager::guardarPendientes() {
+    for (uint8_t z = 0; z < numZonas; z++) {
+        if (!(pendientes & (1 << z))) continue;
+        // Si es igual a lo guardado el almacén no escribe nada
+        if (almacen.escribir(CLAVE_ZONA + z, VERSION_ZONA, &configs[z], sizeof(BombaConfig))) {
+            pendientes &= ~(1 << z);
+        }
+    }
+    if (!almacen.disponible()) pendientes = 0;     // Sin flash no hay nada que esperar
+}
+
+void ConfigManager::aplicarCambios(uint8_t zona) {
+    marcarPendiente(zona);
+    cambiadas |= (1 << zona);
+    revision++;
 }
 
 
 // =================== CONFIG ===================
 
-void ConfigManager::configurarPorDias(uint8_t diasSemana, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+void ConfigManager::configurarPorDias(uint8_t zona, uint8_t diasSemana, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    if (zona >= numZonas) return;
+    BombaConfig& bombaConfig = configs[zona];
     bombaConfig.habilitada = true;
     bombaConfig.desactivarHoy = false; // resetear
     bombaConfig.modo = POR_DIAS;
@@ -79,11 +198,13 @@ void ConfigManager::configurarPorDias(uint8_t diasSemana, uint8_t horaInicio, ui
     bombaConfig.minutoInicio = minutoInicio;
     bombaConfig.horaFin = horaFin;
     bombaConfig.minutoFin = minutoFin;
-    aplicarCambios();
+    aplicarCambios(zona);
 
 }
 
-void ConfigManager::configurarPorIntervalo(uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+void ConfigManager::configurarPorIntervalo(uint8_t zona, uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    if (zona >= numZonas) return;
+    BombaConfig& bombaConfig = configs[zona];
     bombaConfig.habilitada = true;
     bombaConfig.desactivarHoy = false; // resetear
     bombaConfig.modo = POR_INTERVALO;
@@ -93,10 +214,12 @@ void ConfigManager::configurarPorIntervalo(uint8_t intervalo, const Fecha& inici
     bombaConfig.minutoInicio = minutoInicio;
     bombaConfig.horaFin = horaFin;
     bombaConfig.minutoFin = minutoFin;
-    aplicarCambios();
+    aplicarCambios(zona);
 }
 
-void ConfigManager::configurarPorFecha(Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+void ConfigManager::configurarPorFecha(uint8_t zona, Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    if (zona >= numZonas) return;
+    BombaConfig& bombaConfig = configs[zona];
     bombaConfig.habilitada = true;
     bombaConfig.desactivarHoy = false; // resetear
     bombaConfig.modo = POR_FECHA;
@@ -105,24 +228,99 @@ void ConfigManager::configurarPorFecha(Fecha fecha, uint8_t horaInicio, uint8_t
     bombaConfig.minutoInicio = minutoInicio;
     bombaConfig.horaFin = horaFin;
     bombaConfig.minutoFin = minutoFin;
-    aplicarCambios();
+    aplicarCambios(zona);
 }
 
 
-void ConfigManager::apagarBomba() {
-    bombaConfig.habilitada = false;
-    aplicarCambios();
+bool ConfigManager::configurarSemanal(uint8_t zona, const Tramo* tramos, uint8_t numTramos) {
+    if (zona >= numZonas || numTramos > MAX_TRAMOS) return false;
+
+    // Pasar por el mapa deja la forma canónica: solapes unidos, en orden
+    static HorarioSemanal mapa;     // 1,3 KB: mejor fuera de la pila
+    mapa.limpiar();
+    for (uint8_t i = 0; i < numTramos; i++) {
+        const Tramo& t = tramos[i];
+        if (t.inicio >= MINUTOS_SEMANA || t.minutos == 0 || t.minutos > MINUTOS_SEMANA) return false;
+        mapa.marcar(t);
+    }
+    Tramo normalizados[MAX_TRAMOS];
+    uint8_t n = mapa.comprimir(normalizados, MAX_TRAMOS);
+    if (n > MAX_TRAMOS) return false;
+
+    BombaConfig& bombaConfig = configs[zona];
+    bombaConfig.habilitada = true;
+    bombaConfig.desactivarHoy = false; // resetear
+    bombaConfig.modo = SEMANAL;
+    bombaConfig.numTramos = n;
+    memcpy(bombaConfig.tramos, normalizados, n * sizeof(Tramo));
+    memset(bombaConfig.tramos + n, 0, (MAX_TRAMOS - n) * sizeof(Tramo));
+    aplicarCambios(zona);
+    return true;
 }
 
-void ConfigManager::encenderBomba() {
+bool ConfigManager::configurarCron(uint8_t zona, const HorarioCron& cron) {
+    if (zona >= numZonas || !cron::valida(cron)) return false;
+    BombaConfig& bombaConfig = configs[zona];
     bombaConfig.habilitada = true;
-    aplicarCambios();
+    bombaConfig.desactivarHoy = false; // resetear
+    bombaConfig.modo = CRON;
+    bombaConfig.cron = cron;
+    aplicarCambios(zona);
+    return true;
+}
+
+bool ConfigManager::configurarCron(uint8_t zona, const char* expresion, uint16_t duracion) {
+    HorarioCron cron = {};
+    cron.duracion = duracion;
+    return cron::compilar(expresion, cron) && configurarCron(zona, cron);
+}
+
+void ConfigManager::apagarBomba(uint8_t zona) {
+    if (zona >= numZonas) return;
+    configs[zona].habilitada = false;
+    aplicarCambios(zona);
+}
+
+void ConfigManager::encenderBomba(uint8_t zona) {
+    if (zona >= numZonas) return;
+    configs[zona].habilitada = true;
+    aplicarCambios(zona);
+}
+
+void ConfigManager::reactivarHoy(uint8_t zona) {
+    if (zona >= numZonas || !configs[zona].desactivarHoy) return;
+    configs[zona].desactivarHoy = false;
+    aplicarCambios(zona);
+}
+
+void ConfigManager::aplicarConfig(uint8_t zona, const BombaConfig& nuevaConfig) {
+    if (zona >= numZonas) return;
+    configs[zona] = nuevaConfig;
+    aplicarCambios(zona);
+}
+
+// =================== CREDENCIALES ===================
+bool ConfigManager::cargarCredenciales(CredencialesMqtt& credenciales) {
+    uint8_t version = 0;
+    CredencialesMqtt leidas;
+    if (almacen.leer(CLAVE_MQTT, &leidas, sizeof(leidas), &version) == sizeof(leidas) &&
+        version == VERSION_MQTT) {
+        credenciales = leidas;
+        return true;
+    }
+
+    strcpy(credenciales.servidor, DEFAULT_MQTT_SERVER);
+    strcpy(credenciales.puerto, DEFAULT_MQTT_PORT);
+    strcpy(credenciales.usuario, DEFAULT_MQTT_USER);
+    strcpy(credenciales.clave, DEFAULT_MQTT_PASS);
+    return false;
 }
 
-bool ConfigManager::estadoBomba() {
-    return bombaConfig.habilitada;
+bool ConfigManager::guardarCredenciales(const CredencialesMqtt& credenciales) {
+    return almacen.escribir(CLAVE_MQTT, VERSION_MQTT, &credenciales, sizeof(credenciales));
 }
 
-String ConfigManager::infoBomba() {
-    return bombaConfig.toString();
-}
\ No newline at end of file
+bool ConfigManager::estadoBomba(uint8_t zona) {
+    if (zona >= numZonas) return false;
+    return configs[zona].habilitada;
+}
@@ -1,31 +1,86 @@
 #pragma once
 #include "../objects/BombaConfig.h"
+#include "../objects/AlmacenRegistros.h"
+
+// Credenciales del broker (las rellena WiFiManager o quedan las de Config.h)
+struct CredencialesMqtt {
+    char servidor[80];
+    char puerto[6];
+    char usuario[32];
+    char clave[32];
+};
 
 class ConfigManager {
     private:
-        BombaConfig& bombaConfig;   // referencia al objeto activo
-        
-        static const int EEPROM_ADDR = 0;
+        BombaConfig* configs;       // una config activa por zona (array externo)
+        uint8_t numZonas;
+        uint16_t revision = 0;      // Sube con cada cambio (para quien cachea la config)
+        uint16_t cambiadas = 0;     // Zonas cambiadas que la red aún no conoce
+
+        // Persistencia: registros tipados en el almacén de flash
+        AlmacenRegistros& almacen;
+        uint16_t pendientes = 0;            // Zonas cambiadas aún sin guardar
+        unsigned long primerCambio = 0;     // Del lote pendiente más antiguo
+        unsigned long ultimoCambio = 0;
+
+        // Claves del almacén y versión del esquema de cada tipo
+        static const uint8_t CLAVE_ZONA = 0;            // + zona (0..MAX_ZONAS-1)
+        static const uint8_t CLAVE_MQTT = 16;
+        static const uint8_t VERSION_ZONA = 3;         // 2: tramos de SEMANAL; 3: cron
+        static const uint8_t LARGO_ZONA_V1 = 17;        // BombaConfig hasta proximaFecha
+        static const uint8_t LARGO_ZONA_V2 = 130;       // ... hasta los tramos
+        static const uint8_t VERSION_MQTT = 1;
 
-        BombaConfig cargarConfig();
+        // Ráfagas de cambios: se guarda tras un rato sin cambios, con tope
+        static const unsigned long ESPERA_GUARDADO_MS = 2000;
+        static const unsigned long MAX_ESPERA_GUARDADO_MS = 10000;
+
+        static bool esValida(const BombaConfig& config);
+        BombaConfig cargarConfig(uint8_t zona);
+        bool migrarZona(uint8_t version, const uint8_t* datos, uint8_t largo, BombaConfig& config);
+        void migrarDesdeEeprom();
         // Métodos privados de persistencia
-        void aplicarCambios();
-        void guardarConfig(const BombaConfig& config);
+        void aplicarCambios(uint8_t zona);
+        void marcarPendiente(uint8_t zona);
         
 
     public:
-        // Constructor: recibe la config activa
-        ConfigManager(BombaConfig& config);
+        // Constructor: recibe el array de configs activas (una por zona)
+        ConfigManager(BombaConfig* configs, uint8_t numZonas, AlmacenRegistros& almacen);
 
-        // Inicializa cargando desde EEPROM
+        // Monta el almacén y carga las zonas (migra la EEPROM antigua si hace falta)
         void iniciar();
 
-        // === Métodos de configuración ===
-        void configurarPorDias(uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
-        void configurarPorIntervalo(uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
-        void configurarPorFecha(Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
-        void apagarBomba();
-        void encenderBomba();
-        String infoBomba();
-        bool estadoBomba();
+        // Guarda los cambios pendientes cuando toca (llamar periódicamente)
+        void actualizar();
+        void guardarPendientes();       // Ya, sin esperar (p.ej. antes de reiniciar)
+        unsigned long msHastaGuardar() const;   // Para dormir hasta entonces (~0UL: nada pendiente)
+
+        // === Métodos de configuración (zona: 0..numZonas-1) ===
+        void configurarPorDias(uint8_t zona, uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+        void configurarPorIntervalo(uint8_t zona, uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+        void configurarPorFecha(uint8_t zona, Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+        // Los tramos se guardan normalizados (ordenados y sin solapes);
+        // false si aun así no caben en MAX_TRAMOS
+        bool configurarSemanal(uint8_t zona, const Tramo* tramos, uint8_t numTramos);
+        // Ya compilada (ver objects/Cron.h) o en texto: "0 6,18 * * 1-5".
+        // false si no es válida (la zona no se toca)
+        bool configurarCron(uint8_t zona, const HorarioCron& cron);
+        bool configurarCron(uint8_t zona, const char* expresion, uint16_t duracion);
+        void apagarBomba(uint8_t zona);
+        void encenderBomba(uint8_t zona);
+        void reactivarHoy(uint8_t zona);    // Deshace desactivarHoy (si estaba puesto)
+        void aplicarConfig(uint8_t zona, const BombaConfig& nuevaConfig);
+
+        // Credenciales MQTT (solo al arrancar, antes de lanzar la red)
+        bool cargarCredenciales(CredencialesMqtt& credenciales);
+        bool guardarCredenciales(const CredencialesMqtt& credenciales);
+
+        // Acceso a la config activa y a su número de revisión
+        uint8_t zonas() const { return numZonas; }
+        BombaConfig& config(uint8_t zona) { return configs[zona]; }
+        uint16_t obtenerRevision() const { return revision; }
+        // Máscara de zonas cambiadas desde la última llamada (para avisar a la red)
+        uint16_t tomarCambiadas() { uint16_t m = cambiadas; cambiadas = 0; return m; }
+        bool estadoBomba(uint8_t zona);
 };
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "MonitorCorriente.h"
+#include <stdio.h>
+#include "../hal/Hal.h"
+
+static const char* const NOMBRES_ESTADO[] = {
+    "sin medida", "parada", "arrancando", "en marcha", "sin corriente", "sobrecorriente", "bloqueada"
+};
+
+MonitorCorriente::MonitorCorriente(Bomba& bomba, uint8_t zona, BombaManager& bombaManager, int pin,
+                                   const LimitesCorriente& limites, uint16_t muestrasPorSegundo, uint8_t hzRed)
+    : bomba(bomba), zona(zona), bombaManager(bombaManager), pin(pin), limites(limites),
+      muestrasPorSegundo(muestrasPorSegundo), medidor(muestrasPorSegundo / hzRed),
+      ciclosArranque((uint16_t)((uint32_t)limites.arranqueMs * hzRed / 1000)),
+      ciclosEncendida(0), ciclosAltos(0), estado(PARADA), disparos(0), perdidasVistas(0), huecos(0),
+      midiendo(false) {
+}
+
+bool MonitorCorriente::iniciar() {
+    hal::pinModo(pin, hal::ENTRADA);
+    medidor.reiniciar();
+    bomba.fijarMedida(PARADA, 0);
+    if (!hal::adcContinuoIniciar(pin, muestrasPorSegundo)) {
+        hal::log("Corriente: sin ADC continuo");
+        return false;
+    }
+    midiendo = false;
+    hal::adcContinuoPausar(pin, true);      // Hasta que se mande encender
+    perdidasVistas = hal::adcContinuoPerdidas(pin);
+    return true;
+}
+
+void MonitorCorriente::actualizar() {
+    // Apagada no hay corriente que medir: el canal, en pausa. Al volver,
+    // ciclo nuevo (las muestras de antes no son continuas con estas)
+    bool encendida = bomba.estaEncendida();
+    if (encendida != midiendo) {
+        midiendo = encendida;
+        hal::adcContinuoPausar(pin, !encendida);
+        medidor.reiniciar();
+        perdidasVistas = hal::adcContinuoPerdidas(pin);
+        if (!encendida) {
+            estado = juzgar(0);             // Parada, o el motivo del corte
+            bomba.fijarMedida(estado, 0);
+        }
+    }
+    if (!midiendo) return;
+
+    uint16_t lote[32];
+    size_t n;
+    while ((n = hal::adcContinuoLeer(pin, lote, 32)) > 0) {
+        // Las perdidas van justo antes de este lote: el ciclo a medias se tira
+        uint32_t perdidas = hal::adcContinuoPerdidas(pin);
+        if (perdidas != perdidasVistas) {
+            perdidasVistas = perdidas;
+            medidor.reiniciar();
+            huecos++;
+        }
+        procesar(lote, n);
+    }
+}
+
+// ======================================================
+// UN CICLO DE RED
+// ======================================================
+void MonitorCorriente::procesar(const uint16_t* muestras, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (!medidor.meter(muestras[i])) continue;
+
+        uint32_t mA = ((uint32_t)medidor.rmsQ4() * limites.maPorCuenta + 8) >> 4;
+        if (mA > 0xFFFF) mA = 0xFFFF;
+        EstadoMedido nuevo = juzgar((uint16_t)mA);
+        if ((nuevo == SOBRECORRIENTE || nuevo == BLOQUEADA) && nuevo != estado) {
+            bombaManager.cortarPorSensor(1 << zona, CAUSA_CORRIENTE);
+            disparos++;
+            char linea[64];
+            snprintf(linea, sizeof(linea), "Bomba %u %s (%u mA) -> corte", (unsigned)zona + 1,
+                     NOMBRES_ESTADO[nuevo], (unsigned)mA);
+            hal::log(linea);
+        }
+        estado = nuevo;
+        bomba.fijarMedida(estado, (uint16_t)mA);
+    }
+}
+
+EstadoMedido MonitorCorriente::juzgar(uint16_t mA) {
+    if (!bomba.estaEncendida()) {
+        ciclosEncendida = 0;
+        ciclosAltos = 0;
+        // Tras un corte se queda el motivo hasta el próximo encendido
+        return (estado == SOBRECORRIENTE || estado == BLOQUEADA) ? estado : PARADA;
+    }
+
+    if (ciclosEncendida < 0xFFFF) ciclosEncendida++;
+    if (ciclosEncendida <= ciclosArranque) return ARRANCANDO;
+
+    if (mA >= limites.bloqueoMa) return BLOQUEADA;
+    if (mA > limites.maximoMa) {
+        if (++ciclosAltos >= CICLOS_CONFIRMAR) return SOBRECORRIENTE;
+        return estado;          // Un ciclo alto: se espera al siguiente
+    }
+    ciclosAltos = 0;
+    return mA < limites.minimoMa ? SIN_CORRIENTE : EN_MARCHA;
+}
+
+void MonitorCorriente::reportar() const {
+    char linea[112];
+    snprintf(linea, sizeof(linea), "[Corriente zona %u] %s, %u mA, %lu cortes, %lu huecos", (unsigned)zona + 1,
+             NOMBRES_ESTADO[bomba.estadoMedido()], (unsigned)bomba.corrienteMa(), (unsigned long)disparos,
+             (unsigned long)huecos);
+    hal::log(linea);
+}
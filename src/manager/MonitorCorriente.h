@@ -0,0 +1,70 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "../objects/Bomba.h"
+#include "../objects/MedidorRms.h"
+#include "BombaManager.h"
+
+// Umbrales de una bomba (mA RMS)
+struct LimitesCorriente {
+    uint16_t maPorCuenta;       // Calibración del transformador
+    uint16_t minimoMa;          // Por debajo, ya en marcha: no está girando
+    uint16_t maximoMa;          // Por encima CICLOS_CONFIRMAR ciclos: sobrecorriente
+    uint16_t bloqueoMa;         // Por encima pasado el arranque: rotor bloqueado
+    uint16_t arranqueMs;        // Pico de arranque que no se juzga
+};
+
+// ==========================================
+// MONITOR DE CORRIENTE DE UNA BOMBA
+// ==========================================
+// Un canal del ADC continuo con el transformador de corriente de una
+// salida. Cada ciclo de red saca el RMS verdadero (MedidorRms), lo deja
+// en la Bomba como estado medido y, si hace falta, corta la zona con
+// BombaManager::cortarPorSensor(CAUSA_CORRIENTE):
+//   - rotor bloqueado: el primer ciclo tras el arranque sigue en bloqueoMa
+//   - sobrecorriente: CICLOS_CONFIRMAR ciclos seguidos por encima de maximoMa
+// Una bomba cortada se queda en SOBRECORRIENTE/BLOQUEADA hasta que se
+// vuelva a encender.
+//
+// Si el ADC perdió muestras (adcContinuoPerdidas sube), el ciclo a medias
+// no es continuo con lo que llega después: se tira y se empieza otro.
+// Con la bomba apagada su canal del ADC está en pausa.
+//
+// Corre en la tarea de sensores; procesar() no toca la HAL salvo para
+// cortar, así que los tests le pasan formas de onda grabadas sin más.
+class MonitorCorriente {
+    public:
+        static const uint8_t CICLOS_CONFIRMAR = 2;
+
+    private:
+        Bomba& bomba;
+        uint8_t zona;
+        BombaManager& bombaManager;
+        int pin;
+        LimitesCorriente limites;
+        uint16_t muestrasPorSegundo;
+        MedidorRms medidor;
+
+        uint16_t ciclosArranque;    // limites.arranqueMs en ciclos de red
+        uint16_t ciclosEncendida;   // Ciclos cerrados desde que se mandó encender
+        uint8_t ciclosAltos;        // Seguidos por encima de maximoMa
+        EstadoMedido estado;
+        uint32_t disparos;
+        uint32_t perdidasVistas;    // Última cuenta de adcContinuoPerdidas()
+        uint32_t huecos;            // Ciclos tirados por muestras perdidas
+        bool midiendo;              // Canal en marcha (bomba mandada encender)
+
+        EstadoMedido juzgar(uint16_t mA);
+
+    public:
+        MonitorCorriente(Bomba& bomba, uint8_t zona, BombaManager& bombaManager, int pin,
+                         const LimitesCorriente& limites, uint16_t muestrasPorSegundo, uint8_t hzRed);
+
+        bool iniciar();                 // Pide su canal al ADC continuo
+        void actualizar();              // Tarea de sensores: drena el ADC y procesa
+        void procesar(const uint16_t* muestras, size_t n);
+
+        uint32_t totalDisparos() const { return disparos; }
+        uint32_t totalHuecos() const { return huecos; }
+        void reportar() const;
+};
@@ -1,6 +1,6 @@
 
 #include "NetworkManager.h"
-#include "../include/Context.h"
+#include "../hal/Hal.h"
 
 // Variable auxiliar para el callback de WiFiManager
 bool shouldSaveConfig = false;
@@ -9,177 +9,344 @@ void saveConfigCallback() {
     shouldSaveConfig = true;
 }
 
-NetworkManager::NetworkManager(OLED& display, ConfigManager& configManager) : oled(display), configManager(configManager), client(espClient) {
-    // Constructor: Copiamos valores por defecto a las variables
-    strcpy(mqtt_server, DEFAULT_MQTT_SERVER);
-    strcpy(mqtt_port, DEFAULT_MQTT_PORT);
-    strcpy(mqtt_user, DEFAULT_MQTT_USER);
-    strcpy(mqtt_pass, DEFAULT_MQTT_PASS);
+NetworkManager::NetworkManager(OLED& display, ConfigManager& configManager, MqttHal& mqtt,
+                               ColaComandos& comandos, ColaEventos& eventos, DiarioRiego& diario,
+                               Perfilador& perfilador)
+    : client(mqtt), configManager(configManager), comandos(comandos), eventos(eventos), oled(display),
+      diario(diario), perfilador(perfilador), parser(configManager.zonas()) {
+    // Constructor: valores por defecto hasta que iniciar() lea el almacén
+    strcpy(credenciales.servidor, DEFAULT_MQTT_SERVER);
+    strcpy(credenciales.puerto, DEFAULT_MQTT_PORT);
+    strcpy(credenciales.usuario, DEFAULT_MQTT_USER);
+    strcpy(credenciales.clave, DEFAULT_MQTT_PASS);
 }
 
+// Solo desde iniciar(): el almacén es del núcleo de control y la tarea de
+// red todavía no existe
 void NetworkManager::loadCredentials() {
-    if (EEPROM.read(EEPROM_ADDR_MQTT) != 0xFF) {
-        EEPROM.get(EEPROM_ADDR_MQTT, mqtt_server);
-        Serial.println("Credenciales cargadas de EEPROM");
+    if (configManager.cargarCredenciales(credenciales)) {
+        Serial.println("Credenciales cargadas del almacen");
     }
 }
 
 void NetworkManager::saveCredentials() {
-    Serial.println("Guardando credenciales en EEPROM...");
-    EEPROM.put(EEPROM_ADDR_MQTT, mqtt_server);
-    EEPROM.put(EEPROM_ADDR_USER, mqtt_user);
-    EEPROM.commit();
+    Serial.println("Guardando credenciales...");
+    if (!configManager.guardarCredenciales(credenciales)) {
+        Serial.println("No se pudieron guardar las credenciales");
+    }
 }
 
 void NetworkManager::iniciar() {
-    // ... (todo tu código de EEPROM y WiFiManager igual) ...
+    // ... (todo tu código de WiFiManager igual) ...
+    loadCredentials();
+    etapaPublicar = perfilador.agregar("publicar");   // Antes de que exista la tarea de red
+
+    // La red publica las configs desde los huecos de la cola de eventos, no
+    // desde las del control; antes de arrancar las tareas se llenan aquí y
+    // luego los mantiene al día el control con cada CONFIG_APLICADA
+    numZonas = configManager.zonas();
+    for (uint8_t z = 0; z < numZonas; z++) eventos.dejarConfig(z, configManager.config(z));
 
     // Configuración MQTT
-    espClient.setInsecure();
-    int port = atoi(mqtt_port);
-    client.setServer(mqtt_server, port);
+    int port = atoi(credenciales.puerto);
+    client.configurar(credenciales.servidor, port);
     
     // ==========================================
     // CALLBACK INTELIGENTE (JSON + COMANDOS)
     // ==========================================
     client.setCallback([this](char* topic, byte* payload, unsigned int length) {
-        String mensaje = "";
-        for (int i = 0; i < length; i++) mensaje += (char)payload[i];
-        
+        // Sin String ni JsonDocument en el heap: el parser trabaja sobre
+        // el payload tal cual y con su propia arena de tamaño fijo
         Serial.print("MQTT Recibido: ");
-        Serial.println(mensaje);
-
-        // CASO 1: COMANDOS SIMPLES (Manual)
-        if (mensaje == "ON") {
-            bombaManager.forzarManual(true);
-        } 
-        else if (mensaje == "OFF") {
-            bombaManager.forzarManual(false);
+        if (ParserComandos::esMsgPack(payload, length)) {
+            Serial.print("MessagePack, ");
+            Serial.print(length);
+            Serial.print(" B");
+        } else {
+            Serial.write(payload, length);
         }
-        
-        // CASO 2: CONFIGURACIÓN AVANZADA (JSON)
-        // Si el mensaje empieza con '{', asumimos que es un JSON de configuración
-        else if (mensaje.startsWith("{")) {
-            Serial.println("-> Procesando Configuración JSON...");
-            
-            // Buffer para el JSON (512 bytes suele ser suficiente)
-            JsonDocument doc; 
-            DeserializationError error = deserializeJson(doc, mensaje);
-
-            if (error) {
-                Serial.print("Error JSON: "); Serial.println(error.c_str());
-                return;
-            }
+        Serial.println();
+
+        ComandoControl cmd;
+        ResultadoParseo resultado = parser.parsear(payload, length, cmd);
+        if (resultado != PARSEO_OK) {
+            Serial.print("Comando descartado: ");
+            Serial.println(ParserComandos::texto(resultado));
+            return;
+        }
+
+        // La codificación de salida es cosa de la red: no pasa al control
+        if (cmd.tipo == ComandoControl::CODIFICACION) {
+            salida = cmd.codificacion;
+            publicarCapacidades();
+            return;
+        }
+
+        // La confirmación a la nube de una config sale cuando vuelve el
+        // evento CONFIG_APLICADA
+        enviarComando(cmd.tipo, cmd.zona, cmd.config);
+    });
+}
+
+// ======================================================
+// CONEXIÓN (máquina de estados)
+// ======================================================
+// Cada llamada hace como mucho un paso corto: el handshake TLS corre en la
+// tarea de MqttPubSub y aquí solo se mira cómo va. Así ni la tarea de red
+// (ni el control, en las placas de un solo núcleo) se quedan esperando.
+void NetworkManager::avanzarConexion() {
+    unsigned long ahora = hal::millis();
 
-            // Leemos el "modo" para saber qué configurar
-            const char* modo = doc["modo"]; // "dias", "intervalo", "fecha"
-
-            if (strcmp(modo, "dias") == 0) {
-                uint8_t dias = doc["diasSemana"];
-                uint8_t hI = doc["horaInicio"];
-                uint8_t mI = doc["minutoInicio"];
-                uint8_t hF = doc["horaFin"];
-                uint8_t mF = doc["minutoFin"];
-                
-                // Aplicamos la configuración y confirmamos a la nube
-                this->configurarPorDias(dias, hI, mI, hF, mF);
-                Serial.println("Configuración POR DIAS actualizada desde Nube");
+    switch (estadoConexion) {
+        case RED_SIN_WIFI:
+            if (!hal::wifiConectado()) break;
+            estadoConexion = RED_ESPERA;
+            proximoIntento = ahora;
+            break;
+
+        case RED_ESPERA:
+            if (!hal::wifiConectado()) {
+                estadoConexion = RED_SIN_WIFI;
+                break;
             }
-            else if (strcmp(modo, "intervalo") == 0) {
-                uint8_t interv = doc["intervaloDias"];
-                
-                // Parseamos la fecha (asumiendo formato "2024-01-20" o campos separados)
-                // Para facilitar, sugiero que envíes campos separados desde HiveMQ:
-                Fecha inicio;
-                inicio.anio = doc["anioInicio"];
-                inicio.mes  = doc["mesInicio"];
-                inicio.dia  = doc["diaInicio"];
-                
-                uint8_t hI = doc["horaInicio"];
-                uint8_t mI = doc["minutoInicio"];
-                uint8_t hF = doc["horaFin"];
-                uint8_t mF = doc["minutoFin"];
-
-                this->configurarPorIntervalo(interv, inicio, hI, mI, hF, mF);
-                Serial.println("Configuración POR INTERVALO actualizada desde Nube");
+            if ((long)(ahora - proximoIntento) < 0) break;
+
+            snprintf(clientId, sizeof(clientId), "ESP32Riego-%lx", (unsigned long)random(0xffff));
+            if (!client.empezarConexion(clientId, credenciales.usuario, credenciales.clave)) {
+                programarReintento();
+                break;
             }
-            else if (strcmp(modo, "fecha") == 0) {
-                Fecha prox;
-                prox.anio = doc["anio"];
-                prox.mes  = doc["mes"];
-                prox.dia  = doc["dia"];
-
-                uint8_t hI = doc["horaInicio"];
-                uint8_t mI = doc["minutoInicio"];
-                uint8_t hF = doc["horaFin"];
-                uint8_t mF = doc["minutoFin"];
-
-                this->configurarPorFecha(prox, hI, mI, hF, mF);
-                Serial.println("Configuración POR FECHA actualizada desde Nube");
+            Serial.print("Conectando MQTT (intento ");
+            Serial.print(fallosSeguidos + 1);
+            Serial.println(")...");
+            estadoConexion = RED_CONECTANDO;
+            break;
+
+        case RED_CONECTANDO:
+            switch (client.progresoConexion()) {
+                case CONEXION_EN_CURSO:
+                    break;
+                case CONEXION_LISTA:
+                    fallosSeguidos = 0;
+                    estadoConexion = RED_CONECTADA;
+                    alConectar();
+                    break;
+                case CONEXION_FALLIDA:
+                    Serial.print("Fallo MQTT, rc=");
+                    Serial.println(client.estado());
+                    programarReintento();
+                    break;
             }
-        }
-    });
+            break;
+
+        case RED_CONECTADA:
+            if (hal::wifiConectado() && client.conectado()) break;
+            Serial.println("MQTT desconectado");
+            programarReintento();
+            break;
+    }
+    conectado = estadoConexion == RED_CONECTADA;
+}
+
+// Espera exponencial; se sortea entre la mitad y el total para que varios
+// equipos (o un broker que vuelve) no reciban todos los intentos a la vez
+void NetworkManager::programarReintento() {
+    unsigned long espera = ESPERA_MINIMA << (fallosSeguidos < 8 ? fallosSeguidos : 8);
+    if (espera > ESPERA_MAXIMA) espera = ESPERA_MAXIMA;
+    espera = espera / 2 + random(espera / 2 + 1);
+
+    if (fallosSeguidos < 0xFF) fallosSeguidos++;
+    proximoIntento = hal::millis() + espera;
+    estadoConexion = RED_ESPERA;
+}
+
+void NetworkManager::alConectar() {
+    Serial.println("Conectado!");
+    client.suscribir("casa/jardin/bomba/comando");
+    Serial.println("Suscrito a .../comando");
+
+    // Lo perdido durante el corte sigue en la cola; además se
+    // repone todo el estado para quien se haya conectado entretanto
+    publicarCapacidades();
+    colaSalida.marcarZonas(SALIDA_ESTADO, numZonas);
+    colaSalida.marcarZonas(SALIDA_INFO, numZonas);
+    Serial.printf("Salida MQTT: %lu enviados, %lu fusionados, %lu fallidos\n",
+                  (unsigned long)colaSalida.totalEnviados(),
+                  (unsigned long)colaSalida.totalFusionados(),
+                  (unsigned long)colaSalida.totalFallidos());
+
+    const EstadisticasTls* tls = client.tls();
+    if (tls) {
+        Serial.printf("TLS: %lu completos (ultimo %lu ms), %lu reanudados (ultimo %lu ms)\n",
+                      (unsigned long)tls->completos, (unsigned long)tls->msCompleto,
+                      (unsigned long)tls->reanudados, (unsigned long)tls->msReanudado);
+    }
 }
 
 void NetworkManager::reconnect() {
-    if (!client.connected()) {
-        Serial.print("Reconectando MQTT...");
-        String clientId = "ESP32Riego-" + String(random(0xffff), HEX);
+    if (estadoConexion == RED_ESPERA) proximoIntento = hal::millis();
+}
+
+void NetworkManager::update() {
+    avanzarConexion();
+    if (enLinea()) client.procesar();
 
-        if (client.connect(clientId.c_str(), mqtt_user, mqtt_pass)) {
-            Serial.println("Conectado!");
-            
-            client.subscribe("casa/jardin/bomba/comando");
-            Serial.println("Suscrito a .../comando");
+    // Lo que nos manda el control (cambios de zona, configs aplicadas) se
+    // apunta en la cola aunque no haya conexión
+    EventoControl ev;
+    while (eventos.sacar(ev)) {
+        if (ev.tipo == EventoControl::ESTADO_ZONA) {
+            publishStatus(ev.zona, ev.encendida, ev.estadoOverride);
+        } else if (ev.tipo == EventoControl::CONFIG_APLICADA && ev.zona < numZonas) {
+            publicarConfiguracion(ev.zona);
+            publishInfo(ev.zona);
+        }
+    }
 
-            publishInfo();
+    // Diagnóstico del lazo cada minuto (se fusiona si no llega a salir)
+    static const unsigned long PERIODO_DIAGNOSTICO = 60000;
+    if (hal::millis() - ultimoDiagnostico >= PERIODO_DIAGNOSTICO) {
+        ultimoDiagnostico = hal::millis();
+        colaSalida.marcar(SALIDA_DIAGNOSTICO);
+    }
 
-        } else {
-            Serial.print("Fallo, rc=");
-            Serial.print(client.state());
+    MedidaEtapa medida(perfilador, etapaPublicar);
+    vaciarSalida();
+    vaciarDiario();
+}
+
+// Publica lo pendiente al ritmo del cubo de fichas. Si el cliente rechaza
+// un mensaje se queda marcado y se reintenta (tras reconectar si hace falta).
+void NetworkManager::vaciarSalida() {
+    if (!enLinea()) return;
+
+    TopicoSalida topico;
+    uint8_t zona;
+    while (colaSalida.siguiente(topico, zona) && colaSalida.tomarFicha(hal::millis())) {
+        if (!publicarPendiente(topico, zona)) {
+            colaSalida.fallido();
+            return;
         }
+        colaSalida.enviado(topico, zona);
     }
 }
 
-void NetworkManager::update() {
-    if (WiFi.status() == WL_CONNECTED) {
-        if (!client.connected()) {
-            static unsigned long lastReconnect = 0;
-            if (millis() - lastReconnect > 5000) {
-                lastReconnect = millis();
-                reconnect();
-            }
+// Serializa lo último que se sabe de ese topic (false si no salió)
+bool NetworkManager::publicarPendiente(TopicoSalida topico, uint8_t zona) {
+    switch (topico) {
+        case SALIDA_CAPACIDADES: {
+            // Retenido: un panel que se conecte después sabe qué puede pedir
+            char payload[serializar::TAM_CAPACIDADES];
+            return publicar("casa/jardin/bomba/capacidades", payload,
+                            serializar::capacidades(payload, salida), true);
+        }
+        case SALIDA_ESTADO: {
+            char payload[serializar::TAM_ESTADO];
+            return publicar("casa/jardin/bomba/estado", payload,
+                            serializar::estado(payload, salida, zona, espejoEncendidas & (1 << zona),
+                                               espejoOverride[zona]));
         }
-        client.loop();
+        case SALIDA_CONFIGURACION: {
+            // Confirmación a la nube de la config que quedó guardada en 'zona'
+            char payload[serializar::TAM_CONFIGURACION];
+            BombaConfig config;
+            if (!eventos.config(zona, config)) return false;    // El control la está cambiando
+            size_t len = serializar::configuracion(payload, salida, zona, config);
+            if (len == 0) return true;  // Zona apagada: no hay eco que mandar
+            return publicar("casa/jardin/bomba/configuracion", payload, len);
+        }
+        case SALIDA_INFO: {
+            char payload[serializar::TAM_INFO];
+            BombaConfig config;
+            if (!eventos.config(zona, config)) return false;    // El control la está cambiando
+            return publicar("casa/jardin/bomba/info", payload,
+                            serializar::info(payload, salida, zona, config));
+        }
+        case SALIDA_DIAGNOSTICO: {
+            char payload[serializar::TAM_DIAGNOSTICO];
+            return publicar("casa/jardin/bomba/diagnostico", payload,
+                            serializar::diagnostico(payload, salida, perfilador));
+        }
+        default:
+            return true;
     }
 }
 
-bool NetworkManager::isConnected() { return client.connected(); }
+// Sube lo que el diario tenga pendiente, por lotes y con las fichas que
+// deje la cola de salida (lo de la cola va antes). Si un lote no sale se
+// rebobina y se reintenta en la siguiente vuelta (o al reconectar): lo
+// confirmado lo marca el control en flash y no se vuelve a enviar.
+void NetworkManager::vaciarDiario() {
+    static const uint8_t LOTES_POR_VUELTA = 4;  // Que una vuelta larga no frene los comandos
+    if (!enLinea()) return;
+
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    for (uint8_t i = 0; i < LOTES_POR_VUELTA && colaSalida.tomarFicha(hal::millis()); i++) {
+        uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+        if (n == 0) return;
 
-void NetworkManager::publishStatus(bool estadoBomba) {
-    if (client.connected()) {
-        String payload = "{\"bomba\": " + String(estadoBomba) + "}";
-        client.publish("casa/jardin/bomba/estado", payload.c_str());
+        char payload[serializar::TAM_DIARIO];
+        size_t len = serializar::diario(payload, salida, lote, n, diario.totalPerdidas());
+        if (!publicar("casa/jardin/bomba/diario", payload, len)) {
+            diario.rebobinar();
+            return;
+        }
+        diario.confirmar(lote[n - 1].secuencia);
     }
 }
 
-void NetworkManager::publishInfo() {
-    if (client.connected()) {
-        // Esta variable 'payload' la creas pero NO la usas abajo:
-        String payload = "{\"info\": \"Sistema de riego activo\"}"; 
-        
-        // Aquí estás enviando directamente el String de configManager:
-        client.publish("casa/jardin/bomba/info", configManager.infoBomba().c_str());
+// Se puede llamar desde cualquier núcleo: solo lee el flag
+bool NetworkManager::isConnected() { return conectado; }
+
+bool NetworkManager::enviarComando(ComandoControl::Tipo tipo, uint8_t zona, const BombaConfig& config) {
+    ComandoControl cmd;
+    cmd.tipo = tipo;
+    cmd.zona = zona;
+    cmd.config = config;
+
+    if (!comandos.meter(cmd)) {
+        Serial.println("Cola de comandos llena: comando descartado");
+        return false;
     }
+    hal::despertar();   // El control puede estar en reposo
+    return true;
+}
+
+// Todos los payloads salen de 'serializar' a buffers en la pila, en la
+// codificación elegida por la nube
+bool NetworkManager::publicar(const char* topic, const char* payload, size_t len, bool retenido) {
+    if (len == 0) return false;   // No cupo o no hay nada que contar
+    return client.publicar(topic, reinterpret_cast<const uint8_t*>(payload), len, retenido);
+}
+
+// Estas solo apuntan en la cola: el payload se arma al salir, con lo
+// último que haya (un estado nuevo sustituye al que no llegó a salir)
+void NetworkManager::publishStatus(uint8_t zona, bool estadoBomba, EstadoOverride estadoOverride) {
+    if (zona >= numZonas) return;
+    if (estadoBomba) espejoEncendidas |= (1 << zona);
+    else espejoEncendidas &= ~(1 << zona);
+    espejoOverride[zona] = estadoOverride;
+    colaSalida.marcar(SALIDA_ESTADO, zona);
+}
+
+void NetworkManager::publishInfo(uint8_t zona) {
+    if (zona < numZonas) colaSalida.marcar(SALIDA_INFO, zona);
 }
 
+void NetworkManager::publicarConfiguracion(uint8_t zona) {
+    if (zona < numZonas) colaSalida.marcar(SALIDA_CONFIGURACION, zona);
+}
 
+void NetworkManager::publicarCapacidades() {
+    colaSalida.marcar(SALIDA_CAPACIDADES);
+}
 
 /*  
     Por días 
     
-    EJEMPLO JSON:
+    EJEMPLO JSON ("zona" 1..NUM_ZONAS, opcional: por defecto 1):
     {
+        "zona": 1,
         "modo": "dias",
         "diasSemana": 62,
         "horaInicio": 8,
@@ -188,21 +355,22 @@ void NetworkManager::publishInfo() {
         "minutoFin": 0
     }
 */
-void NetworkManager::configurarPorDias(uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
-    if (client.connected()) {
-        configManager.configurarPorDias(diasSemana, horaInicio, minutoInicio, horaFin, minutoFin);
-        String payload = "{\"modo\":\"dias\",\"diasSemana\":" + String(diasSemana) + ",\"horaInicio\":" + String(horaInicio) + ",\"minutoInicio\":" + String(minutoInicio) + ",\"horaFin\":" + String(horaFin) + ",\"minutoFin\":" + String(minutoFin) + "}";
-        client.publish("casa/jardin/bomba/configuracion", payload.c_str());
-        publishInfo();
-    }
-
-    
+void NetworkManager::configurarPorDias(uint8_t zona, uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    BombaConfig cfg;
+    cfg.modo = POR_DIAS;
+    cfg.diasSemana = diasSemana;
+    cfg.horaInicio = horaInicio;
+    cfg.minutoInicio = minutoInicio;
+    cfg.horaFin = horaFin;
+    cfg.minutoFin = minutoFin;
+    enviarComando(ComandoControl::CONFIGURAR, zona, cfg);
 }
 
 /* 
     Intervalo 
     EJEMPLO JSON:
     {
+        "zona": 2,
         "modo": "intervalo",
         "intervaloDias": 3,
         "anioInicio": 2024,
@@ -214,28 +382,23 @@ void NetworkManager::configurarPorDias(uint8_t diasSemana,uint8_t horaInicio, ui
         "minutoFin": 0
     }
 */
-void NetworkManager::configurarPorIntervalo(uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
-    if (client.connected()) {
-        configManager.configurarPorIntervalo(intervalo, inicio, horaInicio, minutoInicio, horaFin, minutoFin);
-        
-        String fechaInicio = String(inicio.anio) + "-" + 
-                            (inicio.mes < 10 ? "0" : "") + String(inicio.mes) + "-" + 
-                            (inicio.dia < 10 ? "0" : "") + String(inicio.dia);
-                                
-        String payload = "{\"modo\":\"intervalo\",\"intervaloDias\":" + String(intervalo) + 
-                        ",\"fechaInicio\":\"" + fechaInicio + "\",\"horaInicio\":" +
-                        String(horaInicio) + ",\"minutoInicio\":" + String(minutoInicio) +
-                        ",\"horaFin\":" + String(horaFin) + ",\"minutoFin\":" + String(minutoFin) + "}";
-
-        client.publish("casa/jardin/bomba/configuracion", payload.c_str());
-        publishInfo();
-    }
+void NetworkManager::configurarPorIntervalo(uint8_t zona, uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    BombaConfig cfg;
+    cfg.modo = POR_INTERVALO;
+    cfg.intervaloDias = intervalo;
+    cfg.fechaInicio = inicio;
+    cfg.horaInicio = horaInicio;
+    cfg.minutoInicio = minutoInicio;
+    cfg.horaFin = horaFin;
+    cfg.minutoFin = minutoFin;
+    enviarComando(ComandoControl::CONFIGURAR, zona, cfg);
 }
 
 /*  
     Por fecha 
     EJEMPLO JSON:
     {
+        "zona": 3,
         "modo": "fecha",
         "anio": 2024,
         "mes": 12,
@@ -246,20 +409,50 @@ void NetworkManager::configurarPorIntervalo(uint8_t intervalo, const Fecha& inic
         "minutoFin": 0
     }
 */
-void NetworkManager::configurarPorFecha(Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
-    if (client.connected()) {
-        configManager.configurarPorFecha(fecha, horaInicio, minutoInicio, horaFin, minutoFin);
-        
-        String proximaFecha = String(fecha.anio) + "-" + 
-                            (fecha.mes < 10 ? "0" : "") + String(fecha.mes) + "-" + 
-                            (fecha.dia < 10 ? "0" : "") + String(fecha.dia);
-                                
-        String payload = "{\"modo\":\"fecha\",\"proximaFecha\":\"" + proximaFecha + 
-                        "\",\"horaInicio\":" + String(horaInicio) + ",\"minutoInicio\":" +
-                        String(minutoInicio) + ",\"horaFin\":" + String(horaFin) +
-                        ",\"minutoFin\":" + String(minutoFin) + "}";
-
-        client.publish("casa/jardin/bomba/configuracion", payload.c_str());
-        publishInfo();
+void NetworkManager::configurarPorFecha(uint8_t zona, Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin) {
+    BombaConfig cfg;
+    cfg.modo = POR_FECHA;
+    cfg.proximaFecha = fecha;
+    cfg.horaInicio = horaInicio;
+    cfg.minutoInicio = minutoInicio;
+    cfg.horaFin = horaFin;
+    cfg.minutoFin = minutoFin;
+    enviarComando(ComandoControl::CONFIGURAR, zona, cfg);
+}
+
+/*
+    Semanal (varias ventanas; minutos desde el domingo 00:00, hasta 28 tramos)
+    EJEMPLO JSON: lunes a viernes a las 06:00, 12:00 y 18:00, 10 min cada vez
+    {
+        "zona": 4,
+        "modo": "semanal",
+        "tramos": [[1800, 10], [2160, 10], [2520, 10],
+                   [3240, 10], [3600, 10], [3960, 10], ...]
+    }
+*/
+void NetworkManager::configurarSemanal(uint8_t zona, const Tramo* tramos, uint8_t numTramos) {
+    BombaConfig cfg;
+    cfg.modo = SEMANAL;
+    cfg.numTramos = numTramos < MAX_TRAMOS ? numTramos : MAX_TRAMOS;
+    memcpy(cfg.tramos, tramos, cfg.numTramos * sizeof(Tramo));
+    enviarComando(ComandoControl::CONFIGURAR, zona, cfg);
+}
+
+/*
+    Cron (minuto hora díaMes mes díaSemana; listas, rangos y pasos)
+    EJEMPLO JSON: a las 06:00 y 18:00 de lunes a viernes, 15 min cada vez
+    {
+        "zona": 5,
+        "modo": "cron",
+        "cron": "0 6,18 * * 1-5",
+        "duracion": 15
     }
+*/
+bool NetworkManager::configurarCron(uint8_t zona, const char* expresion, uint16_t duracion) {
+    BombaConfig cfg;
+    cfg.modo = CRON;
+    cfg.cron.duracion = duracion;
+    if (!cron::compilar(expresion, cfg.cron) || !cron::valida(cfg.cron)) return false;
+    enviarComando(ComandoControl::CONFIGURAR, zona, cfg);
+    return true;
 }
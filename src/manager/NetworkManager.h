@@ -2,44 +2,100 @@
 #define NETWORK_MANAGER_H
 
 #include <Arduino.h>
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <PubSubClient.h>
-#include <EEPROM.h>
-#include <WiFiManager.h>
 #include <ArduinoJson.h>
+#include <atomic>
+#include "../hal/MqttHal.h"
 #include "../manager/ConfigManager.h"
+#include "../manager/Comandos.h"
+#include "../manager/ParserComandos.h"
+#include "../manager/Serializador.h"
+#include "../manager/ColaSalida.h"
+#include "../manager/Perfilador.h"
+#include "../objects/DiarioRiego.h"
 #include "../include/Config.h"
 #include "../objects/OLED.h" // Necesitamos acceso a la pantalla para mostrar mensajes
 
+// Conexión con el broker (máquina de estados, nunca bloquea)
+enum EstadoConexion : uint8_t {
+    RED_SIN_WIFI,
+    RED_ESPERA,         // Esperando al próximo intento (backoff)
+    RED_CONECTANDO,     // TLS + CONNECT en segundo plano
+    RED_CONECTADA
+};
+
 class NetworkManager {
 private:
-    WiFiClientSecure espClient;
-    PubSubClient client;
+    MqttHal& client;    // Transporte MQTT (PubSubClient en la placa)
     ConfigManager& configManager;
+    ColaComandos& comandos;  // Red -> Control
+    ColaEventos& eventos;    // Control -> Red
     OLED& oled; // Referencia a la pantalla principal
+    DiarioRiego& diario;     // Historial en flash pendiente de subir
+    Perfilador& perfilador;  // Tiempos del lazo (se publican en .../diagnostico)
+    int etapaPublicar = -1;
+    unsigned long ultimoDiagnostico = 0;
+
+    // Lo que ve la red: estado de las zonas (las configs, en los huecos de 'eventos')
+    uint16_t espejoEncendidas = 0;              // Último ESTADO_ZONA de cada zona
+    EstadoOverride espejoOverride[MAX_ZONAS] = {};
+    uint8_t numZonas = 0;
+    std::atomic<bool> conectado{false};
+
+    // Reconexión: espera exponencial con sorteo (2 s, 4 s... hasta 5 min)
+    static const unsigned long ESPERA_MINIMA = 2000;
+    static const unsigned long ESPERA_MAXIMA = 300000;
+    EstadoConexion estadoConexion = RED_SIN_WIFI;
+    unsigned long proximoIntento = 0;
+    uint8_t fallosSeguidos = 0;
+    char clientId[20];          // Tiene que vivir mientras se conecta
+    Codificacion salida = DEFAULT_CODIFICACION;   // JSON o MessagePack en lo publicado
+
+    // Parser de comandos entrantes (buffers fijos, sin heap por mensaje)
+    ParserComandos parser;
 
+    // Lo pendiente de publicar: sobrevive a los cortes y se fusiona
+    ColaSalida colaSalida{MQTT_MENSAJES_POR_SEGUNDO, MQTT_RAFAGA};
 
-    // Variables para guardar credenciales en RAM
-    char mqtt_server[80];
-    char mqtt_port[6];
-    char mqtt_user[32];
-    char mqtt_pass[32];
+
+    // Credenciales en RAM (las guarda el almacén de ConfigManager)
+    CredencialesMqtt credenciales;
+
+    void avanzarConexion();
+    void programarReintento();
+    void alConectar();
+    bool enLinea() const { return estadoConexion == RED_CONECTADA; }
 
     void loadCredentials();
     void saveCredentials();
 
+    bool enviarComando(ComandoControl::Tipo tipo, uint8_t zona, const BombaConfig& config = BombaConfig());
+    void publicarConfiguracion(uint8_t zona);
+    void publicarCapacidades();
+    void vaciarSalida();
+    bool publicarPendiente(TopicoSalida topico, uint8_t zona);
+    void vaciarDiario();
+    bool publicar(const char* topic, const char* payload, size_t len, bool retenido = false);
+
 public:
-    NetworkManager(OLED& display, ConfigManager& configManager);
+    NetworkManager(OLED& display, ConfigManager& configManager, MqttHal& mqtt,
+                   ColaComandos& comandos, ColaEventos& eventos, DiarioRiego& diario,
+                   Perfilador& perfilador);
     void iniciar();
     void update();
     bool isConnected();
-    void reconnect();
-    void publishStatus(bool estadoBomba);
-    void publishInfo();
-    void configurarPorDias(uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
-    void configurarPorIntervalo(uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
-    void configurarPorFecha(Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+    void reconnect();   // Adelanta el próximo intento (no bloquea)
+    void publishStatus(uint8_t zona, bool estadoBomba, EstadoOverride estadoOverride);
+    void publishInfo(uint8_t zona);
+
+    // Contadores de la cola de salida (se pueden leer desde otro núcleo)
+    const ColaSalida& salidaMqtt() const { return colaSalida; }
+
+    // Piden la config al control por la cola (zona: 0..N-1, en el JSON va 1..N)
+    void configurarPorDias(uint8_t zona, uint8_t diasSemana,uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+    void configurarPorIntervalo(uint8_t zona, uint8_t intervalo, const Fecha& inicio, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+    void configurarPorFecha(uint8_t zona, Fecha fecha, uint8_t horaInicio, uint8_t minutoInicio, uint8_t horaFin, uint8_t minutoFin);
+    void configurarSemanal(uint8_t zona, const Tramo* tramos, uint8_t numTramos);
+    bool configurarCron(uint8_t zona, const char* expresion, uint16_t duracion);
 };
 
 #endif
\ No newline at end of file
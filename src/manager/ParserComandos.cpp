@@ -0,0 +1,268 @@
+#include "ParserComandos.h"
+#include "../objects/Cron.h"
+#include <string.h>
+
+// ======================================================
+// ARENA
+// ======================================================
+// Cada bloque lleva delante su tamaño (para reallocate) y todo va
+// alineado a 8 bytes.
+static const size_t ALINEACION = 8;
+static const size_t CABECERA = ALINEACION;
+
+static size_t alinear(size_t n) {
+    return (n + ALINEACION - 1) & ~(ALINEACION - 1);
+}
+
+ArenaJson::ArenaJson(uint8_t* memoria, size_t capacidad)
+    : memoria(memoria), capacidad(capacidad) {}
+
+void* ArenaJson::allocate(size_t n) {
+    size_t total = CABECERA + alinear(n);
+    if (usado + total > capacidad) {
+        fallos++;
+        return nullptr;
+    }
+    uint8_t* bloque = memoria + usado;
+    *reinterpret_cast<size_t*>(bloque) = n;
+    ultimo = usado;
+    usado += total;
+    if (usado > pico) pico = usado;
+    return bloque + CABECERA;
+}
+
+void ArenaJson::deallocate(void*) {
+    // Nada: se recupera todo junto en vaciar()
+}
+
+void* ArenaJson::reallocate(void* p, size_t n) {
+    if (!p) return allocate(n);
+
+    uint8_t* bloque = static_cast<uint8_t*>(p) - CABECERA;
+    size_t actual = *reinterpret_cast<size_t*>(bloque);
+
+    // El último bloque puede crecer o encoger en su sitio
+    if ((size_t)(bloque - memoria) == ultimo) {
+        size_t total = CABECERA + alinear(n);
+        if (ultimo + total > capacidad) {
+            fallos++;
+            return nullptr;
+        }
+        *reinterpret_cast<size_t*>(bloque) = n;
+        usado = ultimo + total;
+        if (usado > pico) pico = usado;
+        return p;
+    }
+
+    if (n <= actual) {
+        *reinterpret_cast<size_t*>(bloque) = n;
+        return p;
+    }
+
+    void* nuevo = allocate(n);
+    if (nuevo) memcpy(nuevo, p, actual);
+    return nuevo;
+}
+
+void ArenaJson::vaciar() {
+    usado = 0;
+    ultimo = SIZE_MAX;
+}
+
+// ======================================================
+// PARSER
+// ======================================================
+ParserComandos::ParserComandos(uint8_t numZonas)
+    : arenaDoc(memoriaDoc, sizeof(memoriaDoc)),
+      arenaFiltros(memoriaFiltros, sizeof(memoriaFiltros)),
+      filtros(&arenaFiltros), doc(&arenaDoc),
+      numZonas(numZonas) {
+
+    // Filtros: lo que NO aparece aquí ni se copia ni ocupa arena
+    JsonObject cabecera = filtros["cabecera"].to<JsonObject>();
+    cabecera["zona"] = true;
+    cabecera["comando"] = true;
+    cabecera["modo"] = true;
+    cabecera["codificacion"] = true;
+
+    static const char* const HORARIO[] = { "horaInicio", "minutoInicio", "horaFin", "minutoFin" };
+
+    JsonObject dias = filtros["dias"].to<JsonObject>();
+    dias["diasSemana"] = true;
+
+    JsonObject intervalo = filtros["intervalo"].to<JsonObject>();
+    intervalo["intervaloDias"] = true;
+    intervalo["anioInicio"] = true;
+    intervalo["mesInicio"] = true;
+    intervalo["diaInicio"] = true;
+
+    JsonObject fecha = filtros["fecha"].to<JsonObject>();
+    fecha["anio"] = true;
+    fecha["mes"] = true;
+    fecha["dia"] = true;
+
+    for (const char* campo : HORARIO) {
+        dias[campo] = true;
+        intervalo[campo] = true;
+        fecha[campo] = true;
+    }
+
+    JsonObject semanal = filtros["semanal"].to<JsonObject>();
+    semanal["tramos"] = true;
+
+    JsonObject cron = filtros["cron"].to<JsonObject>();
+    cron["cron"] = true;
+    cron["duracion"] = true;
+}
+
+DeserializationError ParserComandos::deserializar(const uint8_t* payload, size_t len, const char* filtro) {
+    doc.clear();        // Suelta lo anterior (a la arena no le cuesta nada)
+    arenaDoc.vaciar();
+    DeserializationOption::Filter soloFiltro(filtros[filtro].as<JsonVariantConst>());
+    const char* entrada = reinterpret_cast<const char*>(payload);
+    if (ultima == CODIFICACION_MSGPACK) return deserializeMsgPack(doc, entrada, len, soloFiltro);
+    return deserializeJson(doc, entrada, len, soloFiltro);
+}
+
+// fixmap (0x80..0x8F), map16 (0xDE) o map32 (0xDF)
+bool ParserComandos::esMsgPack(const uint8_t* payload, size_t len) {
+    if (len == 0) return false;
+    uint8_t b = payload[0];
+    return (b & 0xF0) == 0x80 || b == 0xDE || b == 0xDF;
+}
+
+ResultadoParseo ParserComandos::parsear(const uint8_t* payload, size_t len, ComandoControl& cmd) {
+    // CASO 1: COMANDOS SIMPLES (Manual, zona 1)
+    if (len == 2 && memcmp(payload, "ON", 2) == 0) {
+        cmd.tipo = ComandoControl::MANUAL_ON;
+        cmd.zona = 0;
+        return PARSEO_OK;
+    }
+    if (len == 3 && memcmp(payload, "OFF", 3) == 0) {
+        cmd.tipo = ComandoControl::MANUAL_OFF;
+        cmd.zona = 0;
+        return PARSEO_OK;
+    }
+
+    // CASO 2: objeto JSON o MessagePack (comando por zona o configuración)
+    if (len > 0 && payload[0] == '{') ultima = CODIFICACION_JSON;
+    else if (esMsgPack(payload, len)) ultima = CODIFICACION_MSGPACK;
+    else return PARSEO_DESCONOCIDO;
+
+    // Pasada 1: solo zona / comando / modo
+    DeserializationError error = deserializar(payload, len, "cabecera");
+    if (error == DeserializationError::NoMemory) return PARSEO_SIN_MEMORIA;
+    if (error) return PARSEO_JSON_INVALIDO;
+
+    // Codificación de salida: {"codificacion": "msgpack"} (no lleva zona)
+    const char* codificacion = doc["codificacion"];
+    if (codificacion) {
+        if (strcmp(codificacion, "json") == 0) cmd.codificacion = CODIFICACION_JSON;
+        else if (strcmp(codificacion, "msgpack") == 0) cmd.codificacion = CODIFICACION_MSGPACK;
+        else return PARSEO_COMANDO_INVALIDO;
+        cmd.tipo = ComandoControl::CODIFICACION;
+        cmd.zona = 0;
+        return PARSEO_OK;
+    }
+
+    // Zona 1..N (si no viene, la zona 1 como antes)
+    int zonaJson = doc["zona"] | 1;
+    if (zonaJson < 1 || zonaJson > numZonas) return PARSEO_ZONA_INVALIDA;
+    cmd.zona = zonaJson - 1; // Índice interno 0..N-1
+
+    // Comando manual por zona: {"zona": 3, "comando": "ON"}
+    const char* comando = doc["comando"];
+    if (comando) {
+        if (strcmp(comando, "ON") == 0) cmd.tipo = ComandoControl::MANUAL_ON;
+        else if (strcmp(comando, "OFF") == 0) cmd.tipo = ComandoControl::MANUAL_OFF;
+        else if (strcmp(comando, "AUTO") == 0) cmd.tipo = ComandoControl::MANUAL_AUTO;
+        else return PARSEO_COMANDO_INVALIDO;
+        return PARSEO_OK;
+    }
+
+    // El modo se resuelve ANTES de la segunda pasada (que vacía la arena)
+    const char* modo = doc["modo"]; // "dias", "intervalo", "fecha"
+    if (!modo) return PARSEO_SIN_MODO;
+
+    BombaConfig cfg;
+    const char* filtro;
+    if (strcmp(modo, "dias") == 0)           { cfg.modo = POR_DIAS;      filtro = "dias"; }
+    else if (strcmp(modo, "intervalo") == 0) { cfg.modo = POR_INTERVALO; filtro = "intervalo"; }
+    else if (strcmp(modo, "fecha") == 0)     { cfg.modo = POR_FECHA;     filtro = "fecha"; }
+    else if (strcmp(modo, "semanal") == 0)   { cfg.modo = SEMANAL;       filtro = "semanal"; }
+    else if (strcmp(modo, "cron") == 0)      { cfg.modo = CRON;          filtro = "cron"; }
+    else return PARSEO_SIN_MODO;
+
+    // Pasada 2: solo los campos de ese modo
+    error = deserializar(payload, len, filtro);
+    if (error == DeserializationError::NoMemory) return PARSEO_SIN_MEMORIA;
+    if (error) return PARSEO_JSON_INVALIDO;
+
+    cfg.horaInicio   = doc["horaInicio"].as<uint8_t>();
+    cfg.minutoInicio = doc["minutoInicio"].as<uint8_t>();
+    cfg.horaFin      = doc["horaFin"].as<uint8_t>();
+    cfg.minutoFin    = doc["minutoFin"].as<uint8_t>();
+
+    switch (cfg.modo) {
+        case POR_DIAS:
+            cfg.diasSemana = doc["diasSemana"].as<uint8_t>();
+            break;
+        case POR_INTERVALO:
+            cfg.intervaloDias    = doc["intervaloDias"].as<uint8_t>();
+            cfg.fechaInicio.anio = doc["anioInicio"].as<uint16_t>();
+            cfg.fechaInicio.mes  = doc["mesInicio"].as<uint8_t>();
+            cfg.fechaInicio.dia  = doc["diaInicio"].as<uint8_t>();
+            break;
+        case POR_FECHA:
+            cfg.proximaFecha.anio = doc["anio"].as<uint16_t>();
+            cfg.proximaFecha.mes  = doc["mes"].as<uint8_t>();
+            cfg.proximaFecha.dia  = doc["dia"].as<uint8_t>();
+            break;
+        case SEMANAL: {
+            // [[inicio, minutos], ...]: se comprueba aquí, se normaliza al guardar.
+            // Sin tramos no se acepta (para no regar ya está APAGADO)
+            JsonArrayConst tramos = doc["tramos"];
+            if (tramos.size() == 0 || tramos.size() > MAX_TRAMOS) return PARSEO_TRAMOS_INVALIDOS;
+            cfg.numTramos = 0;
+            for (JsonArrayConst par : tramos) {
+                uint32_t inicio = par[0] | (uint32_t)MINUTOS_SEMANA;
+                uint32_t minutos = par[1] | 0UL;
+                if (par.size() != 2 || inicio >= MINUTOS_SEMANA || minutos == 0 || minutos > MINUTOS_SEMANA) {
+                    return PARSEO_TRAMOS_INVALIDOS;
+                }
+                cfg.tramos[cfg.numTramos++] = Tramo{ (uint16_t)inicio, (uint16_t)minutos };
+            }
+            break;
+        }
+        case CRON: {
+            // Se compila aquí: al control le llegan ya los bits
+            const char* expresion = doc["cron"];
+            cfg.cron.duracion = doc["duracion"] | (uint16_t)0;
+            if (!expresion || !cron::compilar(expresion, cfg.cron) || !cron::valida(cfg.cron)) {
+                return PARSEO_CRON_INVALIDO;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    cmd.tipo = ComandoControl::CONFIGURAR;
+    cmd.config = cfg;
+    return PARSEO_OK;
+}
+
+const char* ParserComandos::texto(ResultadoParseo resultado) {
+    switch (resultado) {
+        case PARSEO_OK:               return "OK";
+        case PARSEO_DESCONOCIDO:      return "mensaje desconocido";
+        case PARSEO_JSON_INVALIDO:    return "JSON/MessagePack invalido";
+        case PARSEO_SIN_MEMORIA:      return "JSON demasiado grande";
+        case PARSEO_ZONA_INVALIDA:    return "zona fuera de rango";
+        case PARSEO_COMANDO_INVALIDO: return "comando desconocido";
+        case PARSEO_SIN_MODO:         return "falta modo valido";
+        case PARSEO_TRAMOS_INVALIDOS: return "tramos invalidos";
+        case PARSEO_CRON_INVALIDO:    return "cron invalido";
+    }
+    return "?";
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <ArduinoJson.h>
+#include "Comandos.h"
+
+// ==========================================
+// ARENA FIJA PARA ArduinoJson
+// ==========================================
+// Reparte memoria de un buffer propio, sin tocar el heap. deallocate() no
+// libera nada: la arena entera se vacía entre mensajes con vaciar().
+// Si no cabe, allocate() devuelve nullptr y ArduinoJson da NoMemory.
+class ArenaJson : public ArduinoJson::Allocator {
+    private:
+        uint8_t* memoria;
+        size_t capacidad;
+        size_t usado = 0;
+        size_t ultimo = SIZE_MAX;   // Offset del último bloque (para crecer en sitio)
+        size_t pico = 0;
+        uint32_t fallos = 0;
+
+    public:
+        ArenaJson(uint8_t* memoria, size_t capacidad);
+
+        void* allocate(size_t n) override;
+        void deallocate(void* p) override;
+        void* reallocate(void* p, size_t n) override;
+
+        void vaciar();
+        size_t usadoPico() const { return pico; }
+        uint32_t totalFallos() const { return fallos; }
+};
+
+// ==========================================
+// PARSER DE COMANDOS MQTT (sin heap)
+// ==========================================
+// Trabaja directamente sobre el payload (byte*, longitud) que da el
+// cliente MQTT. Acepta:
+//   "ON" / "OFF"                              -> manual, zona 1
+//   {"zona": 3, "comando": "ON|OFF|AUTO"}     -> manual por zona
+//   {"zona": 2, "modo": "dias|intervalo|fecha", ...} -> configuración
+//   {"zona": 2, "modo": "semanal", "tramos": [[inicio, minutos], ...]}
+//       -> varias ventanas por semana (minutos desde el domingo 00:00)
+//   {"zona": 2, "modo": "cron", "cron": "0 6,18 * * 1-5", "duracion": 15}
+//       -> riega 'duracion' minutos en cada disparo de la expresión
+//   {"codificacion": "json|msgpack"}          -> codificación de salida
+// Los objetos pueden llegar en JSON o en MessagePack con las mismas claves;
+// se distingue por el primer byte ('{' o cabecera de mapa).
+// Primero se materializan solo zona/comando/modo y luego, con el filtro
+// del modo elegido, solo los campos de ese modo.
+enum ResultadoParseo : uint8_t {
+    PARSEO_OK,
+    PARSEO_DESCONOCIDO,     // Ni ON/OFF ni JSON ni MessagePack
+    PARSEO_JSON_INVALIDO,   // JSON o MessagePack mal formado
+    PARSEO_SIN_MEMORIA,     // No cupo en la arena
+    PARSEO_ZONA_INVALIDA,
+    PARSEO_COMANDO_INVALIDO,
+    PARSEO_SIN_MODO,        // JSON sin "comando" ni "modo" válido
+    PARSEO_TRAMOS_INVALIDOS,// "tramos" de más o fuera de la semana
+    PARSEO_CRON_INVALIDO    // Expresión o "duracion" no válidas
+};
+
+class ParserComandos {
+    public:
+        // ArduinoJson reserva los nodos en bloques de ARDUINOJSON_POOL_CAPACITY:
+        // ~1 KB con punteros de 4 bytes (ESP32), ~4 KB con 8 (nativo). Con una
+        // arena de 4 KB en el PC no cabría ni un bloque más las cadenas.
+        static const size_t TAM_ARENA = 1024 * sizeof(void*);         // Documento de cada mensaje
+        static const size_t TAM_ARENA_FILTROS = 1024 * sizeof(void*); // Filtros (se crean una vez)
+
+    private:
+        uint8_t memoriaDoc[TAM_ARENA];
+        uint8_t memoriaFiltros[TAM_ARENA_FILTROS];
+        ArenaJson arenaDoc;
+        ArenaJson arenaFiltros;
+
+        JsonDocument filtros;       // {"cabecera": {...}, "dias": {...}, ...}
+        JsonDocument doc;           // Se reutiliza mensaje a mensaje
+
+        uint8_t numZonas;
+        Codificacion ultima = CODIFICACION_JSON;
+
+        DeserializationError deserializar(const uint8_t* payload, size_t len, const char* filtro);
+
+    public:
+        explicit ParserComandos(uint8_t numZonas);
+
+        ResultadoParseo parsear(const uint8_t* payload, size_t len, ComandoControl& cmd);
+
+        size_t picoArena() const { return arenaDoc.usadoPico(); }
+        size_t picoFiltros() const { return arenaFiltros.usadoPico(); }
+        uint32_t fallosArena() const { return arenaDoc.totalFallos() + arenaFiltros.totalFallos(); }
+        Codificacion ultimaCodificacion() const { return ultima; }   // Del último objeto
+        static bool esMsgPack(const uint8_t* payload, size_t len);
+        static const char* texto(ResultadoParseo resultado);
+};
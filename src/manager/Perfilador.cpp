@@ -0,0 +1,89 @@
+#include "Perfilador.h"
+#include <stdio.h>
+#include <string.h>
+
+// ======================================================
+// CUBETAS
+// ======================================================
+// 0..3 us exactos; después 4 cubetas por potencia de 2 (los 2 bits que
+// siguen al más alto)
+uint8_t Perfilador::cubeta(uint32_t us) {
+    if (us < 4) return us;
+    uint8_t exponente = 31 - __builtin_clz(us);
+    uint32_t i = (exponente - 1) * 4 + ((us >> (exponente - 2)) & 3);
+    return i < CUBETAS ? i : CUBETAS - 1;
+}
+
+uint32_t Perfilador::techo(uint8_t cubeta) {
+    if (cubeta < 4) return cubeta + 1;
+    uint8_t exponente = cubeta / 4 + 1;
+    return (uint32_t)(4 + cubeta % 4 + 1) << (exponente - 2);
+}
+
+// ======================================================
+// REGISTRO Y MEDIDAS
+// ======================================================
+int Perfilador::agregar(const char* nombre) {
+    if (numEtapas >= MAX_ETAPAS) return -1;
+    Etapa& e = etapas[numEtapas];
+    for (uint8_t i = 0; i < CUBETAS; i++) e.cubetas[i].store(0, std::memory_order_relaxed);
+    e.muestras.store(0, std::memory_order_relaxed);
+    e.maximoUs.store(0, std::memory_order_relaxed);
+    e.nombre = nombre;
+    return numEtapas++;
+}
+
+void Perfilador::anotar(uint8_t etapa, uint32_t us) {
+    if (etapa >= numEtapas) return;
+    Etapa& e = etapas[etapa];
+
+    // Un solo escritor por etapa: leer y escribir basta (sin fetch_add)
+    std::atomic<uint16_t>& c = e.cubetas[cubeta(us)];
+    if (c.load(std::memory_order_relaxed) == 0xFFFF) {
+        for (uint8_t i = 0; i < CUBETAS; i++) {
+            e.cubetas[i].store(e.cubetas[i].load(std::memory_order_relaxed) >> 1, std::memory_order_relaxed);
+        }
+    }
+    c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    e.muestras.store(e.muestras.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (us > e.maximoUs.load(std::memory_order_relaxed)) e.maximoUs.store(us, std::memory_order_relaxed);
+}
+
+uint32_t Perfilador::percentil(uint8_t etapa, uint8_t porcentaje) const {
+    if (etapa >= numEtapas) return 0;
+    const Etapa& e = etapas[etapa];
+
+    // Copia local: las dos pasadas ven las mismas cuentas
+    uint16_t cuentas[CUBETAS];
+    uint32_t total = 0;
+    for (uint8_t i = 0; i < CUBETAS; i++) {
+        cuentas[i] = e.cubetas[i].load(std::memory_order_relaxed);
+        total += cuentas[i];
+    }
+    if (total == 0) return 0;
+    uint32_t maximo = e.maximoUs.load(std::memory_order_relaxed);
+
+    // Primera cubeta que deja por debajo al menos el porcentaje pedido
+    uint32_t objetivo = (total * porcentaje + 99) / 100;
+    uint32_t acumulado = 0;
+    for (uint8_t i = 0; i < CUBETAS; i++) {
+        acumulado += cuentas[i];
+        if (acumulado >= objetivo) {
+            uint32_t valor = techo(i) - 1;
+            return valor < maximo ? valor : maximo;
+        }
+    }
+    return maximo;
+}
+
+void Perfilador::reportar() const {
+    char linea[96];
+    for (uint8_t i = 0; i < numEtapas; i++) {
+        const Etapa& e = etapas[i];
+        snprintf(linea, sizeof(linea), "[Etapa %s] %lu veces, p50 %lu us, p99 %lu us, max %lu us",
+                 e.nombre, (unsigned long)e.muestras.load(std::memory_order_relaxed),
+                 (unsigned long)percentil(i, 50), (unsigned long)percentil(i, 99),
+                 (unsigned long)e.maximoUs.load(std::memory_order_relaxed));
+        hal::log(linea);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../hal/Hal.h"
+
+// ==========================================
+// PERFILADOR DE ETAPAS DEL LAZO
+// ==========================================
+// Histograma de duraciones por etapa en memoria estática, pensado para
+// dejarlo siempre activo: anotar() son un par de lecturas de micros()
+// (esp_timer en la placa), un clz y un incremento.
+//
+// Cubetas log-lineales: 4 por cada potencia de 2 (~19 % de resolución)
+// desde 1 us hasta ~2 s. Los percentiles devuelven el techo de su cubeta
+// (nunca por debajo del real). Si una cubeta se satura se dividen todas
+// entre 2: el histograma va olvidando lo viejo sin perder la forma.
+//
+// Cada etapa la anota una sola tarea y la red la lee desde otro núcleo:
+// los contadores son atómicos relajados (en el ESP32 son loads/stores
+// normales, sin cerrojo). Cada valor se lee entero, pero la foto del
+// conjunto es aproximada: muestras, máximo y cubetas pueden ir una
+// anotación desfasados entre sí, o a mitad de un reescalado.
+class Perfilador {
+    public:
+        static const uint8_t MAX_ETAPAS = 10;
+        static const uint8_t CUBETAS = 80;
+        static const uint8_t MAX_NOMBRE = 12;   // Caracteres de un nombre de etapa
+
+        struct Etapa {
+            const char* nombre;
+            std::atomic<uint16_t> cubetas[CUBETAS];
+            std::atomic<uint32_t> muestras;     // Desde el arranque
+            std::atomic<uint32_t> maximoUs;     // Peor desde el arranque
+        };
+
+    private:
+        Etapa etapas[MAX_ETAPAS];
+        uint8_t numEtapas = 0;
+
+        static uint8_t cubeta(uint32_t us);
+
+    public:
+        static uint32_t techo(uint8_t cubeta);  // Primer valor que ya no entra
+
+        // Devuelve el índice de la etapa o -1 si no hay hueco
+        int agregar(const char* nombre);
+
+        void anotar(uint8_t etapa, uint32_t us);
+        void reiniciar() { numEtapas = 0; }    // Olvida las etapas (agregar() las pone a cero)
+
+        uint32_t percentil(uint8_t etapa, uint8_t porcentaje) const;  // us
+        void reportar() const;                  // Una línea por etapa al log
+
+        uint8_t totalEtapas() const { return numEtapas; }
+        const Etapa& etapa(uint8_t i) const { return etapas[i]; }
+};
+
+// Mide su propio ámbito: { MedidaEtapa m(perfilador, etapaRed); network.update(); }
+class MedidaEtapa {
+    private:
+        Perfilador& perfilador;
+        int etapa;
+        unsigned long inicioUs;
+
+    public:
+        MedidaEtapa(Perfilador& perfilador, int etapa)
+            : perfilador(perfilador), etapa(etapa), inicioUs(hal::micros()) {}
+        ~MedidaEtapa() {
+            if (etapa >= 0) perfilador.anotar(etapa, hal::micros() - inicioUs);
+        }
+};
@@ -0,0 +1,142 @@
+#include "Planificador.h"
+#include "../hal/Hal.h"
+#include <stdio.h>
+
+int Planificador::agregar(const char* nombre, FuncionTarea funcion, unsigned long periodoMs, unsigned long plazoMs,
+                          unsigned long periodoReposoMs) {
+    if (numTareas >= MAX_TAREAS || funcion == nullptr) return -1;
+
+    Tarea& t = tareas[numTareas];
+    t.nombre = nombre;
+    t.funcion = funcion;
+    t.periodo = periodoMs;
+    t.plazo = plazoMs;
+    t.periodoReposo = periodoReposoMs;
+    t.proxima = hal::millis();   // Todas arrancan en la primera vuelta
+    t.alDespertar = false;
+    t.ejecuciones = 0;
+    t.excesos = 0;
+    t.excesosVentana = 0;
+    t.peorRetraso = 0;
+    t.peorDuracionUs = 0;
+    return numTareas++;
+}
+
+// En reposo solo marcan el ritmo las que tienen periodo de reposo y las
+// que aún no corrieron tras la última siesta
+bool Planificador::cuenta(const Tarea& t) const {
+    return !enReposo() || t.periodoReposo > 0 || t.alDespertar;
+}
+
+// Tras una siesta por tiempo corren ya las que solo corren al despertar;
+// si despertó un botón o la red, todas (las periódicas pierden su fase)
+void Planificador::ponerAlDia(bool todas) {
+    unsigned long ahora = hal::millis();
+    for (uint8_t i = 0; i < numTareas; i++) {
+        if (!todas && tareas[i].periodoReposo > 0) continue;
+        tareas[i].proxima = ahora;
+        tareas[i].alDespertar = true;
+    }
+}
+
+void Planificador::fijarReposo(bool enReposo) {
+    bool antes = reposo.exchange(enReposo, std::memory_order_relaxed);
+    if (antes && !enReposo) ponerAlDia(true);
+}
+
+void Planificador::proximaEn(unsigned long ms) {
+    if (enCurso < 0) return;
+    if (pedidoEnCurso == 0 || ms < pedidoEnCurso) pedidoEnCurso = ms > 0 ? ms : 1;
+}
+
+unsigned long Planificador::msHastaProxima() {
+    unsigned long ahora = hal::millis();
+    long minimo = -1;
+    bool hay = false;
+    for (uint8_t i = 0; i < numTareas; i++) {
+        if (!cuenta(tareas[i])) continue;
+        long falta = (long)(tareas[i].proxima - ahora);
+        if (!hay || falta < minimo) minimo = falta;
+        hay = true;
+    }
+    if (!hay) return enReposo() ? MAX_SIESTA_MS : 0;
+    return minimo > 0 ? (unsigned long)minimo : 0;
+}
+
+void Planificador::ejecutar() {
+    if (numTareas == 0) return;
+
+    // 1. ELEGIR LA MÁS URGENTE (resta con signo: aguanta el desborde de millis)
+    int elegida = -1;
+    for (uint8_t i = 0; i < numTareas; i++) {
+        if (!cuenta(tareas[i])) continue;
+        if (elegida < 0 || (long)(tareas[i].proxima - tareas[elegida].proxima) < 0) elegida = i;
+    }
+    if (elegida < 0) {
+        ponerAlDia(hal::dormir(MAX_SIESTA_MS));     // Reposo sin ninguna tarea que lo limite
+        return;
+    }
+    Tarea& t = tareas[elegida];
+
+    // 2. DORMIR JUSTO LO QUE FALTA
+    // En reposo la espera se puede cortar; al volver corren todas
+    long falta = (long)(t.proxima - hal::millis());
+    if (falta > 0) {
+        if (!enReposo()) {
+            hal::esperar(falta);
+        } else {
+            ponerAlDia(hal::dormir(falta));
+            return;
+        }
+    }
+
+    // 3. CORRER Y MEDIR
+    enCurso = elegida;
+    pedidoEnCurso = 0;
+    unsigned long inicioUs = hal::micros();
+    t.funcion();
+    unsigned long duracionUs = hal::micros() - inicioUs;
+    unsigned long fin = hal::millis();
+    enCurso = -1;
+
+    unsigned long retraso = fin - t.proxima;
+    t.ejecuciones++;
+    if (duracionUs > t.peorDuracionUs) t.peorDuracionUs = duracionUs;
+    if (retraso > t.peorRetraso) t.peorRetraso = retraso;
+    if (retraso > t.plazo) {
+        t.excesos++;
+        t.excesosVentana++;
+    }
+
+    // 4. SIGUIENTE VENCIMIENTO
+    // Si vamos atrasados más de un periodo, no recuperamos a ráfagas
+    unsigned long periodo = enReposo() && t.periodoReposo > 0 ? t.periodoReposo : t.periodo;
+    if (pedidoEnCurso > 0 && pedidoEnCurso < periodo) {
+        t.proxima = fin + pedidoEnCurso;
+    } else {
+        t.proxima += periodo;
+        if ((long)(fin - t.proxima) >= 0) t.proxima = fin + periodo;
+    }
+
+    // Las demás ya; esta sigue su vencimiento (si no, se despertaría sola)
+    if (atenderTras) {
+        atenderTras = false;
+        unsigned long proxima = t.proxima;
+        ponerAlDia(true);
+        t.proxima = proxima;
+    }
+    t.alDespertar = false;
+}
+
+void Planificador::reportar() {
+    char linea[96];
+    for (uint8_t i = 0; i < numTareas; i++) {
+        Tarea& t = tareas[i];
+        if (t.excesosVentana == 0) continue;
+
+        snprintf(linea, sizeof(linea), "[Tarea %s] %lu fuera de plazo (%lu total), peor retraso %lu ms, peor duracion %lu us",
+                 t.nombre, t.excesosVentana, t.excesos, t.peorRetraso, t.peorDuracionUs);
+        hal::log(linea);
+        t.excesosVentana = 0;
+    }
+}
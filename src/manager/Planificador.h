@@ -0,0 +1,78 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// ==========================================
+// PLANIFICADOR COOPERATIVO
+// ==========================================
+// Cada subsistema registra una tarea con su periodo y su plazo. En cada
+// ejecutar() se corre la tarea que vence antes; si ninguna ha vencido se
+// duerme exactamente lo que falta (en vez de un delay(10) fijo).
+// Una tarea "se pasa de plazo" si termina más de 'plazo' ms después de
+// cuando le tocaba empezar.
+//
+// En reposo solo marcan el ritmo las tareas con periodo de reposo; entre
+// ellas se duerme con hal::dormir() (light sleep en la placa). Al volver
+// corren una vez las demás, y si fue un botón o la red quien despertó,
+// todas: lo que pasó durante la siesta se atiende sin esperar a su periodo.
+
+typedef void (*FuncionTarea)();
+
+struct Tarea {
+    const char* nombre;
+    FuncionTarea funcion;
+    unsigned long periodo;       // ms entre ejecuciones
+    unsigned long plazo;         // ms máximos desde el vencimiento hasta terminar
+    unsigned long periodoReposo; // ms entre ejecuciones en reposo (0: solo al despertar)
+    unsigned long proxima;       // millis() del próximo vencimiento
+    bool alDespertar;            // Debe correr una vez tras la última siesta
+
+    // Estadísticas
+    unsigned long ejecuciones;
+    unsigned long excesos;       // Veces que se pasó del plazo (total)
+    unsigned long excesosVentana;// Desde el último reportar()
+    unsigned long peorRetraso;   // ms, peor (fin - vencimiento)
+    unsigned long peorDuracionUs;
+};
+
+class Planificador {
+    public:
+        static const uint8_t MAX_TAREAS = 8;
+
+    private:
+        static const unsigned long MAX_SIESTA_MS = 60000;   // Si ninguna cuenta en reposo
+
+        Tarea tareas[MAX_TAREAS];
+        uint8_t numTareas = 0;
+        int enCurso = -1;
+        unsigned long pedidoEnCurso = 0;    // proximaEn() de la tarea en curso (0: nada)
+        bool atenderTras = false;           // atenderYa() de la tarea en curso
+        std::atomic<bool> reposo{false};    // Lo consulta la red desde el otro núcleo
+
+        bool cuenta(const Tarea& t) const;
+        void ponerAlDia(bool todas);
+
+    public:
+        // Devuelve el índice de la tarea o -1 si no hay hueco
+        int agregar(const char* nombre, FuncionTarea funcion, unsigned long periodoMs, unsigned long plazoMs,
+                    unsigned long periodoReposoMs = 0);
+
+        void ejecutar();                // Una vuelta: dormir si hace falta y correr la más urgente
+        unsigned long msHastaProxima(); // 0 si hay alguna vencida
+        void reportar();                // Log de las tareas que se pasaron de plazo
+
+        // Al salir de reposo todas las tareas vencen ya
+        void fijarReposo(bool enReposo);
+        bool enReposo() const { return reposo.load(std::memory_order_relaxed); }
+
+        // Desde la tarea en curso: volver a correrla como muy tarde en 'ms'
+        // (p.ej. el próximo cambio del horario, en vez de todo el periodo)
+        void proximaEn(unsigned long ms);
+
+        // Desde la tarea en curso: al acabar, las demás corren ya (como si
+        // hubiera despertado la red, pero sin volver a correr la que avisa)
+        void atenderYa() { atenderTras = true; }
+
+        uint8_t totalTareas() const { return numTareas; }
+        const Tarea& tarea(uint8_t i) const { return tareas[i]; }
+};
@@ -0,0 +1,105 @@
+#include "SensorManager.h"
+#include <stdio.h>
+#include "../hal/Hal.h"
+
+static const char* const NOMBRES_ALARMA[] = {"normal", "bajo", "alto"};
+
+SensorManager::SensorManager(const CanalSensor* canales, uint8_t numCanales, BombaManager& bombaManager,
+                             uint16_t muestrasPorSegundo)
+    : canales(canales), numCanales(numCanales > MAX_CANALES ? MAX_CANALES : numCanales),
+      bombaManager(bombaManager), muestrasPorSegundo(muestrasPorSegundo) {
+}
+
+bool SensorManager::iniciar() {
+    bool ok = true;
+    for (uint8_t c = 0; c < numCanales; c++) {
+        hal::pinModo(canales[c].pin, hal::ENTRADA);
+        estados[c].filtro.reiniciar();
+        if (!hal::adcContinuoIniciar(canales[c].pin, muestrasPorSegundo)) ok = false;
+        hal::adcContinuoPausar(canales[c].pin, true);  // Hasta que rieguen sus zonas
+    }
+    if (!ok) hal::log("Sensores: sin ADC continuo");
+    return ok;
+}
+
+SensorManager::Alarma SensorManager::comprobar(const CanalSensor& canal, uint16_t unidades) const {
+    if (unidades < canal.minimo) return BAJO;
+    if (unidades > canal.maximo) return ALTO;
+    return NORMAL;
+}
+
+// ======================================================
+// TAREA DE SENSORES
+// ======================================================
+void SensorManager::actualizar() {
+    uint16_t activas = bombaManager.zonasActivas();
+    unsigned long ahora = hal::millis();
+    uint16_t cortar = 0;
+    uint8_t disparados = 0;             // Canales que cortan en esta vuelta
+
+    for (uint8_t c = 0; c < numCanales; c++) {
+        const CanalSensor& canal = canales[c];
+        EstadoCanal& e = estados[c];
+
+        // Se arma al encenderse sus zonas y se rearma en el próximo riego.
+        // Sin riego no hay nada que vigilar: el canal no se convierte
+        bool riega = activas & canal.zonas;
+        if (riega != e.vigilando) hal::adcContinuoPausar(canal.pin, !riega);
+        if (riega && !e.vigilando) {
+            e.desdeMs = ahora;
+            e.disparado = false;
+            e.filtro.reiniciar();           // Lo de antes de la pausa no casa con lo nuevo
+        }
+        e.vigilando = riega;
+        if (!riega) e.fuera = 0;
+
+        uint16_t lote[32];
+        size_t n;
+        while ((n = hal::adcContinuoLeer(canal.pin, lote, 32)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                if (!e.filtro.meter(lote[i])) continue;
+                e.valor.store(escalar(canal, e.filtro.valor()), std::memory_order_relaxed);
+
+                if (!e.vigilando || e.disparado || ahora - e.desdeMs < ARRANQUE_MS) continue;
+                Alarma a = comprobar(canal, escalar(canal, e.filtro.decimado()));
+                if (a == NORMAL) {
+                    e.fuera = 0;
+                    continue;
+                }
+                if (++e.fuera < CONFIRMAR) continue;
+                e.disparado = true;
+                e.ultimaAlarma = a;
+                e.alarmas++;
+                cortar |= canal.zonas & activas;
+                disparados |= 1 << c;
+            }
+        }
+    }
+    if (!cortar) return;
+
+    // Primero el relé; el log (Serial) después
+    bombaManager.cortarPorSensor(cortar);
+    for (uint8_t c = 0; c < numCanales; c++) {
+        if (!(disparados & (1 << c))) continue;
+        char linea[64];
+        snprintf(linea, sizeof(linea), "Sensor %s %s (%u) -> corte", canales[c].nombre,
+                 NOMBRES_ALARMA[estados[c].ultimaAlarma], (unsigned)valor(c));
+        hal::log(linea);
+    }
+}
+
+uint16_t SensorManager::valor(uint8_t canal) const {
+    if (canal >= numCanales) return 0;
+    return estados[canal].valor.load(std::memory_order_relaxed);
+}
+
+void SensorManager::reportar() const {
+    char linea[96];
+    for (uint8_t c = 0; c < numCanales; c++) {
+        const EstadoCanal& e = estados[c];
+        snprintf(linea, sizeof(linea), "[Sensor %s] %u, %lu alarmas (ultima: %s), %lu muestras perdidas",
+                 canales[c].nombre, (unsigned)valor(c), (unsigned long)e.alarmas,
+                 NOMBRES_ALARMA[e.ultimaAlarma], (unsigned long)hal::adcContinuoPerdidas(canales[c].pin));
+        hal::log(linea);
+    }
+}
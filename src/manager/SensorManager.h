@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "../objects/FiltroDecimador.h"
+#include "BombaManager.h"
+
+// Un transductor analógico de la línea (presión, caudal...)
+struct CanalSensor {
+    const char* nombre;
+    int pin;
+    uint16_t fondoEscala;   // Unidades a 1023 cuentas (0 cuentas = 0 unidades)
+    uint16_t minimo;        // Por debajo: anomalía (0 = sin mínimo)
+    uint16_t maximo;        // Por encima: anomalía (0xFFFF = sin máximo)
+    uint16_t zonas;         // Zonas que lo arman y que corta (bit z = zona z)
+};
+
+// ==========================================
+// GESTOR DE SENSORES DE LÍNEA
+// ==========================================
+// Vive en su propia tarea (cada pocos ms): drena el ADC continuo de cada
+// canal, lo decima en punto fijo (FiltroDecimador) y vigila los umbrales.
+// Un canal solo vigila mientras alguna de sus zonas riega y ya pasó el
+// arranque (la presión tarda en subir); CONFIRMAR decimados seguidos fuera
+// de rango cortan sus zonas con BombaManager::cortarPorSensor(). Cada
+// canal dispara una sola vez por riego: hasta que sus zonas se apagan.
+// Mientras no riega ninguna de sus zonas el canal está en pausa en el ADC
+// (hal::adcContinuoPausar) y valor() se queda en el último del riego.
+//
+// valor() se puede leer desde cualquier tarea (pantalla, red, diagnóstico).
+class SensorManager {
+    public:
+        static const uint8_t MAX_CANALES = hal::ADC_CANALES - 2; // Potenciómetro y corriente aparte
+        static const uint8_t LOG2_DECIMACION = 4;       // 6 kHz -> 375 Hz
+        static const uint8_t CONFIRMAR = 3;             // Decimados seguidos fuera de rango
+        static const unsigned long ARRANQUE_MS = 3000;  // Sin vigilar tras encender
+
+        enum Alarma : uint8_t {
+            NORMAL,
+            BAJO,
+            ALTO
+        };
+
+    private:
+        struct EstadoCanal {
+            FiltroDecimador filtro;
+            std::atomic<uint16_t> valor{0};  // En unidades, tras la EMA
+            bool vigilando;
+            bool disparado;                  // Ya cortó en este riego
+            uint8_t fuera;                   // Decimados seguidos fuera de rango
+            Alarma ultimaAlarma;
+            unsigned long desdeMs;           // Cuándo se encendieron sus zonas
+            uint32_t alarmas;
+
+            EstadoCanal() : filtro(LOG2_DECIMACION), vigilando(false), disparado(false), fuera(0),
+                            ultimaAlarma(NORMAL), desdeMs(0), alarmas(0) {}
+        };
+
+        const CanalSensor* canales;
+        uint8_t numCanales;
+        BombaManager& bombaManager;
+        uint16_t muestrasPorSegundo;
+        EstadoCanal estados[MAX_CANALES];
+
+        uint16_t escalar(const CanalSensor& canal, uint16_t crudo) const {
+            return (uint16_t)((uint32_t)crudo * canal.fondoEscala / 1023);
+        }
+        Alarma comprobar(const CanalSensor& canal, uint16_t unidades) const;
+
+    public:
+        SensorManager(const CanalSensor* canales, uint8_t numCanales, BombaManager& bombaManager,
+                      uint16_t muestrasPorSegundo);
+
+        bool iniciar();                 // Pide los canales al ADC continuo
+        void actualizar();              // Lo llama la tarea de sensores
+
+        // Consultas (cualquier tarea)
+        uint8_t totalCanales() const { return numCanales; }
+        uint16_t valor(uint8_t canal) const;    // Último decimado y filtrado, en unidades
+        uint32_t totalAlarmas(uint8_t canal) const { return canal < numCanales ? estados[canal].alarmas : 0; }
+        Alarma ultimaAlarma(uint8_t canal) const { return canal < numCanales ? estados[canal].ultimaAlarma : NORMAL; }
+        void reportar() const;                  // Una línea por canal al log
+};
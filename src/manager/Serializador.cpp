@@ -0,0 +1,464 @@
+#include "Serializador.h"
+#include <stdio.h>
+#include <string.h>
+
+// "2024-01-20": igual en JSON y en MessagePack
+static const size_t TAM_FECHA = sizeof("65535-255-255");
+
+static void textoFecha(char (&texto)[TAM_FECHA], const Fecha& valor) {
+    snprintf(texto, sizeof(texto), "%u-%02u-%02u",
+             (unsigned)valor.anio, (unsigned)valor.mes, (unsigned)valor.dia);
+}
+
+// ======================================================
+// ESCRITOR
+// ======================================================
+EscritorJson::EscritorJson(char* buf, size_t capacidad)
+    : buf(buf), capacidad(capacidad) {}
+
+void EscritorJson::poner(char c) {
+    // Siempre queda sitio para el '\0' final
+    if (pos + 1 >= capacidad) {
+        desborde = true;
+        return;
+    }
+    buf[pos++] = c;
+}
+
+void EscritorJson::poner(const char* s) {
+    while (*s) poner(*s++);
+}
+
+void EscritorJson::ponerEntero(uint32_t v) {
+    char cifras[10];
+    uint8_t n = 0;
+    do {
+        cifras[n++] = '0' + (v % 10);
+        v /= 10;
+    } while (v > 0);
+    while (n > 0) poner(cifras[--n]);
+}
+
+void EscritorJson::clave(const char* nombre) {
+    if (!primero) poner(',');
+    primero = false;
+    poner('"');
+    poner(nombre);
+    poner("\":");
+}
+
+void EscritorJson::numero(const char* nombre, uint32_t valor) {
+    clave(nombre);
+    ponerEntero(valor);
+}
+
+void EscritorJson::booleano(const char* nombre, bool valor) {
+    clave(nombre);
+    poner(valor ? "true" : "false");
+}
+
+void EscritorJson::texto(const char* nombre, const char* valor) {
+    clave(nombre);
+    poner('"');
+    poner(valor);
+    poner('"');
+}
+
+void EscritorJson::fecha(const char* nombre, const Fecha& valor) {
+    char texto[TAM_FECHA];
+    textoFecha(texto, valor);
+    clave(nombre);
+    poner('"');
+    poner(texto);
+    poner('"');
+}
+
+void EscritorJson::lista(const char* nombre, const char* const* valores, uint8_t n) {
+    clave(nombre);
+    poner('[');
+    for (uint8_t i = 0; i < n; i++) {
+        if (i > 0) poner(',');
+        poner('"');
+        poner(valores[i]);
+        poner('"');
+    }
+    poner(']');
+}
+
+void EscritorJson::tabla(const char* nombre, const uint32_t* valores, uint8_t filas, uint8_t columnas) {
+    clave(nombre);
+    poner('[');
+    for (uint8_t f = 0; f < filas; f++) {
+        if (f > 0) poner(',');
+        poner('[');
+        for (uint8_t c = 0; c < columnas; c++) {
+            if (c > 0) poner(',');
+            ponerEntero(*valores++);
+        }
+        poner(']');
+    }
+    poner(']');
+}
+
+void EscritorJson::fila(const char* nombre, const uint32_t* valores, uint8_t n) {
+    clave(nombre);
+    poner('[');
+    for (uint8_t i = 0; i < n; i++) {
+        if (i > 0) poner(',');
+        ponerEntero(valores[i]);
+    }
+    poner(']');
+}
+
+size_t EscritorJson::terminar() {
+    if (capacidad == 0) return 0;
+    if (desborde) {
+        buf[0] = '\0';
+        return 0;
+    }
+    buf[pos] = '\0';
+    return pos;
+}
+
+// ======================================================
+// ESCRITOR MESSAGEPACK
+// ======================================================
+// Solo los tipos que usan los payloads: fixmap / map16, fixarray / array16,
+// enteros sin signo (fixint / uint8 / uint16 / uint32), bool y fixstr / str8.
+EscritorMsgPack::EscritorMsgPack(char* buf, size_t capacidad)
+    : buf(reinterpret_cast<uint8_t*>(buf)), capacidad(capacidad) {}
+
+void EscritorMsgPack::poner(uint8_t b) {
+    if (pos >= capacidad) {
+        desborde = true;
+        return;
+    }
+    buf[pos++] = b;
+}
+
+void EscritorMsgPack::ponerCadena(const char* s) {
+    size_t n = strlen(s);
+    if (n < 32) {
+        poner(0xA0 | n);                // fixstr
+    } else if (n < 256) {
+        poner(0xD9);                    // str8
+        poner(n);
+    } else {
+        desborde = true;                // Nada nuestro es tan largo
+        return;
+    }
+    while (*s) poner(*s++);
+}
+
+void EscritorMsgPack::ponerEntero(uint32_t v) {
+    if (v < 0x80) {
+        poner(v);                       // positive fixint
+    } else if (v <= 0xFF) {
+        poner(0xCC);
+        poner(v);
+    } else if (v <= 0xFFFF) {
+        poner(0xCD);
+        poner(v >> 8);
+        poner(v);
+    } else {
+        poner(0xCE);
+        poner(v >> 24);
+        poner(v >> 16);
+        poner(v >> 8);
+        poner(v);
+    }
+}
+
+void EscritorMsgPack::ponerLista(uint16_t n) {
+    if (n < 16) {
+        poner(0x90 | n);                // fixarray
+    } else {
+        poner(0xDC);                    // array16
+        poner(n >> 8);
+        poner(n);
+    }
+}
+
+void EscritorMsgPack::clave(const char* nombre) {
+    campos++;
+    ponerCadena(nombre);
+}
+
+void EscritorMsgPack::abrir() {
+    // La cabecera lleva el número de campos: se reserva y se rellena al cerrar
+    posMapa = pos;
+    campos = 0;
+    poner(0x80);
+}
+
+void EscritorMsgPack::cerrar() {
+    if (desborde || posMapa >= pos) return;
+    if (campos < 16) {
+        buf[posMapa] = 0x80 | campos;   // fixmap
+        return;
+    }
+    // map16: la cabecera pasa de 1 a 3 bytes y el contenido se corre
+    if (pos + 2 > capacidad) {
+        desborde = true;
+        return;
+    }
+    memmove(buf + posMapa + 3, buf + posMapa + 1, pos - posMapa - 1);
+    buf[posMapa] = 0xDE;
+    buf[posMapa + 1] = campos >> 8;
+    buf[posMapa + 2] = campos;
+    pos += 2;
+}
+
+void EscritorMsgPack::numero(const char* nombre, uint32_t valor) {
+    clave(nombre);
+    ponerEntero(valor);
+}
+
+void EscritorMsgPack::booleano(const char* nombre, bool valor) {
+    clave(nombre);
+    poner(valor ? 0xC3 : 0xC2);
+}
+
+void EscritorMsgPack::texto(const char* nombre, const char* valor) {
+    clave(nombre);
+    ponerCadena(valor);
+}
+
+void EscritorMsgPack::fecha(const char* nombre, const Fecha& valor) {
+    char texto[TAM_FECHA];
+    textoFecha(texto, valor);
+    clave(nombre);
+    ponerCadena(texto);
+}
+
+void EscritorMsgPack::lista(const char* nombre, const char* const* valores, uint8_t n) {
+    clave(nombre);
+    ponerLista(n);
+    for (uint8_t i = 0; i < n; i++) ponerCadena(valores[i]);
+}
+
+void EscritorMsgPack::tabla(const char* nombre, const uint32_t* valores, uint8_t filas, uint8_t columnas) {
+    clave(nombre);
+    ponerLista(filas);
+    for (uint8_t f = 0; f < filas; f++) {
+        ponerLista(columnas);
+        for (uint8_t c = 0; c < columnas; c++) ponerEntero(*valores++);
+    }
+}
+
+void EscritorMsgPack::fila(const char* nombre, const uint32_t* valores, uint8_t n) {
+    clave(nombre);
+    ponerLista(n);
+    for (uint8_t i = 0; i < n; i++) ponerEntero(valores[i]);
+}
+
+size_t EscritorMsgPack::terminar() {
+    return desborde ? 0 : pos;
+}
+
+// ======================================================
+// PAYLOADS
+// ======================================================
+namespace serializar {
+
+    const char* nombreModo(ModoBomba modo) {
+        switch (modo) {
+            case POR_DIAS:      return "dias";
+            case POR_INTERVALO: return "intervalo";
+            case POR_FECHA:     return "fecha";
+            case APAGADO:       return "apagado";
+            case SEMANAL:       return "semanal";
+            case CRON:          return "cron";
+        }
+        return "apagado";
+    }
+
+    const char* nombreOverride(EstadoOverride estado) {
+        switch (estado) {
+            case AUTO:       return "auto";
+            case MANUAL_ON:  return "manual_on";
+            case MANUAL_OFF: return "manual_off";
+        }
+        return "auto";
+    }
+
+    const char* nombreCodificacion(Codificacion codificacion) {
+        return codificacion == CODIFICACION_MSGPACK ? "msgpack" : "json";
+    }
+
+    // El esquema se escribe una sola vez y vale para los dos escritores
+    template <class Escritor>
+    static void horario(Escritor& out, const BombaConfig& cfg) {
+        out.numero("horaInicio", cfg.horaInicio);
+        out.numero("minutoInicio", cfg.minutoInicio);
+        out.numero("horaFin", cfg.horaFin);
+        out.numero("minutoFin", cfg.minutoFin);
+    }
+
+    template <class Escritor>
+    static void tramos(Escritor& out, const BombaConfig& cfg) {
+        uint8_t n = cfg.numTramos < MAX_TRAMOS ? cfg.numTramos : MAX_TRAMOS;
+        uint32_t valores[MAX_TRAMOS][2];
+        for (uint8_t i = 0; i < n; i++) {
+            valores[i][0] = cfg.tramos[i].inicio;
+            valores[i][1] = cfg.tramos[i].minutos;
+        }
+        out.tabla("tramos", &valores[0][0], n, 2);
+    }
+
+    template <class Escritor>
+    static void expresionCron(Escritor& out, const BombaConfig& cfg) {
+        char texto[cron::TAM_TEXTO];
+        cron::formatear(cfg.cron, texto, sizeof(texto));    // "" si no hay
+        out.texto("cron", texto);
+        out.numero("duracion", cfg.cron.duracion);
+    }
+
+    template <class Escritor>
+    static size_t escribirEstado(Escritor out, uint8_t zona, bool encendida, EstadoOverride estadoOverride) {
+        out.abrir();
+        out.numero("zona", zona + 1);
+        out.numero("bomba", encendida ? 1 : 0);
+        out.texto("override", nombreOverride(estadoOverride));
+        out.cerrar();
+        return out.terminar();
+    }
+
+    template <class Escritor>
+    static size_t escribirConfiguracion(Escritor out, uint8_t zona, const BombaConfig& cfg) {
+        out.abrir();
+        out.numero("zona", zona + 1);
+        out.texto("modo", nombreModo(cfg.modo));
+
+        switch (cfg.modo) {
+            case POR_DIAS:
+                out.numero("diasSemana", cfg.diasSemana);
+                break;
+            case POR_INTERVALO:
+                out.numero("intervaloDias", cfg.intervaloDias);
+                out.fecha("fechaInicio", cfg.fechaInicio);
+                break;
+            case POR_FECHA:
+                out.fecha("proximaFecha", cfg.proximaFecha);
+                break;
+            case SEMANAL:
+                tramos(out, cfg);       // Sin ventana diaria
+                out.cerrar();
+                return out.terminar();
+            case CRON:
+                expresionCron(out, cfg);
+                out.cerrar();
+                return out.terminar();
+            default:
+                return 0;
+        }
+
+        horario(out, cfg);
+        out.cerrar();
+        return out.terminar();
+    }
+
+    template <class Escritor>
+    static size_t escribirInfo(Escritor out, uint8_t zona, const BombaConfig& cfg) {
+        out.abrir();
+        out.numero("zona", zona + 1);
+        out.booleano("habilitada", cfg.habilitada);
+        out.booleano("desactivarHoy", cfg.desactivarHoy);
+        out.texto("modo", nombreModo(cfg.modo));
+        out.numero("diasSemana", cfg.diasSemana);
+        out.numero("intervaloDias", cfg.intervaloDias);
+        out.fecha("fechaInicio", cfg.fechaInicio);
+        horario(out, cfg);
+        out.fecha("proximaFecha", cfg.proximaFecha);
+        tramos(out, cfg);
+        expresionCron(out, cfg);
+        out.cerrar();
+        return out.terminar();
+    }
+
+    template <class Escritor>
+    static size_t escribirDiario(Escritor out, const EntradaDiario* entradas, uint8_t n, uint32_t perdidas) {
+        static const uint32_t UNIX_2000 = 946684800UL;  // El RTC cuenta desde 2000-01-01
+        if (n > LOTE_DIARIO) return 0;
+
+        uint32_t filas[LOTE_DIARIO][COLUMNAS_DIARIO];
+        for (uint8_t i = 0; i < n; i++) {
+            const EntradaDiario& e = entradas[i];
+            filas[i][0] = e.secuencia;
+            filas[i][1] = e.instante + UNIX_2000;
+            filas[i][2] = e.zona + 1;
+            filas[i][3] = e.encendida() ? 1 : 0;
+            filas[i][4] = e.motivo();
+            filas[i][5] = e.duracionS;
+        }
+
+        out.abrir();
+        out.tabla("entradas", &filas[0][0], n, COLUMNAS_DIARIO);
+        out.numero("perdidas", perdidas);
+        out.cerrar();
+        return out.terminar();
+    }
+
+    template <class Escritor>
+    static size_t escribirDiagnostico(Escritor out, const Perfilador& perfilador) {
+        out.abrir();
+        for (uint8_t i = 0; i < perfilador.totalEtapas(); i++) {
+            const Perfilador::Etapa& e = perfilador.etapa(i);
+            if (strlen(e.nombre) > Perfilador::MAX_NOMBRE) continue;   // No cabría en TAM_DIAGNOSTICO
+            uint32_t valores[] = { e.muestras.load(std::memory_order_relaxed), perfilador.percentil(i, 50),
+                                   perfilador.percentil(i, 99), e.maximoUs.load(std::memory_order_relaxed) };
+            out.fila(e.nombre, valores, 4);
+        }
+        out.cerrar();
+        return out.terminar();
+    }
+
+    size_t estado(char* buf, size_t capacidad, Codificacion cod,
+                  uint8_t zona, bool encendida, EstadoOverride estadoOverride) {
+        if (cod == CODIFICACION_MSGPACK) {
+            return escribirEstado(EscritorMsgPack(buf, capacidad), zona, encendida, estadoOverride);
+        }
+        return escribirEstado(EscritorJson(buf, capacidad), zona, encendida, estadoOverride);
+    }
+
+    size_t configuracion(char* buf, size_t capacidad, Codificacion cod,
+                         uint8_t zona, const BombaConfig& cfg) {
+        if (cod == CODIFICACION_MSGPACK) {
+            return escribirConfiguracion(EscritorMsgPack(buf, capacidad), zona, cfg);
+        }
+        return escribirConfiguracion(EscritorJson(buf, capacidad), zona, cfg);
+    }
+
+    size_t info(char* buf, size_t capacidad, Codificacion cod,
+                uint8_t zona, const BombaConfig& cfg) {
+        if (cod == CODIFICACION_MSGPACK) {
+            return escribirInfo(EscritorMsgPack(buf, capacidad), zona, cfg);
+        }
+        return escribirInfo(EscritorJson(buf, capacidad), zona, cfg);
+    }
+
+    size_t diario(char* buf, size_t capacidad, Codificacion cod,
+                  const EntradaDiario* entradas, uint8_t n, uint32_t perdidas) {
+        if (cod == CODIFICACION_MSGPACK) {
+            return escribirDiario(EscritorMsgPack(buf, capacidad), entradas, n, perdidas);
+        }
+        return escribirDiario(EscritorJson(buf, capacidad), entradas, n, perdidas);
+    }
+
+    size_t diagnostico(char* buf, size_t capacidad, Codificacion cod, const Perfilador& perfilador) {
+        if (cod == CODIFICACION_MSGPACK) {
+            return escribirDiagnostico(EscritorMsgPack(buf, capacidad), perfilador);
+        }
+        return escribirDiagnostico(EscritorJson(buf, capacidad), perfilador);
+    }
+
+    size_t capacidades(char* buf, size_t capacidad, Codificacion salida) {
+        static const char* const SOPORTADAS[] = { "json", "msgpack" };
+        EscritorJson json(buf, capacidad);
+        json.abrir();
+        json.lista("codificaciones", SOPORTADAS, 2);
+        json.texto("salida", nombreCodificacion(salida));
+        json.cerrar();
+        return json.terminar();
+    }
+}
@@ -0,0 +1,205 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "../objects/BombaConfig.h"
+#include "../objects/Cron.h"
+#include "Comandos.h"
+#include "../objects/DiarioRiego.h"
+#include "Perfilador.h"
+
+// ==========================================
+// ESCRITOR JSON COMPACTO (sin heap)
+// ==========================================
+// Escribe sobre un buffer del llamador. Si algo no cabe se marca el
+// desborde y terminar() devuelve 0 en vez de un JSON cortado.
+class EscritorJson {
+    private:
+        char* buf;
+        size_t capacidad;
+        size_t pos = 0;
+        bool desborde = false;
+        bool primero = true;
+
+        void poner(char c);
+        void poner(const char* s);
+        void ponerEntero(uint32_t v);
+        void clave(const char* nombre);
+
+    public:
+        EscritorJson(char* buf, size_t capacidad);
+
+        void abrir()  { poner('{'); primero = true; }
+        void cerrar() { poner('}'); }
+
+        void numero(const char* nombre, uint32_t valor);
+        void booleano(const char* nombre, bool valor);
+        void texto(const char* nombre, const char* valor);    // Sin escapar: solo literales propios
+        void fecha(const char* nombre, const Fecha& valor);   // "2024-01-20"
+        void lista(const char* nombre, const char* const* valores, uint8_t n);
+        // Lista de filas de enteros: [[a,b,...],[a,b,...]] (valores fila a fila)
+        void tabla(const char* nombre, const uint32_t* valores, uint8_t filas, uint8_t columnas);
+        void fila(const char* nombre, const uint32_t* valores, uint8_t n);   // [a,b,...]
+
+        // Cierra la cadena; devuelve su longitud o 0 si no cupo
+        size_t terminar();
+};
+
+// ==========================================
+// ESCRITOR MESSAGEPACK (sin heap)
+// ==========================================
+// Misma interfaz que EscritorJson y mismas claves: un mapa (fixmap hasta
+// 15 campos, map16 desde 16) con enteros sin signo, booleanos, cadenas
+// cortas y listas. Las fechas van
+// como la misma cadena "AAAA-MM-DD" para que el esquema sea idéntico.
+// Nunca ocupa más que su equivalente JSON, así que valen los mismos TAM_*.
+class EscritorMsgPack {
+    private:
+        uint8_t* buf;
+        size_t capacidad;
+        size_t pos = 0;
+        size_t posMapa = 0;     // Byte reservado para la cabecera del mapa
+        uint16_t campos = 0;
+        bool desborde = false;
+
+        void poner(uint8_t b);
+        void ponerCadena(const char* s);
+        void ponerEntero(uint32_t v);
+        void ponerLista(uint16_t n);    // Cabecera de array
+        void clave(const char* nombre);
+
+    public:
+        EscritorMsgPack(char* buf, size_t capacidad);
+
+        void abrir();
+        void cerrar();
+
+        void numero(const char* nombre, uint32_t valor);
+        void booleano(const char* nombre, bool valor);
+        void texto(const char* nombre, const char* valor);
+        void fecha(const char* nombre, const Fecha& valor);
+        void lista(const char* nombre, const char* const* valores, uint8_t n);
+        // Lista de filas de enteros: [[a,b,...],[a,b,...]] (valores fila a fila)
+        void tabla(const char* nombre, const uint32_t* valores, uint8_t filas, uint8_t columnas);
+        void fila(const char* nombre, const uint32_t* valores, uint8_t n);   // [a,b,...]
+
+        // Devuelve los bytes escritos o 0 si no cupo (sin terminador)
+        size_t terminar();
+};
+
+// ==========================================
+// PAYLOADS DE CADA TOPIC
+// ==========================================
+// Un único sitio para todo lo que se publica, en JSON o MessagePack con
+// el mismo esquema. Los TAM_* son el peor caso en JSON (todos los campos
+// con su máximo de cifras, con '\0') y los buffers se comprueban contra
+// ellos al compilar.
+namespace serializar {
+
+    // Lista de tramos de SEMANAL: "tramos":[[inicio,minutos],...]
+    constexpr size_t TAM_TRAMOS = sizeof(",\"tramos\":[]") + MAX_TRAMOS * sizeof("[10079,10080],");
+
+    // Expresión de CRON en su forma canónica: "cron":"...","duracion":1440
+    constexpr size_t TAM_CRON = sizeof(",\"cron\":\"\",\"duracion\":65535") + cron::TAM_TEXTO;
+
+    constexpr size_t TAM_ESTADO = sizeof(
+        "{\"zona\":255,\"bomba\":1,\"override\":\"manual_off\"}");
+
+    constexpr size_t TAM_CONFIGURACION = sizeof(
+        "{\"zona\":255,\"modo\":\"intervalo\",\"intervaloDias\":255,"
+        "\"fechaInicio\":\"65535-255-255\",\"horaInicio\":255,\"minutoInicio\":255,"
+        "\"horaFin\":255,\"minutoFin\":255}") + (TAM_TRAMOS > TAM_CRON ? TAM_TRAMOS : TAM_CRON);
+
+    constexpr size_t TAM_INFO = sizeof(
+        "{\"zona\":255,\"habilitada\":false,\"desactivarHoy\":false,\"modo\":\"intervalo\","
+        "\"diasSemana\":255,\"intervaloDias\":255,\"fechaInicio\":\"65535-255-255\","
+        "\"horaInicio\":255,\"minutoInicio\":255,\"horaFin\":255,\"minutoFin\":255,"
+        "\"proximaFecha\":\"65535-255-255\"}") + TAM_TRAMOS + TAM_CRON;
+
+    constexpr size_t TAM_CAPACIDADES = sizeof(
+        "{\"codificaciones\":[\"json\",\"msgpack\"],\"salida\":\"msgpack\"}");
+
+    // Entradas del diario por mensaje y columnas de cada fila
+    static const uint8_t LOTE_DIARIO = 8;
+    static const uint8_t COLUMNAS_DIARIO = 6;
+
+    constexpr size_t TAM_DIARIO =
+        sizeof("{\"entradas\":[],\"perdidas\":4294967295}") +
+        LOTE_DIARIO * sizeof("[4294967295,4294967295,255,1,255,4294967295],");
+
+    // Una clave por etapa del perfilador: [veces, p50, p99, max] en us
+    constexpr size_t TAM_DIAGNOSTICO = sizeof("{}") + Perfilador::MAX_ETAPAS *
+        sizeof("\"123456789012\":[4294967295,4294967295,4294967295,4294967295],");
+
+    const char* nombreModo(ModoBomba modo);
+    const char* nombreOverride(EstadoOverride estado);
+    const char* nombreCodificacion(Codificacion codificacion);
+
+    // casa/jardin/bomba/estado: salida y override de una zona
+    size_t estado(char* buf, size_t capacidad, Codificacion cod,
+                  uint8_t zona, bool encendida, EstadoOverride estadoOverride);
+
+    // casa/jardin/bomba/configuracion: eco de la config aplicada, solo los
+    // campos de su modo. 0 si APAGADO. Mismas claves que acepta el parser
+    // salvo las fechas, que salen como cadena ("fechaInicio"/"proximaFecha":
+    // "2024-01-20") igual que antes del parser; no se puede reenviar tal cual.
+    size_t configuracion(char* buf, size_t capacidad, Codificacion cod,
+                         uint8_t zona, const BombaConfig& cfg);
+
+    // casa/jardin/bomba/info: la config completa (los tramos, aunque sea
+    // [], y el cron, "" si no hay)
+    size_t info(char* buf, size_t capacidad, Codificacion cod,
+                uint8_t zona, const BombaConfig& cfg);
+
+    // casa/jardin/bomba/diario: lote de transiciones guardadas en flash,
+    // una fila [secuencia, unix, zona, encendida, causa, duracionS] por
+    // entrada. La secuencia permite descartar repetidos tras un reinicio.
+    size_t diario(char* buf, size_t capacidad, Codificacion cod,
+                  const EntradaDiario* entradas, uint8_t n, uint32_t perdidas);
+
+    // casa/jardin/bomba/diagnostico: histogramas del lazo, p.ej.
+    // {"red":[1200,180,950,4100],"riego":[...]} (nombres de MAX_NOMBRE)
+    size_t diagnostico(char* buf, size_t capacidad, Codificacion cod, const Perfilador& perfilador);
+
+    // casa/jardin/bomba/capacidades: siempre JSON, para que cualquier
+    // panel sepa qué puede pedir
+    size_t capacidades(char* buf, size_t capacidad, Codificacion salida);
+
+    // --- Versiones con el tamaño del buffer comprobado al compilar ---
+    template <size_t N>
+    inline size_t estado(char (&buf)[N], Codificacion cod,
+                         uint8_t zona, bool encendida, EstadoOverride estadoOverride) {
+        static_assert(N >= TAM_ESTADO, "Buffer pequeño para el payload de estado");
+        return estado(buf, N, cod, zona, encendida, estadoOverride);
+    }
+
+    template <size_t N>
+    inline size_t configuracion(char (&buf)[N], Codificacion cod, uint8_t zona, const BombaConfig& cfg) {
+        static_assert(N >= TAM_CONFIGURACION, "Buffer pequeño para el payload de configuracion");
+        return configuracion(buf, N, cod, zona, cfg);
+    }
+
+    template <size_t N>
+    inline size_t info(char (&buf)[N], Codificacion cod, uint8_t zona, const BombaConfig& cfg) {
+        static_assert(N >= TAM_INFO, "Buffer pequeño para el payload de info");
+        return info(buf, N, cod, zona, cfg);
+    }
+
+    template <size_t N>
+    inline size_t diario(char (&buf)[N], Codificacion cod,
+                         const EntradaDiario* entradas, uint8_t n, uint32_t perdidas) {
+        static_assert(N >= TAM_DIARIO, "Buffer pequeño para el payload del diario");
+        return diario(buf, N, cod, entradas, n, perdidas);
+    }
+
+    template <size_t N>
+    inline size_t diagnostico(char (&buf)[N], Codificacion cod, const Perfilador& perfilador) {
+        static_assert(N >= TAM_DIAGNOSTICO, "Buffer pequeño para el payload de diagnostico");
+        return diagnostico(buf, N, cod, perfilador);
+    }
+
+    template <size_t N>
+    inline size_t capacidades(char (&buf)[N], Codificacion salida) {
+        static_assert(N >= TAM_CAPACIDADES, "Buffer pequeño para el payload de capacidades");
+        return capacidades(buf, N, salida);
+    }
+}
@@ -1,223 +1,242 @@
 #include "MenuBomba.h"
+#include "../hal/Hal.h"
+#include <stdio.h>
+
+// Lo que se pide en cada modo después de la zona (y de los días)
+static const Paso PASOS_DIAS[] = {
+    {"Hora Inicio", 0, 23, "h"},
+    {"Min Inicio", 0, 59, "m"},
+    {"Hora Fin", 0, 23, "h"},
+    {"Min Fin", 0, 59, "m"},
+};
+static const Paso PASOS_INTERVALO[] = {
+    {"Intervalo", 1, 30, "dias"},
+    {"Dia Inicio", 1, 31, "d"},
+    {"Mes Inicio", 1, 12, "m"},
+    {"Anio Inicio", 2025, 2035, "a"},
+    {"Hora Inicio", 0, 23, "h"},
+    {"Min Inicio", 0, 59, "m"},
+    {"Hora Fin", 0, 23, "h"},
+    {"Min Fin", 0, 59, "m"},
+};
+static const Paso PASOS_FECHA[] = {
+    {"Dia", 1, 31, "d"},
+    {"Mes", 1, 12, "m"},
+    {"Anio", 2024, 2035, "a"},
+    {"Hora Inicio", 0, 23, "h"},
+    {"Min Inicio", 0, 59, "m"},
+    {"Hora Fin", 0, 23, "h"},
+    {"Min Fin", 0, 59, "m"},
+};
 
 MenuBomba::MenuBomba(OLED& oled, Boton& boton, Potenciometro& pot, ConfigManager& cfg)
-    : oled(oled), boton(boton), pot(pot), configManager(cfg), estado(NO_MENU) {}
+    : oled(oled), boton(boton), pot(pot), configManager(cfg), selector(oled, pot), estado(NO_MENU) {}
 
+void MenuBomba::pintarLista() {
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar("Config Bomba", 0, 0);
+    oled.mostrar(opciones[opcionActual], 0, 1);
+    oled.confirmarCuadro();
+}
 
-void MenuBomba::procesarEventoBoton() {
-    switch (estado) {
-        case POR_DIAS: {
-            oled.limpiar();
-            uint8_t dias = selectorDias();
-            int hInicio = selectorGenerico("Hora Inicio", 0, 23, "h");
-            int mInicio = selectorGenerico("Min Inicio", 0, 59, "m");
-            int hFin = selectorGenerico("Hora Fin", 0, 23, "h");
-            int mFin = selectorGenerico("Min Fin", 0, 59, "m");
-
-            configManager.configurarPorDias(dias, hInicio, mInicio, hFin, mFin);
-
-            oled.limpiar();
-            oled.mostrar("Config Guardada", 0, 0);
-            delay(1500);
-            break;
-        }
-        case POR_INTERVALO: {
-            oled.limpiar();
-            int intervalo = selectorIntervalo();
-            Fecha inicio;
-            inicio.dia  = selectorGenerico("Dia Inicio", 1, 31, "d");
-            inicio.mes  = selectorGenerico("Mes Inicio", 1, 12, "m");
-            inicio.anio = selectorGenerico("Anio Inicio", 2025, 2035, "a");
+void MenuBomba::abrir() {
+    ultimaInteraccion = hal::millis();
+    estado = NO_MENU;
+    pantalla = LISTA;
+    pintarLista();
+}
 
-            int hInicio = selectorGenerico("Hora Inicio", 0, 23, "h");
-            int mInicio = selectorGenerico("Min Inicio", 0, 59, "m");
-            int hFin    = selectorGenerico("Hora Fin", 0, 23, "h");
-            int mFin    = selectorGenerico("Min Fin", 0, 59, "m");
+void MenuBomba::cerrar() {
+    oled.limpiar();
+    estado = NO_MENU;
+    pantalla = CERRADO;
+}
 
-            configManager.configurarPorIntervalo(intervalo, inicio, hInicio, mInicio, hFin, mFin);
+void MenuBomba::mensaje(const char* texto) {
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar(texto, 0, 0);
+    oled.confirmarCuadro();
+    finMensaje = hal::millis() + MENSAJE_MS;
+    pantalla = MENSAJE;
+}
 
-            oled.limpiar();
-            oled.mostrar("Config Guardada", 0, 0);
-            delay(1500);
+// Opción elegida en la lista: cada modo con sus pasos
+void MenuBomba::procesarEventoBoton() {
+    switch (estado) {
+        case POR_DIAS:
+            pasos = PASOS_DIAS;
+            numPasos = sizeof(PASOS_DIAS) / sizeof(PASOS_DIAS[0]);
             break;
-        }
-        case POR_FECHA: {
-            oled.limpiar();
-
-            int dia = selectorGenerico("Dia", 1, 31, "d");
-            int mes = selectorGenerico("Mes", 1, 12, "m");
-            int anio = selectorGenerico("Anio", 2024, 2035, "a");
-
-            int hInicio = selectorGenerico("Hora Inicio", 0, 23, "h");
-            int mInicio = selectorGenerico("Min Inicio", 0, 59, "m");
-            int hFin = selectorGenerico("Hora Fin", 0, 23, "h");
-            int mFin = selectorGenerico("Min Fin", 0, 59, "m");
-
-            configManager.configurarPorFecha({(uint8_t)dia, (uint8_t)mes, (uint16_t)anio}, hInicio, mInicio, hFin, mFin);
-
-            oled.limpiar();
-            oled.mostrar("Config Guardada", 0, 0);
-            delay(1500);
-            oled.limpiar();
+        case POR_INTERVALO:
+            pasos = PASOS_INTERVALO;
+            numPasos = sizeof(PASOS_INTERVALO) / sizeof(PASOS_INTERVALO[0]);
             break;
-        }
-        case APAGADO: {
-            if (configManager.estadoBomba()) {
-                configManager.apagarBomba();
-                oled.limpiar();
-                oled.mostrar("Bomba Apagada", 0, 0);
-            } else {
-                configManager.encenderBomba();
-                oled.limpiar();
-                oled.mostrar("Bomba Encendida", 0, 0);
-            }
+        case POR_FECHA:
+            pasos = PASOS_FECHA;
+            numPasos = sizeof(PASOS_FECHA) / sizeof(PASOS_FECHA[0]);
             break;
-        }
+        case APAGADO:
         case NO_MENU:
         default:
-            delay(50);
-            oled.limpiar();
+            pasos = nullptr;
+            numPasos = 0;
             break;
     }
+    siguientePaso();
 }
 
-void MenuBomba::mostrarMenu() {
-    bool salir = false;
-
-    ultimaInteraccion = millis();
-    oled.limpiar();
-    oled.mostrar("Config Bomba", 0, 0);
-    oled.mostrar(opciones[opcionActual], 0, 1);
-
-    while (!salir) {
-        int evento = boton.leerEvento();
-
-        if (evento != 0) {
-            ultimaInteraccion = millis();
-        }
-
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            ultimaInteraccion = millis();
-            oled.limpiar();
+// Zona (si hay más de una) -> días (solo POR_DIAS) -> pasos del modo ->
+// guardar. Cada pantalla nueva se pinta ya, sin esperar a la vuelta siguiente.
+void MenuBomba::siguientePaso() {
+    if (pantalla == LISTA) {
+        zona = 0;
+        pantalla = ELIGE_ZONA;
+        if (configManager.zonas() > 1) {
+            selector.empezar({"Zona", 1, (int16_t)configManager.zonas(), ""});
+            selector.actualizar();
             return;
         }
-
-        if (evento == 1) {
-            opcionActual = (opcionActual + 1) % numOpciones;
-
-            oled.limpiar();
-            oled.mostrar("Config Bomba", 0, 0);
-            oled.mostrar(opciones[opcionActual], 0, 1);
-        }
-        else if (evento == 2) {  
-            if (opcionActual == 4) {   // "Salir"
-                oled.limpiar();
-                estado = NO_MENU;
-                salir = true;
+    }
+    if (pantalla == ELIGE_ZONA) {
+        if (estado == APAGADO) {
+            if (configManager.estadoBomba(zona)) {
+                configManager.apagarBomba(zona);
+                mensaje("Zona Apagada");
             } else {
-                estado =    (opcionActual == 0) ? POR_INTERVALO :
-                            (opcionActual == 1) ? POR_DIAS :
-                            (opcionActual == 2) ? POR_FECHA :
-                            (opcionActual == 3) ? APAGADO :
-                            APAGADO;
-                procesarEventoBoton();
-                salir = true;
+                configManager.encenderBomba(zona);
+                mensaje("Zona Encendida");
             }
+            return;
         }
-        delay(50);
-    }
-}
-
-int MenuBomba::selectorGenerico(const char* titulo, int minVal, int maxVal, const char* sufijo) {
-    bool salir = false;
-    ultimaInteraccion = millis();
-    int valor = minVal;
-    int valorAnterior = -1;
-
-    while (!salir) {
-        int evento = boton.leerEvento();
-        int nuevoValor = pot.leerEscalado(minVal, maxVal);
-        // Reset del timeout con el potenciómetro
-        if (evento != 0 || nuevoValor != valorAnterior) {
-            ultimaInteraccion = millis();
-        }
-
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            oled.limpiar();
-            return minVal;
-        }
-
-        if (nuevoValor != valorAnterior) {
-            valor = nuevoValor;
-            valorAnterior = nuevoValor;
-
-            oled.limpiar();
-            oled.mostrar(titulo, 0, 0);
-
-            char buffer[17];
-            snprintf(buffer, sizeof(buffer), "%d %s", valor, sufijo);
-            oled.mostrar(buffer, 0, 1);
-        }
-
-        if (evento == 1) {
-            salir = true;
+        pasoActual = 0;
+        if (estado == POR_DIAS) {
+            pantalla = ELIGE_DIAS;
+            mask = 0;
+            diaActual = pot.leerEscalado(0, 6);
+            pintarDias();
+            return;
         }
-
-        delay(50);
     }
-
-    return valor;
+    if (pasoActual < numPasos) {
+        pantalla = ELIGE_VALOR;
+        selector.empezar(pasos[pasoActual]);
+        selector.actualizar();
+        return;
+    }
+    guardar();
 }
 
-uint8_t MenuBomba::selectorDias() {
-    bool salir = false;
-    ultimaInteraccion = millis();
-    uint8_t mask = 0;
-    int diaActual = -1;
-
+void MenuBomba::pintarDias() {
     static const char* nombres[] = {
         "Dom", "Lun", "Mar", "Mie", "Jue", "Vie", "Sab"
     };
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar("Dias Semana", 0, 0);
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%s %s", nombres[diaActual],
+                (mask & (1 << diaActual)) ? "[X]" : "[ ]");
+    oled.mostrar(buffer, 0, 1);
+    oled.confirmarCuadro();
+}
 
-    while (!salir) {
-        int evento = boton.leerEvento();
-        int nuevoDia = pot.leerEscalado(0, 6);
-
-        if (evento != 0 || nuevoDia != diaActual) {
-            ultimaInteraccion = millis();
+void MenuBomba::guardar() {
+    const int* v = valores;
+    switch (estado) {
+        case POR_DIAS:
+            configManager.configurarPorDias(zona, mask, v[0], v[1], v[2], v[3]);
+            break;
+        case POR_INTERVALO: {
+            Fecha inicio;
+            inicio.dia  = v[1];
+            inicio.mes  = v[2];
+            inicio.anio = v[3];
+            configManager.configurarPorIntervalo(zona, v[0], inicio, v[4], v[5], v[6], v[7]);
+            break;
         }
+        case POR_FECHA:
+            configManager.configurarPorFecha(zona, {(uint8_t)v[0], (uint8_t)v[1], (uint16_t)v[2]}, v[3], v[4], v[5], v[6]);
+            break;
+        default:
+            break;
+    }
+    mensaje("Config Guardada");
+}
 
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            oled.limpiar();
-            return mask;
-        }
+bool MenuBomba::actualizar() {
+    if (pantalla == CERRADO) return false;
+    unsigned long ahora = hal::millis();
+    if (pantalla == MENSAJE) {
+        if ((long)(ahora - finMensaje) >= 0) cerrar();
+        return abierto();
+    }
+
+    int evento = boton.leerEvento();
 
-        
+    // El pot también cuenta como interacción mientras se elige algo
+    bool cambio = false;
+    if (pantalla == ELIGE_ZONA || pantalla == ELIGE_VALOR) {
+        cambio = selector.actualizar();
+    } else if (pantalla == ELIGE_DIAS) {
+        int nuevoDia = pot.leerEscalado(0, 6);
         if (nuevoDia != diaActual) {
             diaActual = nuevoDia;
-
-            oled.limpiar();
-            oled.mostrar("Dias Semana", 0, 0);
-
-            char buffer[17];
-            snprintf(buffer, sizeof(buffer), "%s %s", nombres[diaActual],
-                        (mask & (1 << diaActual)) ? "[X]" : "[ ]");
-            oled.mostrar(buffer, 0, 1);
+            pintarDias();
+            cambio = true;
         }
-
-        if (evento == 1) {
-            mask ^= (1 << diaActual); // toggle
-        }
-        else if (evento == 2) {
-            salir = true;
-        }
-
-        delay(50);
+    }
+    if (evento != 0 || cambio) {
+        ultimaInteraccion = ahora;
     }
 
-    return mask;
-}
+    // A medias no se guarda nada
+    if (ahora - ultimaInteraccion > TIMEOUT_MS || !oled.estaEncendido()) {
+        cerrar();
+        return false;
+    }
 
-int MenuBomba::selectorIntervalo() {
-    return selectorGenerico("Intervalo", 1, 30, "dias");
+    switch (pantalla) {
+        case LISTA:
+            if (evento == 1) {
+                opcionActual = (opcionActual + 1) % numOpciones;
+                pintarLista();
+            } else if (evento == 2) {
+                if (opcionActual == 4) {   // "Salir"
+                    cerrar();
+                } else {
+                    estado =    (opcionActual == 0) ? POR_INTERVALO :
+                                (opcionActual == 1) ? POR_DIAS :
+                                (opcionActual == 2) ? POR_FECHA :
+                                APAGADO;
+                    procesarEventoBoton();
+                }
+            }
+            break;
+        case ELIGE_ZONA:
+            // Índice interno (0..N-1); en pantalla se ve 1..N
+            if (evento == 1) {
+                zona = selector.valor() - 1;
+                siguientePaso();
+            }
+            break;
+        case ELIGE_DIAS:
+            if (evento == 1) {
+                mask ^= (1 << diaActual); // toggle
+                pintarDias();
+            } else if (evento == 2) {
+                siguientePaso();
+            }
+            break;
+        case ELIGE_VALOR:
+            if (evento == 1) {
+                valores[pasoActual++] = selector.valor();
+                siguientePaso();
+            }
+            break;
+        default:
+            break;
+    }
+    return abierto();
 }
@@ -4,13 +4,19 @@
 #include "../objects/Potenciometro.h"
 #include "../objects/OLED.h"
 #include "../manager/ConfigManager.h"
+#include "Selector.h"
 
+// Menú de configuración de las zonas como máquina de estados: abrir() lo
+// pinta y cada actualizar() (una vuelta de la tarea de interfaz) lee el
+// botón una vez y avanza a lo sumo un paso. Nunca espera: el riego y el
+// botón manual siguen mientras se elige.
 class MenuBomba {
     private:
         OLED& oled;
         Boton& boton;
         Potenciometro& pot;
         ConfigManager& configManager;
+        Selector selector;
 
         int opcionActual = 0;
         unsigned long ultimaInteraccion;
@@ -23,26 +29,49 @@ class MenuBomba {
             NO_MENU
         } estado;
 
+        // Dónde está el usuario dentro del menú
+        enum Pantalla {
+            CERRADO,
+            LISTA,              // Eligiendo opción
+            ELIGE_ZONA,
+            ELIGE_DIAS,
+            ELIGE_VALOR,        // pasos[pasoActual]
+            MENSAJE             // "Config Guardada" hasta finMensaje
+        } pantalla = CERRADO;
+
         const char* opciones[5] = {
             "1) Por Intervalo",
             "2) Por Dias",
             "3) Por Fecha",
-            configManager.estadoBomba() ? "4) Apagar Bomba" : "4) Encender Bomba",
+            "4) On/Off Zona",
             "5) Salir"
         };
         const int numOpciones = sizeof(opciones) / sizeof(opciones[0]);
 
+        static const uint8_t MAX_PASOS = 8;
+        const Paso* pasos = nullptr;    // Los del modo elegido
+        uint8_t numPasos = 0;
+        uint8_t pasoActual = 0;
+        int valores[MAX_PASOS];
+        uint8_t zona = 0;
+        uint8_t mask = 0;               // Días elegidos
+        int diaActual = -1;
+        unsigned long finMensaje = 0;
 
-        void procesarEventoBoton();
-        uint8_t selectorDias();
-        void selectorFecha();
-        int selectorIntervalo();
-        int selectorGenerico(const char* titulo, int minVal, int maxVal, const char* sufijo);
-    
-
-        
+        void pintarLista();
+        void procesarEventoBoton();     // Entra en el modo de opcionActual
+        void siguientePaso();
+        void pintarDias();
+        void guardar();
+        void mensaje(const char* texto);
+        void cerrar();
 
     public:
+        static const unsigned long TIMEOUT_MS = 15000;  // Sin tocar nada: se sale sin guardar
+        static const unsigned long MENSAJE_MS = 1500;
+
         MenuBomba(OLED& oled, Boton& boton, Potenciometro& pot, ConfigManager& cfg);
-        void mostrarMenu();
-};
\ No newline at end of file
+        void abrir();
+        bool actualizar();              // false cuando ya se cerró
+        bool abierto() const { return pantalla != CERRADO; }
+};
@@ -1,75 +1,81 @@
 #include "MenuPrincipal.h"
+#include "../hal/Hal.h"
 
 MenuPrincipal::MenuPrincipal(OLED& oled, Boton& boton, MenuBomba& menuBomba, MenuReloj& menuReloj)
     : oled(oled), boton(boton), menuBomba(menuBomba), menuReloj(menuReloj)  {}
 
-// maquina de estados simple
+void MenuPrincipal::pintar() {
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar("Menu Principal", 0, 0);
+    oled.mostrar(opciones[opcionActual], 0, 1);
+    oled.confirmarCuadro();
+}
+
+void MenuPrincipal::abrir() {
+    ultimaInteraccion = hal::millis();
+    estado = MENU_PRINCIPAL;
+    pintar();
+}
+
+void MenuPrincipal::cerrar() {
+    oled.limpiar();
+    estado = NO_MENU;
+}
+
+// maquina de estados simple: el submenú elegido se abre y lleva las vueltas
 void MenuPrincipal::procesarEventoBoton() {
     switch (estado) {
         case MENU_CONFIG_BOMBA:
-            oled.limpiar();
-            menuBomba.mostrarMenu();
-            delay(1500);
+            menuBomba.abrir();
             break;
-
         case MENU_CONFIG_RELOJ:
-            oled.limpiar();
-            menuReloj.mostrarMenu();
-            delay(1500);
+            menuReloj.abrir();
             break;
+        case MENU_PRINCIPAL:
         case NO_MENU:
         default:
-            delay(50);
-            oled.limpiar();
+            cerrar();
             break;
-
     }
-    return;
 }
 
-// Mostrar menú principal y manejar navegación
-void MenuPrincipal::mostrarMenu() {
-    bool salir = false;
-
-    ultimaInteraccion = millis();
-    
-    // Mostrar por primera vez al entrar
-    oled.limpiar();
-    oled.mostrar("Menu Principal", 0, 0);
-    oled.mostrar(opciones[opcionActual], 0, 1);
-
-    while (!salir) {
-        int evento = boton.leerEvento();
+bool MenuPrincipal::actualizar() {
+    // Al acabar el submenú (guardado, "Salir" o timeout) se vuelve a la
+    // pantalla de estado, como antes
+    if (estado == MENU_CONFIG_BOMBA) {
+        if (!menuBomba.actualizar()) cerrar();
+        return abierto();
+    }
+    if (estado == MENU_CONFIG_RELOJ) {
+        if (!menuReloj.actualizar()) cerrar();
+        return abierto();
+    }
+    if (estado == NO_MENU) return false;
 
-        // Reset timeout si hubo interacción
-        if (evento != 0) {
-            ultimaInteraccion = millis();
-        }
+    int evento = boton.leerEvento();
 
-        // Timeout o LCD apagado → salir
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            ultimaInteraccion = millis();
-            oled.limpiar();
-            return;
-        }
+    // Reset timeout si hubo interacción
+    if (evento != 0) {
+        ultimaInteraccion = hal::millis();
+    }
 
-        if (evento == 1) {
-            opcionActual = (opcionActual + 1) % numOpciones;
+    // Timeout o LCD apagado → salir
+    if (hal::millis() - ultimaInteraccion > TIMEOUT_MS || !oled.estaEncendido()) {
+        cerrar();
+        return false;
+    }
 
-            oled.limpiar();
-            oled.mostrar("Menu Principal", 0, 0);
-            oled.mostrar(opciones[opcionActual], 0, 1);
-        } else if (evento == 2) {  
-            if (opcionActual == 2) {   // "Salir"
-                oled.limpiar();
-                estado = NO_MENU;      // <- salir al estado reposo
-                salir = true;
-            } else {
-                estado = (opcionActual == 0) ? MENU_CONFIG_BOMBA : MENU_CONFIG_RELOJ;
-                procesarEventoBoton();
-                salir = true;
-            }
+    if (evento == 1) {
+        opcionActual = (opcionActual + 1) % numOpciones;
+        pintar();
+    } else if (evento == 2) {
+        if (opcionActual == 2) {   // "Salir"
+            cerrar();
+        } else {
+            estado = (opcionActual == 0) ? MENU_CONFIG_BOMBA : MENU_CONFIG_RELOJ;
+            procesarEventoBoton();
         }
-        delay(50); // pequeño respiro, no debounce fuerte
     }
+    return abierto();
 }
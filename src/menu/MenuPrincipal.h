@@ -9,6 +9,9 @@
 #include "MenuBomba.h"
 #include "MenuReloj.h"
 
+// Entrada a los menús. No bloquea: abrir() lo pinta y la tarea de
+// interfaz llama a actualizar() en cada vuelta mientras abierto(). Con un
+// submenú dentro, la vuelta es suya (él lee el botón y el pot).
 class MenuPrincipal {
 private:
     OLED& oled;
@@ -23,9 +26,10 @@ private:
 
     enum EstadoMenu {
         NO_MENU,
+        MENU_PRINCIPAL,
         MENU_CONFIG_BOMBA,
         MENU_CONFIG_RELOJ,
-    } estado;
+    } estado = NO_MENU;
 
     const char* opciones[3] = {
         "1) Config Bomba",
@@ -33,9 +37,15 @@ private:
         "3) Salir"
     };
     const int numOpciones = sizeof(opciones) / sizeof(opciones[0]);
+    void pintar();
     void procesarEventoBoton();
+    void cerrar();
 
 public:
+    static const unsigned long TIMEOUT_MS = 15000;
+
     MenuPrincipal(OLED& oled, Boton& boton, MenuBomba& menuBomba, MenuReloj& menuReloj);
-    void mostrarMenu();
+    void abrir();
+    bool actualizar();              // Un paso; false cuando ya se cerró
+    bool abierto() const { return estado != NO_MENU; }
 };
@@ -1,118 +1,113 @@
 #include "MenuReloj.h"
+#include "../hal/Hal.h"
+
+static const Paso PASOS_HORA[] = {
+    {"Hora", 0, 23, "h"},
+    {"Minuto", 0, 59, "m"},
+};
+static const Paso PASOS_FECHA[] = {
+    {"Dia", 1, 31, "d"},
+    {"Mes", 1, 12, "m"},
+    {"Anio", 2024, 2035, "a"},
+};
 
 MenuReloj::MenuReloj(OLED& oled, Boton& boton, Potenciometro& pot, Reloj& reloj)
-    : oled(oled), boton(boton), pot(pot), reloj(reloj), estado(NO_MENU) {}
+    : oled(oled), boton(boton), pot(pot), reloj(reloj), selector(oled, pot), estado(NO_MENU) {}
 
+void MenuReloj::pintarLista() {
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar("Menu Reloj", 0, 0);
+    oled.mostrar(opciones[opcionActual], 0, 1);
+    oled.confirmarCuadro();
+}
+
+void MenuReloj::abrir() {
+    ultimaInteraccion = hal::millis();
+    estado = NO_MENU;
+    pantalla = LISTA;
+    pintarLista();
+}
+
+void MenuReloj::cerrar() {
+    oled.limpiar();
+    estado = NO_MENU;
+    pantalla = CERRADO;
+}
 
 void MenuReloj::procesarEventoBoton() {
-    switch (estado) {
-        case MENU_AJUSTE_HORA: {
-            oled.limpiar();
-            int hora = selectorGenerico("Hora", 0, 23, "h");
-            int min = selectorGenerico("Minuto", 0, 59, "m");
-            reloj.setHora(hora, min, 0);
-            delay(1500);
-            break;
-        }
-        case MENU_AJUSTE_FECHA: {
-            oled.limpiar();
-            int dia = selectorGenerico("Dia", 1, 31, "d");
-            int mes = selectorGenerico("Mes", 1, 12, "m");
-            int year = selectorGenerico("Anio", 2024, 2035, "a");
-            reloj.setFecha(dia, mes, year);
-            delay(1500);
-            break;
-        }   
-        case NO_MENU:
-        default:
-            delay(50);
-            oled.limpiar();
-            break;
+    if (estado == MENU_AJUSTE_HORA) {
+        pasos = PASOS_HORA;
+        numPasos = sizeof(PASOS_HORA) / sizeof(PASOS_HORA[0]);
+    } else {
+        pasos = PASOS_FECHA;
+        numPasos = sizeof(PASOS_FECHA) / sizeof(PASOS_FECHA[0]);
     }
-    return;
+    pasoActual = 0;
+    siguientePaso();
 }
 
-void MenuReloj::mostrarMenu() {
-    bool salir = false;
-
-    // Mostrar por primera vez al entrar
+// Un valor tras otro; con el último se ajusta el reloj
+void MenuReloj::siguientePaso() {
+    if (pasoActual < numPasos) {
+        pantalla = ELIGE_VALOR;
+        selector.empezar(pasos[pasoActual]);
+        selector.actualizar();
+        return;
+    }
+    const char* texto;
+    if (estado == MENU_AJUSTE_HORA) {
+        reloj.setHora(valores[0], valores[1], 0);
+        texto = "Hora Ajustada";
+    } else {
+        reloj.setFecha(valores[0], valores[1], valores[2]);
+        texto = "Fecha Ajustada";
+    }
+    oled.iniciarCuadro();
     oled.limpiar();
-    oled.mostrar("Menu Reloj", 0, 0);
-    oled.mostrar(opciones[opcionActual], 0, 1);
+    oled.mostrar(texto, 0, 0);
+    oled.confirmarCuadro();
+    finMensaje = hal::millis() + MENSAJE_MS;
+    pantalla = MENSAJE;
+}
 
-    while (!salir) {
-        
-        int evento = boton.leerEvento();
+bool MenuReloj::actualizar() {
+    if (pantalla == CERRADO) return false;
+    unsigned long ahora = hal::millis();
+    if (pantalla == MENSAJE) {
+        if ((long)(ahora - finMensaje) >= 0) cerrar();
+        return abierto();
+    }
 
-        // Reset timeout si hubo interacción
-        if (evento != 0) {
-            ultimaInteraccion = millis();
-        }
+    int evento = boton.leerEvento();
+    bool cambio = pantalla == ELIGE_VALOR && selector.actualizar();
 
-        // Timeout o oled apagado → salir
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            ultimaInteraccion = millis();
-            oled.limpiar();
-            return;
-        }
+    // Reset timeout si hubo interacción
+    if (evento != 0 || cambio) {
+        ultimaInteraccion = ahora;
+    }
+
+    // Timeout o oled apagado → salir sin tocar el reloj
+    if (ahora - ultimaInteraccion > TIMEOUT_MS || !oled.estaEncendido()) {
+        cerrar();
+        return false;
+    }
 
+    if (pantalla == LISTA) {
         if (evento == 1) {
             opcionActual = (opcionActual + 1) % numOpciones;
-            oled.limpiar();
-            oled.mostrar("Menu Reloj", 0, 0);
-            oled.mostrar(opciones[opcionActual], 0, 1);
-        } else if (evento == 2) {  
+            pintarLista();
+        } else if (evento == 2) {
             if (opcionActual == 2) {   // "Salir"
-                oled.limpiar();
-                estado = NO_MENU;      // <- salir al estado reposo
-                salir = true;
+                cerrar();
             } else {
                 estado = (opcionActual == 0) ?  MENU_AJUSTE_HORA : MENU_AJUSTE_FECHA;
                 procesarEventoBoton();
-                salir = true;
             }
         }
-        delay(50); // pequeño respiro, no debounce fuerte
+    } else if (pantalla == ELIGE_VALOR && evento == 1) {
+        valores[pasoActual++] = selector.valor();
+        siguientePaso();
     }
-}
-
-int MenuReloj::selectorGenerico(const char* titulo, int minVal, int maxVal, const char* sufijo) {
-    bool salir = false;
-    ultimaInteraccion = millis();
-    int valor = minVal;
-    int valorAnterior = -1;
-
-    while (!salir) {
-        int evento = boton.leerEvento();
-        int nuevoValor = pot.leerEscalado(minVal, maxVal);
-        // Reset del timeout con el potenciómetro
-        if (evento != 0 || nuevoValor != valorAnterior) {
-            ultimaInteraccion = millis();
-        }
-
-        if (millis() - ultimaInteraccion > 15000 || !oled.estaEncendido()) {
-            oled.limpiar();
-            return minVal;
-        }
-
-        if (nuevoValor != valorAnterior) {
-            valor = nuevoValor;
-            valorAnterior = nuevoValor;
-
-            oled.limpiar();
-            oled.mostrar(titulo, 0, 0);
-
-            char buffer[17];
-            snprintf(buffer, sizeof(buffer), "%d %s", valor, sufijo);
-            oled.mostrar(buffer, 0, 1);
-        }
-
-        if (evento == 1) {
-            salir = true;
-        }
-
-        delay(50);
-    }
-
-    return valor;
+    return abierto();
 }
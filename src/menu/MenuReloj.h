@@ -4,13 +4,17 @@
 #include "../objects/Boton.h"
 #include "../objects/Potenciometro.h"
 #include "../objects/Reloj.h"
+#include "Selector.h"
 
+// Ajuste de hora y fecha, no bloqueante como MenuBomba: abrir() y un
+// actualizar() por vuelta de la tarea de interfaz.
 class MenuReloj{
     private:
         OLED& oled;
         Boton& boton;
         Potenciometro& pot;
         Reloj& reloj;
+        Selector selector;
 
         int opcionActual = 0;
         unsigned long ultimaInteraccion;
@@ -21,16 +25,37 @@ class MenuReloj{
             MENU_AJUSTE_FECHA,
         } estado;
 
+        enum Pantalla {
+            CERRADO,
+            LISTA,
+            ELIGE_VALOR,        // pasos[pasoActual]
+            MENSAJE
+        } pantalla = CERRADO;
+
         const char* opciones[3] = {
             "1) Ajuste Hora",
             "2) Ajuste Fecha",
             "3) Salir"
         };
         const int numOpciones = sizeof(opciones) / sizeof(opciones[0]);
-        void procesarEventoBoton();
-        int selectorGenerico(const char* titulo, int minVal, int maxVal, const char* sufijo);
-        
+
+        const Paso* pasos = nullptr;
+        uint8_t numPasos = 0;
+        uint8_t pasoActual = 0;
+        int valores[3];
+        unsigned long finMensaje = 0;
+
+        void pintarLista();
+        void procesarEventoBoton();     // Entra en el ajuste de opcionActual
+        void siguientePaso();
+        void cerrar();
+
     public:
+        static const unsigned long TIMEOUT_MS = 15000;
+        static const unsigned long MENSAJE_MS = 1500;
+
         MenuReloj(OLED& oled, Boton& boton, Potenciometro& pot, Reloj& reloj);
-        void mostrarMenu();
-};
\ No newline at end of file
+        void abrir();
+        bool actualizar();              // false cuando ya se cerró
+        bool abierto() const { return pantalla != CERRADO; }
+};
@@ -0,0 +1,27 @@
+#include "Selector.h"
+#include <stdio.h>
+
+Selector::Selector(OLED& oled, Potenciometro& pot)
+    : oled(oled), pot(pot), paso({"", 0, 0, ""}), valorActual(0), pintado(false) {}
+
+void Selector::empezar(const Paso& nuevo) {
+    paso = nuevo;
+    valorActual = nuevo.minVal;
+    pintado = false;
+}
+
+bool Selector::actualizar() {
+    int nuevoValor = pot.leerEscalado(paso.minVal, paso.maxVal);
+    if (pintado && nuevoValor == valorActual) return false;
+    valorActual = nuevoValor;
+    pintado = true;
+
+    oled.iniciarCuadro();
+    oled.limpiar();
+    oled.mostrar(paso.titulo, 0, 0);
+    char buffer[17];
+    snprintf(buffer, sizeof(buffer), "%d %s", valorActual, paso.sufijo);
+    oled.mostrar(buffer, 0, 1);
+    oled.confirmarCuadro();
+    return true;
+}
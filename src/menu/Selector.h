@@ -0,0 +1,34 @@
+#pragma once
+#include <stdint.h>
+#include "../objects/OLED.h"
+#include "../objects/Potenciometro.h"
+
+// Un valor pedido con el potenciómetro: título arriba, valor y sufijo abajo
+struct Paso {
+    const char* titulo;
+    int16_t minVal;
+    int16_t maxVal;
+    const char* sufijo;
+};
+
+// ==========================================
+// SELECTOR DE VALOR (NO BLOQUEANTE)
+// ==========================================
+// Lo que antes era selectorGenerico() sin su bucle: cada actualizar() lee
+// el pot una vez y repinta solo si el valor cambió. El menú que lo usa
+// decide con el botón cuándo vale el valor().
+class Selector {
+    private:
+        OLED& oled;
+        Potenciometro& pot;
+        Paso paso;
+        int valorActual;
+        bool pintado;
+
+    public:
+        Selector(OLED& oled, Potenciometro& pot);
+
+        void empezar(const Paso& nuevo);
+        bool actualizar();      // true si el valor cambió (cuenta como interacción)
+        int valor() const { return valorActual; }
+};
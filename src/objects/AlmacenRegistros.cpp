@@ -0,0 +1,242 @@
+#include "AlmacenRegistros.h"
+#include "../hal/Hal.h"
+#include <string.h>
+
+static const uint32_t MAGIA = 0x52454731;       // "REG1"
+static const uint16_t FORMATO = 1;
+static const uint32_t LISTO = 0;
+static const uint8_t CLAVE_LIBRE = 0xFF;
+
+static_assert(hal::FLASH_SECTOR <= 0xFFFF, "Las posiciones del índice son de 16 bits");
+
+AlmacenRegistros::AlmacenRegistros(hal::ParticionFlash particion) : particion(particion) {
+    memset(posicion, 0, sizeof(posicion));
+}
+
+// ======================================================
+// AUXILIARES
+// ======================================================
+uint32_t AlmacenRegistros::base(size_t sector) const {
+    return sector * hal::FLASH_SECTOR;
+}
+
+// Cabecera + datos, redondeado a 4 bytes
+size_t AlmacenRegistros::tamRegistro(uint8_t largo) {
+    return (sizeof(CabeceraRegistro) + largo + 3) & ~(size_t)3;
+}
+
+// CRC-32 (IEEE, reflejado) bit a bit: los registros son cortos
+static uint32_t crc32(uint32_t crc, const uint8_t* datos, size_t len) {
+    crc = ~crc;
+    while (len--) {
+        crc ^= *datos++;
+        for (uint8_t b = 0; b < 8; b++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+uint32_t AlmacenRegistros::crc(const CabeceraRegistro& cab, const uint8_t* datos) {
+    uint8_t cabecera[4] = { cab.clave, cab.version, cab.largo, cab.reservado };
+    return crc32(crc32(0, cabecera, sizeof(cabecera)), datos, cab.largo);
+}
+
+// ======================================================
+// MONTAJE
+// ======================================================
+bool AlmacenRegistros::iniciar() {
+    montado = false;
+    sectores = hal::flashSectores(particion);
+    if (sectores < 2) return false;     // Hace falta uno libre para compactar
+
+    // Sector activo: el listo de secuencia más alta
+    bool hay = false;
+    for (size_t s = 0; s < sectores; s++) {
+        CabeceraSector cab;
+        if (!hal::flashLeer(particion, base(s), &cab, sizeof(cab))) continue;
+        if (cab.magia != MAGIA || cab.formato != FORMATO || cab.listo != LISTO) continue;
+        if (!hay || (int32_t)(cab.secuencia - secuencia) > 0) {
+            activo = s;
+            secuencia = cab.secuencia;
+            hay = true;
+        }
+    }
+
+    if (!hay) {
+        vacio = true;
+        montado = formatear();
+        return montado;
+    }
+
+    recorrerActivo();
+    vacio = true;
+    for (uint8_t c = 0; c < MAX_CLAVES; c++) {
+        if (posicion[c]) vacio = false;
+    }
+    montado = true;
+    return true;
+}
+
+bool AlmacenRegistros::formatear() {
+    activo = 0;
+    secuencia = 1;
+    memset(posicion, 0, sizeof(posicion));
+
+    CabeceraSector cab = { MAGIA, secuencia, FORMATO, 0xFFFF, LISTO };
+    if (!hal::flashBorrarSector(particion, activo)) return false;
+    if (!hal::flashEscribir(particion, base(activo), &cab, sizeof(cab))) return false;
+    escritura = sizeof(CabeceraSector);
+    return true;
+}
+
+// Rellena el índice con el sector activo; lo último de cada clave manda
+void AlmacenRegistros::recorrerActivo() {
+    memset(posicion, 0, sizeof(posicion));
+    escritura = sizeof(CabeceraSector);
+
+    uint8_t datos[MAX_DATOS];
+    while (escritura + sizeof(CabeceraRegistro) <= hal::FLASH_SECTOR) {
+        CabeceraRegistro cab;
+        hal::flashLeer(particion, base(activo) + escritura, &cab, sizeof(cab));
+
+        if (cab.clave == CLAVE_LIBRE) {
+            // Fin del log. Si lo que sigue no está borrado, una escritura se
+            // cortó a medias: se da el sector por lleno y se compactará.
+            uint8_t bloque[64];
+            for (size_t p = escritura; p < hal::FLASH_SECTOR; p += sizeof(bloque)) {
+                size_t n = hal::FLASH_SECTOR - p < sizeof(bloque) ? hal::FLASH_SECTOR - p : sizeof(bloque);
+                hal::flashLeer(particion, base(activo) + p, bloque, n);
+                for (size_t i = 0; i < n; i++) {
+                    if (bloque[i] != 0xFF) {
+                        descartados++;
+                        escritura = hal::FLASH_SECTOR;
+                        return;
+                    }
+                }
+            }
+            return;
+        }
+
+        size_t tam = tamRegistro(cab.largo);
+        bool valido = cab.clave < MAX_CLAVES && cab.largo <= MAX_DATOS &&
+                      escritura + tam <= hal::FLASH_SECTOR;
+        if (valido) {
+            hal::flashLeer(particion, base(activo) + escritura + sizeof(cab), datos, cab.largo);
+            valido = crc(cab, datos) == cab.crc;
+        }
+        if (!valido) {
+            // Registro roto (corte de luz): lo anterior vale, el resto no
+            descartados++;
+            escritura = hal::FLASH_SECTOR;
+            return;
+        }
+
+        posicion[cab.clave] = escritura;
+        escritura += tam;
+    }
+}
+
+// ======================================================
+// LECTURA
+// ======================================================
+bool AlmacenRegistros::leerRegistro(uint8_t clave, CabeceraRegistro& cab, uint8_t* datos) const {
+    if (!montado || clave >= MAX_CLAVES || posicion[clave] == 0) return false;
+    uint32_t dir = base(activo) + posicion[clave];
+    if (!hal::flashLeer(particion, dir, &cab, sizeof(cab))) return false;
+    return hal::flashLeer(particion, dir + sizeof(cab), datos, cab.largo);
+}
+
+uint8_t AlmacenRegistros::leer(uint8_t clave, void* destino, uint8_t max, uint8_t* version) const {
+    CabeceraRegistro cab;
+    uint8_t datos[MAX_DATOS];
+    if (!leerRegistro(clave, cab, datos)) return 0;
+
+    memcpy(destino, datos, cab.largo < max ? cab.largo : max);
+    if (version) *version = cab.version;
+    return cab.largo;
+}
+
+bool AlmacenRegistros::existe(uint8_t clave) const {
+    return montado && clave < MAX_CLAVES && posicion[clave] != 0;
+}
+
+size_t AlmacenRegistros::libres() const {
+    return montado ? hal::FLASH_SECTOR - escritura : 0;
+}
+
+// ======================================================
+// ESCRITURA
+// ======================================================
+bool AlmacenRegistros::escribir(uint8_t clave, uint8_t version, const void* datos, uint8_t largo) {
+    if (!montado || clave >= MAX_CLAVES || largo > MAX_DATOS) return false;
+
+    // Igual que lo guardado: ni un byte a la flash
+    CabeceraRegistro actual;
+    uint8_t guardado[MAX_DATOS];
+    if (leerRegistro(clave, actual, guardado) && actual.version == version &&
+        actual.largo == largo && memcmp(guardado, datos, largo) == 0) {
+        omitidas++;
+        return true;
+    }
+
+    size_t tam = tamRegistro(largo);
+    if (escritura + tam > hal::FLASH_SECTOR) {
+        if (!compactar()) return false;
+        if (escritura + tam > hal::FLASH_SECTOR) return false;  // Ni compactando cabe
+    }
+
+    uint8_t registro[sizeof(CabeceraRegistro) + MAX_DATOS + 3];
+    memset(registro, 0xFF, tam);
+    CabeceraRegistro cab = { clave, version, largo, 0, 0 };
+    cab.crc = crc(cab, static_cast<const uint8_t*>(datos));
+    memcpy(registro, &cab, sizeof(cab));
+    memcpy(registro + sizeof(cab), datos, largo);
+
+    if (!hal::flashEscribir(particion, base(activo) + escritura, registro, tam)) {
+        escritura = hal::FLASH_SECTOR;  // No sabemos qué quedó: a compactar
+        return false;
+    }
+
+    posicion[clave] = escritura;
+    escritura += tam;
+    escrituras++;
+    return true;
+}
+
+// Copia lo vigente al siguiente sector y lo marca listo al final
+bool AlmacenRegistros::compactar() {
+    size_t destino = (activo + 1) % sectores;
+    uint32_t nuevaSecuencia = secuencia + 1;
+
+    if (!hal::flashBorrarSector(particion, destino)) return false;
+    CabeceraSector cab = { MAGIA, nuevaSecuencia, FORMATO, 0xFFFF, 0xFFFFFFFF };
+    if (!hal::flashEscribir(particion, base(destino), &cab, sizeof(cab))) return false;
+
+    uint16_t nuevaPosicion[MAX_CLAVES];
+    memset(nuevaPosicion, 0, sizeof(nuevaPosicion));
+    size_t pos = sizeof(CabeceraSector);
+
+    uint8_t registro[sizeof(CabeceraRegistro) + MAX_DATOS + 3];
+    for (uint8_t c = 0; c < MAX_CLAVES; c++) {
+        if (!posicion[c]) continue;
+        CabeceraRegistro rc;
+        hal::flashLeer(particion, base(activo) + posicion[c], &rc, sizeof(rc));
+        size_t tam = tamRegistro(rc.largo);
+        hal::flashLeer(particion, base(activo) + posicion[c], registro, tam);
+        if (!hal::flashEscribir(particion, base(destino) + pos, registro, tam)) return false;
+        nuevaPosicion[c] = pos;
+        pos += tam;
+    }
+
+    // Solo ahora manda el sector nuevo
+    uint32_t listo = LISTO;
+    if (!hal::flashEscribir(particion, base(destino) + offsetof(CabeceraSector, listo), &listo, sizeof(listo))) {
+        return false;
+    }
+
+    activo = destino;
+    secuencia = nuevaSecuencia;
+    escritura = pos;
+    memcpy(posicion, nuevaPosicion, sizeof(posicion));
+    compactaciones++;
+    return true;
+}
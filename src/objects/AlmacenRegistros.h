@@ -0,0 +1,93 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "../hal/Hal.h"
+
+// ==========================================
+// ALMACÉN DE REGISTROS EN FLASH (log estructurado)
+// ==========================================
+// Guarda registros pequeños (clave 0..MAX_CLAVES-1, versión de esquema y
+// hasta MAX_DATOS bytes) en una partición de hal::flash*. Nunca reescribe
+// en sitio: cada cambio se añade al final del sector activo con su CRC.
+//
+//   - Arranque: se elige el sector activo por su cabecera y se recorre solo
+//     ese sector para rellenar el índice clave -> posición. El coste no
+//     depende de cuántas veces se haya escrito.
+//   - Lectura: por el índice, directa (O(1)).
+//   - Escritura: si el contenido no cambia no se toca la flash.
+//   - Sector lleno: se compacta (solo lo vigente) en el SIGUIENTE sector,
+//     en rueda: los borrados se reparten entre todos los sectores.
+//   - Cortes de luz: un registro a medias no pasa el CRC y se ignora; una
+//     compactación a medias no llega a marcar su sector como listo y en el
+//     arranque sigue mandando el anterior, que no se ha tocado.
+//
+// No es reentrante: usarlo siempre desde el mismo núcleo (el de control).
+class AlmacenRegistros {
+    public:
+        static const uint8_t MAX_CLAVES = 32;
+        static const uint8_t MAX_DATOS = 160;
+
+    private:
+        struct CabeceraSector {
+            uint32_t magia;
+            uint32_t secuencia;     // Crece en cada compactación
+            uint16_t formato;       // Del propio almacén, no de los datos
+            uint16_t reservado;
+            uint32_t listo;         // 0xFFFFFFFF hasta acabar de compactar
+        };
+
+        struct CabeceraRegistro {
+            uint8_t clave;          // 0xFF: hueco sin escribir
+            uint8_t version;        // Esquema de los datos (lo decide el usuario)
+            uint8_t largo;
+            uint8_t reservado;
+            uint32_t crc;           // CRC-32 de cabecera (sin crc) + datos
+        };
+
+        hal::ParticionFlash particion;
+        size_t sectores = 0;
+        size_t activo = 0;
+        uint32_t secuencia = 0;
+        size_t escritura = 0;       // Próximo byte libre del sector activo
+        bool montado = false;
+        bool vacio = true;          // No había nada guardado al montar
+
+        uint16_t posicion[MAX_CLAVES];  // 0 = sin registro (0 es la cabecera)
+
+        uint32_t escrituras = 0;
+        uint32_t omitidas = 0;
+        uint32_t compactaciones = 0;
+        uint32_t descartados = 0;   // Registros rotos encontrados al montar
+
+        uint32_t base(size_t sector) const;
+        static size_t tamRegistro(uint8_t largo);
+        static uint32_t crc(const CabeceraRegistro& cab, const uint8_t* datos);
+
+        bool formatear();
+        void recorrerActivo();
+        bool compactar();
+        bool leerRegistro(uint8_t clave, CabeceraRegistro& cab, uint8_t* datos) const;
+
+    public:
+        explicit AlmacenRegistros(hal::ParticionFlash particion = hal::FLASH_CONFIG);
+
+        // Monta el almacén (false si no hay partición o no se puede formatear)
+        bool iniciar();
+
+        // Copia hasta 'max' bytes del registro; devuelve su largo (0 si no hay)
+        uint8_t leer(uint8_t clave, void* destino, uint8_t max, uint8_t* version = nullptr) const;
+        bool existe(uint8_t clave) const;
+
+        // Añade la nueva versión del registro (nada si es igual a la guardada)
+        bool escribir(uint8_t clave, uint8_t version, const void* datos, uint8_t largo);
+
+        bool disponible() const { return montado; }
+        bool estabaVacio() const { return vacio; }
+        size_t libres() const;
+
+        // --- Estadísticas ---
+        uint32_t totalEscrituras() const { return escrituras; }
+        uint32_t totalOmitidas() const { return omitidas; }
+        uint32_t totalCompactaciones() const { return compactaciones; }
+        uint32_t totalDescartados() const { return descartados; }
+};
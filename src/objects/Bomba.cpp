@@ -1,29 +1,34 @@
 #include "Bomba.h"
-#include <Arduino.h>
+#include "../hal/Hal.h"
 
 // Constructor
-Bomba::Bomba(int pinControl) : estado(false), pinControl(pinControl) {
+Bomba::Bomba(int pinControl)
+    : estado(false), pinControl(pinControl), medido(SIN_MEDIDA), corriente(0) {
 }   
 
 void Bomba::iniciar() {
-    pinMode(pinControl, OUTPUT);
+    hal::pinModo(pinControl, hal::SALIDA);
     ApagarBomba(); // Asegurarse de que la bomba esté apagada al iniciar
     
 }
 
 // Encender bomba
 void Bomba::ActivarBomba() {
-    digitalWrite(pinControl, HIGH);
-    estado = true;
+    hal::escribir(pinControl, hal::ALTO);
+    estado.store(true, std::memory_order_relaxed);
 }
 
 // Apagar bomba
 void Bomba::ApagarBomba() {
-    digitalWrite(pinControl, LOW);
-    estado = false;
+    hal::escribir(pinControl, hal::BAJO);
+    estado.store(false, std::memory_order_relaxed);
 }
 
 bool Bomba::estaEncendida() {
-    return estado;
+    return estado.load(std::memory_order_relaxed);
 }
 
+void Bomba::fijarMedida(EstadoMedido nuevo, uint16_t mA) {
+    medido.store(nuevo, std::memory_order_relaxed);
+    corriente.store(mA, std::memory_order_relaxed);
+}
@@ -1,16 +1,38 @@
 #pragma once
+#include <stdint.h>
+#include <atomic>
+
+// Lo que mide el sensor de corriente de una salida (si lo tiene)
+enum EstadoMedido : uint8_t {
+    SIN_MEDIDA,         // Salida sin sensor de corriente
+    PARADA,
+    ARRANCANDO,         // Pico de arranque: aún no se juzga
+    EN_MARCHA,
+    SIN_CORRIENTE,      // Mandada encender pero no consume: no está girando
+    SOBRECORRIENTE,     // Cortada por consumir de más
+    BLOQUEADA           // Cortada: rotor bloqueado (el pico de arranque no baja)
+};
 
 class Bomba {
     private:
-        bool estado;
+        // Lo mandado lo escriben el control y el temporizador de flancos;
+        // la medida, MonitorCorriente desde la tarea de sensores. Se leen
+        // desde el control, la UI y la red: atómicos sueltos (relajados),
+        // así que estado y mA pueden verse de ciclos distintos, nunca rotos
+        std::atomic<bool> estado;
         int  pinControl;
-
+        std::atomic<EstadoMedido> medido;
+        std::atomic<uint16_t> corriente;     // mA RMS del último ciclo de red
 
     public:
-        // Constructor
+        // Constructor (en arrays, con llaves: ver BOMBAS_ZONAS)
         Bomba(int pinControl);
         void iniciar();
         void ActivarBomba();
         void ApagarBomba();
-        bool estaEncendida();
+        bool estaEncendida();   // Lo mandado, no lo medido
+
+        void fijarMedida(EstadoMedido nuevo, uint16_t mA);
+        EstadoMedido estadoMedido() const { return medido.load(std::memory_order_relaxed); }
+        uint16_t corrienteMa() const { return corriente.load(std::memory_order_relaxed); }
 };
@@ -1,14 +1,24 @@
 #pragma once
-#include <Arduino.h>
+#include <stdint.h>
 
 // Modo de operación de la bomba
 enum ModoBomba : uint8_t { // Forzamos que el enum pese 1 byte, no 4
     POR_DIAS,
     POR_INTERVALO,
     POR_FECHA,
-    APAGADO
+    APAGADO,
+    SEMANAL,        // Varias ventanas por día (tramos en minutos de la semana)
+    CRON            // Expresión tipo cron: cada disparo riega 'duracion' minutos
 };
 
+static const uint16_t MINUTOS_SEMANA = 7 * 24 * 60;   // 10080 (0 = domingo 00:00)
+static const uint8_t MAX_TRAMOS = 28;                 // 4 ventanas al día toda la semana
+static const uint16_t MAX_DURACION_CRON = 24 * 60;    // Minutos por disparo
+
+// Campos de día de HorarioCron escritos con '*' (cambian cómo se combinan)
+static const uint8_t CRON_DIA_MES_TODOS = 1 << 0;
+static const uint8_t CRON_DIA_SEMANA_TODOS = 1 << 1;
+
 // Empaquetado estricto para evitar problemas en EEPROM
 #pragma pack(push, 1)
 
@@ -19,6 +29,25 @@ struct Fecha {
     uint16_t anio; // año completo (ej: 2025)
 };
 
+// Forma comprimida del horario semanal: cada tramo es un trozo encendido
+// (codificación por longitudes). Puede cruzar la medianoche y el domingo.
+struct Tramo {
+    uint16_t inicio;    // Minuto de la semana (0..MINUTOS_SEMANA-1)
+    uint16_t minutos;   // 1..MINUTOS_SEMANA
+};
+
+// Expresión cron ya compilada: un bit por valor permitido de cada campo
+// (el texto se rehace con cron::formatear). Ver objects/Cron.h.
+struct HorarioCron {
+    uint64_t minutos;       // bit 0..59
+    uint32_t horas;         // bit 0..23
+    uint32_t diasMes;       // bit 1..31
+    uint16_t meses;         // bit 1..12
+    uint8_t diasSemana;     // bit 0..6 (0 = domingo, como en POR_DIAS)
+    uint8_t comodines;      // CRON_DIA_MES_TODOS | CRON_DIA_SEMANA_TODOS
+    uint16_t duracion;      // Minutos de riego por disparo (1..MAX_DURACION_CRON)
+};
+
 class BombaConfig {
 
     public:
@@ -43,6 +72,15 @@ class BombaConfig {
         // --- POR FECHA ---
         Fecha proximaFecha;
 
+        // --- SEMANAL ---
+        // Al final del struct: lo anterior conserva la disposición de la v1
+        uint8_t numTramos;
+        Tramo tramos[MAX_TRAMOS];
+
+        // --- CRON ---
+        // Al final: lo anterior conserva la disposición de la v2
+        HorarioCron cron;
+
         // Constructor (Sin cambios, está perfecto)
         BombaConfig(bool habilitada = false,
             bool desactivarHoy = false,
@@ -65,32 +103,10 @@ class BombaConfig {
             minutoInicio(minutoInicio),
             horaFin(horaFin),
             minutoFin(minutoFin),
-            proximaFecha(proximaFecha) {}
-
-        String toString() const {
-            String resultado = "Modo: ";
-            switch (modo) {
-                case POR_DIAS: resultado += "Por Dias"; break;
-                case POR_INTERVALO: resultado += "Por Intervalo"; break;
-                case POR_FECHA: resultado += "Por Fecha"; break;
-                case APAGADO: resultado += "Apagado"; break;
-            }
-
-            resultado += "\nDias Semana: " + String(diasSemana, BIN);
-            resultado += "\nIntervalo Dias: " + String(intervaloDias);
-            resultado += "\nFecha Inicio: " + String(fechaInicio.dia) + "/" + 
-                            String(fechaInicio.mes) + "/" + String(fechaInicio.anio);
-            resultado += "\nProxima Fecha: " + String(proximaFecha.dia) + "/" + 
-                            String(proximaFecha.mes) + "/" + String(proximaFecha.anio);
-            resultado += "\nHora Inicio: " + String(horaInicio) + ":" + 
-                            (minutoInicio < 10 ? "0" : "") + String(minutoInicio);
-            resultado += "\nHora Fin: " + String(horaFin) + ":" + 
-                            (minutoFin < 10 ? "0" : "") + String(minutoFin);
-            resultado += "\nDesactivar Hoy: " + String(desactivarHoy ? "Si" : "No");
-            resultado += "\nHabilitada: " + String(habilitada ? "Si" : "No");
-
-            return resultado;
-        }
+            proximaFecha(proximaFecha),
+            numTramos(0),
+            tramos(),
+            cron() {}
 };
 
 #pragma pack(pop) // Volvemos a la configuración normal de memoria
\ No newline at end of file
@@ -1,76 +1,152 @@
 #include "Boton.h"
 
-Boton::Boton(int pin) : pin(pin) {}
+Boton::Boton(int pin, unsigned long ventanaDobleMs) : pin(pin), ventanaDobleMs(ventanaDobleMs) {}
 
 void Boton::iniciar() {
-    pinMode(pin, INPUT_PULLUP);
-    stableState = digitalRead(pin);
+    hal::pinModo(pin, hal::ENTRADA_PULLUP);
+    stableState = hal::leer(pin);
     lastReading = stableState;
+    ultimoEncolado = stableState;
+    ultimoFlancoUs = hal::micros();
+    inicioRafagaUs = ultimoFlancoUs;    // El primer flanco no mide desde una ráfaga vieja
+
+    // Nada de una vida anterior: ni flancos, ni pulsación a medias, ni eventos
+    Flanco f;
+    while (flancos.sacar(f)) {}
+    pressActive = false;
+    longTriggered = false;
+    clickPendiente = false;
+    eventosLeidos = eventosEscritos;
+
+    porInterrupcion = hal::interrupcionPin(pin, &Boton::alCambiar, this);
 }
 
-int Boton::leerEvento() {
-    int reading = digitalRead(pin);
+// ======================================================
+// ISR: solo marca de tiempo + cola (nada de lógica aquí)
+// ======================================================
+void HAL_ISR Boton::alCambiar(void* ctx, hal::Nivel nivel, uint32_t us) {
+    Boton* self = static_cast<Boton*>(ctx);
+    if (nivel == self->ultimoEncolado) return; // Flanco duplicado, no aporta
+    if (self->flancos.meter(Flanco{ us, nivel })) self->ultimoEncolado = nivel;
+}
 
-    // 1. FILTRO DE REBOTE (DEBOUNCE)
-    // Si la lectura física cambió (ruido o pulsación real), reseteamos el cronómetro
-    if (reading != lastReading) {
-        lastDebounceTime = millis();
-    }
-    lastReading = reading;
-
-    // Si ha pasado suficiente tiempo estable, aceptamos el cambio de estado
-    if ((millis() - lastDebounceTime) > DEBOUNCE_MS) {
-        
-        // Si el estado estable cambió respecto a lo que teníamos guardado...
-        if (reading != stableState) {
-            stableState = reading;
-
-            // --- LÓGICA DE DETECCIÓN ---
-            if (stableState == LOW) {
-                // FLANCO DE BAJADA (Presionado)
-                pressStart = millis();
-                pressActive = true;
-                longTriggered = false;
-            } else {
-                // FLANCO DE SUBIDA (Soltado)
-                if (pressActive) {
-                    pressActive = false;
-                    unsigned long duration = millis() - pressStart;
-
-                    // Si soltó RÁPIDO y no se había disparado el evento largo...
-                    if (!longTriggered && duration < LONG_MS) {
-                        buttonEvent = 1; // CLICK CORTO
-                    }
-                }
-            }
+// ======================================================
+// ANTIRREBOTE + CLASIFICACIÓN
+// ======================================================
+// Una ráfaga de rebotes es una serie de flancos separados menos de
+// DEBOUNCE_MS. Cuando se calma, el nivel final se da por bueno con el
+// instante de su PRIMER flanco, así las duraciones no arrastran el rebote.
+void Boton::procesar() {
+    const uint32_t debounceUs = DEBOUNCE_MS * 1000UL;
+
+    if (!porInterrupcion) {
+        // Sin interrupción: cada cambio visto al muestrear cuenta como flanco
+        hal::Nivel nivel = hal::leer(pin);
+        if (nivel != ultimoEncolado) {
+            flancos.meter(Flanco{ (uint32_t)hal::micros(), nivel });
+            ultimoEncolado = nivel;
         }
     }
 
-    // 2. DETECCIÓN DE PULSACIÓN LARGA (Mientras se mantiene presionado)
-    if (pressActive && !longTriggered) {
-        if ((millis() - pressStart) >= LONG_MS) {
-            buttonEvent = 2; // CLICK LARGO
-            longTriggered = true; // Marcamos para no dispararlo múltiples veces
+    Flanco f;
+    while (flancos.sacar(f)) {
+        if (f.us - ultimoFlancoUs >= debounceUs) {
+            // La ráfaga anterior ya estaba asentada antes de este flanco
+            consolidar(lastReading, inicioRafagaUs);
+            inicioRafagaUs = f.us;
         }
+        lastReading = f.nivel;
+        ultimoFlancoUs = f.us;
     }
 
-    // 3. RETORNAR Y LIMPIAR EVENTO
-    if (buttonEvent != 0) {
-        int ev = buttonEvent;
-        buttonEvent = 0; // Limpiamos el evento para no leerlo dos veces
-        return ev;
+    uint32_t ahoraUs = hal::micros();
+    if (ahoraUs - ultimoFlancoUs >= debounceUs) consolidar(lastReading, inicioRafagaUs);
+
+    // DETECCIÓN DE PULSACIÓN LARGA (Mientras se mantiene presionado)
+    if (pressActive && !longTriggered && ahoraUs - pressStartUs >= LONG_MS * 1000UL) {
+        longTriggered = true; // Marcamos para no dispararlo múltiples veces
+        clickPendiente = false;
+        emitir(EventoBoton::LARGO, (ahoraUs - pressStartUs) / 1000UL, pressStartUs);
     }
 
-    return 0; // Sin novedad
+    // Corto sin segunda pulsación a tiempo -> es un click simple
+    if (clickPendiente && !pressActive && ahoraUs - releaseUs >= ventanaDobleMs * 1000UL) {
+        clickPendiente = false;
+        emitir(EventoBoton::CORTO, duracionPendienteMs, inicioPendienteUs);
+    }
+}
+
+void Boton::consolidar(hal::Nivel nivel, uint32_t us) {
+    if (nivel == stableState) return;
+    stableState = nivel;
+
+    if (stableState == hal::BAJO) {
+        // FLANCO DE BAJADA (Presionado)
+        pressStartUs = us;
+        pressActive = true;
+        longTriggered = false;
+        return;
+    }
+
+    // FLANCO DE SUBIDA (Soltado)
+    if (!pressActive) return;
+    pressActive = false;
+    if (longTriggered) return; // El evento largo ya salió al cumplir LONG_MS
+
+    uint32_t duracionMs = (us - pressStartUs) / 1000UL;
+    if (duracionMs >= LONG_MS) {
+        // Nadie consultó mientras estaba pulsado: el largo sale al soltar
+        clickPendiente = false;
+        emitir(EventoBoton::LARGO, duracionMs, pressStartUs);
+    } else if (clickPendiente) {
+        clickPendiente = false;
+        emitir(EventoBoton::DOBLE, duracionMs, pressStartUs);
+    } else if (ventanaDobleMs == 0) {
+        emitir(EventoBoton::CORTO, duracionMs, pressStartUs);
+    } else {
+        clickPendiente = true;
+        releaseUs = us;
+        duracionPendienteMs = duracionMs;
+        inicioPendienteUs = pressStartUs;
+    }
+}
+
+void Boton::emitir(EventoBoton::Tipo tipo, uint32_t duracionMs, uint32_t instanteUs) {
+    if ((uint8_t)(eventosEscritos - eventosLeidos) >= 8) eventosLeidos++; // Pierde el más viejo
+    EventoBoton& ev = eventos[eventosEscritos & 7];
+    ev.tipo = tipo;
+    ev.duracionMs = duracionMs;
+    // micros() y millis() comparten origen: se pasa la marca a ms "de ahora"
+    ev.instanteMs = hal::millis() - ((uint32_t)hal::micros() - instanteUs) / 1000UL;
+    eventosEscritos++;
+}
+
+bool Boton::sacarEvento(EventoBoton& evento) {
+    procesar();
+    if (eventosLeidos == eventosEscritos) return false;
+    evento = eventos[eventosLeidos & 7];
+    eventosLeidos++;
+    return true;
+}
+
+int Boton::leerEvento() {
+    EventoBoton ev;
+    return sacarEvento(ev) ? ev.tipo : 0; // 0 = Sin novedad
+}
+
+bool Boton::ocupado() const {
+    return pressActive || clickPendiente || lastReading != stableState || !flancos.vacia() ||
+           eventosLeidos != eventosEscritos;
 }
 
 // Métodos auxiliares para consultar estado directo (útil para tu BombaManager)
 bool Boton::estaEncendido() {
-    return (stableState == LOW);
+    procesar();
+    return (stableState == hal::BAJO);
 }
 
 bool Boton::cambioDetectado() {
     // Esta función es un helper simple, pero para tu lógica avanzada 
     // es mejor usar leerEvento() que ya maneja todo.
     return false; 
-}
\ No newline at end of file
+}
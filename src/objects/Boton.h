@@ -1,35 +1,83 @@
 #pragma once
-#include <Arduino.h>
+#include "../hal/Hal.h"
+#include "ColaSpsc.h"
 
+// Evento ya clasificado, con tiempos exactos sacados de los flancos
+struct EventoBoton {
+    enum Tipo : uint8_t {
+        NINGUNO = 0,
+        CORTO = 1,
+        LARGO = 2,
+        DOBLE = 3
+    };
+    Tipo tipo;
+    uint32_t duracionMs;   // Tiempo pulsado (en DOBLE, el de la 2ª pulsación)
+    uint32_t instanteMs;   // millis() equivalente del flanco de bajada
+};
+
+// Los flancos llegan por interrupción con su micros() y se encolan sin
+// bloqueos; el antirrebote y la clasificación corren en el consumidor al
+// llamar a leerEvento()/sacarEvento(). Si el pin no admite interrupción
+// se cae a muestreo en cada llamada (como antes).
 class Boton {
 private:
+    struct Flanco {
+        uint32_t us;
+        hal::Nivel nivel;
+    };
+
     int pin;
-    
-    // ESTADO INTERNO (Cada botón debe tener el suyo propio)
-    int stableState = HIGH;   // Estado consolidado (sin rebote)
-    int lastReading = HIGH;   // Última lectura física (para debounce)
-    
-    // Variables de eventos
-    int buttonEvent = 0;      // 0=Nada, 1=Corta, 2=Larga
+    bool porInterrupcion = false;
+
+    // --- Lado ISR ---
+    ColaSpsc<Flanco, 64> flancos;
+    hal::Nivel ultimoEncolado = hal::ALTO; // Solo lo toca la ISR
+    static void alCambiar(void* ctx, hal::Nivel nivel, uint32_t us);
+
+    // --- Antirrebote (sobre marcas de tiempo) ---
+    hal::Nivel stableState = hal::ALTO;   // Estado consolidado (sin rebote)
+    hal::Nivel lastReading = hal::ALTO;   // Último nivel visto en la ráfaga
+    uint32_t inicioRafagaUs = 0;          // Primer flanco de la ráfaga actual
+    uint32_t ultimoFlancoUs = 0;
+
+    // --- Clasificador ---
     bool pressActive = false;
-    bool longTriggered = false; 
+    bool longTriggered = false;
+    bool clickPendiente = false;          // Corto esperando por si hay doble
+    uint32_t pressStartUs = 0;
+    uint32_t releaseUs = 0;
+    uint32_t duracionPendienteMs = 0;
+    uint32_t inicioPendienteUs = 0;
 
-    // Tiempos
-    unsigned long pressStart = 0;
-    unsigned long lastDebounceTime = 0;
+    // Eventos listos (solo consumidor)
+    EventoBoton eventos[8];
+    uint8_t eventosLeidos = 0;
+    uint8_t eventosEscritos = 0;
 
     // Configuración
     const unsigned long DEBOUNCE_MS = 50;   // Aumentado un poco para estabilidad
     const unsigned long LONG_MS     = 1000; // 1 segundo para larga (más natural)
+    const unsigned long ventanaDobleMs;     // 0 = sin doble click (corto inmediato)
+
+    void procesar();
+    void consolidar(hal::Nivel nivel, uint32_t us);
+    void emitir(EventoBoton::Tipo tipo, uint32_t duracionMs, uint32_t instanteUs);
 
 public:
-    Boton(int pin);
+    Boton(int pin, unsigned long ventanaDobleMs = 0);
     void iniciar();
     
-    // Devuelve: 0 (nada), 1 (click corto), 2 (click largo)
+    // Devuelve: 0 (nada), 1 (click corto), 2 (click largo), 3 (doble click)
     int leerEvento();
+
+    // Igual que leerEvento() pero con duración e instante exactos
+    bool sacarEvento(EventoBoton& evento);
     
+    // Hay una pulsación a medias (rebote, pulsado o esperando el doble):
+    // quien lo lee no debe irse a dormir todavía
+    bool ocupado() const;
+
     // Métodos extra útiles para el BombaManager
     bool estaEncendido();     // Devuelve true si el botón está físicamente presionado
     bool cambioDetectado();   // Helper para detectar cambios simples
-};
\ No newline at end of file
+};
@@ -0,0 +1,63 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+
+// ==========================================
+// COLA SPSC SIN BLOQUEOS
+// ==========================================
+// Un solo productor y un solo consumidor (p.ej. núcleo 0 -> núcleo 1).
+// Nunca bloquea: meter() devuelve false si está llena y sacar() si está vacía.
+// N debe ser potencia de 2; los índices corren libres y se enmascaran.
+// meter()/sacar() se fuerzan inline para poder usarlas desde una ISR en IRAM.
+#define COLA_INLINE inline __attribute__((always_inline))
+
+template <typename T, uint16_t N>
+class ColaSpsc {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N debe ser potencia de 2");
+
+    private:
+        T elementos[N];
+        std::atomic<uint16_t> indiceEscritura{0}; // Solo lo avanza el productor
+        std::atomic<uint16_t> indiceLectura{0};   // Solo lo avanza el consumidor
+        std::atomic<uint32_t> rechazados{0};      // meter() con la cola llena
+
+    public:
+        // --- Lado productor ---
+        COLA_INLINE bool meter(const T& valor) {
+            uint16_t escritura = indiceEscritura.load(std::memory_order_relaxed);
+            uint16_t lectura = indiceLectura.load(std::memory_order_acquire);
+            if ((uint16_t)(escritura - lectura) >= N) {
+                rechazados.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            elementos[escritura & (N - 1)] = valor;
+            indiceEscritura.store(escritura + 1, std::memory_order_release);
+            return true;
+        }
+
+        // Solo el productor: si dice que no, meter() no fallará (el consumidor solo libera)
+        bool llena() const {
+            return (uint16_t)(indiceEscritura.load(std::memory_order_relaxed) -
+                              indiceLectura.load(std::memory_order_acquire)) >= N;
+        }
+
+        // --- Lado consumidor ---
+        COLA_INLINE bool sacar(T& valor) {
+            uint16_t lectura = indiceLectura.load(std::memory_order_relaxed);
+            if (lectura == indiceEscritura.load(std::memory_order_acquire)) return false;
+            valor = elementos[lectura & (N - 1)];
+            indiceLectura.store(lectura + 1, std::memory_order_release);
+            return true;
+        }
+
+        // --- Consultas (aproximadas si el otro lado está trabajando) ---
+        bool vacia() const {
+            return indiceLectura.load(std::memory_order_acquire) ==
+                   indiceEscritura.load(std::memory_order_acquire);
+        }
+        uint16_t ocupados() const {
+            return indiceEscritura.load(std::memory_order_acquire) -
+                   indiceLectura.load(std::memory_order_acquire);
+        }
+        uint32_t totalRechazados() const { return rechazados.load(std::memory_order_relaxed); }
+};
@@ -0,0 +1,89 @@
+#include "ConmutadorProgramado.h"
+#include <stdio.h>
+#include "../hal/Hal.h"
+
+ConmutadorProgramado::ConmutadorProgramado(Bomba* bombas, uint8_t numZonas)
+    : bombas(bombas), numZonas(numZonas) {
+}
+
+// ======================================================
+// ARMAR Y CANCELAR (tarea de riego)
+// ======================================================
+void ConmutadorProgramado::programar(uint32_t segundo, unsigned long msHasta, uint16_t cambian, uint16_t encender) {
+    uint32_t plan = ((uint32_t)(encender & cambian) << 16) | cambian;
+    if (plan == 0) {
+        cancelar();
+        return;
+    }
+
+    // Mismo flanco: solo se rearma si la hora se corrigió (resincronización)
+    uint32_t objetivo = hal::micros() + msHasta * 1000UL;
+    int32_t desvio = (int32_t)(objetivo - objetivoUs.load(std::memory_order_relaxed));
+    if (segundo == segundoArmado.load(std::memory_order_relaxed) && armado.load(std::memory_order_relaxed) == plan &&
+        desvio > -(int32_t)TOLERANCIA_US && desvio < (int32_t)TOLERANCIA_US) return;
+
+    // Parar antes de cambiar el plan para que un disparo viejo no lo use
+    hal::disparoCancelar();
+    segundoArmado.store(segundo, std::memory_order_relaxed);
+    objetivoUs.store(objetivo, std::memory_order_relaxed);
+    armado.store(plan, std::memory_order_release);
+    if (!hal::disparoProgramar((uint64_t)msHasta * 1000, alVencer, this)) {
+        // Sin temporizador queda la pasada normal de Evaluar()
+        armado.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ConmutadorProgramado::cancelar() {
+    if (armado.exchange(0, std::memory_order_acq_rel) == 0) return;
+    hal::disparoCancelar();
+    segundoArmado.store(0, std::memory_order_relaxed);
+}
+
+uint16_t ConmutadorProgramado::recoger(uint16_t& encendidas) {
+    uint32_t h = hecho.exchange(0, std::memory_order_acq_rel);
+    encendidas = h >> 16;
+    return h & 0xFFFF;
+}
+
+// ======================================================
+// DISPARO (tarea del temporizador)
+// ======================================================
+void ConmutadorProgramado::alVencer(void* ctx) {
+    ConmutadorProgramado* c = static_cast<ConmutadorProgramado*>(ctx);
+    uint32_t plan = c->armado.exchange(0, std::memory_order_acq_rel);
+    if (plan == 0) return;     // Cancelado mientras vencía
+
+    uint16_t cambian = plan & 0xFFFF;
+    uint16_t encender = plan >> 16;
+    for (uint16_t m = cambian; m; m &= m - 1) {
+        uint8_t z = __builtin_ctz(m);
+        if (z >= c->numZonas) break;
+        if (encender & (1 << z)) c->bombas[z].ActivarBomba();
+        else c->bombas[z].ApagarBomba();
+    }
+
+    // Acumular con lo que aún no se recogió: manda el último estado
+    uint32_t previo = c->hecho.load(std::memory_order_relaxed);
+    uint32_t nuevo;
+    do {
+        uint16_t zonas = (previo & 0xFFFF) | cambian;
+        uint16_t estado = ((previo >> 16) & ~cambian) | encender;
+        nuevo = ((uint32_t)estado << 16) | zonas;
+    } while (!c->hecho.compare_exchange_weak(previo, nuevo, std::memory_order_acq_rel));
+    c->segundoHecho.store(c->segundoArmado.load(std::memory_order_relaxed), std::memory_order_release);
+
+    uint32_t retraso = hal::micros() - c->objetivoUs.load(std::memory_order_relaxed);
+    if (retraso < 0x80000000UL && retraso > c->peorRetrasoUs.load(std::memory_order_relaxed)) {
+        c->peorRetrasoUs.store(retraso, std::memory_order_relaxed);
+    }
+    c->disparos.fetch_add(1, std::memory_order_relaxed);
+
+    hal::despertar();          // Que Evaluar() lo anote ya, aunque se duerma
+}
+
+void ConmutadorProgramado::reportar() const {
+    char linea[64];
+    snprintf(linea, sizeof(linea), "[Flancos] %lu disparos, peor retraso %lu us",
+             (unsigned long)totalDisparos(), (unsigned long)peorRetraso());
+    hal::log(linea);
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <stdint.h>
+#include <atomic>
+#include "Bomba.h"
+
+// ==========================================
+// CONMUTADOR PROGRAMADO (flancos del horario)
+// ==========================================
+// Deja armado el próximo flanco del horario en el disparo único de la HAL.
+// Al vencer, escribe los relés de las zonas que cambian desde el propio
+// temporizador, sin esperar a que alguien sondee, y despierta a la tarea
+// de riego para que Evaluar() lo anote en el diario.
+//
+// Lo arma y lo recoge solo la tarea de riego; el disparo corre en otra
+// tarea, así que todo lo que comparten va en atómicos. Las máscaras van
+// empaquetadas (bits 0-15: zonas a tocar, 16-31: su estado final) para
+// que zonas y estado se lean siempre juntos.
+class ConmutadorProgramado {
+    private:
+        Bomba* bombas;
+        uint8_t numZonas;
+
+        static const uint32_t TOLERANCIA_US = 2000;  // Corrección de hora que obliga a rearmar
+
+        std::atomic<uint32_t> armado{0};        // Lo que hará el disparo (0: nada)
+        std::atomic<uint32_t> hecho{0};         // Lo que ya escribió y falta recoger
+        std::atomic<uint32_t> objetivoUs{0};    // micros() previsto del flanco
+        std::atomic<uint32_t> segundoHecho{0};  // Segundo del último flanco conmutado
+        std::atomic<uint32_t> segundoArmado{0};
+
+        std::atomic<uint32_t> disparos{0};
+        std::atomic<uint32_t> peorRetrasoUs{0};
+
+        static void alVencer(void* ctx);
+
+    public:
+        ConmutadorProgramado(Bomba* bombas, uint8_t numZonas);
+
+        // En 'msHasta' ms (al empezar el segundo 'segundo') las zonas de
+        // 'cambian' pasan al estado que marca 'encender'. Si ya está armado
+        // ese mismo flanco (y la hora no se ha corregido) no hace nada.
+        void programar(uint32_t segundo, unsigned long msHasta, uint16_t cambian, uint16_t encender);
+        void cancelar();
+
+        // Zonas que conmutó el disparo desde la última llamada (0: ninguna)
+        // y, en 'encendidas', el estado en que las dejó
+        uint16_t recoger(uint16_t& encendidas);
+        uint32_t segundoConmutado() const { return segundoHecho.load(std::memory_order_acquire); }
+
+        uint32_t totalDisparos() const { return disparos.load(std::memory_order_relaxed); }
+        uint32_t peorRetraso() const { return peorRetrasoUs.load(std::memory_order_relaxed); }
+        void reportar() const;
+};
@@ -0,0 +1,338 @@
+#include "Cron.h"
+#include "../hal/RtcHal.h"
+#include <string.h>
+
+// Cualquier fecha tiene un disparo en 8 años si lo tiene alguno (29 de
+// febrero); hasta 2099 llega el DS3231
+static const uint8_t ANIOS_BUSQUEDA = 8;
+static const uint16_t ULTIMO_ANIO = 2099;
+
+static const uint8_t DIAS_SEMANA_TODOS = 0x7F;
+
+static const char* const NOMBRES_MES[] = {
+    "jan", "feb", "mar", "apr", "may", "jun", "jul", "aug", "sep", "oct", "nov", "dec"
+};
+static const char* const NOMBRES_DIA[] = { "sun", "mon", "tue", "wed", "thu", "fri", "sat" };
+
+// Límites de cada campo; los nombres valen 'primerNombre' + índice
+struct Campo {
+    uint8_t minimo;
+    uint8_t maximo;
+    const char* const* nombres;
+    uint8_t numNombres;
+    uint8_t primerNombre;
+};
+
+static const Campo MINUTO     = { 0, 59, nullptr, 0, 0 };
+static const Campo HORA       = { 0, 23, nullptr, 0, 0 };
+static const Campo DIA_MES    = { 1, 31, nullptr, 0, 0 };
+static const Campo MES        = { 1, 12, NOMBRES_MES, 12, 1 };
+static const Campo DIA_SEMANA = { 0, 7, NOMBRES_DIA, 7, 0 };    // 7 también es domingo
+
+static uint8_t diasDelMes(uint16_t anio, uint8_t mes) {
+    static const uint8_t DIAS[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    bool bisiesto = (anio % 4 == 0 && anio % 100 != 0) || anio % 400 == 0;
+    return (mes == 2 && bisiesto) ? 29 : DIAS[mes - 1];
+}
+
+// Días del mes (bit d = día d) que disparan según díaMes y díaSemana
+static uint32_t diasValidos(const HorarioCron& c, uint16_t anio, uint8_t mes) {
+    uint32_t delMes = ((1UL << diasDelMes(anio, mes)) - 1) << 1;
+
+    // La semana girada para que el bit 0 sea el día 1, repetida todo el mes
+    uint8_t primero = RtcDateTime(anio, mes, 1, 0, 0, 0).DayOfWeek();
+    uint32_t semana = ((c.diasSemana >> primero) | (c.diasSemana << (7 - primero))) & DIAS_SEMANA_TODOS;
+    uint32_t porSemana = (semana | semana << 7 | semana << 14 | semana << 21 | semana << 28) << 1;
+
+    uint32_t dias = (c.comodines & (CRON_DIA_MES_TODOS | CRON_DIA_SEMANA_TODOS))
+                        ? (c.diasMes & porSemana)
+                        : (c.diasMes | porSemana);
+    return dias & delMes;
+}
+
+// ======================================================
+// TEXTO -> BITS
+// ======================================================
+static bool leerValor(const char*& p, const Campo& campo, uint8_t& valor) {
+    if (*p >= '0' && *p <= '9') {
+        unsigned n = 0;
+        for (uint8_t cifras = 0; *p >= '0' && *p <= '9'; cifras++, p++) {
+            if (cifras == 3) return false;
+            n = n * 10 + (*p - '0');
+        }
+        if (n < campo.minimo || n > campo.maximo) return false;
+        valor = n;
+        return true;
+    }
+
+    // "jan", "Mon"...: tres letras, sin distinguir mayúsculas
+    char nombre[4] = {};
+    for (uint8_t i = 0; i < 3; i++) {
+        char c = p[i] | 0x20;
+        if (c < 'a' || c > 'z') return false;
+        nombre[i] = c;
+    }
+    for (uint8_t i = 0; i < campo.numNombres; i++) {
+        if (strcmp(nombre, campo.nombres[i]) == 0) {
+            valor = campo.primerNombre + i;
+            p += 3;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Un campo entero ("1-5,10/2,*/15") hasta el espacio o el final
+static bool leerCampo(const char*& p, const Campo& campo, uint64_t& bits, bool& comodin) {
+    bits = 0;
+    comodin = (*p == '*');
+    while (true) {
+        uint8_t desde, hasta;
+        bool rango = true;
+        if (*p == '*') {
+            desde = campo.minimo;
+            hasta = campo.maximo;
+            p++;
+        } else {
+            if (!leerValor(p, campo, desde)) return false;
+            hasta = desde;
+            rango = (*p == '-');
+            if (rango) {
+                p++;
+                if (!leerValor(p, campo, hasta)) return false;
+            }
+        }
+
+        unsigned paso = 1;
+        if (*p == '/') {
+            p++;
+            if (*p < '0' || *p > '9') return false;
+            paso = 0;
+            for (uint8_t cifras = 0; *p >= '0' && *p <= '9'; cifras++, p++) {
+                if (cifras == 2) return false;
+                paso = paso * 10 + (*p - '0');
+            }
+            if (paso == 0) return false;
+            if (!rango) hasta = campo.maximo;   // "10/5": de 10 al final
+        }
+        if (desde > hasta) return false;
+        for (unsigned v = desde; v <= hasta; v += paso) bits |= 1ULL << v;
+
+        if (*p != ',') return true;
+        p++;
+    }
+}
+
+namespace cron {
+
+    bool compilar(const char* texto, HorarioCron& cron) {
+        static const Campo* const CAMPOS[] = { &MINUTO, &HORA, &DIA_MES, &MES, &DIA_SEMANA };
+        uint64_t bits[5];
+        bool comodin[5];
+
+        const char* p = texto;
+        for (uint8_t i = 0; i < 5; i++) {
+            while (*p == ' ' || *p == '\t') p++;
+            if (!leerCampo(p, *CAMPOS[i], bits[i], comodin[i])) return false;
+            if (*p != ' ' && *p != '\t' && *p != '\0') return false;
+        }
+        while (*p == ' ' || *p == '\t') p++;
+        if (*p != '\0') return false;
+
+        cron.minutos = bits[0];
+        cron.horas = bits[1];
+        cron.diasMes = bits[2];
+        cron.meses = bits[3];
+        cron.diasSemana = (bits[4] | (bits[4] >> 7)) & DIAS_SEMANA_TODOS;   // 7 -> 0
+        cron.comodines = (comodin[2] ? CRON_DIA_MES_TODOS : 0) | (comodin[4] ? CRON_DIA_SEMANA_TODOS : 0);
+        return true;
+    }
+}
+
+// ======================================================
+// BITS -> TEXTO
+// ======================================================
+struct Texto {
+    char* buf;
+    size_t capacidad;
+    size_t pos;
+    bool desborde;
+
+    void poner(char c) {
+        if (pos + 1 >= capacidad) desborde = true;
+        else buf[pos++] = c;
+    }
+    void numero(unsigned v) {
+        if (v >= 10) poner('0' + v / 10);
+        poner('0' + v % 10);
+    }
+};
+
+// '*' solo si el campo se puede escribir así sin cambiar su sentido: en
+// los de día, solo si llegó con '*' (ver la regla del O en Cron.h)
+static bool escribirCampo(Texto& out, uint64_t bits, const Campo& campo, bool asterisco) {
+    if (!bits) return false;
+    uint8_t maximo = campo.maximo == 7 ? 6 : campo.maximo;      // Día de la semana: 0..6
+    uint64_t todos = ((2ULL << maximo) - 1) & ~((1ULL << campo.minimo) - 1);
+    if (asterisco && bits == todos) {
+        out.poner('*');
+        return true;
+    }
+
+    // Progresión de 3 o más valores con paso > 1: "*/15", "5-50/15"
+    uint8_t n = __builtin_popcountll(bits);
+    uint8_t primero = __builtin_ctzll(bits);
+    uint8_t ultimo = 63 - __builtin_clzll(bits);
+    if (n >= 3) {
+        uint8_t paso = __builtin_ctzll(bits & (bits - 1)) - primero;
+        uint64_t progresion = 0;
+        for (unsigned v = primero; v <= ultimo; v += paso) progresion |= 1ULL << v;
+        if (paso > 1 && progresion == bits) {
+            if (asterisco && primero == campo.minimo && ultimo + paso > maximo) {
+                out.poner('*');
+            } else {
+                out.numero(primero);
+                out.poner('-');
+                out.numero(ultimo);
+            }
+            out.poner('/');
+            out.numero(paso);
+            return true;
+        }
+    }
+
+    // Si no, rachas: "1-5,8,10,11"
+    bool coma = false;
+    while (bits) {
+        uint8_t desde = __builtin_ctzll(bits);
+        uint64_t racha = bits >> desde;
+        uint8_t largo = (~racha == 0) ? 64 - desde : __builtin_ctzll(~racha);
+        uint8_t hasta = desde + largo - 1;
+        if (coma) out.poner(',');
+        out.numero(desde);
+        if (largo >= 3) {
+            out.poner('-');
+            out.numero(hasta);
+        } else if (largo == 2) {
+            out.poner(',');
+            out.numero(hasta);
+        }
+        coma = true;
+        bits &= ~(((2ULL << hasta) - 1) & ~((1ULL << desde) - 1));
+    }
+    return true;
+}
+
+namespace cron {
+
+    size_t formatear(const HorarioCron& cron, char* buf, size_t capacidad) {
+        if (capacidad == 0) return 0;
+        Texto out = { buf, capacidad, 0, false };
+        bool ok = escribirCampo(out, cron.minutos, MINUTO, true);
+        out.poner(' ');
+        ok = ok && escribirCampo(out, cron.horas, HORA, true);
+        out.poner(' ');
+        ok = ok && escribirCampo(out, cron.diasMes, DIA_MES, cron.comodines & CRON_DIA_MES_TODOS);
+        out.poner(' ');
+        ok = ok && escribirCampo(out, cron.meses, MES, true);
+        out.poner(' ');
+        ok = ok && escribirCampo(out, cron.diasSemana, DIA_SEMANA, cron.comodines & CRON_DIA_SEMANA_TODOS);
+
+        if (!ok || out.desborde) {
+            buf[0] = '\0';
+            return 0;
+        }
+        buf[out.pos] = '\0';
+        return out.pos;
+    }
+
+    bool valida(const HorarioCron& cron) {
+        if (!cron.minutos || (cron.minutos >> 60)) return false;
+        if (!cron.horas || (cron.horas >> 24)) return false;
+        if (!(cron.diasMes >> 1) || (cron.diasMes & 1)) return false;
+        if (!(cron.meses >> 1) || (cron.meses & 1) || (cron.meses >> 13)) return false;
+        if (!cron.diasSemana || (cron.diasSemana & ~DIAS_SEMANA_TODOS)) return false;
+        if (cron.comodines & ~(CRON_DIA_MES_TODOS | CRON_DIA_SEMANA_TODOS)) return false;
+        if (cron.duracion == 0 || cron.duracion > MAX_DURACION_CRON) return false;
+
+        char texto[TAM_TEXTO];
+        return formatear(cron, texto, sizeof(texto)) > 0;
+    }
+
+    // ======================================================
+    // DISPAROS
+    // ======================================================
+    bool coincide(const HorarioCron& cron, uint32_t segundos) {
+        RtcDateTime t(segundos);
+        if (!((cron.minutos >> t.Minute()) & 1) || !((cron.horas >> t.Hour()) & 1) ||
+            !((cron.meses >> t.Month()) & 1)) {
+            return false;
+        }
+        bool porMes = (cron.diasMes >> t.Day()) & 1;
+        bool porSemana = (cron.diasSemana >> t.DayOfWeek()) & 1;
+        if (cron.comodines & (CRON_DIA_MES_TODOS | CRON_DIA_SEMANA_TODOS)) return porMes && porSemana;
+        return porMes || porSemana;
+    }
+
+    // De fuera adentro: si un campo ya no tiene bits por delante se pasa
+    // al siguiente valor del campo de encima y se empieza desde abajo
+    uint32_t siguiente(const HorarioCron& cron, uint32_t desde) {
+        if (!cron.minutos || !cron.horas || !cron.meses) return SIN_DISPARO;
+        uint32_t minutoDesde = desde / 60 + (desde % 60 ? 1 : 0);
+        if (minutoDesde > SIN_DISPARO / 60) return SIN_DISPARO;
+
+        RtcDateTime t(minutoDesde * 60);
+        uint16_t anio = t.Year();
+        uint8_t mes = t.Month();
+        uint8_t dia = t.Day();
+        uint8_t hora = t.Hour();
+        uint8_t minuto = t.Minute();
+        uint16_t limite = anio + ANIOS_BUSQUEDA;
+        if (limite > ULTIMO_ANIO) limite = ULTIMO_ANIO;
+
+        while (anio <= limite) {
+            uint16_t meses = cron.meses >> mes;
+            if (!meses) {
+                anio++;
+                mes = 1; dia = 1; hora = 0; minuto = 0;
+                continue;
+            }
+            uint8_t m = mes + __builtin_ctz(meses);
+            if (m != mes) {
+                mes = m; dia = 1; hora = 0; minuto = 0;
+            }
+
+            uint32_t dias = dia <= 31 ? diasValidos(cron, anio, mes) >> dia : 0;
+            if (!dias) {
+                mes++;
+                dia = 1; hora = 0; minuto = 0;
+                continue;
+            }
+            uint8_t d = dia + __builtin_ctz(dias);
+            if (d != dia) {
+                dia = d; hora = 0; minuto = 0;
+            }
+
+            uint32_t horas = hora < 24 ? cron.horas >> hora : 0;
+            if (!horas) {
+                dia++;
+                hora = 0; minuto = 0;
+                continue;
+            }
+            uint8_t h = hora + __builtin_ctz(horas);
+            if (h != hora) {
+                hora = h; minuto = 0;
+            }
+
+            uint64_t minutos = cron.minutos >> minuto;
+            if (!minutos) {
+                hora++;
+                minuto = 0;
+                continue;
+            }
+            minuto += __builtin_ctzll(minutos);
+            return RtcDateTime(anio, mes, dia, hora, minuto, 0).TotalSeconds();
+        }
+        return SIN_DISPARO;
+    }
+}
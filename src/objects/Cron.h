@@ -0,0 +1,42 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "BombaConfig.h"
+
+// ==========================================
+// EXPRESIONES CRON COMPILADAS A BITS
+// ==========================================
+// "minuto hora díaMes mes díaSemana", cada campo con listas, rangos y
+// pasos: "*/15 6-8 * * 1-5", "0 7,19 1,15 * *", "30 6 * jun-sep mon,thu".
+// El texto se compila una vez a un bitset por campo (HorarioCron) y eso
+// es lo que se guarda: ver si un minuto dispara son unos pocos AND y el
+// próximo disparo se busca saltando de bit en bit (mes, día, hora,
+// minuto), no minuto a minuto.
+//
+// Como en cron, si díaMes y díaSemana están restringidos los dos (ninguno
+// empieza por '*') basta con que se cumpla uno de ellos.
+namespace cron {
+
+    static const uint32_t SIN_DISPARO = 0xFFFFFFFF;
+
+    // Texto más largo que se guarda y se publica (con el '\0')
+    static const size_t TAM_TEXTO = 96;
+
+    // Texto -> bits (no toca 'duracion'). false si algún campo no es válido.
+    bool compilar(const char* texto, HorarioCron& cron);
+
+    // Bits -> texto canónico (rangos unidos, pasos detectados). Devuelve la
+    // longitud o 0 si algún campo está vacío o no cabe en 'capacidad'.
+    size_t formatear(const HorarioCron& cron, char* buf, size_t capacidad);
+
+    // Campos no vacíos y en rango, duración 1..MAX_DURACION_CRON y texto
+    // canónico dentro de TAM_TEXTO
+    bool valida(const HorarioCron& cron);
+
+    // ¿Dispara en el minuto de 'segundos'? (s desde 2000-01-01)
+    bool coincide(const HorarioCron& cron, uint32_t segundos);
+
+    // Primer minuto en punto >= 'desde' que dispara, o SIN_DISPARO si no
+    // hay ninguno en los próximos años (p.ej. "0 0 30 2 *")
+    uint32_t siguiente(const HorarioCron& cron, uint32_t desde);
+}
@@ -0,0 +1,149 @@
+#include "DiarioRiego.h"
+#include <string.h>
+
+static const hal::ParticionFlash PARTICION = hal::FLASH_DIARIO;
+static const uint32_t LIBRE = 0xFFFFFFFF;
+static const uint8_t MARCAS_POR_VUELTA = 32;   // Acota lo que tarda actualizar()
+
+static_assert(sizeof(EntradaDiario) == 16, "EntradaDiario debe ocupar 16 bytes");
+
+// ======================================================
+// AUXILIARES
+// ======================================================
+uint32_t DiarioRiego::direccion(uint32_t secuencia) const {
+    return (secuencia % capacidad) * sizeof(EntradaDiario);
+}
+
+// CRC-8 (polinomio 0x07) de todo menos 'crc' y 'enviada'
+uint8_t DiarioRiego::crc(const EntradaDiario& e) {
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(&e);
+    uint8_t c = 0;
+    for (size_t i = 0; i < offsetof(EntradaDiario, crc); i++) {
+        c ^= p[i];
+        for (uint8_t b = 0; b < 8; b++) c = (c & 0x80) ? (c << 1) ^ 0x07 : c << 1;
+    }
+    return c;
+}
+
+// La casilla de 'secuencia' todavía la guarda a ella (no se pisó ni se rompió)
+bool DiarioRiego::leerEntrada(uint32_t secuencia, EntradaDiario& e) const {
+    if (!hal::flashLeer(PARTICION, direccion(secuencia), &e, sizeof(e))) return false;
+    return e.secuencia == secuencia && e.crc == crc(e);
+}
+
+// ======================================================
+// MONTAJE
+// ======================================================
+bool DiarioRiego::iniciar() {
+    size_t sectores = hal::flashSectores(PARTICION);
+    montado = sectores >= 2;    // Uno se borra mientras el otro guarda lo pendiente
+    if (!montado) return false;
+    capacidad = sectores * ENTRADAS_SECTOR;
+
+    // Las casillas se rellenan en orden: basta con la mayor secuencia válida
+    // y la mayor ya subida (las marcas también van en orden)
+    uint32_t ultima = 0;
+    uint32_t ultimaEnviada = 0;
+    for (uint32_t casilla = 0; casilla < capacidad; casilla++) {
+        EntradaDiario e;
+        hal::flashLeer(PARTICION, casilla * sizeof(e), &e, sizeof(e));
+        if (e.secuencia == LIBRE || e.secuencia % capacidad != casilla || e.crc != crc(e)) continue;
+        if (e.secuencia > ultima) ultima = e.secuencia;
+        if (e.enviada == 0 && e.secuencia > ultimaEnviada) ultimaEnviada = e.secuencia;
+    }
+
+    // Diario vacío (o partición con basura): se empieza en un sector limpio
+    if (ultima == 0 && !hal::flashBorrarSector(PARTICION, 0)) return montado = false;
+
+    siguiente.store(ultima + 1, std::memory_order_relaxed);
+    confirmada.store(ultimaEnviada, std::memory_order_relaxed);
+    marcada = ultimaEnviada;
+    lectura = ultimaEnviada + 1;
+    return true;
+}
+
+// ======================================================
+// CONTROL
+// ======================================================
+bool DiarioRiego::anotar(uint8_t zona, bool encendida, CausaCambio causa, uint32_t instante, uint32_t duracionS) {
+    if (!montado) return false;
+
+    EntradaDiario e;
+    e.instante = instante;
+    e.duracionS = duracionS;
+    e.zona = zona;
+    e.causa = causa | (encendida ? EntradaDiario::ENCENDIDA : 0);
+    e.enviada = 0xFF;
+
+    // Si la casilla no está limpia (una escritura cortada antes de un
+    // reinicio) se salta esa secuencia: la red la dará por perdida
+    uint32_t s = siguiente.load(std::memory_order_relaxed);
+    for (uint8_t intento = 0; intento < 2; intento++, s++) {
+        uint32_t casilla = s % capacidad;
+        if (casilla % ENTRADAS_SECTOR == 0) {
+            if (!hal::flashBorrarSector(PARTICION, casilla / ENTRADAS_SECTOR)) return false;
+        }
+
+        uint32_t actual;
+        hal::flashLeer(PARTICION, direccion(s), &actual, sizeof(actual));
+        if (actual != LIBRE) continue;
+
+        e.secuencia = s;
+        e.crc = crc(e);
+        bool ok = hal::flashEscribir(PARTICION, direccion(s), &e, sizeof(e));
+        siguiente.store(s + 1, std::memory_order_release);
+        return ok;
+    }
+    siguiente.store(s, std::memory_order_release);
+    return false;
+}
+
+// Marca en flash lo que la red ya publicó (poco a poco)
+void DiarioRiego::actualizar() {
+    if (!montado) return;
+    uint32_t hasta = confirmada.load(std::memory_order_acquire);
+    static const uint8_t SUBIDA = 0x00;
+
+    for (uint8_t n = 0; marcada < hasta && n < MARCAS_POR_VUELTA; n++) {
+        marcada++;
+        EntradaDiario e;
+        if (!leerEntrada(marcada, e)) continue;    // Ya pisada
+        hal::flashEscribir(PARTICION, direccion(marcada) + offsetof(EntradaDiario, enviada),
+                           &SUBIDA, sizeof(SUBIDA));
+    }
+}
+
+// ======================================================
+// RED
+// ======================================================
+uint8_t DiarioRiego::leer(EntradaDiario* destino, uint8_t max) {
+    if (!montado) return 0;
+    uint32_t fin = siguiente.load(std::memory_order_acquire);
+
+    // Lo que el productor ya pudo haber borrado se da por perdido
+    uint32_t margen = capacidad - ENTRADAS_SECTOR;
+    if (fin - lectura > margen) {
+        perdidas += fin - margen - lectura;
+        lectura = fin - margen;
+    }
+
+    uint8_t n = 0;
+    while (lectura < fin && n < max) {
+        if (leerEntrada(lectura, destino[n])) n++;
+        else perdidas++;
+        lectura++;
+    }
+    return n;
+}
+
+void DiarioRiego::confirmar(uint32_t secuencia) {
+    confirmada.store(secuencia, std::memory_order_release);
+}
+
+void DiarioRiego::rebobinar() {
+    lectura = confirmada.load(std::memory_order_relaxed) + 1;
+}
+
+uint32_t DiarioRiego::pendientes() const {
+    return siguiente.load(std::memory_order_acquire) - 1 - confirmada.load(std::memory_order_acquire);
+}
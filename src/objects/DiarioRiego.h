@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include "../hal/Hal.h"
+
+// Por qué cambió una zona
+enum CausaCambio : uint8_t {
+    CAUSA_HORARIO,
+    CAUSA_BOTON,        // Botón manual físico
+    CAUSA_MQTT,         // Comando de la nube
+    CAUSA_TIMEOUT,      // Seguridad: manual ON demasiado tiempo
+    CAUSA_SENSOR,       // Seguridad: presión o caudal fuera de rango
+    CAUSA_CORRIENTE     // Seguridad: sobrecorriente o rotor bloqueado
+};
+
+// Una transición de zona tal y como queda en flash (16 B)
+struct EntradaDiario {
+    uint32_t secuencia;     // Sube de 1 en 1; fija la casilla del anillo
+    uint32_t instante;      // s desde 2000-01-01 (RtcDateTime::TotalSeconds)
+    uint32_t duracionS;     // En los apagados: cuánto estuvo encendida
+    uint8_t zona;
+    uint8_t causa;          // CausaCambio | ENCENDIDA
+    uint8_t crc;            // CRC-8 de todo lo anterior
+    uint8_t enviada;        // 0xFF pendiente, 0x00 subida (fuera del CRC)
+
+    static const uint8_t ENCENDIDA = 0x80;
+
+    bool encendida() const { return causa & ENCENDIDA; }
+    CausaCambio motivo() const { return (CausaCambio)(causa & ~ENCENDIDA); }
+};
+
+// ==========================================
+// DIARIO DE RIEGO (anillo en flash, un productor y un consumidor)
+// ==========================================
+// Cada encendido/apagado se anota en la partición FLASH_DIARIO y ahí se
+// queda hasta que la red confirma que lo publicó: un corte de MQTT (o de
+// luz) no pierde historial. La entrada 's' vive en la casilla s % CAPACIDAD;
+// al entrar en un sector se borra entero, así que solo se pierde algo si
+// quedan sin subir más de CAPACIDAD - ENTRADAS_SECTOR entradas.
+//
+//   - Control (productor, único que escribe la flash): anotar() y
+//     actualizar(), que marca como enviadas las que la red confirmó.
+//   - Red (consumidor, solo lee la flash): leer() para sacar un lote,
+//     confirmar() tras publicarlo y rebobinar() si no se pudo.
+// Entre núcleos solo se comparten tres contadores atómicos, como ColaSpsc.
+class DiarioRiego {
+    public:
+        static const uint16_t ENTRADAS_SECTOR = hal::FLASH_SECTOR / sizeof(EntradaDiario);
+
+    private:
+        uint32_t capacidad = 0;             // Entradas en toda la partición
+        bool montado = false;
+
+        std::atomic<uint32_t> siguiente{1}; // Próxima secuencia a anotar (control)
+        std::atomic<uint32_t> confirmada{0};// Última publicada (red)
+        uint32_t marcada = 0;               // Última marcada en flash (control)
+        uint32_t lectura = 1;               // Próxima a leer (red)
+
+        uint32_t perdidas = 0;              // Pisadas sin subir (anillo lleno)
+
+        uint32_t direccion(uint32_t secuencia) const;
+        static uint8_t crc(const EntradaDiario& e);
+        bool leerEntrada(uint32_t secuencia, EntradaDiario& e) const;
+
+    public:
+        // Recorre la partición: última secuencia y primera sin subir
+        bool iniciar();
+
+        // --- Control ---
+        bool anotar(uint8_t zona, bool encendida, CausaCambio causa, uint32_t instante, uint32_t duracionS);
+        void actualizar();
+
+        // --- Red ---
+        uint8_t leer(EntradaDiario* destino, uint8_t max);
+        void confirmar(uint32_t secuencia);
+        void rebobinar();
+        uint32_t pendientes() const;
+
+        uint32_t totalPerdidas() const { return perdidas; }
+        bool disponible() const { return montado; }
+};
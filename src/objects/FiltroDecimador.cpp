@@ -0,0 +1,40 @@
+#include "FiltroDecimador.h"
+
+FiltroDecimador::FiltroDecimador(uint8_t log2Factor, uint8_t emaDesplaz)
+    : log2Factor(log2Factor > LOG2_MAX ? LOG2_MAX : log2Factor), emaDesplaz(emaDesplaz) {
+    reiniciar();
+}
+
+void FiltroDecimador::reiniciar() {
+    integrador1 = integrador2 = 0;
+    peine1 = peine2 = 0;
+    entradas = 0;
+    calentando = 2;             // Orden 2: dos salidas hasta que los peines valen
+    ultimo = 0;
+    emaQ4 = 0;
+}
+
+bool FiltroDecimador::meter(uint16_t muestra) {
+    integrador1 += muestra;
+    integrador2 += integrador1;
+    if (++entradas < factor()) return false;
+    entradas = 0;
+
+    // Peines a ritmo decimado; la ganancia del CIC es factor^2
+    uint32_t c1 = integrador2 - peine1;
+    peine1 = integrador2;
+    uint32_t c2 = c1 - peine2;
+    peine2 = c1;
+    if (calentando) {
+        calentando--;
+        if (calentando) return false;
+        ultimo = (uint16_t)(c2 >> (2 * log2Factor));
+        emaQ4 = (uint32_t)ultimo << 4;
+        return true;
+    }
+
+    ultimo = (uint16_t)(c2 >> (2 * log2Factor));
+    uint32_t x = (uint32_t)ultimo << 4;
+    emaQ4 = emaQ4 + ((int32_t)(x - emaQ4) >> emaDesplaz);
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+// ==========================================
+// FILTRO DECIMADOR EN PUNTO FIJO
+// ==========================================
+// CIC de orden 2 (dos integradores, dos peines) que deja una muestra de
+// cada 2^log2Factor, y detrás una EMA para lo que se publica. Solo sumas,
+// restas y desplazamientos: los integradores desbordan a propósito
+// (aritmética módulo 2^32) y los peines lo deshacen, así que el resultado
+// es exacto sin saturar nunca.
+//
+// La salida del CIC (decimado()) ya es un paso bajo: es la que se compara
+// con los umbrales, con solo ~1 periodo decimado de retraso. La EMA
+// (valor()) suaviza además lo que se muestra y se publica.
+class FiltroDecimador {
+    private:
+        uint8_t log2Factor;
+        uint8_t emaDesplaz;
+
+        // --- CIC ---
+        uint32_t integrador1, integrador2;
+        uint32_t peine1, peine2;        // Retardos de los peines (a ritmo decimado)
+        uint16_t entradas;              // Muestras desde la última salida
+        uint8_t calentando;             // Salidas que faltan para llenar los peines
+
+        // --- Salidas ---
+        uint16_t ultimo;                // Último decimado (0-1023)
+        uint32_t emaQ4;                 // EMA en punto fijo (x16)
+
+    public:
+        static const uint8_t LOG2_MAX = 10;     // 1024 -> 1: 10 + 2*10 bits, cabe en 32
+
+        FiltroDecimador(uint8_t log2Factor = 4, uint8_t emaDesplaz = 2);
+        void reiniciar();
+
+        // Mete una muestra (0-1023). true si con ella sale un decimado nuevo.
+        bool meter(uint16_t muestra);
+
+        bool listo() const { return calentando == 0; }
+        uint16_t decimado() const { return ultimo; }
+        uint16_t valor() const { return (uint16_t)((emaQ4 + 8) >> 4); }
+        uint16_t factor() const { return (uint16_t)1 << log2Factor; }
+};
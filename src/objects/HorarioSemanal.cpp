@@ -0,0 +1,105 @@
+#include "HorarioSemanal.h"
+#include <string.h>
+
+static const uint16_t MINUTOS_DIA = 24 * 60;
+
+void HorarioSemanal::limpiar() {
+    memset(bits, 0, sizeof(bits));
+}
+
+void HorarioSemanal::marcarRango(uint16_t desde, uint16_t hasta) {
+    while (desde < hasta) {
+        uint8_t bit = desde & 31;
+        uint16_t n = hasta - desde;
+        if (n > 32u - bit) n = 32 - bit;
+        uint32_t mascara = (n == 32) ? 0xFFFFFFFFUL : ((1UL << n) - 1) << bit;
+        bits[desde >> 5] |= mascara;
+        desde += n;
+    }
+}
+
+void HorarioSemanal::marcar(const Tramo& tramo) {
+    if (tramo.minutos >= MINUTOS_SEMANA) {
+        marcarRango(0, MINUTOS_SEMANA);
+        return;
+    }
+    uint32_t fin = (uint32_t)tramo.inicio + tramo.minutos;
+    if (fin <= MINUTOS_SEMANA) {
+        marcarRango(tramo.inicio, fin);
+    } else {
+        marcarRango(tramo.inicio, MINUTOS_SEMANA);     // Cruza el domingo 00:00
+        marcarRango(0, fin - MINUTOS_SEMANA);
+    }
+}
+
+bool HorarioSemanal::compilar(const BombaConfig& cfg) {
+    limpiar();
+    switch (cfg.modo) {
+        case POR_DIAS: {
+            uint16_t inicio = cfg.horaInicio * 60 + cfg.minutoInicio;
+            uint16_t fin = cfg.horaFin * 60 + cfg.minutoFin;
+            if (inicio == fin) return true;             // Ventana vacía: nunca enciende
+            // Fin antes que inicio: la ventana sigue pasada la medianoche
+            uint16_t minutos = fin > inicio ? fin - inicio : MINUTOS_DIA - inicio + fin;
+            for (uint8_t dia = 0; dia < 7; dia++) {
+                if (cfg.diasSemana & (1 << dia)) marcar(Tramo{ (uint16_t)(dia * MINUTOS_DIA + inicio), minutos });
+            }
+            return true;
+        }
+        case SEMANAL: {
+            uint8_t n = cfg.numTramos < MAX_TRAMOS ? cfg.numTramos : MAX_TRAMOS;
+            for (uint8_t i = 0; i < n; i++) {
+                if (cfg.tramos[i].inicio < MINUTOS_SEMANA) marcar(cfg.tramos[i]);
+            }
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+uint16_t HorarioSemanal::minutosHastaCambio(uint16_t minuto) const {
+    // Se buscan los bits distintos del actual: invertir si está encendido
+    uint32_t invertir = encendido(minuto) ? 0xFFFFFFFFUL : 0;
+    uint16_t primera = minuto >> 5;
+
+    // La primera palabra solo desde 'minuto'; al dar la vuelta, entera
+    uint32_t palabra = (bits[primera] ^ invertir) & (0xFFFFFFFFUL << (minuto & 31));
+    for (uint16_t k = 0; k <= PALABRAS; k++) {
+        if (palabra) {
+            uint16_t i = (primera + k) % PALABRAS;
+            uint16_t cambio = i * 32 + __builtin_ctz(palabra);
+            return (cambio + MINUTOS_SEMANA - minuto) % MINUTOS_SEMANA;
+        }
+        palabra = bits[(primera + k + 1) % PALABRAS] ^ invertir;
+    }
+    return 0;
+}
+
+uint8_t HorarioSemanal::comprimir(Tramo* tramos, uint8_t max) const {
+    // Se empieza en un minuto apagado para no partir la racha que cruza
+    // el domingo 00:00
+    uint16_t inicio = MINUTOS_SEMANA;
+    for (uint16_t i = 0; i < PALABRAS && inicio == MINUTOS_SEMANA; i++) {
+        if (~bits[i]) inicio = i * 32 + __builtin_ctz(~bits[i]);
+    }
+    if (inicio == MINUTOS_SEMANA) {             // Toda la semana encendida
+        if (max > 0) tramos[0] = Tramo{ 0, MINUTOS_SEMANA };
+        return 1;
+    }
+
+    uint8_t n = 0;
+    uint16_t minuto = inicio;
+    uint16_t recorrido = 0;
+    while (recorrido < MINUTOS_SEMANA) {
+        uint16_t racha = minutosHastaCambio(minuto);
+        if (racha == 0) break;                  // Toda la semana apagada
+        if (encendido(minuto)) {
+            if (n < max) tramos[n] = Tramo{ minuto, racha };
+            if (n < 0xFF) n++;
+        }
+        minuto = (minuto + racha) % MINUTOS_SEMANA;
+        recorrido += racha;
+    }
+    return n;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+#include "BombaConfig.h"
+
+// ==========================================
+// HORARIO SEMANAL EN MAPA DE BITS
+// ==========================================
+// Un bit por minuto de la semana (10080 bits = 1260 bytes, bit m = minuto
+// m desde el domingo 00:00). Saber si toca regar es leer un bit y el
+// próximo cambio se busca palabra a palabra, no minuto a minuto.
+//
+// Se compila desde los tramos de SEMANAL o desde la ventana diaria de
+// POR_DIAS, que así también puede cruzar la medianoche. comprimir() hace
+// el camino inverso: devuelve los tramos canónicos (ordenados, sin
+// solapes y con las rachas que cruzan el domingo unidas).
+class HorarioSemanal {
+    public:
+        static const uint16_t PALABRAS = MINUTOS_SEMANA / 32;   // 315, exacto
+
+    private:
+        uint32_t bits[PALABRAS];
+
+        void marcarRango(uint16_t desde, uint16_t hasta);      // [desde, hasta)
+
+    public:
+        HorarioSemanal() { limpiar(); }
+
+        void limpiar();
+        void marcar(const Tramo& tramo);
+
+        // Modos semanales (POR_DIAS, SEMANAL): true y el mapa compilado.
+        // Cualquier otro modo deja el mapa vacío y devuelve false.
+        bool compilar(const BombaConfig& cfg);
+
+        bool encendido(uint16_t minuto) const { return (bits[minuto >> 5] >> (minuto & 31)) & 1; }
+
+        // Minutos desde 'minuto' hasta el primero con otro estado (dando la
+        // vuelta a la semana). 0 si la semana entera está igual.
+        uint16_t minutosHastaCambio(uint16_t minuto) const;
+
+        // Tramos encendidos; devuelve cuántos hacen falta (si pasa de 'max'
+        // solo se escriben los 'max' primeros)
+        uint8_t comprimir(Tramo* tramos, uint8_t max) const;
+
+        // Minuto de la semana de un instante (segundos desde 2000-01-01,
+        // que fue sábado)
+        static uint16_t minutoDeSemana(uint32_t segundos) {
+            return (segundos / 60 + 6 * 24 * 60UL) % MINUTOS_SEMANA;
+        }
+};
@@ -0,0 +1,45 @@
+#include "MedidorRms.h"
+
+MedidorRms::MedidorRms(uint16_t muestrasPorCiclo)
+    : muestrasCiclo(muestrasPorCiclo == 0 ? 1 : (muestrasPorCiclo > MAX_MUESTRAS ? MAX_MUESTRAS : muestrasPorCiclo)) {
+    reiniciar();
+}
+
+void MedidorRms::reiniciar() {
+    muestras = 0;
+    suma = 0;
+    sumaCuadrados = 0;
+    ultimoQ4 = 0;
+    media = 0;
+}
+
+void MedidorRms::cerrarCiclo() {
+    uint64_t n = muestrasCiclo;
+    uint64_t s = suma;
+    uint64_t varianzaN2 = n * sumaCuadrados - s * s;    // N^2 * RMS^2 (>= 0 siempre)
+
+    // x256 para sacar 4 bits de fracción: N^2 * RMS^2 * 256 < 2^54
+    ultimoQ4 = (uint16_t)(raizEntera((varianzaN2 << 8) / (n * n)));
+    media = (uint16_t)((suma + muestrasCiclo / 2) / muestrasCiclo);
+
+    muestras = 0;
+    suma = 0;
+    sumaCuadrados = 0;
+}
+
+// Bit a bit, de dos en dos: 32 vueltas de sumas y desplazamientos
+uint32_t MedidorRms::raizEntera(uint64_t x) {
+    uint64_t resultado = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+    while (bit > x) bit >>= 2;
+    while (bit) {
+        if (x >= resultado + bit) {
+            x -= resultado + bit;
+            resultado = (resultado >> 1) + bit;
+        } else {
+            resultado >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)resultado;
+}
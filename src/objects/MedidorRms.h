@@ -0,0 +1,48 @@
+#pragma once
+#include <stdint.h>
+
+// ==========================================
+// RMS VERDADERO EN PUNTO FIJO
+// ==========================================
+// Acumula suma y suma de cuadrados de un ciclo de red (un número exacto de
+// muestras) y al cerrarlo saca el RMS de la parte alterna:
+//
+//   RMS^2 = (N * sum(x^2) - sum(x)^2) / N^2
+//
+// Restar la media del propio ciclo quita el punto medio del transformador
+// (Vcc/2 más la deriva que tenga) sin filtro aparte. Por muestra: una suma
+// y un producto de 32 bits; por ciclo, una cuenta de 64 y una raíz entera.
+// Vale para cualquier forma de onda (arranques, armónicos, recortes).
+class MedidorRms {
+    private:
+        uint16_t muestrasCiclo;
+        uint16_t muestras;          // Del ciclo en curso
+        uint32_t suma;
+        uint32_t sumaCuadrados;     // <= MAX_MUESTRAS * 1023^2: cabe en 32 bits
+        uint16_t ultimoQ4;          // RMS del último ciclo cerrado (cuentas x16)
+        uint16_t media;             // Media del último ciclo cerrado (cuentas)
+
+    public:
+        static const uint16_t MAX_MUESTRAS = 4096;
+
+        explicit MedidorRms(uint16_t muestrasPorCiclo);
+        void reiniciar();
+
+        // Mete una muestra (0-1023). true si con ella se cierra un ciclo.
+        bool meter(uint16_t muestra) {
+            suma += muestra;
+            sumaCuadrados += (uint32_t)muestra * muestra;
+            if (++muestras < muestrasCiclo) return false;
+            cerrarCiclo();
+            return true;
+        }
+
+        uint16_t rmsQ4() const { return ultimoQ4; }
+        uint16_t continua() const { return media; }
+        uint16_t muestrasPorCiclo() const { return muestrasCiclo; }
+
+        static uint32_t raizEntera(uint64_t x);     // floor(sqrt(x))
+
+    private:
+        void cerrarCiclo();
+};
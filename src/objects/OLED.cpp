@@ -1,22 +1,19 @@
 #include "OLED.h"
-#include <Arduino.h>
+#include "../hal/Hal.h"
 
 // Constructor
-OLED::OLED(Adafruit_SSD1306& displayRef, unsigned long timeout)
-    : display(displayRef), tiempoApagado(timeout), encendido(true) {
-    ultimaActividad = millis();
+OLED::OLED(PantallaHal& displayRef, unsigned long timeout)
+    : display(displayRef), tiempoApagado(timeout), encendido(true),
+      cuadrosAbiertos(0), pendiente(false) {
+    ultimaActividad = hal::millis();
 }
 
 // Inicialización del OLED
 void OLED::iniciar() {
-    display.clearDisplay();
-    display.setTextSize(1);      // Tamaño normal
-    display.setTextColor(SSD1306_WHITE);
-    display.setCursor(0,0);
-    
-    display.display();
+    display.limpiar();
+    display.volcar();
     encendido = true;
-    ultimaActividad = millis();
+    ultimaActividad = hal::millis();
 }
 
 // Mostrar un mensaje en el OLED
@@ -25,29 +22,40 @@ void OLED::mostrar(const char* msg, int col, int row) {
         encender(); 
     }
     
-    display.setTextColor(SSD1306_WHITE); 
-    display.setCursor(col, row * 10); 
-    display.print(msg);
-    display.display();
-    ultimaActividad = millis(); 
+    display.escribir(col, row * 10, msg);
+    if (cuadrosAbiertos == 0) display.volcar();
+    else pendiente = true;
+    ultimaActividad = hal::millis(); 
+}
+
+void OLED::iniciarCuadro() {
+    cuadrosAbiertos++;
+}
+
+void OLED::confirmarCuadro() {
+    if (cuadrosAbiertos == 0) return;
+    if (--cuadrosAbiertos > 0 || !pendiente) return;
+    pendiente = false;
+    display.volcar();
 }
 
 // Limpiar la pantalla
 void OLED::limpiar() {
-    display.clearDisplay();   
-    ultimaActividad = millis();
+    display.limpiar();   
+    if (cuadrosAbiertos > 0) pendiente = true;
+    ultimaActividad = hal::millis();
 }
 
 // Forzar encendido (Despertar hardware)
 void OLED::encender() {
-    display.ssd1306_command(SSD1306_DISPLAYON); 
+    display.encender(); 
     encendido = true;
-    ultimaActividad = millis();
+    ultimaActividad = hal::millis();
 }
 
 // Forzar apagado (Ahorro de energía real)
 void OLED::apagar() {
-    display.ssd1306_command(SSD1306_DISPLAYOFF); 
+    display.apagar(); 
     encendido = false;
 }
 
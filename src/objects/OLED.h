@@ -1,22 +1,30 @@
 #pragma once
-#include <Adafruit_SSD1306.h>
-#include <Adafruit_GFX.h>
+#include "../hal/PantallaHal.h"
 
 class OLED {
     private:
-        Adafruit_SSD1306& display;
+        PantallaHal& display;
         unsigned long ultimaActividad; // último momento de uso
         unsigned long tiempoApagado;   // timeout ms
         bool encendido;                // Estado actual del OLED
+        uint8_t cuadrosAbiertos;       // Anidamiento de iniciarCuadro()
+        bool pendiente;                // Se dibujó algo sin volcar
 
     public:
         // Constructor con timeout por defecto (10s)
-        OLED(Adafruit_SSD1306& displayRef, unsigned long timeout = 10000);
+        OLED(PantallaHal& displayRef, unsigned long timeout = 10000);
 
         void iniciar();
         void mostrar(const char* msg, int col = 0, int row = 0);
         void limpiar();
 
+        // Cuadros: entre iniciarCuadro() y confirmarCuadro() mostrar() solo
+        // dibuja en el framebuffer; confirmar hace UN volcado (y el panel
+        // solo recibe lo que cambió). Se pueden anidar: vuelca el externo.
+        // Un mostrar() suelto sigue volcando al momento.
+        void iniciarCuadro();
+        void confirmarCuadro();
+
         // Métodos para forzar encendido/apagado
         void encender();
         void apagar();
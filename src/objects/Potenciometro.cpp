@@ -1,25 +1,80 @@
 #include "Potenciometro.h"
-#include <Arduino.h>
+#include "../hal/Hal.h"
 
-Potenciometro::Potenciometro(int pinEntrada, int numMuestras)
-    : pin(pinEntrada), muestras(numMuestras) {
-        pinMode(pin, INPUT);
+Potenciometro::Potenciometro(int pinEntrada, uint16_t frecuenciaHz)
+    : pin(pinEntrada), muestrasPorSegundo(frecuenciaHz), enPausa(false),
+      posVentana(0), emaQ4(0), cebado(false),
+      escMin(0), escMax(0), escUltimo(0) {
+        hal::pinModo(pin, hal::ENTRADA);
     }
 
     void Potenciometro::iniciar() {
-        pinMode(pin, INPUT);
+        hal::pinModo(pin, hal::ENTRADA);
+        if (!hal::adcContinuoIniciar(pin, muestrasPorSegundo)) {
+            hal::log("Potenciometro: sin ADC continuo");
+        }
     }
 
-    int Potenciometro::leer() {
-        long suma = 0;
-        for (int i = 0; i < muestras; i++) {
-            suma += analogRead(pin);
-            delay(2); // pequeño delay para estabilidad
+    void Potenciometro::pausar(bool pausado) {
+        if (pausado == enPausa) return;
+        enPausa = pausado;
+        hal::adcContinuoPausar(pin, pausado);   // Al volver, el filtro sigue donde estaba
+    }
+
+    uint16_t Potenciometro::mediana3(uint16_t a, uint16_t b, uint16_t c) {
+        if (a > b) { uint16_t t = a; a = b; b = t; }
+        if (b > c) b = c;
+        return a > b ? a : b;
+    }
+
+    // Drena las muestras nuevas (a lo sumo un anillo) y las pasa por el filtro
+    void Potenciometro::actualizar() {
+        uint16_t lote[16];
+        size_t n;
+        while ((n = hal::adcContinuoLeer(pin, lote, 16)) > 0) {
+            for (size_t i = 0; i < n; i++) {
+                if (!cebado) {
+                    ventana[0] = ventana[1] = ventana[2] = lote[i];
+                    emaQ4 = (uint32_t)lote[i] << 4;
+                    cebado = true;
+                    continue;
+                }
+                ventana[posVentana] = lote[i];
+                posVentana = (posVentana + 1) % 3;
+                uint32_t x = (uint32_t)mediana3(ventana[0], ventana[1], ventana[2]) << 4;
+                emaQ4 = emaQ4 + ((int32_t)(x - emaQ4) >> EMA_DESPLAZ);
+            }
         }
-        return suma / muestras; // valor promedio (0–1023)
+    }
+
+    int Potenciometro::leer() {
+        actualizar();
+        return (int)((emaQ4 + 8) >> 4); // valor filtrado (0–1023)
     }
 
     int Potenciometro::leerEscalado(int minVal, int maxVal) {
-        int valorCrudo = leer(); // promedio crudo
-        return map(valorCrudo, 0, 1023, minVal, maxVal);
-}
\ No newline at end of file
+        int valorCrudo = leer();
+        auto escalar = [&](long crudo) {
+            if (crudo < 0) crudo = 0;
+            if (crudo > 1023) crudo = 1023;
+            return (int)(minVal + crudo * (maxVal - minVal) / 1023); // map()
+        };
+        int candidato = escalar(valorCrudo);
+
+        // Rango nuevo (otro selector): sin historia que respetar
+        if (minVal != escMin || maxVal != escMax) {
+            escMin = minVal;
+            escMax = maxVal;
+            escUltimo = candidato;
+            return escUltimo;
+        }
+
+        // Se mantiene el valor anterior mientras siga alcanzable moviendo el
+        // crudo +-HISTERESIS: así no parpadea en la frontera entre dos pasos.
+        int a = escalar(valorCrudo - HISTERESIS);
+        int b = escalar(valorCrudo + HISTERESIS);
+        int bajo = a < b ? a : b;
+        int alto = a < b ? b : a;
+        if (escUltimo < bajo || escUltimo > alto) escUltimo = candidato;
+        return escUltimo;
+}
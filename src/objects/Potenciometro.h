@@ -1,17 +1,40 @@
 // Potenciometro.h
 #pragma once
+#include <stdint.h>
 
+// El ADC convierte en segundo plano (hal::adcContinuo*) y aquí solo se
+// drena lo que haya llegado: mediana de 3 contra picos + EMA contra ruido.
+// leer() y leerEscalado() no esperan nunca; devuelven el último filtrado.
 class Potenciometro {
 private:
-    int pin;        // Pin analógico conectado al potenciómetro
-    int muestras;   // Número de muestras para promediar
+    int pin;                    // Pin analógico conectado al potenciómetro
+    uint16_t muestrasPorSegundo;
+    bool enPausa;
+
+    // --- Filtro ---
+    uint16_t ventana[3];        // Anillo para la mediana de 3
+    uint8_t posVentana;
+    uint32_t emaQ4;             // EMA en punto fijo (x16)
+    bool cebado;                // Ya llegó la primera muestra
+
+    // --- Histéresis de leerEscalado() ---
+    int escMin, escMax, escUltimo;
+
+    void actualizar();
+    static uint16_t mediana3(uint16_t a, uint16_t b, uint16_t c);
 
 public:
-    Potenciometro(int pinEntrada, int numMuestras = 10);
+    static const int HISTERESIS = 8;    // Cuentas (0-1023) de banda muerta
+    static const uint8_t EMA_DESPLAZ = 3; // alfa = 1/8
+
+    Potenciometro(int pinEntrada, uint16_t frecuenciaHz = 500);
     void iniciar();
-    // Lectura promedio cruda (0-1023)
+    // Sin nadie mirando (reposo) el ADC no lo muestrea; se reanuda solo con
+    // pausar(false). Lo llama la tarea que lo lee.
+    void pausar(bool pausado);
+    // Lectura filtrada cruda (0-1023)
     int leer();
 
-    // Lectura escalada a un rango [minVal, maxVal]
+    // Lectura escalada a un rango [minVal, maxVal], con histéresis
     int leerEscalado(int minVal, int maxVal);
-};
\ No newline at end of file
+};
@@ -1,23 +1,183 @@
 #include "Reloj.h"
-#include <Arduino.h>
+#include <stdio.h>
 
 // Constructor
-Reloj::Reloj(RtcDS3231<TwoWire>& rtc, OLED& oledRef) : oled(oledRef), Rtc(rtc){
+Reloj::Reloj(RtcHal& rtc, OLED& oledRef, int pinPulso) : oled(oledRef), Rtc(rtc), pinPulso(pinPulso) {
+}
+
+void Reloj::iniciar() {
+    medirFlanco();
+
+    if (pinPulso >= 0 && Rtc.activarPulsoSegundo()) {
+        hal::pinModo(pinPulso, hal::ENTRADA_PULLUP); // SQW es de drenador abierto
+        modoPulso = hal::interrupcionPin(pinPulso, &Reloj::alPulso, this);
+        millisUltimoPulso = hal::millis();
+    }
+}
+
+// ======================================================
+// HORA POR SOFTWARE
+// ======================================================
+uint64_t Reloj::extrapolar(unsigned long enMillis) const {
+    unsigned long transcurrido = enMillis - millisBase;
+    int64_t correccion = (int64_t)transcurrido * derivaPpm / 1000000;
+    return msBase + transcurrido + correccion;
+}
+
+void Reloj::fijar(uint64_t ms, unsigned long enMillis) {
+    msBase = ms;
+    millisBase = enMillis;
+}
+
+RtcDateTime Reloj::ahora() const {
+    return RtcDateTime((uint32_t)(extrapolar(hal::millis()) / 1000));
+}
+
+unsigned long Reloj::msHasta(uint32_t segundos) const {
+    int64_t falta = (int64_t)segundos * 1000 - (int64_t)extrapolar(hal::millis());
+    if (falta <= 0) return 0;
+    // La hora avanza (1 + deriva) ms por cada ms de millis()
+    int64_t local = falta * 1000000 / (1000000 + derivaPpm) + 1;
+    return local < 0x7FFFFFFF ? (unsigned long)local : 0x7FFFFFFFUL;
+}
+
+void Reloj::actualizar() {
+    unsigned long ms = hal::millis();
+
+    if (modoPulso) {
+        procesarPulsos();
+        if (ms - millisUltimoPulso > SIN_PULSO_MS) {
+            hal::log("Reloj: sin pulso SQW -> resincronizo por minuto");
+            modoPulso = false;
+        }
+    }
+
+    if (ms - ultimaSincronizacion >= (modoPulso ? RESYNC_PULSO_MS : RESYNC_MS)) sincronizar();
+}
+
+// ======================================================
+// RESINCRONIZACIÓN CON EL DS3231
+// ======================================================
+
+// Se conoce el instante exacto en que empezó 'segundos': fija la hora y,
+// si hay un ancla anterior lo bastante lejos, mide la deriva entre ambas.
+void Reloj::anclar(uint32_t segundos, unsigned long enMillis, bool medirDeriva) {
+    fijar((uint64_t)segundos * 1000, enMillis);
+
+    if (medirDeriva && anclaValida && enMillis - anclaMillis >= BASE_DERIVA_MS) {
+        int64_t real = (int64_t)(segundos - anclaSegundos) * 1000;
+        int64_t medido = enMillis - anclaMillis;
+        int32_t ppm = (int32_t)((real - medido) * 1000000 / medido);
+        if (ppm > -DERIVA_MAX_PPM && ppm < DERIVA_MAX_PPM) derivaPpm = (3 * derivaPpm + ppm) / 4;
+    }
+    if (!medirDeriva || !anclaValida || enMillis - anclaMillis >= BASE_DERIVA_MS) {
+        anclaSegundos = segundos;
+        anclaMillis = enMillis;
+        anclaValida = true;
+    }
+}
+
+// Lee el DS3231 hasta que cambia el segundo: da la fase exacta. Bloquea
+// hasta ~1 s, así que solo se usa al arrancar o tras un salto de hora.
+void Reloj::medirFlanco() {
+    RtcDateTime inicial = Rtc.leer();
+    lecturasRtc++;
+    ultimaSincronizacion = hal::millis();
+    valida = inicial.IsValid();
+    fijar((uint64_t)inicial.TotalSeconds() * 1000, ultimaSincronizacion);
+    if (!valida) return;
+
+    unsigned long desde = hal::millis();
+    while (hal::millis() - desde < 1100) {
+        hal::esperar(5);
+        RtcDateTime r = Rtc.leer();
+        lecturasRtc++;
+        if (r.TotalSeconds() != inicial.TotalSeconds()) {
+            ultimaSincronizacion = hal::millis();
+            anclaValida = false;             // Nueva base para la deriva
+            anclar(r.TotalSeconds(), ultimaSincronizacion, false);
+            return;
+        }
+    }
+}
+
+// Una sola lectura: el DS3231 dice el segundo entero S, así que la hora
+// real está en [S, S+1). Si la extrapolada se salió, se mete en la ventana.
+void Reloj::sincronizar() {
+    RtcDateTime r = Rtc.leer();
+    lecturasRtc++;
+    unsigned long ms = hal::millis();
+    ultimaSincronizacion = ms;
+
+    valida = r.IsValid();
+    if (!valida) return;
+
+    uint64_t bajo = (uint64_t)r.TotalSeconds() * 1000;
+    uint64_t alto = bajo + 999;
+    uint64_t estimada = extrapolar(ms);
+
+    if (estimada + 2000 < bajo || estimada > alto + 2000) {
+        // Alguien cambió la hora del DS3231 (o se perdieron pulsos): fase nueva
+        medirFlanco();
+        return;
+    }
+    if (estimada < bajo) estimada = bajo;
+    else if (estimada > alto) estimada = alto;
+    fijar(estimada, ms);
+
+    // Sin SQW la deriva sale del ancla de arranque: el punto medio de la
+    // ventana tiene +-500 ms de error, que a partir de 1 h ya es poco.
+    if (!modoPulso && anclaValida && ms - anclaMillis >= BASE_DERIVA_MS) {
+        int64_t real = (int64_t)(r.TotalSeconds() - anclaSegundos) * 1000 + 500;
+        int64_t medido = ms - anclaMillis;
+        int32_t ppm = (int32_t)((real - medido) * 1000000 / medido);
+        if (ppm > -DERIVA_MAX_PPM && ppm < DERIVA_MAX_PPM) derivaPpm = ppm;
+    }
+}
+
+// ======================================================
+// PULSO SQW DE 1 Hz
+// ======================================================
+void HAL_ISR Reloj::alPulso(void* ctx, hal::Nivel nivel, uint32_t us) {
+    if (nivel != hal::BAJO) return;          // El DS3231 cambia de segundo en el flanco de bajada
+    Reloj* self = static_cast<Reloj*>(ctx);
+    self->usPulso = us;
+    self->pulsos = self->pulsos + 1;
+}
+
+void Reloj::procesarPulsos() {
+    uint32_t n, us;
+    do {                                      // Par coherente aunque entre otra ISR
+        n = pulsos;
+        us = usPulso;
+    } while (n != pulsos);
+    if (n == pulsosVistos) return;
+    pulsosVistos = n;
+
+    unsigned long enMillis = hal::millis() - ((uint32_t)hal::micros() - us) / 1000UL;
+    millisUltimoPulso = enMillis;
+
+    // El pulso es un inicio de segundo: redondear la estimada al más cercano
+    uint32_t segundos = (uint32_t)((extrapolar(enMillis) + 500) / 1000);
+    anclar(segundos, enMillis, true);
 }
 
 void Reloj::mostrarHora() {
-    RtcDateTime now = Rtc.GetDateTime();
-    if (!now.IsValid()) {
+    if (!valida) {
+        oled.iniciarCuadro();
         oled.mostrar("RTC no valido", 0, 0);
         oled.mostrar(" ", 0, 1); // limpiar segunda línea
+        oled.confirmarCuadro();
         return;
     }
 
+    RtcDateTime now = ahora();
     static unsigned long lastUpdate = 0;
-    if (millis() - lastUpdate < 1000) return; // refrescar cada 1s
-    lastUpdate = millis();
+    if (hal::millis() - lastUpdate < 1000) return; // refrescar cada 1s
+    lastUpdate = hal::millis();
 
     char buffer[21];
+    oled.iniciarCuadro();
 
     // --- Fecha en la primera línea ---
     snprintf(buffer, sizeof(buffer), "%02d/%02d/%04d", now.Day(), now.Month(), now.Year());
@@ -26,6 +186,7 @@ void Reloj::mostrarHora() {
     // --- Hora en la segunda línea ---
     snprintf(buffer, sizeof(buffer), "%02d:%02d:%02d", now.Hour(), now.Minute(), now.Second());
     oled.mostrar(buffer, 0, 1);
+    oled.confirmarCuadro();
 }
 
 
@@ -33,16 +194,23 @@ void Reloj::setHora(int h, int m, int s) {
     if (h < 0 || h > 23 || m < 0 || m > 59) {
         return; // Hora inválida
     }
-    RtcDateTime now = Rtc.GetDateTime();
+    RtcDateTime now = ahora();
     RtcDateTime newTime(now.Year(), now.Month(), now.Day(), h, m, s);
-    Rtc.SetDateTime(newTime);
+    Rtc.escribir(newTime);
+    // Escribir los segundos reinicia el divisor del DS3231: fase exacta
+    valida = newTime.IsValid();
+    anclaValida = false;
+    anclar(newTime.TotalSeconds(), hal::millis(), false);
 }
 
 void Reloj::setFecha(int d, int m, int a) {
     if (a < 2000 || m < 1 || m > 12 || d < 1 || d > 31) {
         return; // Fecha inválida
     }
-    RtcDateTime now = Rtc.GetDateTime();
+    RtcDateTime now = ahora();
     RtcDateTime newDate(a, m, d, now.Hour(), now.Minute(), now.Second());
-    Rtc.SetDateTime(newDate);
+    Rtc.escribir(newDate);
+    valida = newDate.IsValid();
+    anclaValida = false;
+    anclar(newDate.TotalSeconds(), hal::millis(), false);
 }
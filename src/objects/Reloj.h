@@ -1,15 +1,73 @@
 #pragma once
 #include "../objects/OLED.h"
-#include <RtcDS3231.h>
+#include "../hal/Hal.h"
+#include "../hal/RtcHal.h"
 
+// Reloj por software disciplinado por el DS3231: la hora se extrapola de
+// millis() (corregido por la deriva medida) y el bus I2C solo se toca
+// para resincronizar. Con el pin SQW cableado cada pulso de 1 Hz marca el
+// flanco exacto del segundo; sin él se relee el DS3231 una vez por minuto.
 class Reloj {
     private:
         OLED& oled;
-        RtcDS3231<TwoWire>& Rtc;
-        
+        RtcHal& Rtc;
+        int pinPulso;                        // SQW del DS3231, -1 = sin cablear
+
+        static const unsigned long RESYNC_MS = 60000UL;         // Sin SQW
+        static const unsigned long RESYNC_PULSO_MS = 3600000UL; // Con SQW (comprobación)
+        static const unsigned long BASE_DERIVA_MS = 3600000UL;  // Mínimo para estimar
+        static const unsigned long SIN_PULSO_MS = 3000UL;       // SQW muerto -> minuto
+        static const int32_t DERIVA_MAX_PPM = 500;
+
+        // --- Hora extrapolada ---
+        // 'msBase' (ms desde 2000) era la hora cuando millis() valía 'millisBase'
+        uint64_t msBase = 0;
+        unsigned long millisBase = 0;
+        bool valida = false;
+        unsigned long ultimaSincronizacion = 0;
+
+        // --- Deriva de millis() frente al DS3231 ---
+        int32_t derivaPpm = 0;               // >0: millis() va lento
+        uint32_t anclaSegundos = 0;          // Último flanco de segundo conocido con exactitud
+        unsigned long anclaMillis = 0;
+        bool anclaValida = false;
+
+        // --- Pulso SQW (lo escribe la ISR) ---
+        volatile uint32_t pulsos = 0;
+        volatile uint32_t usPulso = 0;
+        uint32_t pulsosVistos = 0;
+        unsigned long millisUltimoPulso = 0;
+        bool modoPulso = false;
+        static void alPulso(void* ctx, hal::Nivel nivel, uint32_t us);
+
+        uint32_t lecturasRtc = 0;
+
+        uint64_t extrapolar(unsigned long enMillis) const;
+        void fijar(uint64_t ms, unsigned long enMillis);
+        void anclar(uint32_t segundos, unsigned long enMillis, bool medirDeriva);
+        void sincronizar();
+        void procesarPulsos();
+        void medirFlanco();
+
     public:
-        Reloj(RtcDS3231<TwoWire>& rtc, OLED& oled);
+        Reloj(RtcHal& rtc, OLED& oled, int pinPulso = -1);
+
+        void iniciar();                      // Busca el flanco de segundo y arma el SQW
+        void actualizar();                   // Llamar a menudo: resincroniza cuando toca
+
+        // Hora actual sin tocar el bus
+        RtcDateTime ahora() const;
+
+        // ms de millis() hasta que empiece el segundo dado (desde 2000),
+        // redondeado hacia arriba para no llegar antes del flanco. 0 si ya pasó.
+        unsigned long msHasta(uint32_t segundos) const;
+        bool esValida() const { return valida; }
+
+        int32_t deriva() const { return derivaPpm; }
+        uint32_t totalLecturasRtc() const { return lecturasRtc; }
+        bool usaPulso() const { return modoPulso; }
+
         void mostrarHora();
         void setHora(int h, int m, int s = 0);
         void setFecha(int d, int m, int a);
-};
\ No newline at end of file
+};
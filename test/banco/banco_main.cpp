@@ -0,0 +1,284 @@
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <string.h>
+#include "Config.h"
+#include "hal/native/HalNative.h"
+#include "hal/native/RtcSimulado.h"
+#include "hal/native/PantallaConsola.h"
+#include "objects/Bomba.h"
+#include "objects/BombaConfig.h"
+#include "objects/Boton.h"
+#include "objects/OLED.h"
+#include "objects/Reloj.h"
+#include "objects/AlmacenRegistros.h"
+#include "objects/DiarioRiego.h"
+#include "objects/FiltroDecimador.h"
+#include "objects/MedidorRms.h"
+#include "manager/ConfigManager.h"
+#include "manager/BombaManager.h"
+#include "manager/ParserComandos.h"
+#include "manager/Serializador.h"
+
+// ==========================================
+// BANCO DE PRUEBAS DE LOS CAMINOS CALIENTES
+// ==========================================
+// Google Benchmark sobre la HAL nativa ([env:banco]). Cubre la evaluación
+// del horario en cada modo, la carga de la config desde flash, el parser
+// de comandos, los payloads de estado/info, el pintado de la pantalla y
+// los núcleos de la tarea de sensores (por muestra).
+//
+//   pio run -e banco && .pio/build/banco/program
+//
+// La referencia va en test/banco/referencia.json y no está en el repo:
+// hay que sacarla con la ArduinoJson real (la de lib_deps) y una
+// libbenchmark de release, sin filtro, para que traiga todos los casos
+// (BM_Parsear/1..3 incluidos). En la máquina donde se vaya a comparar:
+//
+//   pio run -e banco
+//   .pio/build/banco/program --benchmark_repetitions=5 --benchmark_report_aggregates_only \
+//       --benchmark_out=test/banco/referencia.json --benchmark_out_format=json
+//
+// Antes de subirla, mirar su "context": library_build_type "release" y
+// num_cpus los del equipo real. Para comparar con ella después:
+//
+//   .pio/build/banco/program --benchmark_out=actual.json --benchmark_out_format=json
+//   compare.py benchmarks test/banco/referencia.json actual.json   (tools/ de Google Benchmark)
+//
+// Los tiempos son del host: sirven para ver regresiones, no para deducir
+// cuánto tarda en el ESP32.
+
+RtcSimulado rtcHal(RtcDateTime(2025, 1, 6, 7, 0, 0)); // Lunes 07:00
+PantallaConsola pantalla(false);
+
+Bomba bombas[NUM_ZONAS] = BOMBAS_ZONAS;
+BombaConfig configsZonas[NUM_ZONAS];
+Boton botonManual(PIN_BOTON_MANUAL, 400);
+AlmacenRegistros almacen;
+DiarioRiego diario;
+ConfigManager configManager(configsZonas, NUM_ZONAS, almacen);
+BombaManager bombaManager(bombas, NUM_ZONAS, configManager, rtcHal, botonManual, diario);
+OLED oled(pantalla, 7000);
+Reloj reloj(rtcHal, oled);
+ParserComandos parser(NUM_ZONAS);
+
+static const uint32_t SEGUNDOS_SEMANA = 7 * 86400UL;
+
+// Todas las zonas en el mismo modo, escalonadas 15 min como en el simulador
+// (SEMANAL y CRON: tres riegos de 10 min al día, de lunes a viernes)
+static void configurarModo(ModoBomba modo) {
+    for (uint8_t z = 0; z < NUM_ZONAS; z++) {
+        uint8_t inicio = z * 15;
+        if (modo == SEMANAL) {
+            Tramo tramos[15];
+            for (uint8_t i = 0; i < 15; i++) {
+                uint16_t dia = 1 + i / 3;
+                tramos[i] = Tramo{ (uint16_t)(dia * 1440 + (6 + 6 * (i % 3)) * 60 + inicio), 10 };
+            }
+            configManager.configurarSemanal(z, tramos, 15);
+            continue;
+        }
+        if (modo == CRON) {
+            char expresion[32];
+            snprintf(expresion, sizeof(expresion), "%u 6,12,18 * * 1-5", (unsigned)inicio);
+            configManager.configurarCron(z, expresion, 10);
+            continue;
+        }
+        BombaConfig cfg(true, false, modo, 0b0111110, 3, Fecha{6, 1, 2025},
+                        8 + inicio / 60, inicio % 60, 8 + (inicio + 10) / 60, (inicio + 10) % 60,
+                        Fecha{8, 1, 2025});
+        configManager.aplicarConfig(z, cfg);
+    }
+    configManager.guardarPendientes();
+}
+
+static const char* const NOMBRES_MODO[] = {"dias", "intervalo", "fecha", "apagado", "semanal", "cron"};
+
+// ======================================================
+// HORARIO: BombaManager::Evaluar por modo
+// ======================================================
+// Reposo: mismo segundo una y otra vez (lo normal entre flancos)
+static void BM_EvaluarReposo(benchmark::State& state) {
+    ModoBomba modo = (ModoBomba)state.range(0);
+    configurarModo(modo);
+    RtcDateTime ahora(2025, 1, 8, 8, 5, 0);
+    bombaManager.Evaluar(ahora);
+
+    for (auto _ : state) {
+        bombaManager.Evaluar(ahora);
+        benchmark::DoNotOptimize(bombaManager.zonasEncendidas());
+    }
+    state.SetLabel(NOMBRES_MODO[modo]);
+}
+BENCHMARK(BM_EvaluarReposo)->DenseRange(POR_DIAS, CRON);
+
+// Recompilar: el reloj va hacia atrás un minuto en cada vuelta, lo que
+// obliga a recalcular el horario de todas las zonas (peor caso)
+static void BM_EvaluarCompilar(benchmark::State& state) {
+    ModoBomba modo = (ModoBomba)state.range(0);
+    configurarModo(modo);
+    uint32_t base = RtcDateTime(2025, 1, 13, 0, 0, 0).TotalSeconds();
+    uint32_t paso = 0;
+
+    for (auto _ : state) {
+        bombaManager.Evaluar(RtcDateTime(base - (paso * 60) % SEGUNDOS_SEMANA));
+        paso++;
+        benchmark::DoNotOptimize(bombaManager.zonasEncendidas());
+    }
+    state.SetLabel(NOMBRES_MODO[modo]);
+    state.SetItemsProcessed(state.iterations() * NUM_ZONAS);
+}
+BENCHMARK(BM_EvaluarCompilar)->DenseRange(POR_DIAS, CRON);
+
+// ======================================================
+// CONFIG: montar el almacén, leer y validar todas las zonas
+// ======================================================
+static void BM_CargarConfig(benchmark::State& state) {
+    configurarModo(POR_DIAS);
+    for (auto _ : state) {
+        configManager.iniciar();
+        benchmark::DoNotOptimize(configManager.config(NUM_ZONAS - 1).horaInicio);
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_ZONAS);
+}
+BENCHMARK(BM_CargarConfig);
+
+// ======================================================
+// PARSER DE COMANDOS MQTT
+// ======================================================
+static const char* const MENSAJES[] = {
+    "ON",
+    "{\"zona\": 3, \"comando\": \"AUTO\"}",
+    "{\"zona\": 1, \"modo\": \"dias\", \"diasSemana\": 62, \"horaInicio\": 8, "
+        "\"minutoInicio\": 0, \"horaFin\": 20, \"minutoFin\": 0}",
+    "{\"zona\": 2, \"modo\": \"intervalo\", \"intervaloDias\": 3, \"anioInicio\": 2024, "
+        "\"mesInicio\": 1, \"diaInicio\": 20, \"horaInicio\": 8, \"minutoInicio\": 0, "
+        "\"horaFin\": 20, \"minutoFin\": 0, \"origen\": \"dashboard\", \"ts\": 1735689600}",
+};
+static const char* const NOMBRES_MENSAJE[] = {"texto", "manual", "dias", "intervalo+extra"};
+
+static void BM_Parsear(benchmark::State& state) {
+    const char* mensaje = MENSAJES[state.range(0)];
+    size_t len = strlen(mensaje);
+    ComandoControl cmd;
+
+    for (auto _ : state) {
+        ResultadoParseo r = parser.parsear(reinterpret_cast<const uint8_t*>(mensaje), len, cmd);
+        benchmark::DoNotOptimize(r);
+    }
+    state.SetLabel(NOMBRES_MENSAJE[state.range(0)]);
+    state.SetBytesProcessed(state.iterations() * len);
+}
+BENCHMARK(BM_Parsear)->DenseRange(0, 3);
+
+// ======================================================
+// SERIALIZACIÓN (JSON y MessagePack)
+// ======================================================
+static void BM_SerializarEstado(benchmark::State& state) {
+    Codificacion cod = (Codificacion)state.range(0);
+    char buf[serializar::TAM_ESTADO];
+    uint8_t zona = 0;
+
+    for (auto _ : state) {
+        size_t n = serializar::estado(buf, cod, zona, zona & 1, (EstadoOverride)(zona % 3));
+        zona = (zona + 1) % NUM_ZONAS;
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetLabel(serializar::nombreCodificacion(cod));
+}
+BENCHMARK(BM_SerializarEstado)->Arg(CODIFICACION_JSON)->Arg(CODIFICACION_MSGPACK);
+
+static void BM_SerializarInfo(benchmark::State& state) {
+    Codificacion cod = (Codificacion)state.range(0);
+    configurarModo(POR_INTERVALO);
+    char buf[serializar::TAM_INFO];
+    uint8_t zona = 0;
+
+    for (auto _ : state) {
+        size_t n = serializar::info(buf, cod, zona, configManager.config(zona));
+        zona = (zona + 1) % NUM_ZONAS;
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetLabel(serializar::nombreCodificacion(cod));
+}
+BENCHMARK(BM_SerializarInfo)->Arg(CODIFICACION_JSON)->Arg(CODIFICACION_MSGPACK);
+
+// ======================================================
+// PANTALLA: el cuadro de tareaPantalla, un segundo después cada vez
+// ======================================================
+static void BM_PintarPantalla(benchmark::State& state) {
+    char estadoTxt[17];
+    oled.encender();
+    uint32_t bytesAntes = pantalla.bytesEnviados();
+
+    for (auto _ : state) {
+        sim::avanzar(1000);
+        snprintf(estadoTxt, sizeof(estadoTxt), "Zonas ON: %d/%d",
+                 __builtin_popcount(bombaManager.zonasEncendidas()), NUM_ZONAS);
+        oled.iniciarCuadro();
+        oled.limpiar();
+        reloj.mostrarHora();
+        oled.mostrar(estadoTxt, 0, 2);
+        oled.confirmarCuadro();
+    }
+    state.counters["bytesI2C"] = benchmark::Counter(pantalla.bytesEnviados() - bytesAntes,
+                                                   benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_PintarPantalla);
+
+// ======================================================
+// SENSORES: coste por muestra del ADC (a SENSORES_HZ por canal)
+// ======================================================
+// Un ciclo de red con algo de ruido, en bucle
+static const uint16_t POR_CICLO = SENSORES_HZ / RED_HZ;
+static uint16_t ondaSensor[POR_CICLO];
+
+static void prepararOnda() {
+    uint32_t semilla = 1;
+    for (uint16_t k = 0; k < POR_CICLO; k++) {
+        semilla = semilla * 1103515245 + 12345;
+        int16_t triangulo = (int16_t)((k < POR_CICLO / 2 ? k : POR_CICLO - k) * 400 / POR_CICLO) - 100;
+        ondaSensor[k] = (uint16_t)(512 + triangulo + (int16_t)((semilla >> 16) & 15) - 8);
+    }
+}
+
+static void BM_FiltroDecimador(benchmark::State& state) {
+    FiltroDecimador filtro(4);
+    uint16_t k = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(filtro.meter(ondaSensor[k]));
+        if (++k == POR_CICLO) k = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_FiltroDecimador);
+
+static void BM_MedidorRms(benchmark::State& state) {
+    MedidorRms medidor(POR_CICLO);
+    uint16_t k = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(medidor.meter(ondaSensor[k]));
+        if (++k == POR_CICLO) k = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MedidorRms);
+
+// ======================================================
+int main(int argc, char** argv) {
+    sim::silenciarLog(true);
+    pantalla.iniciar();
+    botonManual.iniciar();
+    rtcHal.iniciar();
+    reloj.iniciar();
+    hal::eepromIniciar(EEPROM_SIZE);
+    configManager.iniciar();
+    diario.iniciar();
+    oled.iniciar();
+    prepararOnda();
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include "Config.h"
+#include "hal/native/HalNative.h"
+#include "hal/native/RtcSimulado.h"
+#include "objects/Bomba.h"
+#include "objects/Boton.h"
+#include "objects/AlmacenRegistros.h"
+#include "objects/DiarioRiego.h"
+#include "manager/ConfigManager.h"
+#include "manager/BombaManager.h"
+
+// ==========================================
+// ENTORNO COMÚN DE LOS TESTS DEL GESTOR
+// ==========================================
+// Los globales que en la placa pone Context.cpp, sobre la HAL nativa.
+// Define (no solo declara): cada test es su propio programa y lo incluye
+// una sola vez, desde su test_main.cpp.
+//
+//   #include "../comun/EntornoRiego.h"
+
+static const int PINES[NUM_ZONAS] = PINES_ZONAS;
+
+RtcSimulado rtcHal;
+Bomba bombas[NUM_ZONAS] = BOMBAS_ZONAS;
+BombaConfig configsZonas[NUM_ZONAS];
+Boton botonManual(PIN_BOTON_MANUAL, 400);
+AlmacenRegistros almacen;
+DiarioRiego diario;
+ConfigManager configManager(configsZonas, NUM_ZONAS, almacen);
+
+// Flash y EEPROM vacías, config por defecto, diario sin entradas y
+// relés abiertos (para el setUp() de cada test)
+inline void reiniciarEntorno() {
+    sim::borrarFlash();
+    hal::eepromIniciar(EEPROM_SIZE);
+    configManager.iniciar();
+    diario.iniciar();
+    botonManual.iniciar();
+    for (uint8_t z = 0; z < NUM_ZONAS; z++) bombas[z].iniciar();
+}
+
+// Un gestor nuevo por caso: sin overrides ni flancos del anterior
+inline BombaManager gestorRiego() {
+    return BombaManager(bombas, NUM_ZONAS, configManager, rtcHal, botonManual, diario);
+}
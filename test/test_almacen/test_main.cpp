@@ -0,0 +1,196 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include "hal/native/HalNative.h"
+#include "objects/AlmacenRegistros.h"
+#include "objects/BombaConfig.h"
+
+// ==========================================
+// ALMACÉN DE REGISTROS: CORTES DE LUZ Y DESGASTE
+// ==========================================
+// Sobre la flash simulada de la HAL nativa (NOR, 4 sectores): se corta la
+// luz en cada byte posible de una escritura y de una compactación y se
+// comprueba que al volver a montar siempre queda el valor anterior o el
+// nuevo, nunca basura ni una clave perdida.
+//
+//   pio test -e native -f test_almacen -v
+
+static const uint8_t VERSION = 1;
+// Lo que ocupa en flash cada BombaConfig (cabecera de 8 bytes, alineado a 4)
+static const size_t TAM_REGISTRO = (8 + sizeof(BombaConfig) + 3) & ~(size_t)3;
+
+void setUp() {
+    sim::borrarFlash();
+}
+void tearDown() {}
+
+// "Reinicio": un almacén nuevo que monta lo que haya en la flash
+static bool montar(AlmacenRegistros& almacen) {
+    sim::cortarFlashTras(-1);
+    return almacen.iniciar();
+}
+
+static BombaConfig configZona(uint8_t hora) {
+    BombaConfig cfg;
+    cfg.habilitada = true;
+    cfg.modo = POR_DIAS;
+    cfg.horaInicio = hora;
+    cfg.horaFin = hora + 1;
+    return cfg;
+}
+
+static uint8_t horaGuardada(const AlmacenRegistros& almacen, uint8_t clave) {
+    BombaConfig cfg;
+    if (almacen.leer(clave, &cfg, sizeof(cfg)) != sizeof(cfg)) return 0xFF;
+    return cfg.horaInicio;
+}
+
+// ======================================================
+// BÁSICO
+// ======================================================
+void test_vacio_y_persistencia() {
+    AlmacenRegistros almacen;
+    TEST_ASSERT_TRUE(montar(almacen));
+    TEST_ASSERT_TRUE(almacen.estabaVacio());
+    TEST_ASSERT_FALSE(almacen.existe(0));
+
+    BombaConfig cfg = configZona(7);
+    TEST_ASSERT_TRUE(almacen.escribir(0, VERSION, &cfg, sizeof(cfg)));
+    TEST_ASSERT_TRUE(almacen.escribir(3, VERSION, &cfg, sizeof(cfg)));
+
+    AlmacenRegistros reiniciado;
+    TEST_ASSERT_TRUE(montar(reiniciado));
+    TEST_ASSERT_FALSE(reiniciado.estabaVacio());
+    TEST_ASSERT_EQUAL(7, horaGuardada(reiniciado, 0));
+    TEST_ASSERT_EQUAL(7, horaGuardada(reiniciado, 3));
+    TEST_ASSERT_FALSE(reiniciado.existe(1));
+
+    uint8_t version = 0;
+    reiniciado.leer(0, &cfg, sizeof(cfg), &version);
+    TEST_ASSERT_EQUAL(VERSION, version);
+}
+
+void test_igual_no_escribe() {
+    AlmacenRegistros almacen;
+    montar(almacen);
+    BombaConfig cfg = configZona(9);
+    almacen.escribir(0, VERSION, &cfg, sizeof(cfg));
+    size_t libres = almacen.libres();
+
+    for (int i = 0; i < 100; i++) almacen.escribir(0, VERSION, &cfg, sizeof(cfg));
+    TEST_ASSERT_EQUAL(libres, almacen.libres());
+    TEST_ASSERT_EQUAL(100, almacen.totalOmitidas());
+    TEST_ASSERT_EQUAL(1, almacen.totalEscrituras());
+}
+
+// ======================================================
+// DESGASTE: muchas reconfiguraciones remotas
+// ======================================================
+void test_reparte_borrados() {
+    AlmacenRegistros almacen;
+    montar(almacen);
+
+    const uint32_t CAMBIOS = 20000;
+    for (uint32_t i = 0; i < CAMBIOS; i++) {
+        BombaConfig cfg = configZona(i % 20);
+        TEST_ASSERT_TRUE(almacen.escribir(i % 8, VERSION, &cfg, sizeof(cfg)));
+    }
+
+    unsigned long minimo = ~0UL;
+    unsigned long maximo = 0;
+    for (size_t s = 0; s < hal::flashSectores(hal::FLASH_CONFIG); s++) {
+        unsigned long b = sim::borradosSector(hal::FLASH_CONFIG, s);
+        if (b < minimo) minimo = b;
+        if (b > maximo) maximo = b;
+    }
+    char linea[120];
+    snprintf(linea, sizeof(linea), "%lu cambios: %lu compactaciones, borrados por sector %lu..%lu",
+             (unsigned long)CAMBIOS, (unsigned long)almacen.totalCompactaciones(), minimo, maximo);
+    TEST_MESSAGE(linea);
+    TEST_ASSERT_TRUE(maximo - minimo <= 1);
+
+    AlmacenRegistros reiniciado;
+    TEST_ASSERT_TRUE(montar(reiniciado));
+    for (uint8_t z = 0; z < 8; z++) {
+        // Último valor escrito en la zona z: i = CAMBIOS - 8 + z
+        TEST_ASSERT_EQUAL((CAMBIOS - 8 + z) % 20, horaGuardada(reiniciado, z));
+    }
+}
+
+// ======================================================
+// CORTES DE LUZ
+// ======================================================
+void test_corte_en_cada_byte_de_un_registro() {
+    BombaConfig vieja = configZona(5);
+    BombaConfig nueva = configZona(6);
+
+    for (long corte = 0; corte < 40; corte++) {
+        sim::borrarFlash();
+        AlmacenRegistros almacen;
+        montar(almacen);
+        almacen.escribir(0, VERSION, &vieja, sizeof(vieja));
+        almacen.escribir(1, VERSION, &vieja, sizeof(vieja));
+
+        sim::cortarFlashTras(corte);
+        almacen.escribir(0, VERSION, &nueva, sizeof(nueva));
+
+        AlmacenRegistros reiniciado;
+        TEST_ASSERT_TRUE(montar(reiniciado));
+        uint8_t hora = horaGuardada(reiniciado, 0);
+        TEST_ASSERT_TRUE(hora == 5 || hora == 6);
+        TEST_ASSERT_EQUAL(5, horaGuardada(reiniciado, 1));
+
+        // Y se puede seguir escribiendo
+        TEST_ASSERT_TRUE(reiniciado.escribir(0, VERSION, &nueva, sizeof(nueva)));
+        AlmacenRegistros otraVez;
+        montar(otraVez);
+        TEST_ASSERT_EQUAL(6, horaGuardada(otraVez, 0));
+        TEST_ASSERT_EQUAL(5, horaGuardada(otraVez, 1));
+    }
+}
+
+void test_corte_durante_compactacion() {
+    for (long corte = 0; corte < 400; corte += 7) {
+        sim::borrarFlash();
+        AlmacenRegistros almacen;
+        montar(almacen);
+
+        // Llenar el sector hasta que la siguiente escritura compacte
+        uint8_t hora = 0;
+        while (true) {
+            BombaConfig cfg = configZona(hora % 20);
+            uint32_t antes = almacen.totalCompactaciones();
+            size_t libres = almacen.libres();
+            if (libres < 2 * TAM_REGISTRO) break;
+            almacen.escribir(hora % 8, VERSION, &cfg, sizeof(cfg));
+            TEST_ASSERT_EQUAL(antes, almacen.totalCompactaciones());
+            hora++;
+        }
+        uint8_t esperadas[8];
+        for (uint8_t z = 0; z < 8; z++) esperadas[z] = horaGuardada(almacen, z);
+
+        sim::cortarFlashTras(corte);
+        for (uint8_t i = 0; i < 3; i++) {
+            BombaConfig cfg = configZona(19 - i);
+            almacen.escribir(i, VERSION, &cfg, sizeof(cfg));
+        }
+
+        AlmacenRegistros reiniciado;
+        TEST_ASSERT_TRUE(montar(reiniciado));
+        for (uint8_t z = 3; z < 8; z++) TEST_ASSERT_EQUAL(esperadas[z], horaGuardada(reiniciado, z));
+        for (uint8_t z = 0; z < 3; z++) {
+            uint8_t h = horaGuardada(reiniciado, z);
+            TEST_ASSERT_TRUE(h == esperadas[z] || h == 19 - z);
+        }
+    }
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_vacio_y_persistencia);
+    RUN_TEST(test_igual_no_escribe);
+    RUN_TEST(test_reparte_borrados);
+    RUN_TEST(test_corte_en_cada_byte_de_un_registro);
+    RUN_TEST(test_corte_durante_compactacion);
+    return UNITY_END();
+}
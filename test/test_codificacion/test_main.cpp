@@ -0,0 +1,280 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "manager/ParserComandos.h"
+#include "manager/Serializador.h"
+
+// ==========================================
+// JSON <-> MESSAGEPACK: IDA Y VUELTA + BYTES
+// ==========================================
+// Lo que sale en MessagePack tiene que decir exactamente lo mismo que el
+// JSON (mismas claves, mismos valores) y los comandos en MessagePack se
+// tienen que interpretar igual que su versión JSON. Además se mide cuánto
+// se ahorra en bytes y en tiempo de parseo.
+//
+//   pio test -e native -f test_codificacion -v
+
+static const char* const COMANDOS[] = {
+    "{\"zona\": 3, \"comando\": \"AUTO\"}",
+    "{\"zona\": 1, \"modo\": \"dias\", \"diasSemana\": 62, \"horaInicio\": 8, "
+        "\"minutoInicio\": 0, \"horaFin\": 20, \"minutoFin\": 0}",
+    "{\"zona\": 2, \"modo\": \"intervalo\", \"intervaloDias\": 3, \"anioInicio\": 2024, "
+        "\"mesInicio\": 1, \"diaInicio\": 20, \"horaInicio\": 8, \"minutoInicio\": 0, "
+        "\"horaFin\": 20, \"minutoFin\": 0}",
+    "{\"zona\": 3, \"modo\": \"fecha\", \"anio\": 2024, \"mes\": 12, \"dia\": 25, "
+        "\"horaInicio\": 9, \"minutoInicio\": 0, \"horaFin\": 18, \"minutoFin\": 0}",
+    "{\"zona\": 4, \"modo\": \"semanal\", \"tramos\": [[1800, 10], [2160, 10], [9000, 600]]}",
+    "{\"zona\": 5, \"modo\": \"cron\", \"cron\": \"*/20 6-8 * * 1-5\", \"duracion\": 15}",
+    "{\"codificacion\": \"msgpack\"}",
+};
+static const size_t NUM_COMANDOS = sizeof(COMANDOS) / sizeof(COMANDOS[0]);
+static const unsigned long VUELTAS = 20000;
+
+static ParserComandos parser(8);
+
+// Versión MessagePack de cada comando (preparada fuera de las medidas)
+static uint8_t comandosMsgPack[NUM_COMANDOS][256];
+static size_t largoMsgPack[NUM_COMANDOS];
+
+static BombaConfig configuracionesPrueba[5];
+
+void setUp() {}
+void tearDown() {}
+
+static ResultadoParseo parsear(const void* payload, size_t len, ComandoControl& cmd) {
+    return parser.parsear(static_cast<const uint8_t*>(payload), len, cmd);
+}
+
+static void prepararComandos() {
+    for (size_t i = 0; i < NUM_COMANDOS; i++) {
+        JsonDocument doc;
+        deserializeJson(doc, COMANDOS[i]);
+        largoMsgPack[i] = serializeMsgPack(doc, comandosMsgPack[i], sizeof(comandosMsgPack[i]));
+    }
+
+    BombaConfig dias;
+    dias.modo = POR_DIAS;
+    dias.diasSemana = 0b1111111;
+    dias.horaInicio = 6;
+    dias.horaFin = 7;
+    dias.minutoFin = 45;
+
+    BombaConfig intervalo;
+    intervalo.modo = POR_INTERVALO;
+    intervalo.intervaloDias = 200;
+    intervalo.fechaInicio = { 20, 1, 2024 };
+
+    BombaConfig fecha;
+    fecha.modo = POR_FECHA;
+    fecha.proximaFecha = { 31, 12, 2099 };
+    fecha.habilitada = false;
+
+    configuracionesPrueba[0] = dias;
+    configuracionesPrueba[1] = intervalo;
+    configuracionesPrueba[2] = fecha;
+
+    // Más de 15 tramos: la lista pasa a array16 en MessagePack
+    BombaConfig semanal;
+    semanal.modo = SEMANAL;
+    semanal.numTramos = MAX_TRAMOS;
+    for (uint8_t i = 0; i < MAX_TRAMOS; i++) semanal.tramos[i] = Tramo{ (uint16_t)(i * 360), 45 };
+    configuracionesPrueba[3] = semanal;
+
+    BombaConfig conCron;
+    conCron.modo = CRON;
+    conCron.cron.duracion = 20;
+    cron::compilar("0 6,18 1,15 * *", conCron.cron);
+    configuracionesPrueba[4] = conCron;
+}
+
+// El MessagePack, pasado a JSON por ArduinoJson, tiene que ser el mismo texto
+static void comprobarIgual(const char* json, size_t largoJson, const char* msgpack, size_t largoMp) {
+    TEST_ASSERT_TRUE(largoJson > 0);
+    TEST_ASSERT_TRUE(largoMp > 0);
+    TEST_ASSERT_TRUE(largoMp < largoJson);
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeMsgPack(doc, msgpack, largoMp));
+    char traducido[serializar::TAM_INFO];
+    serializeJson(doc, traducido, sizeof(traducido));
+    TEST_ASSERT_EQUAL_STRING(json, traducido);
+}
+
+// ======================================================
+// SALIDA: mismo esquema en las dos codificaciones
+// ======================================================
+void test_estado_ida_y_vuelta() {
+    char json[serializar::TAM_ESTADO];
+    char msgpack[serializar::TAM_ESTADO];
+    for (uint8_t z = 0; z < 8; z++) {
+        EstadoOverride ov = (EstadoOverride)(z % 3);
+        size_t nj = serializar::estado(json, CODIFICACION_JSON, z, z & 1, ov);
+        size_t nm = serializar::estado(msgpack, CODIFICACION_MSGPACK, z, z & 1, ov);
+        comprobarIgual(json, nj, msgpack, nm);
+    }
+}
+
+void test_config_e_info_ida_y_vuelta() {
+    char json[serializar::TAM_INFO];
+    char msgpack[serializar::TAM_INFO];
+    for (uint8_t i = 0; i < 5; i++) {
+        const BombaConfig& cfg = configuracionesPrueba[i];
+
+        size_t nj = serializar::configuracion(json, sizeof(json), CODIFICACION_JSON, i, cfg);
+        size_t nm = serializar::configuracion(msgpack, sizeof(msgpack), CODIFICACION_MSGPACK, i, cfg);
+        comprobarIgual(json, nj, msgpack, nm);
+
+        nj = serializar::info(json, CODIFICACION_JSON, i, cfg);
+        nm = serializar::info(msgpack, CODIFICACION_MSGPACK, i, cfg);
+        comprobarIgual(json, nj, msgpack, nm);
+    }
+}
+
+void test_msgpack_sin_sitio() {
+    char pequeno[16];
+    TEST_ASSERT_EQUAL(0, serializar::info(pequeno, sizeof(pequeno), CODIFICACION_MSGPACK,
+                                          0, configuracionesPrueba[1]));
+}
+
+// 15 campos caben en un fixmap; desde 16 la cabecera pasa a map16 (0xDE)
+template <class Escritor>
+static size_t escribirCampos(Escritor out, uint8_t n) {
+    static const char* const NOMBRES[] = {
+        "c00", "c01", "c02", "c03", "c04", "c05", "c06", "c07", "c08",
+        "c09", "c10", "c11", "c12", "c13", "c14", "c15", "c16" };
+    out.abrir();
+    for (uint8_t i = 0; i < n; i++) out.numero(NOMBRES[i], i * 100);
+    out.cerrar();
+    return out.terminar();
+}
+
+void test_msgpack_mapa_de_16_campos() {
+    char json[256];
+    uint8_t mp[256];
+    for (uint8_t n = 14; n <= 17; n++) {
+        size_t nj = escribirCampos(EscritorJson(json, sizeof(json)), n);
+        size_t nm = escribirCampos(EscritorMsgPack(reinterpret_cast<char*>(mp), sizeof(mp)), n);
+        if (n <= 15) {
+            TEST_ASSERT_EQUAL_HEX8(0x80 | n, mp[0]);
+        } else {
+            TEST_ASSERT_EQUAL_HEX8(0xDE, mp[0]);
+            TEST_ASSERT_EQUAL_HEX8(0x00, mp[1]);
+            TEST_ASSERT_EQUAL_HEX8(n, mp[2]);
+            TEST_ASSERT_EQUAL_HEX8(0xA3, mp[3]);    // Primera clave, ya corrida
+        }
+        comprobarIgual(json, nj, reinterpret_cast<const char*>(mp), nm);
+    }
+
+    // Justo lo del fixmap no basta: los 2 bytes de más del map16 desbordan
+    size_t justo = escribirCampos(EscritorMsgPack(reinterpret_cast<char*>(mp), sizeof(mp)), 16) - 2;
+    TEST_ASSERT_EQUAL(0, escribirCampos(EscritorMsgPack(reinterpret_cast<char*>(mp), justo), 16));
+    TEST_ASSERT_TRUE(escribirCampos(EscritorMsgPack(reinterpret_cast<char*>(mp), justo + 2), 16) > 0);
+}
+
+void test_capacidades() {
+    char payload[serializar::TAM_CAPACIDADES];
+    TEST_ASSERT_TRUE(serializar::capacidades(payload, CODIFICACION_MSGPACK) > 0);
+    TEST_ASSERT_EQUAL_STRING("{\"codificaciones\":[\"json\",\"msgpack\"],\"salida\":\"msgpack\"}", payload);
+}
+
+// ======================================================
+// ENTRADA: el mismo comando en las dos codificaciones
+// ======================================================
+void test_comandos_msgpack_iguales_a_json() {
+    for (size_t i = 0; i < NUM_COMANDOS; i++) {
+        ComandoControl dejson;
+        ComandoControl demp;
+        memset(&dejson, 0, sizeof(dejson));
+        memset(&demp, 0, sizeof(demp));
+
+        TEST_ASSERT_EQUAL(PARSEO_OK, parsear(COMANDOS[i], strlen(COMANDOS[i]), dejson));
+        TEST_ASSERT_EQUAL(CODIFICACION_JSON, parser.ultimaCodificacion());
+        TEST_ASSERT_EQUAL(PARSEO_OK, parsear(comandosMsgPack[i], largoMsgPack[i], demp));
+        TEST_ASSERT_EQUAL(CODIFICACION_MSGPACK, parser.ultimaCodificacion());
+
+        TEST_ASSERT_EQUAL(dejson.tipo, demp.tipo);
+        TEST_ASSERT_EQUAL(dejson.zona, demp.zona);
+        TEST_ASSERT_EQUAL(dejson.codificacion, demp.codificacion);
+        TEST_ASSERT_EQUAL_MEMORY(&dejson.config, &demp.config, sizeof(BombaConfig));
+    }
+}
+
+void test_comando_codificacion() {
+    ComandoControl cmd;
+    const char* json = "{\"codificacion\": \"json\"}";
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsear(json, strlen(json), cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::CODIFICACION, cmd.tipo);
+    TEST_ASSERT_EQUAL(CODIFICACION_JSON, cmd.codificacion);
+
+    const char* mala = "{\"codificacion\": \"cbor\"}";
+    TEST_ASSERT_EQUAL(PARSEO_COMANDO_INVALIDO, parsear(mala, strlen(mala), cmd));
+
+    const uint8_t truncado[] = { 0x82, 0xA4, 'z', 'o', 'n', 'a' };
+    TEST_ASSERT_EQUAL(PARSEO_JSON_INVALIDO, parsear(truncado, sizeof(truncado), cmd));
+}
+
+// ======================================================
+// BANCO: bytes en el cable y tiempo de parseo
+// ======================================================
+void test_bytes_y_tiempo() {
+    ComandoControl cmd;
+    size_t bytesJson = 0;
+    size_t bytesMp = 0;
+    for (size_t i = 0; i < NUM_COMANDOS; i++) {
+        bytesJson += strlen(COMANDOS[i]);
+        bytesMp += largoMsgPack[i];
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned long v = 0; v < VUELTAS; v++) {
+        for (size_t i = 0; i < NUM_COMANDOS; i++) parsear(COMANDOS[i], strlen(COMANDOS[i]), cmd);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (unsigned long v = 0; v < VUELTAS; v++) {
+        for (size_t i = 0; i < NUM_COMANDOS; i++) parsear(comandosMsgPack[i], largoMsgPack[i], cmd);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double mensajes = (double)VUELTAS * NUM_COMANDOS;
+    double nsJson = std::chrono::duration<double, std::nano>(t1 - t0).count() / mensajes;
+    double nsMp = std::chrono::duration<double, std::nano>(t2 - t1).count() / mensajes;
+
+    // Lo publicado: estado de 8 zonas + config e info de las pruebas
+    size_t salidaJson = 0;
+    size_t salidaMp = 0;
+    char buf[serializar::TAM_INFO];
+    for (uint8_t z = 0; z < 8; z++) {
+        salidaJson += serializar::estado(buf, CODIFICACION_JSON, z, true, AUTO);
+        salidaMp += serializar::estado(buf, CODIFICACION_MSGPACK, z, true, AUTO);
+    }
+    for (uint8_t i = 0; i < 5; i++) {
+        salidaJson += serializar::info(buf, CODIFICACION_JSON, i, configuracionesPrueba[i]);
+        salidaMp += serializar::info(buf, CODIFICACION_MSGPACK, i, configuracionesPrueba[i]);
+    }
+
+    char linea[160];
+    snprintf(linea, sizeof(linea), "comandos: JSON %u B, %.0f ns/msg | MessagePack %u B, %.0f ns/msg",
+             (unsigned)bytesJson, nsJson, (unsigned)bytesMp, nsMp);
+    TEST_MESSAGE(linea);
+    snprintf(linea, sizeof(linea), "publicado: JSON %u B | MessagePack %u B",
+             (unsigned)salidaJson, (unsigned)salidaMp);
+    TEST_MESSAGE(linea);
+
+    TEST_ASSERT_TRUE(bytesMp < bytesJson);
+    TEST_ASSERT_TRUE(salidaMp < salidaJson);
+}
+
+int main(int, char**) {
+    prepararComandos();
+    UNITY_BEGIN();
+    RUN_TEST(test_estado_ida_y_vuelta);
+    RUN_TEST(test_config_e_info_ida_y_vuelta);
+    RUN_TEST(test_msgpack_sin_sitio);
+    RUN_TEST(test_msgpack_mapa_de_16_campos);
+    RUN_TEST(test_capacidades);
+    RUN_TEST(test_comandos_msgpack_iguales_a_json);
+    RUN_TEST(test_comando_codificacion);
+    RUN_TEST(test_bytes_y_tiempo);
+    return UNITY_END();
+}
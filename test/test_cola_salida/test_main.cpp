@@ -0,0 +1,99 @@
+#include <unity.h>
+#include "manager/ColaSalida.h"
+
+// ==========================================
+// COLA DE SALIDA MQTT: FUSIÓN, PRIORIDAD Y RITMO
+// ==========================================
+// Simula un corte largo con cambios de zona en ráfaga: al volver sale un
+// mensaje por topic y zona con lo último, nunca más que el cubo de fichas.
+//
+//   pio test -e native -f test_cola_salida -v
+
+void setUp() {}
+void tearDown() {}
+
+// Lo que haría la red: todo lo que dejen las fichas en el instante 'ahora'
+static uint8_t vaciar(ColaSalida& cola, unsigned long ahora, bool aceptar = true) {
+    uint8_t n = 0;
+    TopicoSalida topico;
+    uint8_t zona;
+    while (cola.siguiente(topico, zona) && cola.tomarFicha(ahora)) {
+        if (!aceptar) {
+            cola.fallido();
+            break;
+        }
+        cola.enviado(topico, zona);
+        n++;
+    }
+    return n;
+}
+
+void test_fusiona_por_topic_y_zona() {
+    ColaSalida cola(10, 100);
+    // Sin conexión: la zona 2 cambia 50 veces, la 5 una
+    for (uint8_t i = 0; i < 50; i++) cola.marcar(SALIDA_ESTADO, 2);
+    cola.marcar(SALIDA_ESTADO, 5);
+    cola.marcar(SALIDA_INFO, 2);
+
+    TEST_ASSERT_EQUAL(3, cola.totalPendientes());
+    TEST_ASSERT_EQUAL(49, cola.totalFusionados());
+    TEST_ASSERT_EQUAL(3, vaciar(cola, 1000));
+    TEST_ASSERT_EQUAL(0, cola.totalPendientes());
+    TEST_ASSERT_EQUAL(3, cola.totalEnviados());
+}
+
+void test_prioridad() {
+    ColaSalida cola(10, 100);
+    cola.marcar(SALIDA_INFO, 0);
+    cola.marcar(SALIDA_ESTADO, 7);
+    cola.marcar(SALIDA_ESTADO, 1);
+    cola.marcar(SALIDA_CAPACIDADES);
+
+    TopicoSalida topico;
+    uint8_t zona;
+    TopicoSalida orden[] = { SALIDA_CAPACIDADES, SALIDA_ESTADO, SALIDA_ESTADO, SALIDA_INFO };
+    uint8_t zonas[] = { 0, 1, 7, 0 };
+    for (uint8_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(cola.siguiente(topico, zona));
+        TEST_ASSERT_EQUAL(orden[i], topico);
+        TEST_ASSERT_EQUAL(zonas[i], zona);
+        cola.enviado(topico, zona);
+    }
+    TEST_ASSERT_FALSE(cola.siguiente(topico, zona));
+}
+
+void test_fallo_se_reintenta() {
+    ColaSalida cola(10, 8);
+    cola.marcar(SALIDA_ESTADO, 3);
+    TEST_ASSERT_EQUAL(0, vaciar(cola, 1000, false));
+    TEST_ASSERT_EQUAL(1, cola.totalFallidos());
+    TEST_ASSERT_EQUAL(1, cola.totalPendientes());
+
+    TEST_ASSERT_EQUAL(1, vaciar(cola, 2000));
+    TEST_ASSERT_EQUAL(0, cola.totalPendientes());
+}
+
+void test_ritmo_acotado() {
+    ColaSalida cola(10, 8);     // 10 msg/s, ráfaga de 8
+    cola.marcarZonas(SALIDA_ESTADO, 16);
+    cola.marcarZonas(SALIDA_INFO, 16);
+
+    // Al reconectar sale la ráfaga y luego una ficha cada 100 ms
+    TEST_ASSERT_EQUAL(8, vaciar(cola, 5000));
+    TEST_ASSERT_EQUAL(0, vaciar(cola, 5050));
+    TEST_ASSERT_EQUAL(1, vaciar(cola, 5100));
+    TEST_ASSERT_EQUAL(5, vaciar(cola, 5600));
+
+    // Un segundo parado no da más que la ráfaga
+    TEST_ASSERT_EQUAL(8, vaciar(cola, 7000));
+    TEST_ASSERT_EQUAL(32 - 22, cola.totalPendientes());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_fusiona_por_topic_y_zona);
+    RUN_TEST(test_prioridad);
+    RUN_TEST(test_fallo_se_reintenta);
+    RUN_TEST(test_ritmo_acotado);
+    return UNITY_END();
+}
@@ -0,0 +1,168 @@
+#include <unity.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include "manager/Comandos.h"
+
+// ==========================================
+// COLAS ENTRE NÚCLEOS: CONFIG POR HUECO Y REVISIÓN
+// ==========================================
+// Las entradas no llevan la BombaConfig: va por el hueco de la zona.
+// Dos CONFIGURAR seguidos para una zona se quedan en el último, y el
+// hueco (seqlock) no entrega nunca una config a medio escribir.
+//
+//   pio test -e native -f test_comandos -v
+
+void setUp() {}
+void tearDown() {}
+
+static ComandoControl configurar(uint8_t zona, uint8_t hora) {
+    ComandoControl cmd = {};
+    cmd.tipo = ComandoControl::CONFIGURAR;
+    cmd.zona = zona;
+    cmd.config.modo = POR_DIAS;
+    cmd.config.horaInicio = hora;
+    return cmd;
+}
+
+void test_configurar_lleva_su_config() {
+    ColaComandos cola;
+    ComandoControl on = {};
+    on.tipo = ComandoControl::MANUAL_ON;
+    on.zona = 3;
+    TEST_ASSERT_TRUE(cola.meter(configurar(1, 6)));
+    TEST_ASSERT_TRUE(cola.meter(on));
+
+    ComandoControl cmd;
+    TEST_ASSERT_TRUE(cola.sacar(cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::CONFIGURAR, cmd.tipo);
+    TEST_ASSERT_EQUAL(1, cmd.zona);
+    TEST_ASSERT_EQUAL(6, cmd.config.horaInicio);
+    TEST_ASSERT_TRUE(cola.sacar(cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::MANUAL_ON, cmd.tipo);
+    TEST_ASSERT_EQUAL(3, cmd.zona);
+    TEST_ASSERT_FALSE(cola.sacar(cmd));
+}
+
+void test_configurar_repetido_se_queda_en_el_ultimo() {
+    ColaComandos cola;
+    cola.meter(configurar(2, 5));
+    cola.meter(configurar(4, 7));
+    cola.meter(configurar(2, 9));
+
+    // El primero de la zona 2 ya no vale: sale la 4 y luego la 2 con la hora 9
+    ComandoControl cmd;
+    TEST_ASSERT_TRUE(cola.sacar(cmd));
+    TEST_ASSERT_EQUAL(4, cmd.zona);
+    TEST_ASSERT_EQUAL(7, cmd.config.horaInicio);
+    TEST_ASSERT_TRUE(cola.sacar(cmd));
+    TEST_ASSERT_EQUAL(2, cmd.zona);
+    TEST_ASSERT_EQUAL(9, cmd.config.horaInicio);
+    TEST_ASSERT_FALSE(cola.sacar(cmd));
+
+    // Zona fuera de las cableadas: no hay hueco
+    TEST_ASSERT_FALSE(cola.meter(configurar(NUM_ZONAS, 8)));
+}
+
+void test_configurar_rechazado_no_pisa_al_de_la_cola() {
+    ColaComandos cola;
+    ComandoControl on = {};
+    on.tipo = ComandoControl::MANUAL_ON;
+    TEST_ASSERT_TRUE(cola.meter(configurar(2, 5)));
+    while (cola.meter(on)) {}
+
+    // Cola llena: el segundo se rechaza y el primero sigue valiendo
+    TEST_ASSERT_FALSE(cola.meter(configurar(2, 9)));
+    ComandoControl cmd;
+    TEST_ASSERT_TRUE(cola.sacar(cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::CONFIGURAR, cmd.tipo);
+    TEST_ASSERT_EQUAL(2, cmd.zona);
+    TEST_ASSERT_EQUAL(5, cmd.config.horaInicio);
+}
+
+void test_evento_rechazado_no_pisa_la_config_anunciada() {
+    ColaEventos cola;
+    BombaConfig cfg;
+    cfg.horaInicio = 4;
+    TEST_ASSERT_TRUE(cola.meterConfig(1, cfg));
+    EventoControl estado = {};
+    estado.tipo = EventoControl::ESTADO_ZONA;
+    while (cola.meter(estado)) {}
+
+    cfg.horaInicio = 11;
+    TEST_ASSERT_FALSE(cola.meterConfig(1, cfg));
+    EventoControl ev;
+    TEST_ASSERT_TRUE(cola.sacar(ev));
+    BombaConfig leida;
+    uint16_t revision;
+    TEST_ASSERT_TRUE(cola.config(1, leida, &revision));
+    TEST_ASSERT_EQUAL(ev.revision, revision);
+    TEST_ASSERT_EQUAL(4, leida.horaInicio);
+}
+
+void test_evento_anuncia_la_config_del_hueco() {
+    ColaEventos cola;
+    BombaConfig cfg;
+    cfg.horaInicio = 4;
+    uint16_t inicial = cola.dejarConfig(0, cfg);
+
+    cfg.horaInicio = 11;
+    TEST_ASSERT_TRUE(cola.meterConfig(0, cfg));
+
+    EventoControl ev;
+    TEST_ASSERT_TRUE(cola.sacar(ev));
+    TEST_ASSERT_EQUAL(EventoControl::CONFIG_APLICADA, ev.tipo);
+    TEST_ASSERT_EQUAL(0, ev.zona);
+    TEST_ASSERT_EQUAL(inicial + 1, ev.revision);
+
+    BombaConfig leida;
+    uint16_t revision;
+    TEST_ASSERT_TRUE(cola.config(0, leida, &revision));
+    TEST_ASSERT_EQUAL(ev.revision, revision);
+    TEST_ASSERT_EQUAL(11, leida.horaInicio);
+    TEST_ASSERT_FALSE(cola.sacar(ev));
+}
+
+// Escritor y lector en hilos distintos: cada lectura buena es una config
+// entera (todos los bytes iguales), nunca mezcla de dos escrituras
+void test_hueco_sin_cerrojo_nunca_da_una_config_rota() {
+    static HuecoConfig hueco;
+    std::atomic<bool> fin{false};
+    std::thread escritor([&] {
+        BombaConfig cfg;
+        for (uint32_t i = 1; !fin.load(); i++) {
+            memset((void*)&cfg, (uint8_t)i, sizeof(cfg));
+            hueco.dejar(cfg);
+        }
+    });
+
+    uint32_t buenas = 0, rotas = 0;
+    for (uint32_t intento = 0; intento < 50000000 && buenas < 100000; intento++) {
+        BombaConfig leida;
+        uint16_t revision;
+        if (!hueco.leer(leida, revision) || revision == 0) continue;     // 0: la de por defecto
+        const uint8_t* bytes = (const uint8_t*)&leida;
+        for (size_t b = 1; b < sizeof(leida); b++) {
+            if (bytes[b] != bytes[0]) {
+                rotas++;
+                break;
+            }
+        }
+        buenas++;
+    }
+    fin.store(true);
+    escritor.join();
+    TEST_ASSERT_EQUAL(0, rotas);
+    TEST_ASSERT_TRUE(buenas > 0);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_configurar_lleva_su_config);
+    RUN_TEST(test_configurar_repetido_se_queda_en_el_ultimo);
+    RUN_TEST(test_configurar_rechazado_no_pisa_al_de_la_cola);
+    RUN_TEST(test_evento_rechazado_no_pisa_la_config_anunciada);
+    RUN_TEST(test_evento_anuncia_la_config_del_hueco);
+    RUN_TEST(test_hueco_sin_cerrojo_nunca_da_una_config_rota);
+    return UNITY_END();
+}
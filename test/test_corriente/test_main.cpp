@@ -0,0 +1,319 @@
+#include <unity.h>
+#include <math.h>
+#include "objects/MedidorRms.h"
+#include "../comun/EntornoRiego.h"
+#include "manager/MonitorCorriente.h"
+#include "manager/Serializador.h"
+
+// ==========================================
+// CORRIENTE DE LA BOMBA: RMS Y CORTES
+// ==========================================
+// El RMS en punto fijo contra formas de onda de RMS conocido, y el monitor
+// entero reproduciendo grabaciones por el ADC continuo simulado
+// (sim::reproducirAnalogico): marcha normal, pico de arranque, rotor
+// bloqueado, sobrecorriente, un hueco de muestras perdidas y el canal en
+// pausa con la bomba apagada. Las grabaciones están en cuentas del ADC a
+// SENSORES_HZ, como las que se sacan de la placa. Zona 1 riega todos los
+// días de 12:00 a 12:30.
+//
+//   pio test -e native -f test_corriente -v
+
+static const RtcDateTime REGANDO(2025, 1, 6, 12, 1, 0);
+static const uint16_t POR_CICLO = SENSORES_HZ / RED_HZ;     // 100 muestras
+static const unsigned long MS_CICLO = 1000 / RED_HZ;
+static const LimitesCorriente LIMITES = {
+    CORRIENTE_MA_CUENTA, CORRIENTE_MIN_MA, CORRIENTE_MAX_MA, CORRIENTE_BLOQUEO_MA, ARRANQUE_BOMBA_MS
+};
+static const uint16_t NOMINAL_MA = 8000;
+
+static uint16_t grabacion[12 * SENSORES_HZ / 6];     // Hasta 2 s
+
+// Un ciclo de 'mA' RMS (senoidal) desde la muestra 'desde'. 'tercero':
+// tercer armónico en % de la fundamental.
+static void ciclo(uint16_t* destino, uint16_t mA, uint8_t tercero = 0, uint16_t medio = 512) {
+    double pico = mA * sqrt(2.0) / CORRIENTE_MA_CUENTA;
+    for (uint16_t k = 0; k < POR_CICLO; k++) {
+        double fase = 2 * M_PI * k / POR_CICLO;
+        double x = medio + pico * sin(fase) + pico * tercero / 100.0 * sin(3 * fase);
+        destino[k] = (uint16_t)lround(x < 0 ? 0 : (x > 1023 ? 1023 : x));
+    }
+}
+
+static void grabarConstante(uint16_t mA, uint16_t ciclos) {
+    for (uint16_t c = 0; c < ciclos; c++) ciclo(&grabacion[c * POR_CICLO], mA);
+    sim::reproducirAnalogico(PIN_CORRIENTE, grabacion, ciclos * POR_CICLO);
+}
+
+void setUp() {
+    reiniciarEntorno();
+    configManager.configurarPorDias(0, 0x7F, 12, 0, 12, 30);
+}
+void tearDown() {
+    sim::reproducirAnalogico(PIN_CORRIENTE, nullptr, 0);
+}
+
+// La tarea de sensores cada SENSORES_MS durante 'ms'; devuelve los ms
+// que tardó en abrirse el relé de la zona 1 (o 'ms' + 1 si no se abrió
+// o ya estaba abierto)
+static unsigned long correr(MonitorCorriente& monitor, unsigned long ms) {
+    bool cerrado = sim::nivelPin(PINES[0]) == hal::ALTO;
+    for (unsigned long t = 0; t < ms; t += SENSORES_MS) {
+        sim::avanzar(SENSORES_MS);
+        monitor.actualizar();
+        if (cerrado && sim::nivelPin(PINES[0]) == hal::BAJO) return t + SENSORES_MS;
+    }
+    return ms + 1;
+}
+
+static EntradaDiario ultimaAnotada() {
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+    diario.rebobinar();
+    TEST_ASSERT_TRUE(n > 0);
+    return lote[n - 1];
+}
+
+// ======================================================
+// NÚCLEO RMS
+// ======================================================
+void test_raiz_entera() {
+    const uint64_t casos[] = {0, 1, 2, 3, 4, 15, 16, 17, 1000000, 1ULL << 40, 0xFFFFFFFE00000000ULL};
+    for (uint8_t i = 0; i < sizeof(casos) / sizeof(casos[0]); i++) {
+        uint64_t r = MedidorRms::raizEntera(casos[i]);
+        TEST_ASSERT_TRUE(r * r <= casos[i]);
+        TEST_ASSERT_TRUE((r + 1) * (r + 1) > casos[i]);
+    }
+}
+
+void test_rms_no_depende_del_punto_medio() {
+    uint16_t onda[100];
+    for (uint16_t medio = 300; medio <= 700; medio += 200) {
+        MedidorRms m(POR_CICLO);
+        ciclo(onda, 20000, 0, medio);
+        for (uint16_t k = 0; k < POR_CICLO - 1; k++) TEST_ASSERT_FALSE(m.meter(onda[k]));
+        TEST_ASSERT_TRUE(m.meter(onda[POR_CICLO - 1]));
+
+        // 20 A / 97 mA por cuenta = 206,2 cuentas RMS (x16)
+        TEST_ASSERT_UINT_WITHIN(4, 20000 * 16 / CORRIENTE_MA_CUENTA, m.rmsQ4());
+        TEST_ASSERT_EQUAL(medio, m.continua());
+    }
+}
+
+void test_rms_verdadero_con_armonicos_y_cuadrada() {
+    uint16_t onda[100];
+    MedidorRms m(POR_CICLO);
+
+    // Fundamental + 30 % de tercer armónico: sqrt(1 + 0,09) veces el RMS
+    ciclo(onda, 10000, 30);
+    for (uint16_t k = 0; k < POR_CICLO; k++) m.meter(onda[k]);
+    uint32_t esperado = (uint32_t)lround(10000 * sqrt(1.09) * 16 / CORRIENTE_MA_CUENTA);
+    TEST_ASSERT_UINT_WITHIN(4, esperado, m.rmsQ4());
+
+    // Cuadrada de +-200 cuentas: RMS 200 exacto
+    for (uint16_t k = 0; k < POR_CICLO; k++) m.meter(k < POR_CICLO / 2 ? 712 : 312);
+    TEST_ASSERT_EQUAL(200 * 16, m.rmsQ4());
+
+    // Continua pura: nada de alterna
+    for (uint16_t k = 0; k < POR_CICLO; k++) m.meter(512);
+    TEST_ASSERT_EQUAL(0, m.rmsQ4());
+}
+
+// ======================================================
+// MONITOR SOBRE GRABACIONES
+// ======================================================
+void test_marcha_normal() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    TEST_ASSERT_TRUE(monitor.iniciar());
+    grabarConstante(NOMINAL_MA, 1);
+    TEST_ASSERT_EQUAL(PARADA, bombas[0].estadoMedido());
+
+    manager.Evaluar(REGANDO);
+    correr(monitor, 100);
+    TEST_ASSERT_EQUAL(ARRANCANDO, bombas[0].estadoMedido());
+    TEST_ASSERT_TRUE(correr(monitor, ARRANQUE_BOMBA_MS + 500) > ARRANQUE_BOMBA_MS + 500);
+    TEST_ASSERT_EQUAL(EN_MARCHA, bombas[0].estadoMedido());
+    TEST_ASSERT_UINT_WITHIN(50, NOMINAL_MA, bombas[0].corrienteMa());
+
+    // Apagada por el horario: parada y sin corriente
+    grabarConstante(0, 1);
+    manager.Evaluar(RtcDateTime(2025, 1, 6, 12, 30, 0));
+    correr(monitor, 100);
+    TEST_ASSERT_EQUAL(PARADA, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(0, bombas[0].corrienteMa());
+    TEST_ASSERT_EQUAL(0, monitor.totalDisparos());
+}
+
+void test_mandada_encender_sin_corriente() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+    grabarConstante(0, 1);                  // Térmico saltado, cable suelto...
+
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_TRUE(correr(monitor, ARRANQUE_BOMBA_MS + 200) > ARRANQUE_BOMBA_MS + 200);
+    TEST_ASSERT_EQUAL(SIN_CORRIENTE, bombas[0].estadoMedido());
+    TEST_ASSERT_TRUE(bombas[0].estaEncendida());    // Solo se avisa
+}
+
+void test_pico_de_arranque_no_corta() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+
+    // 5 x nominal que cae a nominal con tau = 80 ms (2 s de grabación)
+    const uint16_t ciclos = sizeof(grabacion) / sizeof(grabacion[0]) / POR_CICLO;
+    for (uint16_t c = 0; c < ciclos; c++) {
+        double t = (double)c * MS_CICLO;
+        ciclo(&grabacion[c * POR_CICLO], (uint16_t)(NOMINAL_MA * (1 + 4 * exp(-t / 80.0))));
+    }
+    sim::reproducirAnalogico(PIN_CORRIENTE, grabacion, ciclos * POR_CICLO);
+
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_TRUE(correr(monitor, 1500) > 1500);
+    TEST_ASSERT_EQUAL(EN_MARCHA, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(0, monitor.totalDisparos());
+}
+
+void test_rotor_bloqueado_corta_al_acabar_el_arranque() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+    grabarConstante(30000, 1);              // El pico no baja nunca
+
+    manager.Evaluar(REGANDO);
+    unsigned long ms = correr(monitor, 1000);
+    TEST_ASSERT_TRUE(ms > ARRANQUE_BOMBA_MS);
+    TEST_ASSERT_TRUE(ms <= ARRANQUE_BOMBA_MS + 2 * MS_CICLO + SENSORES_MS);
+    TEST_ASSERT_EQUAL(BLOQUEADA, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(1, monitor.totalDisparos());
+
+    // La pasada lo anota y el motivo se queda mientras siga apagada
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_EQUAL(MANUAL_OFF, manager.obtenerOverride(0));
+    EntradaDiario e = ultimaAnotada();
+    TEST_ASSERT_EQUAL(0, e.zona);
+    TEST_ASSERT_FALSE(e.encendida());
+    TEST_ASSERT_EQUAL(CAUSA_CORRIENTE, e.motivo());
+    correr(monitor, 200);
+    TEST_ASSERT_EQUAL(BLOQUEADA, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(1, monitor.totalDisparos());
+}
+
+void test_sobrecorriente_corta_en_dos_ciclos() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+    grabarConstante(NOMINAL_MA, 1);
+    manager.Evaluar(REGANDO);
+    correr(monitor, ARRANQUE_BOMBA_MS + 200);
+
+    // Se atasca a medias: 15 A, por debajo del nivel de bloqueo. Cae a
+    // mitad de un ciclo de medida: ese cuenta poco, luego dos enteros.
+    grabarConstante(15000, 1);
+    unsigned long ms = correr(monitor, 500);
+    TEST_ASSERT_TRUE(ms > MS_CICLO);
+    TEST_ASSERT_TRUE(ms <= 3 * MS_CICLO + SENSORES_MS);
+    TEST_ASSERT_EQUAL(SOBRECORRIENTE, bombas[0].estadoMedido());
+    TEST_ASSERT_UINT_WITHIN(100, 15000, bombas[0].corrienteMa());
+}
+
+void test_ciclos_altos_sueltos_no_cortan() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+
+    // Uno de cada 4 ciclos a 15 A (alineados con la medida: la grabación
+    // arranca con el canal)
+    for (uint16_t c = 0; c < 40; c++) ciclo(&grabacion[c * POR_CICLO], (c % 4 == 3) ? 15000 : NOMINAL_MA);
+    sim::reproducirAnalogico(PIN_CORRIENTE, grabacion, 40 * POR_CICLO);
+
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_TRUE(correr(monitor, 2000) > 2000);
+    TEST_ASSERT_EQUAL(0, monitor.totalDisparos());
+    TEST_ASSERT_TRUE(bombas[0].estadoMedido() == EN_MARCHA);
+}
+
+void test_hueco_en_el_adc_tira_el_ciclo() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+
+    // Pasado el arranque, con un ciclo de medida a medias (muestras leídas
+    // hasta 'ms', a 1 cada US_MUESTRA)
+    const unsigned long US_MUESTRA = 1000000UL / SENSORES_HZ;
+    unsigned long ms = ARRANQUE_BOMBA_MS + 200;
+    while ((ms * 1000 / US_MUESTRA) % POR_CICLO < POR_CICLO / 3 ||
+           (ms * 1000 / US_MUESTRA) % POR_CICLO > 2 * POR_CICLO / 3) {
+        ms += SENSORES_MS;
+    }
+    uint16_t leidas = ms * 1000 / US_MUESTRA;
+
+    // Nominal siempre, pero el punto medio salta en el siguiente borde de
+    // ciclo, que cae dentro del hueco: ningún ciclo continuo ve el escalón
+    // y uno cosido a través del hueco lo mediría como rotor bloqueado
+    const uint16_t ciclos = sizeof(grabacion) / sizeof(grabacion[0]) / POR_CICLO;
+    for (uint16_t c = 0; c < ciclos; c++) {
+        ciclo(&grabacion[c * POR_CICLO], NOMINAL_MA, 0, c <= leidas / POR_CICLO ? 140 : 880);
+    }
+    sim::reproducirAnalogico(PIN_CORRIENTE, grabacion, ciclos * POR_CICLO);
+
+    manager.Evaluar(REGANDO);
+    correr(monitor, ms);
+    TEST_ASSERT_EQUAL(EN_MARCHA, bombas[0].estadoMedido());
+
+    // La tarea se para más de lo que aguanta el anillo (85 ms)
+    uint32_t perdidas = hal::adcContinuoPerdidas(PIN_CORRIENTE);
+    sim::avanzar(100);
+    TEST_ASSERT_TRUE(correr(monitor, 200) > 200);
+    perdidas = hal::adcContinuoPerdidas(PIN_CORRIENTE) - perdidas;
+    TEST_ASSERT_TRUE(perdidas > (uint32_t)(POR_CICLO - leidas % POR_CICLO));
+    TEST_ASSERT_EQUAL(1, monitor.totalHuecos());
+    TEST_ASSERT_EQUAL(0, monitor.totalDisparos());
+    TEST_ASSERT_EQUAL(EN_MARCHA, bombas[0].estadoMedido());
+    TEST_ASSERT_UINT_WITHIN(50, NOMINAL_MA, bombas[0].corrienteMa());
+}
+
+void test_apagada_el_canal_no_se_convierte() {
+    BombaManager manager = gestorRiego();
+    MonitorCorriente monitor(bombas[0], 0, manager, PIN_CORRIENTE, LIMITES, SENSORES_HZ, RED_HZ);
+    monitor.iniciar();
+    grabarConstante(NOMINAL_MA, 1);
+    correr(monitor, 100);
+    TEST_ASSERT_FALSE(sim::adcConvirtiendo(PIN_CORRIENTE));
+
+    manager.Evaluar(REGANDO);
+    correr(monitor, ARRANQUE_BOMBA_MS + 200);
+    TEST_ASSERT_TRUE(sim::adcConvirtiendo(PIN_CORRIENTE));
+    TEST_ASSERT_EQUAL(EN_MARCHA, bombas[0].estadoMedido());
+
+    // Al apagar se para en la misma vuelta, sin esperar a medir un ciclo
+    manager.Evaluar(RtcDateTime(2025, 1, 6, 12, 30, 0));
+    correr(monitor, SENSORES_MS);
+    TEST_ASSERT_FALSE(sim::adcConvirtiendo(PIN_CORRIENTE));
+    TEST_ASSERT_EQUAL(PARADA, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(0, bombas[0].corrienteMa());
+
+    // Y vuelve a medir desde cero en el próximo encendido
+    manager.Evaluar(RtcDateTime(2025, 1, 7, 12, 1, 0));
+    correr(monitor, 100);
+    TEST_ASSERT_TRUE(sim::adcConvirtiendo(PIN_CORRIENTE));
+    TEST_ASSERT_EQUAL(ARRANCANDO, bombas[0].estadoMedido());
+    TEST_ASSERT_EQUAL(0, monitor.totalHuecos());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_raiz_entera);
+    RUN_TEST(test_rms_no_depende_del_punto_medio);
+    RUN_TEST(test_rms_verdadero_con_armonicos_y_cuadrada);
+    RUN_TEST(test_marcha_normal);
+    RUN_TEST(test_mandada_encender_sin_corriente);
+    RUN_TEST(test_pico_de_arranque_no_corta);
+    RUN_TEST(test_rotor_bloqueado_corta_al_acabar_el_arranque);
+    RUN_TEST(test_sobrecorriente_corta_en_dos_ciclos);
+    RUN_TEST(test_ciclos_altos_sueltos_no_cortan);
+    RUN_TEST(test_hueco_en_el_adc_tira_el_ciclo);
+    RUN_TEST(test_apagada_el_canal_no_se_convierte);
+    return UNITY_END();
+}
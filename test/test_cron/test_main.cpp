@@ -0,0 +1,242 @@
+#include <unity.h>
+#include <string.h>
+#include "objects/Cron.h"
+#include "../comun/EntornoRiego.h"
+
+// ==========================================
+// CRON: BITS, PRÓXIMO DISPARO Y MODO DE ZONA
+// ==========================================
+// La expresión se compila a bits y vuelve a texto canónico; el próximo
+// disparo se contrasta con una búsqueda minuto a minuto y el gestor
+// riega 'duracion' minutos por disparo, uniendo los que se solapan.
+//
+//   pio test -e native -f test_cron -v
+
+void setUp() {
+    reiniciarEntorno();
+}
+void tearDown() {}
+
+static HorarioCron compilado(const char* texto, uint16_t duracion = 10) {
+    HorarioCron cron = {};
+    cron.duracion = duracion;
+    TEST_ASSERT_TRUE_MESSAGE(cron::compilar(texto, cron), texto);
+    return cron;
+}
+
+static void comprobarCanonico(const char* texto, const char* esperado) {
+    HorarioCron cron = compilado(texto);
+    char salida[cron::TAM_TEXTO];
+    TEST_ASSERT_TRUE(cron::formatear(cron, salida, sizeof(salida)) > 0);
+    TEST_ASSERT_EQUAL_STRING_MESSAGE(esperado, salida, texto);
+
+    // Y el canónico compila a los mismos bits
+    HorarioCron otra = compilado(salida);
+    TEST_ASSERT_EQUAL_MEMORY(&cron, &otra, sizeof(HorarioCron));
+}
+
+static uint32_t segundos(uint16_t anio, uint8_t mes, uint8_t dia, uint8_t hora, uint8_t minuto) {
+    return RtcDateTime(anio, mes, dia, hora, minuto, 0).TotalSeconds();
+}
+
+// ======================================================
+// TEXTO <-> BITS
+// ======================================================
+void test_compilar_y_formatear() {
+    comprobarCanonico("* * * * *", "* * * * *");
+    comprobarCanonico("0 6,18 * * 1-5", "0 6,18 * * 1-5");
+    comprobarCanonico("*/15 6-8 * * *", "*/15 6-8 * * *");
+    comprobarCanonico("0,15,30,45 6,7,8 * * *", "*/15 6-8 * * *");
+    comprobarCanonico("5-50/15 0 1 * *", "5-50/15 0 1 * *");
+    comprobarCanonico("10/20 0 * * *", "10-50/20 0 * * *");
+    comprobarCanonico("30 6 * jun-SEP mon,thu", "30 6 * 6-9 1,4");
+    comprobarCanonico("0 0 * * 7", "0 0 * * 0");
+    comprobarCanonico("  0   12 1,2,3,10 */3 *  ", "0 12 1-3,10 */3 *");
+
+    // Día del mes completo pero escrito sin '*': no es lo mismo que '*'
+    HorarioCron cron = compilado("0 8 1-31 * 1");
+    TEST_ASSERT_EQUAL(0, cron.comodines);
+    char salida[cron::TAM_TEXTO];
+    cron::formatear(cron, salida, sizeof(salida));
+    TEST_ASSERT_EQUAL_STRING("0 8 1-31 * 1", salida);
+
+    const char* const MALAS[] = {
+        "", "* * * *", "* * * * * *", "60 * * * *", "* 24 * * *", "* * 0 * *",
+        "* * * 13 *", "* * * * 8", "5-1 * * * *", "*/0 * * * *", "* * * june *",
+        "1,,2 * * * *", "a * * * *", "1- * * * *", "0 0 * * mon-",
+    };
+    for (const char* mala : MALAS) {
+        HorarioCron x = {};
+        TEST_ASSERT_FALSE_MESSAGE(cron::compilar(mala, x), mala);
+    }
+}
+
+void test_valida() {
+    HorarioCron cron = compilado("0 6 * * *", 15);
+    TEST_ASSERT_TRUE(cron::valida(cron));
+    cron.duracion = 0;
+    TEST_ASSERT_FALSE(cron::valida(cron));
+    cron.duracion = MAX_DURACION_CRON + 1;
+    TEST_ASSERT_FALSE(cron::valida(cron));
+
+    HorarioCron vacia = {};
+    vacia.duracion = 10;
+    TEST_ASSERT_FALSE(cron::valida(vacia));
+
+    // Lista que no se deja resumir (dos de cada tres minutos): no cabe en TAM_TEXTO
+    HorarioCron larga = compilado("0 6 * * *");
+    larga.minutos = 0;
+    for (uint8_t m = 0; m < 60; m++) {
+        if (m % 3 != 2) larga.minutos |= 1ULL << m;
+    }
+    TEST_ASSERT_FALSE(cron::valida(larga));
+}
+
+// ======================================================
+// DISPAROS
+// ======================================================
+// Referencia: minuto a minuto con coincide()
+static uint32_t siguienteLento(const HorarioCron& cron, uint32_t desde, uint32_t limite) {
+    for (uint32_t t = (desde + 59) / 60 * 60; t < limite; t += 60) {
+        if (cron::coincide(cron, t)) return t;
+    }
+    return cron::SIN_DISPARO;
+}
+
+void test_siguiente_igual_que_minuto_a_minuto() {
+    const char* const EXPRESIONES[] = {
+        "0 6,18 * * 1-5", "*/7 */5 * * *", "30 23 31 * *", "0 0 29 2 *",
+        "15 8 1,15 * 3", "0 12 * 2 sun", "59 23 * 12 *", "* * * * *",
+    };
+    uint32_t inicio = segundos(2027, 12, 30, 22, 0) + 17;
+    uint32_t limite = inicio + 70 * 86400UL;
+    for (const char* expresion : EXPRESIONES) {
+        HorarioCron cron = compilado(expresion);
+        uint32_t desde = inicio;
+        for (uint8_t i = 0; i < 20; i++) {
+            uint32_t lento = siguienteLento(cron, desde, limite);
+            if (lento == cron::SIN_DISPARO) break;
+            TEST_ASSERT_EQUAL_UINT32_MESSAGE(lento, cron::siguiente(cron, desde), expresion);
+            desde = lento + 1;
+        }
+    }
+}
+
+void test_siguiente_salta_meses_y_anios() {
+    // 29 de febrero: el próximo bisiesto
+    HorarioCron bisiesto = compilado("0 0 29 2 *");
+    TEST_ASSERT_EQUAL_UINT32(segundos(2028, 2, 29, 0, 0), cron::siguiente(bisiesto, segundos(2025, 3, 1, 0, 0)));
+
+    // 31 solo en los meses que lo tienen
+    HorarioCron treintayuno = compilado("0 7 31 * *");
+    TEST_ASSERT_EQUAL_UINT32(segundos(2025, 5, 31, 7, 0), cron::siguiente(treintayuno, segundos(2025, 4, 1, 0, 0)));
+
+    // Día del mes O día de la semana si los dos están restringidos
+    HorarioCron ambos = compilado("0 9 13 * 5");
+    TEST_ASSERT_EQUAL_UINT32(segundos(2025, 1, 10, 9, 0), cron::siguiente(ambos, segundos(2025, 1, 6, 0, 0)));
+    TEST_ASSERT_EQUAL_UINT32(segundos(2025, 1, 13, 9, 0), cron::siguiente(ambos, segundos(2025, 1, 10, 9, 1)));
+
+    // Nunca: 30 de febrero
+    HorarioCron nunca = compilado("0 0 30 2 *");
+    TEST_ASSERT_EQUAL_UINT32(cron::SIN_DISPARO, cron::siguiente(nunca, segundos(2025, 1, 1, 0, 0)));
+
+    // Justo en el minuto: cuenta; un segundo después, ya no
+    HorarioCron seis = compilado("0 6 * * *");
+    TEST_ASSERT_EQUAL_UINT32(segundos(2025, 1, 6, 6, 0), cron::siguiente(seis, segundos(2025, 1, 6, 6, 0)));
+    TEST_ASSERT_EQUAL_UINT32(segundos(2025, 1, 7, 6, 0), cron::siguiente(seis, segundos(2025, 1, 6, 6, 0) + 1));
+}
+
+// ======================================================
+// EN EL GESTOR
+// ======================================================
+// Encendidos y segundos de riego de la zona en [desde, hasta), de minuto en minuto
+static void simular(BombaManager& manager, uint8_t zona, uint32_t desde, uint32_t hasta,
+                    uint8_t& encendidos, uint32_t& encendidaS) {
+    encendidos = 0;
+    encendidaS = 0;
+    for (uint32_t s = desde; s < hasta; s += 60) {
+        bool antes = manager.zonasEncendidas() & (1 << zona);
+        manager.Evaluar(RtcDateTime(s));
+        bool ahora = manager.zonasEncendidas() & (1 << zona);
+        if (!antes && ahora) encendidos++;
+        if (ahora) encendidaS += 60;
+    }
+}
+
+void test_gestor_riega_cada_disparo() {
+    BombaManager manager = gestorRiego();
+    TEST_ASSERT_TRUE(configManager.configurarCron(1, "0 6,18 * * 1-5", 15));
+    TEST_ASSERT_EQUAL(CRON, configManager.config(1).modo);
+
+    // Lunes 6 a domingo 12 de enero de 2025: 10 riegos de 15 min
+    uint32_t lunes = segundos(2025, 1, 6, 0, 0);
+    manager.Evaluar(RtcDateTime(lunes));
+    TEST_ASSERT_EQUAL_UINT32(lunes + 6 * 3600, manager.proximoCambioHorario());
+
+    uint8_t encendidos;
+    uint32_t encendidaS;
+    simular(manager, 1, lunes, lunes + 7 * 86400UL, encendidos, encendidaS);
+    TEST_ASSERT_EQUAL(10, encendidos);
+    TEST_ASSERT_EQUAL_UINT32(10 * 15 * 60, encendidaS);
+}
+
+void test_gestor_une_disparos_solapados() {
+    BombaManager manager = gestorRiego();
+
+    // Cada 10 min de 8 a 8:59 con 15 min de riego: una sola racha 8:00-9:05
+    TEST_ASSERT_TRUE(configManager.configurarCron(2, "*/10 8 * * *", 15));
+    uint32_t dia = segundos(2025, 1, 6, 0, 0);
+    manager.Evaluar(RtcDateTime(dia + 8 * 3600 + 120));
+    TEST_ASSERT_TRUE(manager.zonasEncendidas() & (1 << 2));
+    TEST_ASSERT_EQUAL_UINT32(dia + 9 * 3600 + 5 * 60, manager.proximoCambioHorario());
+
+    uint8_t encendidos;
+    uint32_t encendidaS;
+    simular(manager, 2, dia, dia + 86400UL, encendidos, encendidaS);
+    TEST_ASSERT_EQUAL(1, encendidos);
+    TEST_ASSERT_EQUAL_UINT32(65 * 60, encendidaS);
+
+    // Siempre encendida: no hay flanco, solo se vuelve a mirar más tarde
+    TEST_ASSERT_TRUE(configManager.configurarCron(3, "* * * * *", 5));
+    manager.Evaluar(RtcDateTime(dia));
+    uint32_t revisar = manager.proximoCambioHorario();
+    TEST_ASSERT_TRUE(revisar > dia && revisar != BombaManager::SIN_CAMBIO);
+    simular(manager, 3, dia, dia + 3 * 3600, encendidos, encendidaS);
+    TEST_ASSERT_EQUAL(0, encendidos);
+    TEST_ASSERT_EQUAL_UINT32(3 * 3600, encendidaS);
+}
+
+void test_config_cron_invalida_y_v2() {
+    TEST_ASSERT_FALSE(configManager.configurarCron(1, "0 25 * * *", 10));
+    TEST_ASSERT_FALSE(configManager.configurarCron(1, "0 6 * * *", 0));
+    TEST_ASSERT_FALSE(configManager.configurarCron(NUM_ZONAS, "0 6 * * *", 10));
+    TEST_ASSERT_TRUE(configManager.config(1).modo != CRON);
+
+    // Persiste y vuelve igual
+    TEST_ASSERT_TRUE(configManager.configurarCron(1, "*/20 5-7 * * 6,0", 20));
+    configManager.guardarPendientes();
+    HorarioCron antes = configManager.config(1).cron;
+    configManager.iniciar();
+    TEST_ASSERT_EQUAL(CRON, configManager.config(1).modo);
+    TEST_ASSERT_EQUAL_MEMORY(&antes, &configManager.config(1).cron, sizeof(HorarioCron));
+
+    // Un registro de antes del cron (v2: hasta los tramos) se migra
+    BombaConfig v2(true, false, POR_DIAS, 0b0111110, 1, Fecha{1, 1, 2024}, 6, 0, 7, 0);
+    almacen.escribir(4, 2, &v2, 130);
+    configManager.iniciar();
+    TEST_ASSERT_EQUAL(POR_DIAS, configManager.config(4).modo);
+    TEST_ASSERT_EQUAL(6, configManager.config(4).horaInicio);
+    TEST_ASSERT_EQUAL(0, configManager.config(4).cron.duracion);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_compilar_y_formatear);
+    RUN_TEST(test_valida);
+    RUN_TEST(test_siguiente_igual_que_minuto_a_minuto);
+    RUN_TEST(test_siguiente_salta_meses_y_anios);
+    RUN_TEST(test_gestor_riega_cada_disparo);
+    RUN_TEST(test_gestor_une_disparos_solapados);
+    RUN_TEST(test_config_cron_invalida_y_v2);
+    return UNITY_END();
+}
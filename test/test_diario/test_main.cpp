@@ -0,0 +1,218 @@
+#include <unity.h>
+#include <stdio.h>
+#include "hal/native/HalNative.h"
+#include "objects/DiarioRiego.h"
+#include "manager/Serializador.h"
+
+// ==========================================
+// DIARIO DE RIEGO: GUARDAR Y REENVIAR
+// ==========================================
+// Sobre la flash simulada (partición FLASH_DIARIO, 4 sectores = 1024
+// entradas): lo anotado sin conexión sobrevive a un reinicio, lo
+// confirmado no se repite y un anillo desbordado solo pierde lo más viejo.
+//
+//   pio test -e native -f test_diario -v
+
+void setUp() {
+    sim::borrarFlash();
+    sim::cortarFlashTras(-1);
+}
+void tearDown() {}
+
+static const uint32_t CAPACIDAD = 4 * DiarioRiego::ENTRADAS_SECTOR;
+
+static void anotarVarias(DiarioRiego& diario, uint32_t n, uint32_t desde = 0) {
+    for (uint32_t i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(diario.anotar(i % 8, i % 2 == 0, CAUSA_HORARIO, 1000 + desde + i, i % 2 ? 600 : 0));
+    }
+}
+
+// Lo que haría la red: leer, "publicar" y confirmar. Devuelve lo subido
+// (0 si algún lote no sale en orden).
+static uint32_t subirTodo(DiarioRiego& diario, uint32_t* ultimaSecuencia = nullptr) {
+    uint32_t total = 0;
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    uint8_t n;
+    while ((n = diario.leer(lote, serializar::LOTE_DIARIO)) > 0) {
+        for (uint8_t i = 1; i < n; i++) {
+            if (lote[i].secuencia <= lote[i - 1].secuencia) return 0;
+        }
+        diario.confirmar(lote[n - 1].secuencia);
+        if (ultimaSecuencia) *ultimaSecuencia = lote[n - 1].secuencia;
+        total += n;
+    }
+    return total;
+}
+
+// El control marca en flash poco a poco: se le dan vueltas hasta acabar
+static void marcarTodo(DiarioRiego& diario) {
+    for (uint32_t i = 0; i < CAPACIDAD; i++) diario.actualizar();
+}
+
+// ======================================================
+// BÁSICO
+// ======================================================
+void test_entrada_completa() {
+    DiarioRiego diario;
+    TEST_ASSERT_TRUE(diario.iniciar());
+    TEST_ASSERT_EQUAL(0, diario.pendientes());
+
+    diario.anotar(3, false, CAUSA_TIMEOUT, 123456, 3600);
+    TEST_ASSERT_EQUAL(1, diario.pendientes());
+
+    EntradaDiario e;
+    TEST_ASSERT_EQUAL(1, diario.leer(&e, 1));
+    TEST_ASSERT_EQUAL(1, e.secuencia);
+    TEST_ASSERT_EQUAL(3, e.zona);
+    TEST_ASSERT_FALSE(e.encendida());
+    TEST_ASSERT_EQUAL(CAUSA_TIMEOUT, e.motivo());
+    TEST_ASSERT_EQUAL(123456, e.instante);
+    TEST_ASSERT_EQUAL(3600, e.duracionS);
+}
+
+void test_sin_conexion_sobrevive_reinicio() {
+    {
+        DiarioRiego diario;
+        diario.iniciar();
+        anotarVarias(diario, 50);
+    }
+    DiarioRiego reiniciado;
+    TEST_ASSERT_TRUE(reiniciado.iniciar());
+    TEST_ASSERT_EQUAL(50, reiniciado.pendientes());
+    TEST_ASSERT_EQUAL(50, subirTodo(reiniciado));
+    TEST_ASSERT_EQUAL(0, reiniciado.pendientes());
+}
+
+void test_confirmado_no_se_repite() {
+    {
+        DiarioRiego diario;
+        diario.iniciar();
+        anotarVarias(diario, 30);
+        TEST_ASSERT_EQUAL(30, subirTodo(diario));
+        marcarTodo(diario);
+        anotarVarias(diario, 5, 30);
+    }
+    DiarioRiego reiniciado;
+    reiniciado.iniciar();
+    TEST_ASSERT_EQUAL(5, reiniciado.pendientes());
+
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    TEST_ASSERT_EQUAL(5, reiniciado.leer(lote, serializar::LOTE_DIARIO));
+    TEST_ASSERT_EQUAL(31, lote[0].secuencia);
+}
+
+void test_fallo_al_publicar_rebobina() {
+    DiarioRiego diario;
+    diario.iniciar();
+    anotarVarias(diario, 20);
+
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    diario.leer(lote, serializar::LOTE_DIARIO);
+    diario.confirmar(lote[serializar::LOTE_DIARIO - 1].secuencia);
+    diario.leer(lote, serializar::LOTE_DIARIO);     // Este "no sale"
+    diario.rebobinar();
+
+    TEST_ASSERT_EQUAL(serializar::LOTE_DIARIO, diario.leer(lote, serializar::LOTE_DIARIO));
+    TEST_ASSERT_EQUAL(serializar::LOTE_DIARIO + 1, lote[0].secuencia);
+}
+
+// ======================================================
+// ANILLO
+// ======================================================
+void test_vueltas_con_red_al_dia() {
+    DiarioRiego diario;
+    diario.iniciar();
+    uint32_t ultima = 0;
+    for (uint32_t i = 0; i < 5 * CAPACIDAD; i += 10) {
+        anotarVarias(diario, 10, i);
+        TEST_ASSERT_EQUAL(10, subirTodo(diario, &ultima));
+        diario.actualizar();
+    }
+    TEST_ASSERT_EQUAL(5 * CAPACIDAD, ultima);
+    TEST_ASSERT_EQUAL(0, diario.totalPerdidas());
+
+    // Las vueltas reparten los borrados (el sector 0 lleva además el del montaje)
+    for (size_t s = 1; s < 4; s++) TEST_ASSERT_EQUAL(5, sim::borradosSector(hal::FLASH_DIARIO, s));
+    TEST_ASSERT_EQUAL(6, sim::borradosSector(hal::FLASH_DIARIO, 0));
+}
+
+void test_desborde_pierde_lo_mas_viejo() {
+    DiarioRiego diario;
+    diario.iniciar();
+    anotarVarias(diario, 2 * CAPACIDAD);
+
+    uint32_t ultima = 0;
+    uint32_t subidas = subirTodo(diario, &ultima);
+    TEST_ASSERT_EQUAL(2 * CAPACIDAD, ultima);
+    TEST_ASSERT_EQUAL(CAPACIDAD - DiarioRiego::ENTRADAS_SECTOR, subidas);
+    TEST_ASSERT_EQUAL(2 * CAPACIDAD - subidas, diario.totalPerdidas());
+}
+
+// ======================================================
+// CORTES DE LUZ
+// ======================================================
+void test_corte_en_cada_byte_de_una_entrada() {
+    for (long corte = 0; corte < (long)sizeof(EntradaDiario); corte++) {
+        sim::borrarFlash();
+        sim::cortarFlashTras(-1);
+        DiarioRiego diario;
+        diario.iniciar();
+        anotarVarias(diario, 10);
+
+        sim::cortarFlashTras(corte);
+        diario.anotar(7, true, CAUSA_BOTON, 5000, 0);
+        sim::cortarFlashTras(-1);
+
+        // Las 10 anteriores siguen, la cortada no aparece (salvo si solo
+        // faltaba 'enviada', que ya vale 0xFF) y lo nuevo se guarda
+        DiarioRiego reiniciado;
+        TEST_ASSERT_TRUE(reiniciado.iniciar());
+        TEST_ASSERT_TRUE(reiniciado.anotar(1, false, CAUSA_MQTT, 6000, 60));
+
+        bool completa = corte >= (long)offsetof(EntradaDiario, enviada);
+        EntradaDiario lote[16];
+        uint8_t n = reiniciado.leer(lote, 16);
+        TEST_ASSERT_EQUAL(completa ? 12 : 11, n);
+        for (uint8_t i = 0; i < 10; i++) TEST_ASSERT_EQUAL(i + 1, lote[i].secuencia);
+        if (completa) TEST_ASSERT_EQUAL(CAUSA_BOTON, lote[10].motivo());
+        TEST_ASSERT_EQUAL(CAUSA_MQTT, lote[n - 1].motivo());
+    }
+}
+
+void test_lote_serializado() {
+    DiarioRiego diario;
+    diario.iniciar();
+    diario.anotar(0, true, CAUSA_HORARIO, 0, 0);
+    diario.anotar(0, false, CAUSA_BOTON, 600, 600);
+
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+    char json[serializar::TAM_DIARIO];
+    serializar::diario(json, CODIFICACION_JSON, lote, n, 0);
+    TEST_ASSERT_EQUAL_STRING(
+        "{\"entradas\":[[1,946684800,1,1,0,0],[2,946685400,1,0,1,600]],\"perdidas\":0}", json);
+
+    // El peor caso cabe en TAM_DIARIO, en las dos codificaciones
+    for (uint8_t i = 0; i < serializar::LOTE_DIARIO; i++) {
+        lote[i].secuencia = 0xFFFFFFFF;
+        lote[i].instante = 0xFFFFFFFF - 946684800UL;
+        lote[i].duracionS = 0xFFFFFFFF;
+        lote[i].zona = 254;
+        lote[i].causa = 0x7F | EntradaDiario::ENCENDIDA;
+    }
+    TEST_ASSERT_TRUE(serializar::diario(json, CODIFICACION_JSON, lote, serializar::LOTE_DIARIO, 0xFFFFFFFF) > 0);
+    TEST_ASSERT_TRUE(serializar::diario(json, CODIFICACION_MSGPACK, lote, serializar::LOTE_DIARIO, 0xFFFFFFFF) > 0);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_entrada_completa);
+    RUN_TEST(test_sin_conexion_sobrevive_reinicio);
+    RUN_TEST(test_confirmado_no_se_repite);
+    RUN_TEST(test_fallo_al_publicar_rebobina);
+    RUN_TEST(test_vueltas_con_red_al_dia);
+    RUN_TEST(test_desborde_pierde_lo_mas_viejo);
+    RUN_TEST(test_corte_en_cada_byte_de_una_entrada);
+    RUN_TEST(test_lote_serializado);
+    return UNITY_END();
+}
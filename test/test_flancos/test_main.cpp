@@ -0,0 +1,103 @@
+#include <unity.h>
+#include "manager/Serializador.h"
+#include "../comun/EntornoRiego.h"
+
+// ==========================================
+// FLANCOS PROGRAMADOS DEL HORARIO
+// ==========================================
+// El relé conmuta en el ms del flanco aunque nadie llame a Evaluar(), y
+// la pasada siguiente lo anota en el diario sin volver a escribirlo ni
+// deshacerlo. Zona 1: todos los días de 08:00 a 08:10.
+//
+//   pio test -e native -f test_flancos -v
+
+static const uint32_t INICIO = RtcDateTime(2025, 1, 6, 8, 0, 0).TotalSeconds();
+
+// Hora de pared: el segundo INICIO - 10 empezó en millis() = base
+static unsigned long base;
+static RtcDateTime ahora() { return RtcDateTime(INICIO - 10 + (hal::millis() - base) / 1000); }
+static unsigned long msHasta(uint32_t segundo) {
+    unsigned long objetivo = base + (segundo - (INICIO - 10)) * 1000UL;
+    return objetivo > hal::millis() ? objetivo - hal::millis() : 0;
+}
+
+static void pasada(BombaManager& manager) {
+    manager.Evaluar(ahora());
+    manager.armarFlanco(msHasta(manager.proximoCambioHorario()));
+}
+
+static uint8_t anotadas() {
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+    diario.rebobinar();
+    return n;
+}
+
+void setUp() {
+    reiniciarEntorno();
+    configManager.configurarPorDias(0, 0x7F, 8, 0, 8, 10);
+    base = hal::millis();
+}
+void tearDown() {}
+
+void test_rele_conmuta_en_el_flanco() {
+    BombaManager manager = gestorRiego();
+    pasada(manager);
+    TEST_ASSERT_EQUAL(INICIO, manager.proximoCambioHorario());
+    uint32_t antes = manager.flancos().totalDisparos();
+
+    // Sin ninguna pasada entre medias: el disparo escribe el GPIO a su hora
+    sim::avanzar(9999);
+    TEST_ASSERT_EQUAL(hal::BAJO, sim::nivelPin(PINES[0]));
+    sim::avanzar(1);
+    TEST_ASSERT_EQUAL(hal::ALTO, sim::nivelPin(PINES[0]));
+    TEST_ASSERT_EQUAL(antes + 1, manager.flancos().totalDisparos());
+    TEST_ASSERT_EQUAL(0, manager.zonasEncendidas());
+
+    // La pasada lo hace suyo y lo anota una sola vez
+    uint8_t previas = anotadas();
+    pasada(manager);
+    TEST_ASSERT_EQUAL(1, manager.zonasEncendidas());
+    TEST_ASSERT_EQUAL(previas + 1, anotadas());
+    TEST_ASSERT_EQUAL(INICIO + 600, manager.proximoCambioHorario());
+}
+
+void test_hora_atrasada_no_deshace() {
+    BombaManager manager = gestorRiego();
+    pasada(manager);
+    sim::avanzar(10000);
+    TEST_ASSERT_EQUAL(hal::ALTO, sim::nivelPin(PINES[0]));
+
+    // El reloj se resincroniza y aún dice 07:59:59: la zona sigue encendida
+    manager.Evaluar(RtcDateTime(INICIO - 1));
+    TEST_ASSERT_EQUAL(hal::ALTO, sim::nivelPin(PINES[0]));
+    TEST_ASSERT_EQUAL(1, manager.zonasEncendidas());
+}
+
+void test_override_cancela_el_flanco() {
+    BombaManager manager = gestorRiego();
+    pasada(manager);
+    uint32_t antes = manager.flancos().totalDisparos();
+
+    // Encendida a mano antes de la hora: el flanco ya no cambia nada
+    manager.forzarManual(0, true);
+    pasada(manager);
+    TEST_ASSERT_EQUAL(hal::ALTO, sim::nivelPin(PINES[0]));
+    sim::avanzar(20000);
+    TEST_ASSERT_EQUAL(antes, manager.flancos().totalDisparos());
+
+    // Vuelta a auto: el apagado de las 08:10 sí queda armado
+    manager.resetAutomator(0);
+    pasada(manager);
+    sim::avanzar(msHasta(INICIO + 600));
+    TEST_ASSERT_EQUAL(hal::BAJO, sim::nivelPin(PINES[0]));
+    TEST_ASSERT_EQUAL(antes + 1, manager.flancos().totalDisparos());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_rele_conmuta_en_el_flanco);
+    RUN_TEST(test_hora_atrasada_no_deshace);
+    RUN_TEST(test_override_cancela_el_flanco);
+    return UNITY_END();
+}
@@ -0,0 +1,151 @@
+#include <unity.h>
+#include "objects/HorarioSemanal.h"
+#include "../comun/EntornoRiego.h"
+
+// ==========================================
+// HORARIO SEMANAL EN MAPA DE BITS
+// ==========================================
+// Varias ventanas al día, ventanas que cruzan la medianoche y el domingo,
+// la forma comprimida (tramos) ida y vuelta y POR_DIAS pasando por el
+// mismo mapa sin que cambie lo que ya hacía.
+//
+//   pio test -e native -f test_horario_semanal -v
+
+static const uint16_t DIA = 24 * 60;
+static const uint16_t LUNES = 1 * DIA;
+
+void setUp() {
+    reiniciarEntorno();
+}
+void tearDown() {}
+
+// ======================================================
+// MAPA
+// ======================================================
+void test_varias_ventanas_al_dia() {
+    // Lunes 06:00, 12:00 y 18:00, 10 minutos cada una
+    BombaConfig cfg;
+    cfg.modo = SEMANAL;
+    cfg.numTramos = 3;
+    for (uint8_t i = 0; i < 3; i++) cfg.tramos[i] = Tramo{ (uint16_t)(LUNES + (6 + 6 * i) * 60), 10 };
+
+    HorarioSemanal mapa;
+    TEST_ASSERT_TRUE(mapa.compilar(cfg));
+    TEST_ASSERT_FALSE(mapa.encendido(LUNES + 6 * 60 - 1));
+    TEST_ASSERT_TRUE(mapa.encendido(LUNES + 6 * 60));
+    TEST_ASSERT_TRUE(mapa.encendido(LUNES + 6 * 60 + 9));
+    TEST_ASSERT_FALSE(mapa.encendido(LUNES + 6 * 60 + 10));
+    TEST_ASSERT_TRUE(mapa.encendido(LUNES + 18 * 60 + 5));
+
+    // Próximo cambio: fin de la ventana, la siguiente y, tras la última,
+    // la del lunes que viene dando la vuelta a la semana
+    TEST_ASSERT_EQUAL(10, mapa.minutosHastaCambio(LUNES + 6 * 60));
+    TEST_ASSERT_EQUAL(350, mapa.minutosHastaCambio(LUNES + 6 * 60 + 10));
+    TEST_ASSERT_EQUAL(MINUTOS_SEMANA - 12 * 60 - 10, mapa.minutosHastaCambio(LUNES + 18 * 60 + 10));
+
+    TEST_ASSERT_FALSE(mapa.compilar(BombaConfig(true, false, POR_INTERVALO)));
+    TEST_ASSERT_EQUAL(0, mapa.minutosHastaCambio(0));
+}
+
+void test_cruza_medianoche_y_domingo() {
+    // POR_DIAS de 22:00 a 02:00 el sábado (bit 6): sigue el domingo de madrugada
+    BombaConfig dias(true, false, POR_DIAS, 1 << 6, 1, Fecha{1, 1, 2024}, 22, 0, 2, 0);
+    HorarioSemanal mapa;
+    TEST_ASSERT_TRUE(mapa.compilar(dias));
+    TEST_ASSERT_TRUE(mapa.encendido(6 * DIA + 23 * 60));
+    TEST_ASSERT_TRUE(mapa.encendido(MINUTOS_SEMANA - 1));
+    TEST_ASSERT_TRUE(mapa.encendido(0));
+    TEST_ASSERT_TRUE(mapa.encendido(119));
+    TEST_ASSERT_FALSE(mapa.encendido(120));
+    TEST_ASSERT_EQUAL(4 * 60, mapa.minutosHastaCambio(6 * DIA + 22 * 60));
+
+    // Comprimido es un solo tramo, aunque pase por el domingo 00:00
+    Tramo tramos[4];
+    TEST_ASSERT_EQUAL(1, mapa.comprimir(tramos, 4));
+    TEST_ASSERT_EQUAL(6 * DIA + 22 * 60, tramos[0].inicio);
+    TEST_ASSERT_EQUAL(4 * 60, tramos[0].minutos);
+
+    // Inicio = fin: ventana vacía, como antes
+    BombaConfig vacia(true, false, POR_DIAS, 0x7F, 1, Fecha{1, 1, 2024}, 8, 0, 8, 0);
+    TEST_ASSERT_TRUE(mapa.compilar(vacia));
+    TEST_ASSERT_EQUAL(0, mapa.comprimir(tramos, 4));
+}
+
+void test_comprimir_ida_y_vuelta() {
+    // Tramos solapados y desordenados -> forma canónica
+    HorarioSemanal mapa;
+    mapa.marcar(Tramo{ 500, 100 });
+    mapa.marcar(Tramo{ 100, 50 });
+    mapa.marcar(Tramo{ 550, 100 });
+    mapa.marcar(Tramo{ 150, 10 });     // Pegado al anterior: se une
+
+    Tramo tramos[MAX_TRAMOS];
+    TEST_ASSERT_EQUAL(2, mapa.comprimir(tramos, MAX_TRAMOS));
+    TEST_ASSERT_EQUAL(100, tramos[0].inicio);
+    TEST_ASSERT_EQUAL(60, tramos[0].minutos);
+    TEST_ASSERT_EQUAL(500, tramos[1].inicio);
+    TEST_ASSERT_EQUAL(150, tramos[1].minutos);
+
+    // Un minuto sí y otro no: no cabe, pero dice cuántos harían falta
+    mapa.limpiar();
+    for (uint16_t m = 0; m < 200; m += 2) mapa.marcar(Tramo{ m, 1 });
+    TEST_ASSERT_EQUAL(100, mapa.comprimir(tramos, MAX_TRAMOS));
+
+    // Toda la semana
+    mapa.marcar(Tramo{ 3, MINUTOS_SEMANA });
+    TEST_ASSERT_EQUAL(1, mapa.comprimir(tramos, MAX_TRAMOS));
+    TEST_ASSERT_EQUAL(MINUTOS_SEMANA, tramos[0].minutos);
+    TEST_ASSERT_EQUAL(0, mapa.minutosHastaCambio(1234));
+}
+
+// ======================================================
+// EN EL GESTOR
+// ======================================================
+void test_gestor_sigue_las_ventanas() {
+    BombaManager manager = gestorRiego();
+    Tramo tramos[] = { { LUNES + 12 * 60, 10 }, { LUNES + 6 * 60, 10 }, { LUNES + 18 * 60, 10 } };
+    TEST_ASSERT_TRUE(configManager.configurarSemanal(2, tramos, 3));
+    TEST_ASSERT_EQUAL(SEMANAL, configManager.config(2).modo);
+    TEST_ASSERT_EQUAL(LUNES + 6 * 60, configManager.config(2).tramos[0].inicio);   // Ordenados
+
+    // Lunes 6 de enero de 2025
+    const uint32_t lunes = RtcDateTime(2025, 1, 6, 0, 0, 0).TotalSeconds();
+    manager.Evaluar(RtcDateTime(lunes + 5 * 3600));
+    TEST_ASSERT_EQUAL(0, manager.zonasEncendidas() & (1 << 2));
+    TEST_ASSERT_EQUAL(lunes + 6 * 3600, manager.proximoCambioHorario());
+
+    uint8_t encendidas = 0;
+    for (uint32_t s = lunes + 5 * 3600; s < lunes + 20 * 3600; s += 60) {
+        uint16_t antes = manager.zonasEncendidas();
+        manager.Evaluar(RtcDateTime(s));
+        if (!(antes & (1 << 2)) && (manager.zonasEncendidas() & (1 << 2))) encendidas++;
+    }
+    TEST_ASSERT_EQUAL(3, encendidas);
+
+    // Fuera de la semana o tramos vacíos: se rechaza y no se toca la zona
+    Tramo malo[] = { { MINUTOS_SEMANA, 10 } };
+    TEST_ASSERT_FALSE(configManager.configurarSemanal(2, malo, 1));
+    Tramo vacio[] = { { 10, 0 } };
+    TEST_ASSERT_FALSE(configManager.configurarSemanal(2, vacio, 1));
+    TEST_ASSERT_EQUAL(3, configManager.config(2).numTramos);
+}
+
+void test_config_v1_se_migra() {
+    // Un registro de zona de antes de los tramos (17 bytes, versión 1)
+    BombaConfig v1(true, false, POR_DIAS, 0b0111110, 1, Fecha{1, 1, 2024}, 7, 30, 8, 0);
+    almacen.escribir(3, 1, &v1, 17);
+    configManager.iniciar();
+    TEST_ASSERT_EQUAL(POR_DIAS, configManager.config(3).modo);
+    TEST_ASSERT_EQUAL(30, configManager.config(3).minutoInicio);
+    TEST_ASSERT_EQUAL(0, configManager.config(3).numTramos);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_varias_ventanas_al_dia);
+    RUN_TEST(test_cruza_medianoche_y_domingo);
+    RUN_TEST(test_comprimir_ida_y_vuelta);
+    RUN_TEST(test_gestor_sigue_las_ventanas);
+    RUN_TEST(test_config_v1_se_migra);
+    return UNITY_END();
+}
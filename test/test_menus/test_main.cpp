@@ -0,0 +1,188 @@
+#include <unity.h>
+#include <string.h>
+#include "../comun/EntornoRiego.h"
+#include "hal/native/PantallaConsola.h"
+#include "objects/OLED.h"
+#include "objects/Potenciometro.h"
+#include "objects/Reloj.h"
+#include "menu/MenuPrincipal.h"
+
+// ==========================================
+// MENÚS: MÁQUINAS DE ESTADOS SIN ESPERAS
+// ==========================================
+// Cada actualizar() es una vuelta de la tarea de interfaz: no adelanta el
+// reloj (no espera) y avanza a lo sumo un paso. Botón y pot por la HAL
+// simulada, como en la placa.
+//
+//   pio test -e native -f test_menus -v
+
+static const unsigned long VUELTA_MS = 50;         // Periodo de "interfaz"
+
+PantallaConsola pantalla(false);
+OLED oled(pantalla);
+Boton botonBomba(PIN_BOTON_BOMBA);
+Potenciometro pot(PIN_POT);
+Reloj reloj(rtcHal, oled);
+
+// Menús nuevos por caso: recuerdan la última opción entre aperturas
+struct Menus {
+    MenuBomba bomba;
+    MenuReloj relojes;
+    MenuPrincipal principal;
+    Menus() : bomba(oled, botonBomba, pot, configManager), relojes(oled, botonBomba, pot, reloj),
+              principal(oled, botonBomba, bomba, relojes) {}
+};
+static MenuPrincipal* menu = nullptr;
+
+// Línea de la pantalla sin el relleno de espacios
+static const char* linea(int fila) {
+    static char buf[32];
+    strncpy(buf, pantalla.linea(fila), sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = '\0';
+    for (int i = strlen(buf) - 1; i >= 0 && buf[i] == ' '; i--) buf[i] = '\0';
+    return buf;
+}
+
+void setUp() {
+    reiniciarEntorno();
+    pantalla.iniciar();
+    oled.iniciar();
+    botonBomba.iniciar();
+    pot.iniciar();
+    sim::fijarAnalogico(PIN_POT, 0);
+}
+void tearDown() {}
+
+// Una vuelta: el menú no puede tocar el reloj
+static bool vuelta() {
+    sim::avanzar(VUELTA_MS);
+    unsigned long antes = hal::millis();
+    bool abierto = menu->actualizar();
+    TEST_ASSERT_TRUE_MESSAGE(hal::millis() == antes, "el menu ha esperado");
+    return abierto;
+}
+
+static void vueltas(unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += VUELTA_MS) vuelta();
+}
+
+// Pulsación (corta o larga) y las vueltas que tarda en llegar el evento
+static void pulsar(bool larga = false) {
+    sim::fijarPin(PIN_BOTON_BOMBA, hal::BAJO);
+    sim::avanzar(larga ? 1200 : 120);
+    sim::fijarPin(PIN_BOTON_BOMBA, hal::ALTO);
+    vueltas(2 * VUELTA_MS);
+}
+
+// Pot llevado a 'valor' de [minVal, maxVal] subiendo desde cero, como la
+// mano: con la histéresis, justo pasado el borde del paso ya cuenta
+static void girar(int valor, int minVal, int maxVal) {
+    long n = maxVal - minVal;
+    long borde = ((valor - minVal) * 1023L + n - 1) / n;
+    long crudo = borde + Potenciometro::HISTERESIS + 4;
+    sim::fijarAnalogico(PIN_POT, 0);
+    vueltas(4 * VUELTA_MS);
+    sim::fijarAnalogico(PIN_POT, crudo > 1023 ? 1023 : (int)crudo);
+    vueltas(4 * VUELTA_MS);
+}
+
+static void elegir(int valor, int minVal, int maxVal) {
+    girar(valor, minVal, maxVal);
+    pulsar();
+}
+
+void test_configurar_por_dias_paso_a_paso() {
+    Menus menus;
+    menu = &menus.principal;
+    menu->abrir();
+    TEST_ASSERT_EQUAL_STRING("Menu Principal", linea(0));
+    pulsar(true);                                   // 1) Config Bomba
+    TEST_ASSERT_EQUAL_STRING("Config Bomba", linea(0));
+    pulsar();                                       // 2) Por Dias
+    TEST_ASSERT_EQUAL_STRING("2) Por Dias", linea(1));
+    pulsar(true);
+
+    TEST_ASSERT_EQUAL_STRING("Zona", linea(0));
+    elegir(3, 1, NUM_ZONAS);
+    TEST_ASSERT_EQUAL_STRING("Dias Semana", linea(0));
+    girar(1, 0, 6);                                 // Lunes y miércoles
+    pulsar();
+    TEST_ASSERT_EQUAL_STRING("Lun [X]", linea(1));
+    elegir(3, 0, 6);
+    pulsar(true);
+
+    TEST_ASSERT_EQUAL_STRING("Hora Inicio", linea(0));
+    elegir(7, 0, 23);
+    elegir(30, 0, 59);
+    elegir(8, 0, 23);
+    elegir(15, 0, 59);
+    TEST_ASSERT_EQUAL_STRING("Config Guardada", linea(0));
+    TEST_ASSERT_TRUE(menu->abierto());
+
+    BombaConfig& cfg = configManager.config(2);
+    TEST_ASSERT_EQUAL(POR_DIAS, cfg.modo);
+    TEST_ASSERT_EQUAL_HEX8(0b0001010, cfg.diasSemana);
+    TEST_ASSERT_EQUAL(7, cfg.horaInicio);
+    TEST_ASSERT_EQUAL(30, cfg.minutoInicio);
+    TEST_ASSERT_EQUAL(8, cfg.horaFin);
+    TEST_ASSERT_EQUAL(15, cfg.minutoFin);
+
+    // El mensaje se queda MENSAJE_MS y el menú se cierra solo
+    vueltas(MenuBomba::MENSAJE_MS + VUELTA_MS);
+    TEST_ASSERT_FALSE(menu->abierto());
+}
+
+void test_timeout_a_medias_no_guarda() {
+    BombaConfig antes = configManager.config(0);
+    Menus menus;
+    menu = &menus.principal;
+    menu->abrir();
+    pulsar(true);
+    pulsar();
+    pulsar(true);                                   // Por Dias
+    elegir(1, 1, NUM_ZONAS);
+    pulsar(true);                                   // Días vacíos
+    elegir(9, 0, 23);
+
+    // Se deja a medias: se cierra sin guardar (antes guardaba los mínimos)
+    vueltas(MenuBomba::TIMEOUT_MS + 2 * VUELTA_MS);
+    TEST_ASSERT_FALSE(menu->abierto());
+    TEST_ASSERT_EQUAL(antes.modo, configManager.config(0).modo);
+    TEST_ASSERT_EQUAL(antes.horaInicio, configManager.config(0).horaInicio);
+}
+
+void test_ajuste_de_hora() {
+    Menus menus;
+    menu = &menus.principal;
+    menu->abrir();
+    pulsar();                                       // 2) Config Reloj
+    pulsar(true);
+    TEST_ASSERT_EQUAL_STRING("Menu Reloj", linea(0));
+    pulsar(true);                                   // 1) Ajuste Hora
+    elegir(6, 0, 23);
+    elegir(45, 0, 59);
+    TEST_ASSERT_EQUAL_STRING("Hora Ajustada", linea(0));
+    reloj.actualizar();
+    TEST_ASSERT_EQUAL(6, reloj.ahora().Hour());
+    TEST_ASSERT_EQUAL(45, reloj.ahora().Minute());
+}
+
+void test_salir_cierra_todo() {
+    Menus menus;
+    menu = &menus.principal;
+    menu->abrir();
+    pulsar();
+    pulsar();                                       // 3) Salir
+    pulsar(true);
+    TEST_ASSERT_FALSE(menu->abierto());
+    TEST_ASSERT_FALSE(vuelta());
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_configurar_por_dias_paso_a_paso);
+    RUN_TEST(test_timeout_a_medias_no_guarda);
+    RUN_TEST(test_ajuste_de_hora);
+    RUN_TEST(test_salir_cierra_todo);
+    return UNITY_END();
+}
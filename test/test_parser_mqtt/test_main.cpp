@@ -0,0 +1,334 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <chrono>
+#include <new>
+#include "manager/ParserComandos.h"
+
+// ==========================================
+// PARSER MQTT: CORRECCIÓN + BANCO DE PRUEBAS
+// ==========================================
+// Compara el parser de buffers fijos con el camino anterior del callback
+// (String carácter a carácter + JsonDocument en el heap) y demuestra que
+// el nuevo no hace ni una reserva de memoria por mensaje.
+//
+//   pio test -e native -f test_parser_mqtt -v
+
+// --- Contadores de heap: operator new global + malloc de ArduinoJson ---
+static unsigned long reservasNew = 0;
+static unsigned long reservasMalloc = 0;
+
+// Con glibc también se cuenta malloc directo (el DefaultAllocator de
+// ArduinoJson no pasa por new). En otras libc solo queda el de new.
+#if defined(__GLIBC__)
+extern "C" {
+    void* __libc_malloc(size_t n);
+    void* __libc_calloc(size_t n, size_t tam);
+    void* __libc_realloc(void* p, size_t n);
+    void* malloc(size_t n) { reservasMalloc++; return __libc_malloc(n); }
+    void* calloc(size_t n, size_t tam) { reservasMalloc++; return __libc_calloc(n, tam); }
+    void* realloc(void* p, size_t n) { reservasMalloc++; return __libc_realloc(p, n); }
+}
+#endif
+
+void* operator new(size_t n) {
+    reservasNew++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Allocator por defecto de ArduinoJson (malloc) pero contando
+class AllocatorContador : public ArduinoJson::Allocator {
+    public:
+        unsigned long reservas = 0;
+        void* allocate(size_t n) override { reservas++; return malloc(n); }
+        void deallocate(void* p) override { free(p); }
+        void* reallocate(void* p, size_t n) override { reservas++; return realloc(p, n); }
+};
+
+static const char* const MENSAJES[] = {
+    "ON",
+    "OFF",
+    "{\"zona\": 3, \"comando\": \"AUTO\"}",
+    "{\"zona\": 1, \"modo\": \"dias\", \"diasSemana\": 62, \"horaInicio\": 8, "
+        "\"minutoInicio\": 0, \"horaFin\": 20, \"minutoFin\": 0}",
+    "{\"zona\": 2, \"modo\": \"intervalo\", \"intervaloDias\": 3, \"anioInicio\": 2024, "
+        "\"mesInicio\": 1, \"diaInicio\": 20, \"horaInicio\": 8, \"minutoInicio\": 0, "
+        "\"horaFin\": 20, \"minutoFin\": 0, \"origen\": \"dashboard\", \"ts\": 1735689600}",
+    "{\"zona\": 3, \"modo\": \"fecha\", \"anio\": 2024, \"mes\": 12, \"dia\": 25, "
+        "\"horaInicio\": 9, \"minutoInicio\": 0, \"horaFin\": 18, \"minutoFin\": 0}",
+};
+static const size_t NUM_MENSAJES = sizeof(MENSAJES) / sizeof(MENSAJES[0]);
+static const unsigned long VUELTAS = 20000;
+
+static ParserComandos parser(8);
+
+static ResultadoParseo parsearTexto(const char* texto, ComandoControl& cmd) {
+    return parser.parsear(reinterpret_cast<const uint8_t*>(texto), strlen(texto), cmd);
+}
+
+// --- Los comandos válidos más grandes (lo que más arena pide) ---
+// SEMANAL con MAX_TRAMOS ventanas de cuatro cifras, en JSON y MessagePack,
+// y CRON con todos los valores de cada campo escritos uno a uno.
+static char semanalJson[1024];
+static uint8_t semanalMsgPack[512];
+static size_t largoSemanalMsgPack = 0;
+static char cronJson[1024];
+
+static uint16_t inicioTramo(uint8_t i) { return 1000 + i * 300; }    // 1000..9100
+static uint16_t minutosTramo(uint8_t i) { return 100 + i; }
+
+static void ponerCadenaMsgPack(uint8_t*& p, const char* texto) {
+    size_t n = strlen(texto);
+    *p++ = 0xA0 | n;                // fixstr (< 32)
+    memcpy(p, texto, n);
+    p += n;
+}
+
+static void ponerU16MsgPack(uint8_t*& p, uint16_t v) {
+    *p++ = 0xCD;                    // uint16
+    *p++ = v >> 8;
+    *p++ = v & 0xFF;
+}
+
+static void prepararMasGrandes() {
+    size_t pos = snprintf(semanalJson, sizeof(semanalJson), "{\"zona\": 8, \"modo\": \"semanal\", \"tramos\": [");
+    for (uint8_t i = 0; i < MAX_TRAMOS; i++) {
+        pos += snprintf(semanalJson + pos, sizeof(semanalJson) - pos, "%s[%u, %u]",
+                        i ? ", " : "", inicioTramo(i), minutosTramo(i));
+    }
+    snprintf(semanalJson + pos, sizeof(semanalJson) - pos, "]}");
+
+    uint8_t* p = semanalMsgPack;
+    *p++ = 0x83;                    // fixmap de 3
+    ponerCadenaMsgPack(p, "zona");
+    *p++ = 8;
+    ponerCadenaMsgPack(p, "modo");
+    ponerCadenaMsgPack(p, "semanal");
+    ponerCadenaMsgPack(p, "tramos");
+    *p++ = 0xDC;                    // array16 (más de 15)
+    *p++ = 0;
+    *p++ = MAX_TRAMOS;
+    for (uint8_t i = 0; i < MAX_TRAMOS; i++) {
+        *p++ = 0x92;                // fixarray de 2
+        ponerU16MsgPack(p, inicioTramo(i));
+        ponerU16MsgPack(p, minutosTramo(i));
+    }
+    largoSemanalMsgPack = p - semanalMsgPack;
+
+    static const uint8_t CAMPOS[5][2] = { {0, 59}, {0, 23}, {1, 31}, {1, 12}, {0, 7} };
+    pos = snprintf(cronJson, sizeof(cronJson), "{\"zona\": 8, \"modo\": \"cron\", \"cron\": \"");
+    for (uint8_t c = 0; c < 5; c++) {
+        for (uint8_t v = CAMPOS[c][0]; v <= CAMPOS[c][1]; v++) {
+            pos += snprintf(cronJson + pos, sizeof(cronJson) - pos, "%u%s", v, v < CAMPOS[c][1] ? "," : "");
+        }
+        if (c < 4) cronJson[pos++] = ' ';
+    }
+    snprintf(cronJson + pos, sizeof(cronJson) - pos, "\", \"duracion\": %u}", MAX_DURACION_CRON);
+}
+
+// Camino anterior (NetworkManager antes del parser): mismo trabajo por mensaje
+static AllocatorContador contadorLegado;
+static bool parsearLegado(const uint8_t* payload, size_t length, ComandoControl& cmd) {
+    std::string mensaje = "";
+    for (size_t i = 0; i < length; i++) mensaje += (char)payload[i];
+
+    if (mensaje == "ON") { cmd.tipo = ComandoControl::MANUAL_ON; cmd.zona = 0; return true; }
+    if (mensaje == "OFF") { cmd.tipo = ComandoControl::MANUAL_OFF; cmd.zona = 0; return true; }
+    if (mensaje[0] != '{') return false;
+
+    JsonDocument doc(&contadorLegado);
+    if (deserializeJson(doc, mensaje)) return false;
+
+    int zonaJson = doc["zona"] | 1;
+    cmd.zona = zonaJson - 1;
+    const char* comando = doc["comando"];
+    if (comando) { cmd.tipo = ComandoControl::MANUAL_AUTO; return true; }
+    const char* modo = doc["modo"];
+    if (!modo) return false;
+    cmd.tipo = ComandoControl::CONFIGURAR;
+    cmd.config.horaInicio = doc["horaInicio"].as<uint8_t>();
+    cmd.config.minutoInicio = doc["minutoInicio"].as<uint8_t>();
+    cmd.config.horaFin = doc["horaFin"].as<uint8_t>();
+    cmd.config.minutoFin = doc["minutoFin"].as<uint8_t>();
+    return true;
+}
+
+void setUp() {}
+void tearDown() {}
+
+// ======================================================
+// CORRECCIÓN
+// ======================================================
+void test_comandos_simples() {
+    ComandoControl cmd;
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto("ON", cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::MANUAL_ON, cmd.tipo);
+    TEST_ASSERT_EQUAL(0, cmd.zona);
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto("OFF", cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::MANUAL_OFF, cmd.tipo);
+    TEST_ASSERT_EQUAL(PARSEO_DESCONOCIDO, parsearTexto("ONN", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_DESCONOCIDO, parsearTexto("", cmd));
+}
+
+void test_comando_por_zona() {
+    ComandoControl cmd;
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(MENSAJES[2], cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::MANUAL_AUTO, cmd.tipo);
+    TEST_ASSERT_EQUAL(2, cmd.zona);
+    TEST_ASSERT_EQUAL(PARSEO_COMANDO_INVALIDO, parsearTexto("{\"comando\": \"ABRIR\"}", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_ZONA_INVALIDA, parsearTexto("{\"zona\": 9, \"comando\": \"ON\"}", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_ZONA_INVALIDA, parsearTexto("{\"zona\": 0, \"comando\": \"ON\"}", cmd));
+}
+
+void test_modos() {
+    ComandoControl cmd;
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(MENSAJES[3], cmd));
+    TEST_ASSERT_EQUAL(ComandoControl::CONFIGURAR, cmd.tipo);
+    TEST_ASSERT_EQUAL(POR_DIAS, cmd.config.modo);
+    TEST_ASSERT_EQUAL(62, cmd.config.diasSemana);
+    TEST_ASSERT_EQUAL(20, cmd.config.horaFin);
+
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(MENSAJES[4], cmd));
+    TEST_ASSERT_EQUAL(POR_INTERVALO, cmd.config.modo);
+    TEST_ASSERT_EQUAL(1, cmd.zona);
+    TEST_ASSERT_EQUAL(3, cmd.config.intervaloDias);
+    TEST_ASSERT_EQUAL(2024, cmd.config.fechaInicio.anio);
+    TEST_ASSERT_EQUAL(20, cmd.config.fechaInicio.dia);
+
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(MENSAJES[5], cmd));
+    TEST_ASSERT_EQUAL(POR_FECHA, cmd.config.modo);
+    TEST_ASSERT_EQUAL(12, cmd.config.proximaFecha.mes);
+    TEST_ASSERT_EQUAL(25, cmd.config.proximaFecha.dia);
+    TEST_ASSERT_EQUAL(9, cmd.config.horaInicio);
+
+    // Semanal: lista de [minutoDeSemana, minutos]
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto("{\"zona\": 2, \"modo\": \"semanal\", "
+                                              "\"tramos\": [[1800, 10], [2160, 15]]}", cmd));
+    TEST_ASSERT_EQUAL(SEMANAL, cmd.config.modo);
+    TEST_ASSERT_EQUAL(2, cmd.config.numTramos);
+    TEST_ASSERT_EQUAL(2160, cmd.config.tramos[1].inicio);
+    TEST_ASSERT_EQUAL(15, cmd.config.tramos[1].minutos);
+    TEST_ASSERT_EQUAL(PARSEO_TRAMOS_INVALIDOS,
+                      parsearTexto("{\"modo\": \"semanal\", \"tramos\": [[10080, 10]]}", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_TRAMOS_INVALIDOS, parsearTexto("{\"modo\": \"semanal\"}", cmd));
+
+    // Cron: llega ya compilado a bits
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto("{\"zona\": 5, \"modo\": \"cron\", "
+                                              "\"cron\": \"0 6,18 * * 1-5\", \"duracion\": 15}", cmd));
+    TEST_ASSERT_EQUAL(CRON, cmd.config.modo);
+    TEST_ASSERT_EQUAL(4, cmd.zona);
+    TEST_ASSERT_EQUAL(15, cmd.config.cron.duracion);
+    TEST_ASSERT_EQUAL(1, cmd.config.cron.minutos);
+    TEST_ASSERT_EQUAL((1 << 6) | (1 << 18), cmd.config.cron.horas);
+    TEST_ASSERT_EQUAL(0b0111110, cmd.config.cron.diasSemana);
+    TEST_ASSERT_EQUAL(PARSEO_CRON_INVALIDO,
+                      parsearTexto("{\"modo\": \"cron\", \"cron\": \"0 25 * * *\", \"duracion\": 15}", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_CRON_INVALIDO,
+                      parsearTexto("{\"modo\": \"cron\", \"cron\": \"0 6 * * *\"}", cmd));
+
+    TEST_ASSERT_EQUAL(PARSEO_SIN_MODO, parsearTexto("{\"modo\": \"mensual\"}", cmd));
+    TEST_ASSERT_EQUAL(PARSEO_JSON_INVALIDO, parsearTexto("{\"modo\": \"dias\"", cmd));
+}
+
+// Los mayores comandos válidos caben en la arena sin un solo fallo
+// (ArduinoJson daría NoMemory y el comando se perdería en silencio)
+void test_comandos_mas_grandes_caben() {
+    ComandoControl cmd;
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(semanalJson, cmd));
+    TEST_ASSERT_EQUAL(SEMANAL, cmd.config.modo);
+    TEST_ASSERT_EQUAL(MAX_TRAMOS, cmd.config.numTramos);
+    TEST_ASSERT_EQUAL(inicioTramo(MAX_TRAMOS - 1), cmd.config.tramos[MAX_TRAMOS - 1].inicio);
+    TEST_ASSERT_EQUAL(minutosTramo(MAX_TRAMOS - 1), cmd.config.tramos[MAX_TRAMOS - 1].minutos);
+
+    TEST_ASSERT_EQUAL(PARSEO_OK, parser.parsear(semanalMsgPack, largoSemanalMsgPack, cmd));
+    TEST_ASSERT_EQUAL(CODIFICACION_MSGPACK, parser.ultimaCodificacion());
+    TEST_ASSERT_EQUAL(MAX_TRAMOS, cmd.config.numTramos);
+    TEST_ASSERT_EQUAL(inicioTramo(MAX_TRAMOS - 1), cmd.config.tramos[MAX_TRAMOS - 1].inicio);
+
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(cronJson, cmd));
+    TEST_ASSERT_EQUAL(CRON, cmd.config.modo);
+    TEST_ASSERT_EQUAL(MAX_DURACION_CRON, cmd.config.cron.duracion);
+    TEST_ASSERT_TRUE(cmd.config.cron.minutos == (1ULL << 60) - 1);
+
+    TEST_ASSERT_EQUAL_UINT32(0, parser.fallosArena());
+    TEST_ASSERT_TRUE(parser.picoArena() <= ParserComandos::TAM_ARENA);
+    TEST_ASSERT_TRUE(parser.picoFiltros() <= ParserComandos::TAM_ARENA_FILTROS);
+
+    char linea[96];
+    snprintf(linea, sizeof(linea), "pico arena %u/%u B, filtros %u/%u B",
+             (unsigned)parser.picoArena(), (unsigned)ParserComandos::TAM_ARENA,
+             (unsigned)parser.picoFiltros(), (unsigned)ParserComandos::TAM_ARENA_FILTROS);
+    TEST_MESSAGE(linea);
+}
+
+// ======================================================
+// BANCO: reservas de heap y tiempo por mensaje
+// ======================================================
+void test_sin_heap_por_mensaje() {
+    ComandoControl cmd;
+    parsearTexto(MENSAJES[4], cmd);     // Calentar (por si acaso)
+
+    unsigned long antes = reservasNew;
+    unsigned long antesMalloc = reservasMalloc;
+    auto t0 = std::chrono::steady_clock::now();
+    for (unsigned long v = 0; v < VUELTAS; v++) {
+        for (size_t i = 0; i < NUM_MENSAJES; i++) {
+            TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(MENSAJES[i], cmd));
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    unsigned long reservasNuevo = reservasNew - antes;
+
+    // Los más grandes tampoco tocan el heap
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(semanalJson, cmd));
+    TEST_ASSERT_EQUAL(PARSEO_OK, parser.parsear(semanalMsgPack, largoSemanalMsgPack, cmd));
+    TEST_ASSERT_EQUAL(PARSEO_OK, parsearTexto(cronJson, cmd));
+    unsigned long mallocNuevo = reservasMalloc - antesMalloc;
+    reservasNuevo = reservasNew - antes;
+
+    antes = reservasNew;
+    contadorLegado.reservas = 0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (unsigned long v = 0; v < VUELTAS; v++) {
+        for (size_t i = 0; i < NUM_MENSAJES; i++) {
+            const char* m = MENSAJES[i];
+            parsearLegado(reinterpret_cast<const uint8_t*>(m), strlen(m), cmd);
+        }
+    }
+    auto t3 = std::chrono::steady_clock::now();
+    unsigned long reservasLegado = (reservasNew - antes) + contadorLegado.reservas;
+
+    double mensajes = (double)VUELTAS * NUM_MENSAJES;
+    double nsNuevo = std::chrono::duration<double, std::nano>(t1 - t0).count() / mensajes;
+    double nsLegado = std::chrono::duration<double, std::nano>(t3 - t2).count() / mensajes;
+
+    char linea[160];
+    snprintf(linea, sizeof(linea), "parser fijo: %.0f ns/msg, %.2f reservas/msg, pico arena %u B",
+             nsNuevo, reservasNuevo / mensajes, (unsigned)parser.picoArena());
+    TEST_MESSAGE(linea);
+    snprintf(linea, sizeof(linea), "String + JsonDocument: %.0f ns/msg, %.2f reservas/msg",
+             nsLegado, reservasLegado / mensajes);
+    TEST_MESSAGE(linea);
+
+    TEST_ASSERT_EQUAL_UINT32(0, reservasNuevo);
+    TEST_ASSERT_EQUAL_UINT32(0, mallocNuevo);
+    TEST_ASSERT_EQUAL_UINT32(0, parser.fallosArena());
+    TEST_ASSERT_TRUE(parser.picoArena() <= ParserComandos::TAM_ARENA);
+}
+
+int main(int, char**) {
+    prepararMasGrandes();
+    UNITY_BEGIN();
+    RUN_TEST(test_comandos_simples);
+    RUN_TEST(test_comando_por_zona);
+    RUN_TEST(test_modos);
+    RUN_TEST(test_comandos_mas_grandes_caben);
+    RUN_TEST(test_sin_heap_por_mensaje);
+    return UNITY_END();
+}
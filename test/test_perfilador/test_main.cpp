@@ -0,0 +1,70 @@
+#include <unity.h>
+#include "manager/Perfilador.h"
+
+// ==========================================
+// PERFILADOR: CUBETAS Y PERCENTILES
+// ==========================================
+// Los percentiles nunca quedan por debajo del valor real ni más de una
+// cubeta (~19 %) por encima, y saturar una cubeta no rompe la forma.
+//
+//   pio test -e native -f test_perfilador -v
+
+static Perfilador perfilador;
+
+void setUp() { perfilador.reiniciar(); }
+void tearDown() {}
+
+void test_techo_acota_cada_valor() {
+    // Cada valor cae en una cubeta cuyo techo lo supera por menos de un 25 %
+    for (uint32_t us = 1; us < 2000000; us = us * 9 / 8 + 1) {
+        setUp();
+        int etapa = perfilador.agregar("x");
+        perfilador.anotar(etapa, us);
+        perfilador.anotar(etapa, us + 100000000);    // El máximo no recorta el percentil
+        uint32_t p50 = perfilador.percentil(etapa, 50);
+        TEST_ASSERT_TRUE(p50 >= us);
+        TEST_ASSERT_TRUE(p50 <= us + us / 4 + 1);
+    }
+}
+
+void test_percentiles() {
+    int etapa = perfilador.agregar("red");
+    for (int i = 0; i < 990; i++) perfilador.anotar(etapa, 100);
+    for (int i = 0; i < 10; i++) perfilador.anotar(etapa, 50000);
+
+    uint32_t p50 = perfilador.percentil(etapa, 50);
+    TEST_ASSERT_TRUE(p50 >= 100 && p50 < 125);
+    TEST_ASSERT_TRUE(perfilador.percentil(etapa, 99) < 125);
+    TEST_ASSERT_EQUAL(50000, perfilador.percentil(etapa, 100));
+    TEST_ASSERT_EQUAL(1000, perfilador.etapa(etapa).muestras);
+    TEST_ASSERT_EQUAL(50000, perfilador.etapa(etapa).maximoUs);
+}
+
+void test_saturacion_conserva_forma() {
+    int etapa = perfilador.agregar("riego");
+    for (uint32_t i = 0; i < 200000; i++) perfilador.anotar(etapa, i % 4 == 0 ? 3000 : 10);
+
+    // Un cuarto de las muestras en 3000 us: p50 abajo, p90 arriba
+    TEST_ASSERT_TRUE(perfilador.percentil(etapa, 50) < 16);
+    TEST_ASSERT_TRUE(perfilador.percentil(etapa, 90) >= 3000);
+    TEST_ASSERT_EQUAL(200000, perfilador.etapa(etapa).muestras);
+}
+
+void test_limite_de_etapas() {
+    for (uint8_t i = 0; i < Perfilador::MAX_ETAPAS; i++) TEST_ASSERT_EQUAL(i, perfilador.agregar("e"));
+    TEST_ASSERT_EQUAL(-1, perfilador.agregar("sobra"));
+
+    // Una etapa sin registrar no se anota en ninguna
+    perfilador.anotar(Perfilador::MAX_ETAPAS, 10);
+    TEST_ASSERT_EQUAL(0, perfilador.percentil(0, 50));
+    MedidaEtapa medida(perfilador, -1);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_techo_acota_cada_valor);
+    RUN_TEST(test_percentiles);
+    RUN_TEST(test_saturacion_conserva_forma);
+    RUN_TEST(test_limite_de_etapas);
+    return UNITY_END();
+}
@@ -0,0 +1,112 @@
+#include <unity.h>
+#include "manager/Planificador.h"
+#include "hal/native/HalNative.h"
+
+// ==========================================
+// PLANIFICADOR: REPOSO Y DESPERTARES
+// ==========================================
+// En reposo solo las tareas con periodo de reposo marcan cuándo se
+// duerme; un flanco en un pin de despertar hace correr todas al momento.
+//
+//   pio test -e native -f test_planificador -v
+
+static const int PIN_BOTON = 16;
+
+static unsigned long vecesRiego = 0;
+static unsigned long vecesInterfaz = 0;
+static unsigned long pedidoRiego = 0;
+static Planificador* activo = nullptr;
+
+static void tareaRiego() {
+    vecesRiego++;
+    if (pedidoRiego) activo->proximaEn(pedidoRiego);
+}
+static void tareaInterfaz() { vecesInterfaz++; }
+static void alFlanco(void*, hal::Nivel, uint32_t) {}
+
+void setUp() {
+    vecesRiego = 0;
+    vecesInterfaz = 0;
+    pedidoRiego = 0;
+}
+void tearDown() {}
+
+// Corre el planificador hasta que el reloj simulado pase 'ms'
+static void correrDurante(Planificador& p, unsigned long ms) {
+    unsigned long fin = hal::millis() + ms;
+    while ((long)(hal::millis() - fin) < 0) p.ejecutar();
+}
+
+void test_despierto_sigue_su_periodo() {
+    Planificador p;
+    activo = &p;
+    p.agregar("riego", tareaRiego, 50, 20, 60000);
+    p.agregar("interfaz", tareaInterfaz, 50, 50);
+    correrDurante(p, 1000);                 // Cada 50 ms (más la vuelta en la que acaba)
+    TEST_ASSERT_TRUE(vecesRiego >= 20 && vecesRiego <= 21);
+    TEST_ASSERT_TRUE(vecesInterfaz >= 20 && vecesInterfaz <= 21);
+}
+
+void test_reposo_duerme_hasta_el_evento() {
+    Planificador p;
+    activo = &p;
+    p.agregar("riego", tareaRiego, 50, 20, 60000);
+    p.agregar("interfaz", tareaInterfaz, 50, 50);
+    p.fijarReposo(true);
+
+    // Diez minutos: el riego cada minuto y la interfaz solo al despertar
+    correrDurante(p, 600000);
+    TEST_ASSERT_TRUE(vecesRiego >= 10 && vecesRiego <= 11);
+    TEST_ASSERT_TRUE(vecesInterfaz <= vecesRiego + 1);
+
+    // El riego pide volver antes (p.ej. un cambio del horario en 5 s)
+    vecesRiego = 0;
+    pedidoRiego = 5000;
+    correrDurante(p, 60000);
+    TEST_ASSERT_TRUE(vecesRiego >= 11 && vecesRiego <= 13);
+}
+
+void test_pin_despierta_a_todas() {
+    Planificador p;
+    activo = &p;
+    p.agregar("riego", tareaRiego, 50, 20, 60000);
+    p.agregar("interfaz", tareaInterfaz, 50, 50);
+    hal::interrupcionPin(PIN_BOTON, alFlanco, nullptr);
+    TEST_ASSERT_TRUE(hal::despertarConPin(PIN_BOTON));
+    p.fijarReposo(true);
+    correrDurante(p, 1000);
+
+    // Pulsación durante la siesta: la próxima espera se corta al momento
+    vecesRiego = 0;
+    vecesInterfaz = 0;
+    unsigned long antes = hal::millis();
+    sim::fijarPin(PIN_BOTON, hal::BAJO);
+    while (vecesInterfaz == 0) p.ejecutar();
+    TEST_ASSERT_EQUAL(antes, hal::millis());
+    TEST_ASSERT_EQUAL(1, vecesRiego);
+    sim::fijarPin(PIN_BOTON, hal::ALTO);
+}
+
+void test_salir_de_reposo_pone_al_dia() {
+    Planificador p;
+    activo = &p;
+    p.agregar("riego", tareaRiego, 50, 20, 60000);
+    p.agregar("interfaz", tareaInterfaz, 50, 50);
+    p.fijarReposo(true);
+    correrDurante(p, 30000);
+
+    vecesInterfaz = 0;
+    p.fijarReposo(false);
+    TEST_ASSERT_EQUAL(0, p.msHastaProxima());
+    correrDurante(p, 500);
+    TEST_ASSERT_TRUE(vecesInterfaz >= 10);
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_despierto_sigue_su_periodo);
+    RUN_TEST(test_reposo_duerme_hasta_el_evento);
+    RUN_TEST(test_pin_despierta_a_todas);
+    RUN_TEST(test_salir_de_reposo_pone_al_dia);
+    return UNITY_END();
+}
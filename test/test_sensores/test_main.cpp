@@ -0,0 +1,214 @@
+#include <unity.h>
+#include "objects/FiltroDecimador.h"
+#include "../comun/EntornoRiego.h"
+#include "manager/SensorManager.h"
+#include "manager/Serializador.h"
+
+// ==========================================
+// SENSORES DE LÍNEA: DECIMACIÓN Y CORTE
+// ==========================================
+// El decimador en punto fijo sobre series conocidas, y el camino entero:
+// ADC continuo simulado -> filtro -> umbral -> relé abierto en pocos ms,
+// que la pasada siguiente anota como MANUAL_OFF por CAUSA_SENSOR. Sin
+// riego, los canales quedan en pausa en el ADC.
+// Zona 1 riega todos los días de 12:00 a 12:30.
+//
+//   pio test -e native -f test_sensores -v
+
+static const RtcDateTime REGANDO(2025, 1, 6, 12, 1, 0);
+
+// Presión 500-6000 mbar, caudal 2-45 L/min (ver Config.h)
+static const CanalSensor CANALES[] = {
+    {"presion", PIN_PRESION, PRESION_FONDO, PRESION_MIN, PRESION_MAX, 0xFFFF},
+    {"caudal",  PIN_CAUDAL,  CAUDAL_FONDO,  CAUDAL_MIN,  CAUDAL_MAX,  0xFFFF},
+};
+static const int PRESION_OK = 400;     // ~3900 mbar
+static const int PRESION_SECO = 20;    // ~200 mbar
+static const int CAUDAL_OK = 300;      // ~17,6 L/min
+static const int CAUDAL_ROTURA = 900;  // ~52,8 L/min
+
+void setUp() {
+    reiniciarEntorno();
+    configManager.configurarPorDias(0, 0x7F, 12, 0, 12, 30);
+    sim::fijarAnalogico(PIN_PRESION, PRESION_OK);
+    sim::fijarAnalogico(PIN_CAUDAL, CAUDAL_OK);
+}
+void tearDown() {}
+
+// La tarea de sensores cada SENSORES_MS durante 'ms'; devuelve los ms
+// que tardó en abrirse el relé de la zona 1 (o 'ms' + 1 si no se abrió)
+static unsigned long correr(SensorManager& sensores, unsigned long ms) {
+    for (unsigned long t = 0; t < ms; t += SENSORES_MS) {
+        sim::avanzar(SENSORES_MS);
+        sensores.actualizar();
+        if (sim::nivelPin(PINES[0]) == hal::BAJO) return t + SENSORES_MS;
+    }
+    return ms + 1;
+}
+
+static EntradaDiario ultimaAnotada() {
+    EntradaDiario lote[serializar::LOTE_DIARIO];
+    uint8_t n = diario.leer(lote, serializar::LOTE_DIARIO);
+    diario.rebobinar();
+    TEST_ASSERT_TRUE(n > 0);
+    return lote[n - 1];
+}
+
+// ======================================================
+// FILTRO DECIMADOR
+// ======================================================
+void test_filtro_constante_sale_exacto() {
+    FiltroDecimador f(4);
+    uint8_t salidas = 0;
+    for (uint16_t i = 0; i < 16 * 10; i++) {
+        if (f.meter(700)) salidas++;
+    }
+    // Una de cada 16, menos la primera (peines aún vacíos)
+    TEST_ASSERT_EQUAL(9, salidas);
+    TEST_ASSERT_TRUE(f.listo());
+    TEST_ASSERT_EQUAL(700, f.decimado());
+    TEST_ASSERT_EQUAL(700, f.valor());
+}
+
+void test_filtro_anula_nyquist() {
+    // Lo más rápido que puede cambiar la entrada: el CIC lo deja en la media
+    FiltroDecimador f(4);
+    for (uint16_t i = 0; i < 16 * 8; i++) f.meter((i & 1) ? 1000 : 0);
+    TEST_ASSERT_EQUAL(500, f.decimado());
+    TEST_ASSERT_EQUAL(500, f.valor());
+}
+
+void test_filtro_escalon_en_dos_decimados() {
+    FiltroDecimador f(4);
+    for (uint16_t i = 0; i < 16 * 4; i++) f.meter(200);
+
+    // Orden 2: a medio camino en el primer decimado, entero en el segundo
+    uint16_t primero = 0;
+    uint8_t salidas = 0;
+    for (uint16_t i = 0; i < 16 * 2; i++) {
+        if (!f.meter(800)) continue;
+        if (++salidas == 1) primero = f.decimado();
+    }
+    TEST_ASSERT_TRUE(primero > 200 && primero < 800);
+    TEST_ASSERT_EQUAL(800, f.decimado());
+    TEST_ASSERT_TRUE(f.valor() > 200 && f.valor() < 800);  // La EMA va detrás
+}
+
+// ======================================================
+// CORTE POR ANOMALÍA
+// ======================================================
+void test_bomba_en_seco_corta_en_milisegundos() {
+    BombaManager manager = gestorRiego();
+    SensorManager sensores(CANALES, 2, manager, SENSORES_HZ);
+    TEST_ASSERT_TRUE(sensores.iniciar());
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_EQUAL(hal::ALTO, sim::nivelPin(PINES[0]));
+
+    // Riego normal: publica los valores y no corta
+    TEST_ASSERT_TRUE(correr(sensores, SensorManager::ARRANQUE_MS + 500) > SensorManager::ARRANQUE_MS + 500);
+    TEST_ASSERT_UINT_WITHIN(10, PRESION_OK * PRESION_FONDO / 1023, sensores.valor(0));
+    TEST_ASSERT_UINT_WITHIN(2, CAUDAL_OK * CAUDAL_FONDO / 1023, sensores.valor(1));
+
+    // Se queda sin agua: el relé se abre sin ninguna pasada de por medio
+    sim::fijarAnalogico(PIN_PRESION, PRESION_SECO);
+    unsigned long ms = correr(sensores, 100);
+    TEST_ASSERT_TRUE_MESSAGE(ms <= 20, "el corte tarda mas de 20 ms");
+    TEST_ASSERT_EQUAL(1, sensores.totalAlarmas(0));
+    TEST_ASSERT_EQUAL(SensorManager::BAJO, sensores.ultimaAlarma(0));
+
+    // La pasada lo hace suyo: MANUAL_OFF hasta que acabe la ventana
+    manager.Evaluar(REGANDO);
+    TEST_ASSERT_EQUAL(0, manager.zonasEncendidas() & 1);
+    TEST_ASSERT_EQUAL(MANUAL_OFF, manager.obtenerOverride(0));
+    EntradaDiario e = ultimaAnotada();
+    TEST_ASSERT_EQUAL(0, e.zona);
+    TEST_ASSERT_FALSE(e.encendida());
+    TEST_ASSERT_EQUAL(CAUSA_SENSOR, e.motivo());
+
+    manager.Evaluar(RtcDateTime(REGANDO.TotalSeconds() + 60));
+    TEST_ASSERT_EQUAL(hal::BAJO, sim::nivelPin(PINES[0]));
+    TEST_ASSERT_EQUAL(1, sensores.totalAlarmas(0));  // Ya cortó en este riego
+}
+
+void test_rotura_de_tuberia_corta_por_caudal() {
+    BombaManager manager = gestorRiego();
+    SensorManager sensores(CANALES, 2, manager, SENSORES_HZ);
+    sensores.iniciar();
+    manager.Evaluar(REGANDO);
+    correr(sensores, SensorManager::ARRANQUE_MS + 100);
+
+    sim::fijarAnalogico(PIN_CAUDAL, CAUDAL_ROTURA);
+    TEST_ASSERT_TRUE(correr(sensores, 100) <= 20);
+    TEST_ASSERT_EQUAL(0, sensores.totalAlarmas(0));
+    TEST_ASSERT_EQUAL(1, sensores.totalAlarmas(1));
+    TEST_ASSERT_EQUAL(SensorManager::ALTO, sensores.ultimaAlarma(1));
+}
+
+void test_no_vigila_sin_riego_ni_en_el_arranque() {
+    BombaManager manager = gestorRiego();
+    SensorManager sensores(CANALES, 2, manager, SENSORES_HZ);
+    sensores.iniciar();
+
+    // Fuera de la ventana la línea está vacía y no pasa nada
+    sim::fijarAnalogico(PIN_PRESION, PRESION_SECO);
+    manager.Evaluar(RtcDateTime(2025, 1, 6, 11, 0, 0));
+    correr(sensores, SensorManager::ARRANQUE_MS + 500);
+    TEST_ASSERT_EQUAL(0, sensores.totalAlarmas(0));
+
+    // Al encender, la presión tiene ARRANQUE_MS para subir
+    manager.Evaluar(REGANDO);
+    unsigned long ms = correr(sensores, SensorManager::ARRANQUE_MS + 100);
+    TEST_ASSERT_TRUE(ms >= SensorManager::ARRANQUE_MS);
+    TEST_ASSERT_TRUE(ms <= SensorManager::ARRANQUE_MS + 20);
+}
+
+void test_pico_aislado_no_corta() {
+    BombaManager manager = gestorRiego();
+    SensorManager sensores(CANALES, 2, manager, SENSORES_HZ);
+    sensores.iniciar();
+    manager.Evaluar(REGANDO);
+    correr(sensores, SensorManager::ARRANQUE_MS + 100);
+
+    // 4 ms a cero (un golpe de ariete, un falso contacto): el filtro y la
+    // confirmación se lo comen
+    sim::fijarAnalogico(PIN_PRESION, 0);
+    correr(sensores, 4);
+    sim::fijarAnalogico(PIN_PRESION, PRESION_OK);
+    TEST_ASSERT_TRUE(correr(sensores, 200) > 200);
+    TEST_ASSERT_EQUAL(0, sensores.totalAlarmas(0));
+}
+
+void test_sin_riego_el_canal_no_se_convierte() {
+    BombaManager manager = gestorRiego();
+    SensorManager sensores(CANALES, 2, manager, SENSORES_HZ);
+    sensores.iniciar();
+    TEST_ASSERT_FALSE(sim::adcConvirtiendo(PIN_PRESION));
+
+    manager.Evaluar(REGANDO);
+    correr(sensores, 100);
+    TEST_ASSERT_TRUE(sim::adcConvirtiendo(PIN_PRESION));
+    TEST_ASSERT_TRUE(sim::adcConvirtiendo(PIN_CAUDAL));
+    uint16_t regando = sensores.valor(0);
+
+    // Acaba la ventana: en pausa y con el último valor del riego
+    manager.Evaluar(RtcDateTime(2025, 1, 6, 12, 30, 0));
+    sim::fijarAnalogico(PIN_PRESION, PRESION_SECO);
+    correr(sensores, 100);
+    TEST_ASSERT_FALSE(sim::adcConvirtiendo(PIN_PRESION));
+    TEST_ASSERT_FALSE(sim::adcConvirtiendo(PIN_CAUDAL));
+    TEST_ASSERT_EQUAL(regando, sensores.valor(0));
+    TEST_ASSERT_EQUAL(0, sensores.totalAlarmas(0));
+}
+
+int main(int, char**) {
+    UNITY_BEGIN();
+    RUN_TEST(test_filtro_constante_sale_exacto);
+    RUN_TEST(test_filtro_anula_nyquist);
+    RUN_TEST(test_filtro_escalon_en_dos_decimados);
+    RUN_TEST(test_bomba_en_seco_corta_en_milisegundos);
+    RUN_TEST(test_rotura_de_tuberia_corta_por_caudal);
+    RUN_TEST(test_no_vigila_sin_riego_ni_en_el_arranque);
+    RUN_TEST(test_pico_aislado_no_corta);
+    RUN_TEST(test_sin_riego_el_canal_no_se_convierte);
+    return UNITY_END();
+}